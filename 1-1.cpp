@@ -1,11 +1,24 @@
+#include "differential.hpp"
+#include "generator.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
 #include <array>
-#include <iostream>
+#include <cstdint>
 #include <limits>
+#include <numeric>
 #include <string>
+#include <utility>
+#include <vector>
+
+using namespace ::testing;
 
 bool is_characters_unique_with_lookup(const std::string& input)
 {
-	std::array<bool, std::numeric_limits<unsigned char>::max()> lookup{};
+	std::array<bool, std::numeric_limits<unsigned char>::max() + 1> lookup{};
 	
 	for (const char c : input)
 	{
@@ -42,14 +55,101 @@ bool is_characters_unique_without_lookup(const std::string& input)
 	return true;
 }
 
-int main() {
-	std::cout << is_characters_unique_with_lookup("abc") << std::endl;
-	std::cout << is_characters_unique_with_lookup("abcde") << std::endl;
-	std::cout << is_characters_unique_with_lookup("abcdea") << std::endl;
-	
-	std::cout << is_characters_unique_without_lookup("abc") << std::endl;
-	std::cout << is_characters_unique_without_lookup("abcde") << std::endl;
-	std::cout << is_characters_unique_without_lookup("abcdea") << std::endl;
-	
-	return 0;
+TEST(is_characters_unique, examples)
+{
+	EXPECT_TRUE(is_characters_unique_with_lookup("abc"));
+	EXPECT_TRUE(is_characters_unique_with_lookup("abcde"));
+	EXPECT_FALSE(is_characters_unique_with_lookup("abcdea"));
+
+	EXPECT_TRUE(is_characters_unique_without_lookup("abc"));
+	EXPECT_TRUE(is_characters_unique_without_lookup("abcde"));
+	EXPECT_FALSE(is_characters_unique_without_lookup("abcdea"));
 }
+
+TEST(is_characters_unique, all_bytes)
+{
+	std::string input(256, '\0');
+	std::iota(input.begin(), input.end(), 0);
+
+	EXPECT_TRUE(is_characters_unique_with_lookup(input));
+	EXPECT_TRUE(is_characters_unique_without_lookup(input));
+
+	input.back() = input.front();
+
+	EXPECT_FALSE(is_characters_unique_with_lookup(input));
+	EXPECT_FALSE(is_characters_unique_without_lookup(input));
+}
+
+// Strings of every length up to 300 over alphabets from two letters to
+// all 256 bytes, so that both unique and repeated inputs are common,
+// after the empty string and the 256 distinct bytes with and without
+// one more.
+std::vector<std::string> differential_strings(const std::uint64_t seed)
+{
+	std::string all_bytes(256, '\0');
+	std::iota(all_bytes.begin(), all_bytes.end(), 0);
+
+	std::vector<std::string> inputs = {"", "a", "aa", std::string(1, '\0'), all_bytes, all_bytes + '\xff'};
+
+	for (std::size_t i = 0; i != differential::iterations(); ++i)
+	{
+		const std::uint64_t stream   = generator::derive_seed(seed, i);
+		const std::size_t   length   = generator::splitmix64::at(stream, 0) % 301;
+		const unsigned      alphabet = 2 + generator::splitmix64::at(stream, 1) % 255;
+
+		std::string input(length, '\0');
+
+		for (std::size_t j = 0; j != length; ++j)
+		{
+			input[j] = static_cast<char>(generator::splitmix64::at(stream, j + 2) % alphabet);
+		}
+
+		inputs.push_back(std::move(input));
+	}
+
+	return inputs;
+}
+
+TEST(is_characters_unique, differential)
+{
+	const std::uint64_t seed = generator::default_seed();
+	SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+	EXPECT_TRUE(differential::agree("is_characters_unique_with_lookup", is_characters_unique_with_lookup,
+	                                is_characters_unique_without_lookup, differential_strings(seed)));
+}
+
+// Worst case for both: range(0) distinct characters in shuffled order.
+std::string unique_characters(const std::size_t length)
+{
+	std::string input(length, '\0');
+	generator::fill_permutation(input.begin(), input.end(), 256, length);
+	return input;
+}
+
+void is_characters_unique_with_lookup_benchmark(benchmark::State& state)
+{
+	const std::string input = unique_characters(state.range(0));
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(is_characters_unique_with_lookup(input));
+	}
+
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+void is_characters_unique_without_lookup_benchmark(benchmark::State& state)
+{
+	const std::string input = unique_characters(state.range(0));
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(is_characters_unique_without_lookup(input));
+	}
+
+	state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+BENCHMARK(is_characters_unique_with_lookup_benchmark)->RangeMultiplier(2)->Range(8, 256);
+BENCHMARK(is_characters_unique_without_lookup_benchmark)->RangeMultiplier(2)->Range(8, 256);
@@ -1,7 +1,14 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
 #include <cstring>
-#include <iostream>
+#include <string>
 #include <utility>
 
+using namespace ::testing;
+
 char* reverse(char* input)
 {
 	const std::size_t length = std::strlen(input);
@@ -14,8 +21,29 @@ char* reverse(char* input)
 	return input;
 }
 
-int main() {
+TEST(reverse, examples)
+{
 	char text[] = "Hello World!";
-	std::cout << reverse(text) << std::endl;
-	return 0;
+	EXPECT_THAT(reverse(text), StrEq("!dlroW olleH"));
+
+	char odd[] = "abc";
+	EXPECT_THAT(reverse(odd), StrEq("cba"));
+
+	char empty[] = "";
+	EXPECT_THAT(reverse(empty), StrEq(""));
+}
+
+void reverse_benchmark(benchmark::State& state)
+{
+	std::string text(state.range(0), 'a');
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(reverse(&text[0]));
+		benchmark::ClobberMemory();
+	}
+
+	state.SetBytesProcessed(state.iterations() * text.size());
 }
+
+BENCHMARK(reverse_benchmark)->Range(8, 1 << 20);
@@ -1,12 +1,21 @@
+#include "generator.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
 #include <array>
-#include <iostream>
 #include <limits>
+#include <string>
+
+using namespace ::testing;
 
 bool is_permutation(const std::string& a, const std::string& b)
 {
 	if (a.length() != b.length()) return false;
 	
-	std::array<int, std::numeric_limits<unsigned char>::max()> lookup{};
+	std::array<int, std::numeric_limits<unsigned char>::max() + 1> lookup{};
 	
 	for (const unsigned char c : a)
 	{
@@ -24,10 +33,42 @@ bool is_permutation(const std::string& a, const std::string& b)
 	return true;
 }
 
-int main()
+TEST(is_permutation, examples)
+{
+	EXPECT_FALSE(is_permutation("alpha", "bravo"));
+	EXPECT_FALSE(is_permutation("charlie", "delta"));
+	EXPECT_TRUE(is_permutation("rocket boys", "october sky"));
+	EXPECT_TRUE(is_permutation("doctorwho", "torchwood"));
+}
+
+TEST(is_permutation, high_bytes)
+{
+	EXPECT_TRUE(is_permutation("\xff\x01", "\x01\xff"));
+	EXPECT_FALSE(is_permutation("\xff\xff", "\xff\xfe"));
+}
+
+// b is a shuffle of a, so both passes run to the end.
+void is_permutation_benchmark(benchmark::State& state)
 {
-	std::cout << is_permutation("alpha", "bravo") << std::endl;
-	std::cout << is_permutation("charlie", "delta") << std::endl;
-	std::cout << is_permutation("rocket boys", "october sky") << std::endl;
-	std::cout << is_permutation("doctorwho", "torchwood") << std::endl;
+	const std::size_t length = state.range(0);
+
+	std::string a(length, '\0');
+	std::string b(length, '\0');
+	generator::fill_uniform(a.begin(), a.end(), 1, 'a', 'z');
+
+	const generator::permutation order{length, 2};
+
+	for (std::size_t i = 0; i != length; ++i)
+	{
+		b[i] = a[order[i]];
+	}
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(is_permutation(a, b));
+	}
+
+	state.SetBytesProcessed(state.iterations() * 2 * length);
 }
+
+BENCHMARK(is_permutation_benchmark)->Range(8, 1 << 20);
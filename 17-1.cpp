@@ -1,19 +1,48 @@
+#include "generator.hpp"
+#include "permute.hpp"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <limits>
+#include <map>
+#include <numeric>
 #include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 using namespace ::testing;
 
-void swap(int& a, int& b)
+// The interview answer: swaps two integers without a temporary. Every
+// step depends on the one before, and without the guard a variable
+// swapped with itself would be zeroed, so prefer swap() below.
+template <typename T>
+void xor_swap(T& a, T& b)
 {
+  if (&a == &b)
+  {
+    return;
+  }
+
   a ^= b;
   b ^= a;
   a ^= b;
 }
 
+template <typename T>
+void swap(T& a, T& b)
+{
+  T temp = std::move(a);
+  a = std::move(b);
+  b = std::move(temp);
+}
+
 void test_swap(const int a, const int b)
 {
   int alpha = a;
@@ -23,6 +52,11 @@ void test_swap(const int a, const int b)
 
   EXPECT_THAT(alpha, Eq(b));
   EXPECT_THAT(bravo, Eq(a));
+
+  xor_swap(alpha, bravo);
+
+  EXPECT_THAT(alpha, Eq(a));
+  EXPECT_THAT(bravo, Eq(b));
 }
 
 TEST(swap, extremes)
@@ -34,13 +68,251 @@ TEST(swap, extremes)
 }
 
 TEST(swap, random)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  const int min = std::numeric_limits<int>::min();
+  const int max = std::numeric_limits<int>::max();
+
+  for (std::uint64_t i = 0; i < 20000; i += 2)
+  {
+    test_swap(generator::uniform_at(seed, i, min, max), generator::uniform_at(seed, i + 1, min, max));
+  }
+}
+
+TEST(swap, aliased)
+{
+  int value = 42;
+
+  swap(value, value);
+  EXPECT_THAT(value, Eq(42));
+
+  xor_swap(value, value);
+  EXPECT_THAT(value, Eq(42));
+}
+
+TEST(swap_ranges, trivially_copyable)
+{
+  for (std::size_t n = 0; n != 100; ++n)
+  {
+    std::vector<std::uint16_t> a(n), b(n);
+    std::iota(a.begin(), a.end(), 0);
+    std::iota(b.begin(), b.end(), 1000);
+
+    const auto expected_a = b;
+    const auto expected_b = a;
+
+    EXPECT_THAT(permute::swap_ranges(a.data(), a.data() + n, b.data()), Eq(b.data() + n));
+    ASSERT_THAT(a, Eq(expected_a));
+    ASSERT_THAT(b, Eq(expected_b));
+  }
+}
+
+TEST(swap_ranges, generic)
+{
+  std::vector<std::string> a{"alpha", "bravo"};
+  std::vector<std::string> b{"charlie", "delta"};
+
+  permute::swap_ranges(a.begin(), a.end(), b.begin());
+
+  EXPECT_THAT(a, ElementsAre("charlie", "delta"));
+  EXPECT_THAT(b, ElementsAre("alpha", "bravo"));
+}
+
+TEST(apply_permutation, gathers)
 {
   std::default_random_engine rnd;
-  std::uniform_int_distribution<> dist{std::numeric_limits<int>::min(),
-                                       std::numeric_limits<int>::max()};
 
-  for (int i = 0; i < 10000; ++i)
+  for (std::size_t n = 0; n != 200; ++n)
+  {
+    std::vector<std::size_t> indices(n);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::shuffle(indices.begin(), indices.end(), rnd);
+
+    std::vector<std::string> values;
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      values.push_back(std::to_string(i));
+    }
+
+    std::vector<std::string> expected;
+
+    for (const auto index : indices)
+    {
+      expected.push_back(values[index]);
+    }
+
+    permute::apply_permutation(values.begin(), values.end(), indices.begin());
+    ASSERT_THAT(values, Eq(expected));
+  }
+}
+
+TEST(apply_permutation, rejects_non_permutations)
+{
+  std::vector<int> values{1, 2, 3};
+
+  const std::vector<int> repeated{0, 0, 1};
+  const std::vector<int> out_of_range{0, 3, 1};
+
+  EXPECT_THROW(permute::apply_permutation(values.begin(), values.end(), repeated.begin()),
+               std::invalid_argument);
+  EXPECT_THROW(permute::apply_permutation(values.begin(), values.end(), out_of_range.begin()),
+               std::invalid_argument);
+  EXPECT_THAT(values, ElementsAre(1, 2, 3));
+}
+
+TEST(parallel_shuffle, permutes_reproducibly)
+{
+  const std::size_t n = 5 * permute::shuffle_block + 123;
+
+  std::vector<std::uint32_t> reference(n);
+  std::iota(reference.begin(), reference.end(), 0);
+  permute::parallel_shuffle(reference.begin(), reference.end(), 7, 1);
+
+  for (const unsigned int num_threads : {2U, 3U, 8U})
+  {
+    std::vector<std::uint32_t> values(n);
+    std::iota(values.begin(), values.end(), 0);
+    permute::parallel_shuffle(values.begin(), values.end(), 7, num_threads);
+
+    ASSERT_THAT(values, Eq(reference));
+  }
+
+  EXPECT_FALSE(std::is_sorted(reference.begin(), reference.end()));
+  std::sort(reference.begin(), reference.end());
+
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    ASSERT_THAT(reference[i], Eq(i));
+  }
+}
+
+// Exercises merge_shuffled directly: two shuffled halves of three
+// elements should merge into each of the 720 permutations about equally.
+TEST(parallel_shuffle, merge_is_uniform)
+{
+  std::mt19937_64 engine{1};
+  std::map<std::array<int, 6>, int> counts;
+  const int trials = 720 * 200;
+
+  for (int trial = 0; trial != trials; ++trial)
+  {
+    std::array<int, 6> values{{0, 1, 2, 3, 4, 5}};
+    std::shuffle(values.begin(), values.begin() + 3, engine);
+    std::shuffle(values.begin() + 3, values.end(), engine);
+    permute::merge_shuffled(values.begin(), values.begin() + 3, values.end(), engine);
+    ++counts[values];
+  }
+
+  EXPECT_THAT(counts.size(), Eq(720U));
+
+  for (const auto& count : counts)
+  {
+    ASSERT_THAT(count.second, AllOf(Gt(120), Lt(280)));
+  }
+}
+
+template <typename T>
+void swap_ranges_permute(benchmark::State& state)
+{
+  std::vector<T> a(state.range(0)), b(state.range(0));
+
+  for (auto _ : state)
+  {
+    permute::swap_ranges(a.data(), a.data() + a.size(), b.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * 2 * a.size() * sizeof(T));
+}
+
+template <typename T>
+void swap_ranges_std(benchmark::State& state)
+{
+  std::vector<T> a(state.range(0)), b(state.range(0));
+
+  for (auto _ : state)
+  {
+    std::swap_ranges(a.begin(), a.end(), b.begin());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * 2 * a.size() * sizeof(T));
+}
+
+template <typename T>
+void swap_ranges_xor(benchmark::State& state)
+{
+  std::vector<T> a(state.range(0)), b(state.range(0));
+
+  for (auto _ : state)
+  {
+    for (std::size_t i = 0; i != a.size(); ++i)
+    {
+      xor_swap(a[i], b[i]);
+    }
+
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * 2 * a.size() * sizeof(T));
+}
+
+BENCHMARK_TEMPLATE(swap_ranges_permute, std::uint8_t)->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(swap_ranges_std, std::uint8_t)->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(swap_ranges_xor, std::uint8_t)->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(swap_ranges_permute, std::uint64_t)->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(swap_ranges_std, std::uint64_t)->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(swap_ranges_xor, std::uint64_t)->Range(64, 1 << 20);
+
+void apply_permutation_benchmark(benchmark::State& state)
+{
+  std::vector<std::uint32_t> indices(state.range(0));
+  std::iota(indices.begin(), indices.end(), 0);
+  std::shuffle(indices.begin(), indices.end(), std::mt19937_64{1});
+
+  std::vector<std::uint64_t> values(indices.size());
+
+  for (auto _ : state)
+  {
+    permute::apply_permutation(values.begin(), values.end(), indices.begin());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * indices.size());
+}
+
+BENCHMARK(apply_permutation_benchmark)->Range(64, 1 << 22);
+
+void shuffle_std(benchmark::State& state)
+{
+  std::vector<std::uint32_t> values(state.range(0));
+  std::mt19937_64 engine{1};
+
+  for (auto _ : state)
+  {
+    std::shuffle(values.begin(), values.end(), engine);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+void shuffle_parallel(benchmark::State& state)
+{
+  std::vector<std::uint32_t> values(state.range(0));
+  std::uint64_t seed = 1;
+
+  for (auto _ : state)
   {
-    test_swap(dist(rnd), dist(rnd));
+    permute::parallel_shuffle(values.begin(), values.end(), seed++);
+    benchmark::ClobberMemory();
   }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
 }
+
+BENCHMARK(shuffle_std)->Range(1 << 10, 1 << 24)->UseRealTime();
+BENCHMARK(shuffle_parallel)->Range(1 << 10, 1 << 24)->UseRealTime();
@@ -1,56 +1,16 @@
-#include <cstddef>
-#include <iostream>
+#include "stack.hpp"
 
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
 
-template <typename T>
-class Stack
-{
-public:
-	bool empty() const
-	{
-		return top_ == nullptr;
-	}
-	
-	void pop()
-	{
-		if (top_)
-		{
-			Node *node = top_;
-			top_ = node->next;
-			delete node;
-			--size_;
-		}
-	}
-	
-	void push(T element)
-	{
-		Node *node = new Node(element);
-		if (top_) node->next = top_;
-		top_ = node;
-		++size_;
-	}
-	
-	std::size_t size() const
-	{
-		return size_;
-	}
-	
-	T top() const
-	{
-		return top_->data;
-	}
-	
-private:
-	struct Node
-	{
-		Node(T data) : data(data) { }
-		T     data;
-		Node *next = nullptr;
-	};
-	
-	Node*       top_  = nullptr;
-	std::size_t size_ = 0;
-};
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+using namespace ::testing;
 
 
 // Special queue implemented using two stacks.
@@ -155,26 +115,80 @@ std::ostream& operator<<(std::ostream& os, const MyQueue<T>& queue)
 }
 
 
-int main()
+template <typename T>
+std::string to_string(const MyQueue<T>& queue)
+{
+	std::ostringstream os;
+	os << queue;
+	return os.str();
+}
+
+TEST(MyQueue, push_pop)
 {
 	MyQueue<int> q;
-	
-	std::cout << q << std::endl;
+	EXPECT_THAT(to_string(q), Eq("MyQueue(size=0)"));
+
 	q.push(1);
-	std::cout << q << std::endl;
-	
+	EXPECT_THAT(to_string(q), Eq("MyQueue(size=1,front=1,back=1)"));
+
 	q.push(2);
-	std::cout << q << std::endl;
-	
+	EXPECT_THAT(to_string(q), Eq("MyQueue(size=2,front=1,back=2)"));
+
 	q.push(3);
-	std::cout << q << std::endl;
-	
+	EXPECT_THAT(to_string(q), Eq("MyQueue(size=3,front=1,back=3)"));
+
 	q.pop();
-	std::cout << q << std::endl;
-	
+	EXPECT_THAT(to_string(q), Eq("MyQueue(size=2,front=2,back=3)"));
+
 	q.pop();
-	std::cout << q << std::endl;
-	
+	EXPECT_THAT(to_string(q), Eq("MyQueue(size=1,front=3,back=3)"));
+
 	q.pop();
-	std::cout << q << std::endl;
+	EXPECT_THAT(to_string(q), Eq("MyQueue(size=0)"));
 }
+
+TEST(MyQueue, fifo)
+{
+	MyQueue<int> q;
+
+	for (int i = 0; i != 100; ++i)
+	{
+		q.push(i);
+	}
+
+	for (int i = 0; i != 100; ++i)
+	{
+		ASSERT_THAT(q.front(), Eq(i));
+		q.pop();
+	}
+
+	EXPECT_TRUE(q.empty());
+}
+
+// Every push past the second moves the whole queue twice, so filling
+// the queue is quadratic in its size.
+template <typename T>
+void MyQueue_push_pop(benchmark::State& state)
+{
+	const T value{};
+
+	for (auto _ : state)
+	{
+		MyQueue<T> q;
+
+		for (auto i = 0; i != state.range(0); ++i)
+		{
+			q.push(value);
+		}
+
+		while (!q.empty())
+		{
+			q.pop();
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(MyQueue_push_pop, int)->Range(8, 1 << 10);
+BENCHMARK_TEMPLATE(MyQueue_push_pop, std::string)->Range(8, 1 << 10);
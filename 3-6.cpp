@@ -1,133 +1,682 @@
+#include "allocation.hpp"
+#include "external_sort.hpp"
+#include "profiling.hpp"
+#include "stack.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <functional>
-#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
-template <typename T>
-class Stack
+using namespace ::testing;
+
+// Contiguous drains the stack into a vector, sorts it and refills the
+// stack: O(n log n) time and O(n) extra memory, sorting in parallel for
+// large stacks. TwoStacks is the classic insertion sort shuttling
+// elements between the stack and one extra stack: O(n^2) time, but it
+// never holds more than the elements themselves.
+//
+// Both modes order the stack so that Compare holds from top to bottom and
+// leave equal elements with the earliest pushed nearest the top.
+enum class StackSort
 {
-public:
-	bool empty() const
-	{
-		return top_ == nullptr;
-	}
-	
-	void pop()
+	Contiguous,
+	TwoStacks
+};
+
+constexpr std::size_t parallel_sort_threshold = 1 << 16;
+
+// Stable sort of [first, last) on up to num_threads threads: each thread
+// sorts one slice, then neighbouring slices are merged pairwise.
+template <typename RandomIt, typename Compare>
+void parallel_stable_sort(RandomIt first, RandomIt last, Compare compare,
+                          const unsigned int num_threads)
+{
+	const std::size_t n = std::distance(first, last);
+
+	if (num_threads < 2 || n < 2 * num_threads)
 	{
-		if (top_)
-		{
-			Node *node = top_;
-			top_ = node->next;
-			delete node;
-			--size_;
-		}
+		std::stable_sort(first, last, compare);
+		return;
 	}
-	
-	void push(T element)
+
+	std::vector<RandomIt> bounds;
+
+	for (unsigned int i = 0; i <= num_threads; ++i)
 	{
-		Node *node = new Node(element);
-		if (top_) node->next = top_;
-		top_ = node;
-		++size_;
+		bounds.push_back(first + n * i / num_threads);
 	}
-	
-	std::size_t size() const
+
+	std::vector<std::thread> threads;
+
+	for (unsigned int i = 0; i != num_threads; ++i)
 	{
-		return size_;
+		threads.emplace_back([&, i] { std::stable_sort(bounds[i], bounds[i + 1], compare); });
 	}
-	
-	T top() const
+
+	for (auto& thread : threads)
 	{
-		return top_->data;
+		thread.join();
 	}
-	
-	friend std::ostream& operator<<(std::ostream& os, const Stack<T>& stack)
+
+	for (std::size_t width = 1; width < num_threads; width *= 2)
 	{
-		os << "Stack(size=" << stack.size_;
-		
-		if (stack.top_)
+		threads.clear();
+
+		for (std::size_t i = 0; i + width < num_threads; i += 2 * width)
 		{
-			os << ",elements=" << stack.top_->data;
+			const std::size_t end = std::min<std::size_t>(i + 2 * width, num_threads);
 
-			for (Node *node = stack.top_->next; node; node = node->next)
+			threads.emplace_back([&, i, width, end]
 			{
-				os << " " << node->data;
-			}
+				std::inplace_merge(bounds[i], bounds[i + width], bounds[end], compare);
+			});
 		}
-		
-		os << ")";
-		
-		return os;
-	}
-	
-private:
-	struct Node
-	{
-		Node(T data) : data(data) { }
-		T     data;
-		Node *next = nullptr;
-	};
-	
-	Node*       top_  = nullptr;
-	std::size_t size_ = 0;
-};
 
-template <typename T, typename Compare = std::greater<T>>
-void sort(Stack<T>& stack)
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
+
+template <typename T, typename Compare, typename Allocator, typename Storage>
+void sort_contiguous(Stack<T, Allocator, Storage>& stack)
+{
+	std::vector<T> elements;
+	elements.reserve(stack.size());
+
+	while (!stack.empty())
+	{
+		elements.push_back(std::move(stack.top()));
+		stack.pop();
+	}
+
+	// Back in push order, so that equal elements keep it.
+	std::reverse(elements.begin(), elements.end());
+
+	const unsigned int num_threads = elements.size() < parallel_sort_threshold
+		? 1 : std::thread::hardware_concurrency();
+	parallel_stable_sort(elements.begin(), elements.end(), Compare{}, num_threads);
+
+	stack.reserve(elements.size());
+
+	for (auto element = elements.rbegin(); element != elements.rend(); ++element)
+	{
+		stack.push(std::move(*element));
+	}
+}
+
+template <typename T, typename Compare, typename Allocator, typename Storage>
+void sort_two_stacks(Stack<T, Allocator, Storage>& stack)
 {
-	Compare  compare;
-	Stack<T> store;
-	
+	Compare                      compare;
+	Stack<T, Allocator, Storage> store;
+
 	while (!stack.empty())
 	{
 		if (store.empty() ||
 		    compare(store.top(), stack.top()))
 		{
-			store.push(stack.top());
+			store.push(std::move(stack.top()));
 			stack.pop();
 		}
 		else
 		{
-			T temp = stack.top();
+			T temp = std::move(stack.top());
 			stack.pop();
-			
+
 			std::size_t n = 0;
-			
+
 			do
 			{
-				stack.push(store.top());
+				stack.push(std::move(store.top()));
 				store.pop();
 				++n;
 			} while (!store.empty() &&
 				     !compare(store.top(), temp));
-			
-			store.push(temp);
-			
+
+			store.push(std::move(temp));
+
 			for (; n; --n)
 			{
-				store.push(stack.top());
+				store.push(std::move(stack.top()));
 				stack.pop();
 			}
 		}
 	}
-	
+
 	while (!store.empty())
 	{
-		stack.push(store.top());
+		stack.push(std::move(store.top()));
 		store.pop();
 	}
 }
 
-int main()
+template <typename T, typename Compare = std::greater<T>, typename Allocator, typename Storage>
+void sort(Stack<T, Allocator, Storage>& stack, const StackSort mode = StackSort::Contiguous)
+{
+	if (mode == StackSort::TwoStacks)
+	{
+		sort_two_stacks<T, Compare>(stack);
+	}
+	else
+	{
+		sort_contiguous<T, Compare>(stack);
+	}
+}
+
+template <typename T, typename Compare>
+struct Reversed
+{
+	bool operator()(const T& a, const T& b) const
+	{
+		return compare(b, a);
+	}
+
+	Compare compare;
+};
+
+// Sorts like sort(), holding at most options.memory_budget bytes besides
+// the stack: once that much has been drained from the stack it is sorted
+// and spilled to a run file, and the runs are merged back into the
+// stack. T must be trivially copyable.
+//
+// The stack is consumed as it drains, so storage that frees memory as it
+// is popped (ChunkedStack, or LinkedStorage over std::allocator) hands it
+// over to the sort; an ArrayStack keeps its array for the refill. For
+// more elements than fit in memory once, sort_external_to_file() writes
+// the result to a file instead.
+//
+// The stack is drained top first, which is push order reversed. Sorting
+// that by the reversed comparator, stable, yields the final stack bottom
+// up, ready to be pushed back as it comes out of the merge.
+template <typename T, typename Compare = std::greater<T>, typename Allocator, typename Storage>
+ExternalSortStats sort_external(Stack<T, Allocator, Storage>& stack,
+                                const ExternalSortOptions& options = ExternalSortOptions{})
+{
+	ExternalSorter<T, Reversed<T, Compare>> sorter{options};
+
+	while (!stack.empty())
+	{
+		sorter.push(stack.top());
+		stack.pop();
+	}
+
+	sorter.finish([&](const T& element) { stack.push(element); });
+
+	return sorter.stats();
+}
+
+// As sort_external(), but streams the sorted elements to out, in the
+// order they would be popped, and leaves the stack empty.
+template <typename T, typename Compare = std::greater<T>, typename Allocator, typename Storage, typename OutputIt>
+ExternalSortStats sort_external_into(Stack<T, Allocator, Storage>& stack, OutputIt out,
+                                     const ExternalSortOptions& options = ExternalSortOptions{})
+{
+	ExternalSorter<T, Reversed<T, Compare>> sorter{options};
+
+	while (!stack.empty())
+	{
+		sorter.push(stack.top());
+		stack.pop();
+	}
+
+	sorter.finish([&](const T& element) { *out++ = element; }, true);
+
+	return sorter.stats();
+}
+
+// As sort_external_into(), but writes the elements to the file at path
+// as raw bytes, a block at a time from within the budget.
+template <typename T, typename Compare = std::greater<T>, typename Allocator, typename Storage>
+ExternalSortStats sort_external_to_file(Stack<T, Allocator, Storage>& stack, const std::string& path,
+                                        const ExternalSortOptions& options = ExternalSortOptions{})
+{
+	ExternalSorter<T, Reversed<T, Compare>> sorter{options};
+
+	while (!stack.empty())
+	{
+		sorter.push(stack.top());
+		stack.pop();
+	}
+
+	sorter.finish_to_file(path, true);
+
+	return sorter.stats();
+}
+
+namespace
+{
+	struct Record
+	{
+		int key;
+		int id;
+
+		friend bool operator==(const Record& a, const Record& b)
+		{
+			return a.key == b.key && a.id == b.id;
+		}
+	};
+
+	struct ByKey
+	{
+		bool operator()(const Record& a, const Record& b) const
+		{
+			return a.key > b.key;
+		}
+	};
+
+	template <typename T, typename Allocator, typename Storage>
+	std::vector<T> elements(const Stack<T, Allocator, Storage>& stack)
+	{
+		return std::vector<T>(stack.begin(), stack.end());
+	}
+}
+
+TEST(sort, example)
+{
+	for (const auto mode : {StackSort::Contiguous, StackSort::TwoStacks})
+	{
+		Stack<int> stack;
+
+		stack.push(1);
+		stack.push(2);
+		stack.push(7);
+		stack.push(21);
+		stack.push(5);
+
+		sort(stack, mode);
+
+		std::ostringstream os;
+		os << stack;
+		EXPECT_THAT(os.str(), Eq("Stack(size=5,elements=21 7 5 2 1)"));
+	}
+}
+
+TEST(sort, empty_and_single)
 {
 	Stack<int> stack;
-	
-	stack.push(1);
-	stack.push(2);
-	stack.push(7);
-	stack.push(21);
-	stack.push(5);
-	
-	std::cout << stack << std::endl;
 	sort(stack);
-	std::cout << stack << std::endl;
+	EXPECT_TRUE(stack.empty());
+
+	stack.push(3);
+	sort(stack, StackSort::TwoStacks);
+	EXPECT_THAT(stack.top(), Eq(3));
 }
+
+TEST(sort, modes_agree_on_equal_elements)
+{
+	std::default_random_engine rnd;
+	std::uniform_int_distribution<> dist{0, 20};
+
+	Stack<Record> contiguous;
+	Stack<Record> two_stacks;
+
+	for (int i = 0; i != 500; ++i)
+	{
+		const Record record{dist(rnd), i};
+		contiguous.push(record);
+		two_stacks.push(record);
+	}
+
+	sort<Record, ByKey>(contiguous);
+	sort<Record, ByKey>(two_stacks, StackSort::TwoStacks);
+
+	const auto sorted = elements(contiguous);
+	EXPECT_THAT(sorted, Eq(elements(two_stacks)));
+
+	for (std::size_t i = 1; i != sorted.size(); ++i)
+	{
+		ASSERT_GE(sorted[i - 1].key, sorted[i].key);
+
+		if (sorted[i - 1].key == sorted[i].key)
+		{
+			ASSERT_LT(sorted[i - 1].id, sorted[i].id);
+		}
+	}
+}
+
+TEST(sort, compare)
+{
+	ArrayStack<int> stack;
+
+	for (const int i : {4, 1, 3, 2})
+	{
+		stack.push(i);
+	}
+
+	sort<int, std::less<int>>(stack);
+	EXPECT_THAT(elements(stack), ElementsAre(1, 2, 3, 4));
+}
+
+TEST(sort, move_only)
+{
+	Stack<std::unique_ptr<int>> stack;
+
+	for (const int i : {2, 3, 1})
+	{
+		stack.emplace(new int(i));
+	}
+
+	struct Greater
+	{
+		bool operator()(const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) const
+		{
+			return *a > *b;
+		}
+	};
+
+	sort<std::unique_ptr<int>, Greater>(stack);
+	EXPECT_THAT(*stack.top(), Eq(3));
+}
+
+TEST(parallel_stable_sort, matches_stable_sort)
+{
+	std::default_random_engine rnd;
+	std::uniform_int_distribution<> dist{0, 1000};
+
+	std::vector<Record> records;
+
+	for (int i = 0; i != 100000; ++i)
+	{
+		records.push_back({dist(rnd), i});
+	}
+
+	for (const unsigned int num_threads : {2U, 3U, 4U, 7U})
+	{
+		auto expected = records;
+		auto actual   = records;
+
+		std::stable_sort(expected.begin(), expected.end(), ByKey{});
+		parallel_stable_sort(actual.begin(), actual.end(), ByKey{}, num_threads);
+
+		ASSERT_THAT(actual, Eq(expected));
+	}
+}
+
+namespace
+{
+	template <typename StackType>
+	StackType random_records(const int n, const int max_key)
+	{
+		std::default_random_engine rnd;
+		std::uniform_int_distribution<> dist{0, max_key};
+
+		StackType stack;
+
+		for (int i = 0; i != n; ++i)
+		{
+			stack.push(Record{dist(rnd), i});
+		}
+
+		return stack;
+	}
+}
+
+TEST(sort_external, fits_in_memory)
+{
+	auto stack    = random_records<Stack<Record>>(1000, 50);
+	auto expected = stack;
+
+	sort<Record, ByKey>(expected);
+	const ExternalSortStats stats = sort_external<Record, ByKey>(stack);
+
+	EXPECT_THAT(stats.runs, Eq(0U));
+	EXPECT_THAT(elements(stack), Eq(elements(expected)));
+}
+
+TEST(sort_external, spills_within_budget)
+{
+	for (const bool use_mmap : {false, true})
+	{
+		auto stack    = random_records<ArrayStack<Record>>(20000, 300);
+		auto expected = stack;
+
+		ExternalSortOptions options;
+		options.memory_budget = 16 << 10;
+		options.read_block    = 1 << 10;
+		options.use_mmap      = use_mmap;
+
+		sort<Record, ByKey>(expected);
+		const ExternalSortStats stats = sort_external<Record, ByKey>(stack, options);
+
+		EXPECT_THAT(stats.runs, Gt(1U));
+		EXPECT_THAT(stats.passes, Eq(1U));
+		EXPECT_THAT(stats.peak_memory, Le(options.memory_budget));
+		EXPECT_THAT(elements(stack), Eq(elements(expected)));
+	}
+}
+
+TEST(sort_external, merges_in_passes)
+{
+	auto stack    = random_records<Stack<Record>>(20000, 300);
+	auto expected = stack;
+
+	ExternalSortOptions options;
+	options.memory_budget = 12 << 10;
+
+	sort<Record, ByKey>(expected);
+	const ExternalSortStats stats = sort_external<Record, ByKey>(stack, options);
+
+	EXPECT_THAT(stats.passes, Gt(1U));
+	EXPECT_THAT(stats.peak_memory, Le(options.memory_budget));
+	EXPECT_THAT(elements(stack), Eq(elements(expected)));
+}
+
+TEST(sort_external, into_iterator)
+{
+	auto stack    = random_records<Stack<Record>>(5000, 100);
+	auto expected = stack;
+
+	ExternalSortOptions options;
+	options.memory_budget = 8 << 10;
+
+	std::vector<Record> sorted;
+	sort<Record, ByKey>(expected);
+	sort_external_into<Record, ByKey>(stack, std::back_inserter(sorted), options);
+
+	EXPECT_TRUE(stack.empty());
+	EXPECT_THAT(sorted, Eq(elements(expected)));
+}
+
+namespace
+{
+	std::vector<Record> read_records(const std::string& path)
+	{
+		std::ifstream       file{path, std::ios::binary};
+		std::vector<Record> records;
+		Record              record;
+
+		while (file.read(reinterpret_cast<char*>(&record), sizeof(record)))
+		{
+			records.push_back(record);
+		}
+
+		return records;
+	}
+
+	// Lowers the soft descriptor limit for as long as it lives.
+	class FileLimit
+	{
+	public:
+		explicit FileLimit(const rlim_t files)
+		{
+			::getrlimit(RLIMIT_NOFILE, &saved_);
+
+			rlimit limit = saved_;
+			limit.rlim_cur = std::min(files, saved_.rlim_max);
+			::setrlimit(RLIMIT_NOFILE, &limit);
+		}
+
+		FileLimit(const FileLimit&) = delete;
+		FileLimit& operator=(const FileLimit&) = delete;
+
+		~FileLimit()
+		{
+			::setrlimit(RLIMIT_NOFILE, &saved_);
+		}
+
+	private:
+		rlimit saved_;
+	};
+}
+
+// A stack eight times the budget, sorted into a file: the heap never
+// holds more than the budget beyond what the stack held to begin with,
+// as the stack's chunks are freed while it drains.
+TEST(sort_external, to_file_within_budget_of_real_memory)
+{
+	SKIP_WITHOUT_ALLOCATION_HOOKS();
+
+	auto stack    = random_records<ChunkedStack<Record>>(1 << 18, 1000);
+	auto expected = stack;
+	sort<Record, ByKey>(expected);
+
+	ExternalSortOptions options;
+	options.memory_budget = 256 << 10;
+	options.read_block    = 16 << 10;
+
+	const std::string path = default_temp_directory() + "/sort-external-" + std::to_string(::getpid());
+
+	const allocation::Stats allocated = allocation::measure([&]
+	{
+		sort_external_to_file<Record, ByKey>(stack, path, options);
+	});
+
+	EXPECT_TRUE(stack.empty());
+	EXPECT_THAT(allocated.peak_bytes, Le(options.memory_budget + (4 << 10)));
+	EXPECT_THAT(read_records(path), Eq(elements(expected)));
+
+	std::remove(path.c_str());
+}
+
+TEST(sort_external, merges_within_the_descriptor_limit)
+{
+	auto stack    = random_records<Stack<Record>>(100000, 1000);
+	auto expected = stack;
+	sort<Record, ByKey>(expected);
+
+	ExternalSortOptions options;
+	options.memory_budget = 16 << 10;
+	options.read_block    = 256;
+
+	std::vector<Record> sorted;
+	ExternalSortStats   stats;
+
+	{
+		const FileLimit limit{32};
+		stats = sort_external_into<Record, ByKey>(stack, std::back_inserter(sorted), options);
+	}
+
+	EXPECT_THAT(stats.runs, Gt(32U));
+	EXPECT_THAT(stats.peak_memory, Le(options.memory_budget));
+	EXPECT_THAT(sorted, Eq(elements(expected)));
+}
+
+TEST(ExternalSorter, small_elements_keep_room_for_the_sort)
+{
+	ExternalSortOptions options;
+	options.memory_budget = 3 << 10;
+
+	ExternalSorter<std::uint8_t, std::less<std::uint8_t>> sorter{options};
+
+	for (int i = 0; i != 20000; ++i)
+	{
+		sorter.push(static_cast<std::uint8_t>(i * 7919));
+	}
+
+	std::vector<std::uint8_t> sorted;
+	sorter.finish([&](const std::uint8_t element) { sorted.push_back(element); });
+
+	EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+	EXPECT_THAT(sorted.size(), Eq(20000U));
+	EXPECT_THAT(sorter.stats().peak_memory, Le(options.memory_budget));
+}
+
+template <typename StackType, StackSort mode>
+void sort_benchmark(benchmark::State& state)
+{
+	std::default_random_engine rnd;
+	std::uniform_int_distribution<> dist;
+
+	StackType input;
+
+	for (auto i = 0; i != state.range(0); ++i)
+	{
+		input.push(dist(rnd));
+	}
+
+	// Counted around the sort only, leaving out the untimed copy.
+	profiling::Counters counters;
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		StackType stack{input};
+		state.ResumeTiming();
+
+		counters.start();
+		sort(stack, mode);
+		benchmark::DoNotOptimize(stack.top());
+		counters.stop();
+	}
+
+	profiling::report(state, counters.read());
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(sort_benchmark, Stack<int>, StackSort::Contiguous)->Range(8, 1 << 20);
+BENCHMARK_TEMPLATE(sort_benchmark, ArrayStack<int>, StackSort::Contiguous)->Range(8, 1 << 20);
+BENCHMARK_TEMPLATE(sort_benchmark, ArrayStack<double>, StackSort::Contiguous)->Range(8, 1 << 20);
+BENCHMARK_TEMPLATE(sort_benchmark, Stack<int>, StackSort::TwoStacks)->Range(8, 1 << 12);
+BENCHMARK_TEMPLATE(sort_benchmark, Stack<double>, StackSort::TwoStacks)->Range(8, 1 << 12);
+
+void sort_external_benchmark(benchmark::State& state)
+{
+	std::default_random_engine rnd;
+	std::uniform_int_distribution<> dist;
+
+	ArrayStack<int> input;
+
+	for (auto i = 0; i != state.range(0); ++i)
+	{
+		input.push(dist(rnd));
+	}
+
+	ExternalSortOptions options;
+	options.memory_budget = static_cast<std::size_t>(state.range(1)) << 10;
+	options.use_mmap      = state.range(2);
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		ArrayStack<int> stack{input};
+		state.ResumeTiming();
+
+		sort_external(stack, options);
+		benchmark::DoNotOptimize(stack.top());
+	}
+
+	state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(int));
+}
+
+BENCHMARK(sort_external_benchmark)
+	->ArgNames({"n", "budget_kib", "mmap"})
+	->ArgsProduct({{1 << 20, 1 << 22}, {256, 4096}, {0, 1}})
+	->Unit(benchmark::kMillisecond);
@@ -0,0 +1,92 @@
+#include "allocation.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+
+TEST(allocation, counts_scope)
+{
+	SKIP_WITHOUT_ALLOCATION_HOOKS();
+
+	const allocation::Scope scope;
+
+	std::unique_ptr<int> a{new int{1}};
+	std::unique_ptr<int[]> b{new int[8]};
+	benchmark::DoNotOptimize(a.get());
+	benchmark::DoNotOptimize(b.get());
+	a.reset();
+
+	const allocation::Stats stats = scope.stats();
+
+	EXPECT_THAT(stats.allocations, Eq(2U));
+	EXPECT_THAT(stats.deallocations, Eq(1U));
+	EXPECT_THAT(stats.bytes, Eq(9 * sizeof(int)));
+	EXPECT_THAT(stats.peak_bytes, Eq(9 * sizeof(int)));
+}
+
+TEST(allocation, peak_is_relative_to_scope)
+{
+	SKIP_WITHOUT_ALLOCATION_HOOKS();
+
+	std::vector<char> before(1000);
+
+	const allocation::Stats outer = allocation::measure([]
+	{
+		std::vector<char>{}.reserve(100);
+
+		const allocation::Stats inner = allocation::measure([]
+		{
+			std::vector<char>{}.reserve(10);
+		});
+
+		EXPECT_THAT(inner.peak_bytes, Eq(10U));
+	});
+
+	// The inner scope must not hide the outer scope's higher peak.
+	EXPECT_THAT(outer.allocations, Eq(2U));
+	EXPECT_THAT(outer.peak_bytes, Eq(100U));
+}
+
+TEST(allocation, per_thread)
+{
+	SKIP_WITHOUT_ALLOCATION_HOOKS();
+
+	std::unique_ptr<int> p;
+	std::thread thread{[&] { p.reset(new int{0}); }};
+
+	// Starting the thread allocates its state here, but the int is
+	// allocated on the other thread.
+	thread.join();
+	EXPECT_NO_ALLOCATIONS(p.reset(); p.reset());
+}
+
+TEST(allocation, no_allocations)
+{
+	std::vector<int> values;
+	values.reserve(16);
+
+	EXPECT_NO_ALLOCATIONS(values.push_back(1); values.push_back(2));
+
+	const allocation::Stats stats = allocation::measure([&] { values.resize(32); });
+	EXPECT_THAT(allocation::allocates_nothing("values.resize(32)", stats).message(),
+	            HasSubstr(allocation::installed() ? "values.resize(32) allocated" : ""));
+}
+
+TEST(allocation, check_runs_statement_and_keeps_going)
+{
+	int runs = 0;
+
+	if (runs == 0)
+		EXPECT_NO_ALLOCATIONS(++runs);
+	else
+		ADD_FAILURE() << "the check bound to the wrong if";
+
+	// Without hooks the check is skipped, but the statement still runs and
+	// the test carries on past it.
+	EXPECT_THAT(runs, Eq(1));
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+
+// Counts heap allocations made through the global operator new. The
+// counting operators live in allocation_hooks.cpp and are only linked in
+// when the build asks for them (COUNT_ALLOCATIONS for runTests in CMake,
+// and always for counting_benchmarks); without them installed() is false
+// and every count stays zero.
+//
+// Counters are per thread: a Scope sees the allocations made by the
+// thread it was created on, not those of other threads running meanwhile.
+namespace allocation
+{
+	struct Counters
+	{
+		std::size_t allocations   = 0;
+		std::size_t deallocations = 0;
+		std::size_t bytes         = 0; // bytes requested by all allocations
+		std::size_t live_bytes    = 0; // bytes allocated and not yet freed
+		std::size_t peak_bytes    = 0; // highest live_bytes since the innermost Scope began
+	};
+
+	inline Counters& counters() noexcept
+	{
+		static thread_local Counters counters;
+		return counters;
+	}
+
+	inline bool& installed() noexcept
+	{
+		static bool installed = false;
+		return installed;
+	}
+
+	struct Stats
+	{
+		std::size_t allocations   = 0;
+		std::size_t deallocations = 0;
+		std::size_t bytes         = 0;
+		std::size_t peak_bytes    = 0; // peak live bytes above what was live when the scope began
+	};
+
+	inline std::ostream& operator<<(std::ostream& os, const Stats& stats)
+	{
+		return os << "Stats(allocations=" << stats.allocations
+		          << ",deallocations=" << stats.deallocations
+		          << ",bytes=" << stats.bytes
+		          << ",peak_bytes=" << stats.peak_bytes << ")";
+	}
+
+	// Measures the allocations of the current thread from construction
+	// until stats() is called. Scopes nest.
+	class Scope
+	{
+	public:
+		Scope() noexcept
+			: start_(counters()), saved_peak_(start_.peak_bytes)
+		{
+			counters().peak_bytes = start_.live_bytes;
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		~Scope()
+		{
+			Counters& now = counters();
+			now.peak_bytes = std::max(now.peak_bytes, saved_peak_);
+		}
+
+		Stats stats() const noexcept
+		{
+			const Counters& now = counters();
+
+			Stats stats;
+			stats.allocations   = now.allocations - start_.allocations;
+			stats.deallocations = now.deallocations - start_.deallocations;
+			stats.bytes         = now.bytes - start_.bytes;
+			stats.peak_bytes    = now.peak_bytes - start_.live_bytes;
+			return stats;
+		}
+
+	private:
+		Counters    start_;
+		std::size_t saved_peak_;
+	};
+
+	// Runs function and returns what it allocated.
+	template <typename Function>
+	Stats measure(Function&& function)
+	{
+		const Scope scope;
+		function();
+		return scope.stats();
+	}
+
+	inline ::testing::AssertionResult allocates_nothing(const char* statement, const Stats& stats)
+	{
+		if (stats.allocations == 0)
+		{
+			return ::testing::AssertionSuccess();
+		}
+
+		return ::testing::AssertionFailure() << statement << " allocated: " << stats;
+	}
+
+	// Notes on the running test that an allocation check was skipped
+	// because the counting hooks are not linked in.
+	inline void record_skipped_check(const char* statement)
+	{
+		::testing::Test::RecordProperty("skipped_allocation_check", statement);
+	}
+
+	// Adds allocs/op and bytes_allocated/op counters to a benchmark, given
+	// the stats of a scope spanning its timing loop. Call it straight after
+	// the loop: setting counters allocates too.
+	inline void report(benchmark::State& state, const Stats& stats)
+	{
+		if (!installed())
+		{
+			return;
+		}
+
+		state.counters["allocs/op"] =
+			benchmark::Counter(stats.allocations, benchmark::Counter::kAvgIterations);
+		state.counters["bytes_allocated/op"] =
+			benchmark::Counter(stats.bytes, benchmark::Counter::kAvgIterations);
+	}
+}
+
+// Check that the statement does not allocate on the current thread. When
+// the counting hooks are not linked in, the statement still runs but its
+// check is skipped and recorded as a test property; the rest of the test
+// goes on either way.
+#define ALLOCATION_CHECK_(check, ...)                                           \
+	do                                                                          \
+	{                                                                           \
+		if (::allocation::installed())                                          \
+			check(::allocation::allocates_nothing(#__VA_ARGS__,                 \
+				::allocation::measure([&] { __VA_ARGS__; })));                  \
+		else                                                                    \
+		{                                                                       \
+			__VA_ARGS__;                                                        \
+			::allocation::record_skipped_check(#__VA_ARGS__);                   \
+		}                                                                       \
+	} while (0)
+
+#define EXPECT_NO_ALLOCATIONS(...) ALLOCATION_CHECK_(EXPECT_TRUE, __VA_ARGS__)
+#define ASSERT_NO_ALLOCATIONS(...) ALLOCATION_CHECK_(ASSERT_TRUE, __VA_ARGS__)
+
+// For tests that inspect allocation::measure() themselves.
+#define SKIP_WITHOUT_ALLOCATION_HOOKS()                                         \
+	if (!::allocation::installed())                                             \
+		GTEST_SKIP() << "allocation hooks are not linked in"
@@ -0,0 +1,85 @@
+#include "allocation.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new and delete with versions that update
+// allocation::counters(). Each block carries a header recording its size
+// so that unsized deletes can account for the bytes they free.
+namespace
+{
+	constexpr std::size_t header = alignof(std::max_align_t);
+
+	void* allocate(const std::size_t size) noexcept
+	{
+		void* block = std::malloc(header + size);
+
+		if (!block)
+		{
+			return nullptr;
+		}
+
+		*static_cast<std::size_t*>(block) = size;
+
+		allocation::Counters& counters = allocation::counters();
+		++counters.allocations;
+		counters.bytes      += size;
+		counters.live_bytes += size;
+		counters.peak_bytes  = std::max(counters.peak_bytes, counters.live_bytes);
+
+		return static_cast<char*>(block) + header;
+	}
+
+	void* allocate_or_throw(const std::size_t size)
+	{
+		for (;;)
+		{
+			if (void* p = allocate(size))
+			{
+				return p;
+			}
+
+			const std::new_handler handler = std::get_new_handler();
+
+			if (!handler)
+			{
+				throw std::bad_alloc{};
+			}
+
+			handler();
+		}
+	}
+
+	void deallocate(void* p) noexcept
+	{
+		if (!p)
+		{
+			return;
+		}
+
+		void* block = static_cast<char*>(p) - header;
+		const std::size_t size = *static_cast<std::size_t*>(block);
+
+		// Memory allocated on one thread may be freed on another, so the
+		// freeing thread's live bytes can dip below zero; clamp instead.
+		allocation::Counters& counters = allocation::counters();
+		++counters.deallocations;
+		counters.live_bytes -= std::min(counters.live_bytes, size);
+
+		std::free(block);
+	}
+
+	const bool installed = allocation::installed() = true;
+}
+
+void* operator new(const std::size_t size)                                  { return allocate_or_throw(size); }
+void* operator new[](const std::size_t size)                                { return allocate_or_throw(size); }
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept   { return allocate(size); }
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* p) noexcept                                       { deallocate(p); }
+void operator delete[](void* p) noexcept                                     { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept                          { deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept                        { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept                { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept              { deallocate(p); }
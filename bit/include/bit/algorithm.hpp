@@ -0,0 +1,70 @@
+#pragma once
+
+#include "bit/span.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+// count, find, fill, copy and equal for bit iterators, running a word at
+// a time with masks at the edges instead of a bit at a time through
+// proxies, the way libc++ specializes them for vector<bool>.
+//
+// The standard library may not be overloaded, so these are found by
+// argument-dependent lookup: generic code that calls the algorithms
+// unqualified after `using std::count;` (and so on) gets the word-level
+// versions for bit iterators and the standard ones for everything else.
+// Each takes the same arguments and returns the same result as its
+// standard counterpart.
+namespace bit
+{
+  namespace detail
+  {
+    template <typename Word>
+    inline
+    span<Word> as_span(const span_iterator<Word> first, const span_iterator<Word> last) noexcept
+    {
+      return span<Word>{first.word(), first.bit(), static_cast<std::size_t>(last - first)};
+    }
+  }
+
+  template <typename Word, typename T>
+  inline
+  typename span_iterator<Word>::difference_type
+  count(const span_iterator<Word> first, const span_iterator<Word> last, const T& value) noexcept
+  {
+    const std::size_t ones = bit::count(detail::as_span(first, last));
+    return static_cast<bool>(value) ? ones : (last - first) - ones;
+  }
+
+  template <typename Word, typename T>
+  inline
+  span_iterator<Word> find(const span_iterator<Word> first, const span_iterator<Word> last, const T& value) noexcept
+  {
+    return first + bit::find(detail::as_span(first, last), static_cast<bool>(value));
+  }
+
+  template <typename Word, typename T>
+  inline
+  void fill(const span_iterator<Word> first, const span_iterator<Word> last, const T& value) noexcept
+  {
+    bit::fill(detail::as_span(first, last), static_cast<bool>(value));
+  }
+
+  template <typename From, typename To>
+  inline
+  span_iterator<To> copy(const span_iterator<From> first, const span_iterator<From> last,
+                         const span_iterator<To> d_first) noexcept
+  {
+    const span<From> from = detail::as_span(first, last);
+    bit::copy(from, span<To>{d_first.word(), d_first.bit(), from.size()});
+    return d_first + from.size();
+  }
+
+  template <typename A, typename B>
+  inline
+  bool equal(const span_iterator<A> first1, const span_iterator<A> last1, const span_iterator<B> first2) noexcept
+  {
+    const span<A> a = detail::as_span(first1, last1);
+    return bit::equal(a, span<B>{first2.word(), first2.bit(), a.size()});
+  }
+}
@@ -0,0 +1,693 @@
+#pragma once
+
+#include "bit/tables.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// count and reverse are built either from the byte tables in tables.hpp
+// (the default) or from compiler builtins, picked at build time with
+// BIT_USE_INTRINSICS so the two can be benchmarked against each other;
+// which is faster depends on the instruction set. The bit scans and
+// byteswap always use the GCC and Clang builtins when there are any: they
+// are constexpr, need no -m flags, and beat the loops everywhere.
+#if !defined(BIT_USE_INTRINSICS)
+#define BIT_USE_INTRINSICS 0
+#endif
+
+#if BIT_USE_INTRINSICS && !defined(__GNUC__)
+#error "BIT_USE_INTRINSICS needs the GCC or Clang builtins"
+#endif
+
+namespace bit
+{
+  // Number of value bits in T, not counting the sign bit. Unsigned, as
+  // width(value) is, so loops over bit positions compare without a sign
+  // mismatch whatever T is.
+  template <typename T>
+  inline constexpr
+  unsigned int width() noexcept
+  {
+    return static_cast<unsigned int>(std::numeric_limits<T>::digits);
+  }
+
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef __int128          int128_t;
+  __extension__ typedef unsigned __int128 uint128_t;
+#endif
+
+  namespace detail
+  {
+    // The unsigned type with the bits of T, 128-bit integers included,
+    // which strict ISO modes leave out of std::make_unsigned.
+    template <typename T>
+    struct unsigned_of
+    {
+      using type = std::make_unsigned_t<T>;
+    };
+
+#if defined(__SIZEOF_INT128__)
+    template <> struct unsigned_of<int128_t>  { using type = uint128_t; };
+    template <> struct unsigned_of<uint128_t> { using type = uint128_t; };
+#endif
+
+    template <typename T>
+    using unsigned_t = typename unsigned_of<T>::type;
+
+    // Every bit of T, the sign bit included.
+    template <typename T>
+    inline constexpr
+    unsigned int bits_of() noexcept
+    {
+      return 8 * sizeof(T);
+    }
+
+    template <std::size_t Bytes>
+    using size_tag = std::integral_constant<std::size_t, (Bytes <= 4 ? 4 : Bytes)>;
+
+#if defined(__GNUC__)
+    template <typename U>
+    inline constexpr
+    unsigned int builtin_countl_zero(const U bits, size_tag<4>) noexcept
+    {
+      return bits == 0 ? bits_of<U>() : __builtin_clz(bits) - (32 - bits_of<U>());
+    }
+
+    template <typename U>
+    inline constexpr
+    unsigned int builtin_countl_zero(const U bits, size_tag<8>) noexcept
+    {
+      return bits == 0 ? 64 : __builtin_clzll(bits);
+    }
+
+    template <typename U>
+    inline constexpr
+    unsigned int builtin_countl_zero(const U bits, size_tag<16>) noexcept
+    {
+      const std::uint64_t high = static_cast<std::uint64_t>(bits >> 64);
+      return high != 0 ? __builtin_clzll(high) : 64 + builtin_countl_zero(static_cast<std::uint64_t>(bits), size_tag<8>{});
+    }
+
+    template <typename U>
+    inline constexpr
+    unsigned int builtin_countr_zero(const U bits, size_tag<4>) noexcept
+    {
+      return bits == 0 ? bits_of<U>() : __builtin_ctz(bits);
+    }
+
+    template <typename U>
+    inline constexpr
+    unsigned int builtin_countr_zero(const U bits, size_tag<8>) noexcept
+    {
+      return bits == 0 ? 64 : __builtin_ctzll(bits);
+    }
+
+    template <typename U>
+    inline constexpr
+    unsigned int builtin_countr_zero(const U bits, size_tag<16>) noexcept
+    {
+      const std::uint64_t low = static_cast<std::uint64_t>(bits);
+      return low != 0 ? __builtin_ctzll(low) : 64 + builtin_countr_zero(static_cast<std::uint64_t>(bits >> 64), size_tag<8>{});
+    }
+
+    inline constexpr std::uint8_t  builtin_byteswap(const std::uint8_t  bits) noexcept { return bits; }
+    inline constexpr std::uint16_t builtin_byteswap(const std::uint16_t bits) noexcept { return __builtin_bswap16(bits); }
+    inline constexpr std::uint32_t builtin_byteswap(const std::uint32_t bits) noexcept { return __builtin_bswap32(bits); }
+    inline constexpr std::uint64_t builtin_byteswap(const std::uint64_t bits) noexcept { return __builtin_bswap64(bits); }
+
+    template <typename U>
+    inline constexpr
+    U builtin_byteswap(const U bits) noexcept
+    {
+      // 128 bits, or a 64-bit type other than std::uint64_t.
+      return sizeof(U) == 8 ? static_cast<U>(__builtin_bswap64(static_cast<std::uint64_t>(bits))) :
+             static_cast<U>((static_cast<U>(__builtin_bswap64(static_cast<std::uint64_t>(bits))) << 32 << 32) |
+                            __builtin_bswap64(static_cast<std::uint64_t>(bits >> 32 >> 32)));
+    }
+#endif
+  }
+
+  // Number of zero bits above the highest set bit of value, counted over
+  // every bit of T (the sign bit too); all of them for zero.
+  template <typename T>
+  inline constexpr
+  unsigned int countl_zero(const T value) noexcept
+  {
+    using U = detail::unsigned_t<T>;
+    const U bits = static_cast<U>(value);
+
+#if defined(__GNUC__)
+    return detail::builtin_countl_zero(bits, detail::size_tag<sizeof(U)>{});
+#else
+    // Halve the word until one byte is left, a fixed number of steps for
+    // each width.
+    U            rest = bits;
+    unsigned int high = 0;
+
+    for (unsigned int half = detail::bits_of<U>() / 2; half >= 8; half /= 2)
+    {
+      const U upper = static_cast<U>(rest >> half);
+
+      if (upper != 0)
+      {
+        rest  = upper;
+        high += half;
+      }
+    }
+
+    return detail::bits_of<U>() - high - (8 - tables::bytes::leading_zeros[static_cast<std::uint8_t>(rest)]);
+#endif
+  }
+
+  // Number of zero bits below the lowest set bit of value; every bit of
+  // T for zero.
+  template <typename T>
+  inline constexpr
+  unsigned int countr_zero(const T value) noexcept
+  {
+    using U = detail::unsigned_t<T>;
+    const U bits = static_cast<U>(value);
+
+#if defined(__GNUC__)
+    return detail::builtin_countr_zero(bits, detail::size_tag<sizeof(U)>{});
+#else
+    U            rest = bits;
+    unsigned int low  = 0;
+
+    for (unsigned int half = detail::bits_of<U>() / 2; half >= 8; half /= 2)
+    {
+      if (static_cast<U>(rest << (detail::bits_of<U>() - half)) == 0)
+      {
+        rest = static_cast<U>(rest >> half);
+        low += half;
+      }
+    }
+
+    return low + tables::bytes::trailing_zeros[static_cast<std::uint8_t>(rest)];
+#endif
+  }
+
+  // Number of bits needed to hold value: one past its highest set bit.
+  // Signed values are taken as their two's complement bit pattern.
+  template <typename T>
+  inline constexpr
+  unsigned int bit_width(const T value) noexcept
+  {
+    return detail::bits_of<detail::unsigned_t<T>>() - countl_zero(value);
+  }
+
+  template <typename T>
+  inline constexpr
+  unsigned int width(const T value) noexcept
+  {
+    return bit_width(value);
+  }
+
+  // Largest n with 2^n <= value, for value > 0.
+  template <typename T>
+  inline constexpr
+  unsigned int floor_log2(const T value) noexcept
+  {
+    return bit_width(value) - 1;
+  }
+
+  // Smallest n with 2^n >= value, for value > 0.
+  template <typename T>
+  inline constexpr
+  unsigned int ceil_log2(const T value) noexcept
+  {
+    using U = detail::unsigned_t<T>;
+    return static_cast<U>(value) <= 1 ? 0 : bit_width(static_cast<U>(static_cast<U>(value) - 1));
+  }
+
+  // Smallest power of two not below value; 1 for 0. The result must fit
+  // in T.
+  template <typename T>
+  inline constexpr
+  T next_power_of_two(const T value) noexcept
+  {
+    using U = detail::unsigned_t<T>;
+    return static_cast<T>(static_cast<U>(U{1} << ceil_log2(value)));
+  }
+
+  // value rotated left by shift bits over every bit of T; a negative
+  // shift rotates right.
+  template <typename T>
+  inline constexpr
+  T rotl(const T value, const int shift) noexcept
+  {
+    using U = detail::unsigned_t<T>;
+    constexpr int bits = detail::bits_of<U>();
+
+    const U   word = static_cast<U>(value);
+    const int r    = (shift % bits + bits) % bits;
+
+    return r == 0 ? value : static_cast<T>(static_cast<U>(static_cast<U>(word << r) | static_cast<U>(word >> (bits - r))));
+  }
+
+  template <typename T>
+  inline constexpr
+  T rotr(const T value, const int shift) noexcept
+  {
+    return rotl(value, -(shift % static_cast<int>(detail::bits_of<T>())));
+  }
+
+  // value with the order of its bytes reversed.
+  template <typename T>
+  inline constexpr
+  T byteswap(const T value) noexcept
+  {
+    using U = detail::unsigned_t<T>;
+    U bits = static_cast<U>(value);
+
+#if defined(__GNUC__)
+    return static_cast<T>(detail::builtin_byteswap(bits));
+#else
+    U swapped = 0;
+
+    for (std::size_t byte = 0; byte != sizeof(U); ++byte)
+    {
+      swapped = static_cast<U>(static_cast<U>(swapped << 8) | static_cast<std::uint8_t>(bits));
+      bits    = static_cast<U>(bits >> 4 >> 4);
+    }
+
+    return static_cast<T>(swapped);
+#endif
+  }
+
+  namespace detail
+  {
+    // Index of the lowest set bit of a nonzero unsigned word.
+    template <typename U>
+    inline constexpr
+    unsigned int lowest_set(const U bits) noexcept
+    {
+      return countr_zero(bits);
+    }
+  }
+
+  // Bits start .. end inclusive, end < width of the unsigned counterpart
+  // of T.
+  template <typename T>
+  inline constexpr
+  T mask(const unsigned int start, const unsigned int end) noexcept
+  {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(static_cast<U>(static_cast<U>(~U{0}) >> (std::numeric_limits<U>::digits - 1 - (end - start))) << start);
+  }
+
+  // Bits 0, 2, 4, ... of every integral type, the sign bit included.
+  template <typename T>
+  inline constexpr
+  T odd_pattern() noexcept
+  {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(static_cast<U>(~U{0}) / 3);
+  }
+
+  // Bits 1, 3, 5, ...
+  template <typename T>
+  inline constexpr
+  T even_pattern() noexcept
+  {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(static_cast<U>(static_cast<U>(odd_pattern<T>()) << 1));
+  }
+
+  // A reference to bit index of data. Bits are tested and set on the
+  // unsigned counterpart of T, so every index below its full width works.
+  template <typename T>
+  class proxy
+  {
+  public:
+    using word_type = std::make_unsigned_t<T>;
+
+    constexpr proxy(T& data, unsigned int index) noexcept
+      : data_(data), index_(index) {}
+
+    constexpr proxy(const proxy&) noexcept = default;
+
+    constexpr operator bool() const noexcept
+    {
+      return static_cast<word_type>(data_.get()) & bit();
+    }
+
+    constexpr proxy& operator=(const bool bit) noexcept
+    {
+      const word_type word = static_cast<word_type>(data_.get());
+      data_.get() = static_cast<T>(bit ? (word | this->bit()) : (word & ~this->bit()));
+      return *this;
+    }
+
+    // Assigns the bit, not the reference, so that algorithms moving
+    // values through proxies (std::copy, std::swap) move bits.
+    constexpr proxy& operator=(const proxy& other) noexcept
+    {
+      return *this = static_cast<bool>(other);
+    }
+
+    constexpr void flip() noexcept
+    {
+      data_.get() = static_cast<T>(static_cast<word_type>(data_.get()) ^ bit());
+    }
+
+    friend void swap(proxy a, proxy b) noexcept
+    {
+      const bool bit = a;
+      a = static_cast<bool>(b);
+      b = bit;
+    }
+
+  private:
+    constexpr word_type bit() const noexcept
+    {
+      return static_cast<word_type>(word_type{1} << index_);
+    }
+
+    std::reference_wrapper<T> data_;
+    unsigned int              index_;
+  };
+
+  template <typename T>
+  class const_proxy
+  {
+  public:
+    using word_type = std::make_unsigned_t<T>;
+
+    constexpr const_proxy(const T& data, unsigned int index) noexcept
+      : data_(data), index_(index) {}
+
+    constexpr operator bool() const noexcept
+    {
+      return static_cast<word_type>(data_.get()) & static_cast<word_type>(word_type{1} << index_);
+    }
+
+  private:
+    std::reference_wrapper<const T> data_;
+    unsigned int                    index_;
+  };
+
+  // Iterators over the bits of an array of unsigned words, least
+  // significant bit of words[0] first. They keep a pointer to the word
+  // holding the current bit and the bit's index there, so they stay valid
+  // across word boundaries and the algorithms in algorithm.hpp can work a
+  // word at a time.
+  template <typename Word>
+  class span_iterator
+  {
+  public:
+    using word_type         = std::remove_const_t<Word>;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = bool;
+    using pointer           = void;
+    using reference         = std::conditional_t<std::is_const<Word>::value, const_proxy<word_type>, proxy<word_type>>;
+    using iterator_category = std::random_access_iterator_tag;
+
+    static constexpr std::size_t word_bits = std::numeric_limits<word_type>::digits;
+
+    constexpr span_iterator() noexcept = default;
+
+    // Bit index counted from the least significant bit of words[0].
+    constexpr span_iterator(Word* words, const std::size_t index) noexcept
+      : word_(words + index / word_bits), bit_(static_cast<unsigned int>(index % word_bits)) {}
+
+    // A mutable iterator converts to a const one.
+    template <typename Other,
+              typename = std::enable_if_t<std::is_convertible<Other*, Word*>::value>>
+    constexpr span_iterator(const span_iterator<Other>& other) noexcept
+      : word_(other.word()), bit_(other.bit()) {}
+
+    // The word holding the bit and its index there, for algorithms that
+    // work a word at a time.
+    constexpr Word* word() const noexcept { return word_; }
+    constexpr unsigned int bit() const noexcept { return bit_; }
+
+    constexpr reference operator*() const noexcept
+    {
+      return reference{*word_, bit_};
+    }
+
+    constexpr reference operator[](const difference_type n) const noexcept
+    {
+      return *(*this + n);
+    }
+
+    constexpr span_iterator& operator++() noexcept
+    {
+      if (++bit_ == word_bits)
+      {
+        bit_ = 0;
+        ++word_;
+      }
+
+      return *this;
+    }
+
+    constexpr span_iterator& operator--() noexcept
+    {
+      if (bit_-- == 0)
+      {
+        bit_ = word_bits - 1;
+        --word_;
+      }
+
+      return *this;
+    }
+
+    constexpr span_iterator operator++(const int) noexcept { span_iterator i{*this}; ++*this; return i; }
+    constexpr span_iterator operator--(const int) noexcept { span_iterator i{*this}; --*this; return i; }
+
+    constexpr span_iterator& operator+=(const difference_type n) noexcept
+    {
+      const difference_type index = static_cast<difference_type>(bit_) + n;
+      const difference_type words = (index >= 0 ? index : index - difference_type(word_bits) + 1) / difference_type(word_bits);
+
+      word_ += words;
+      bit_   = static_cast<unsigned int>(index - words * difference_type(word_bits));
+      return *this;
+    }
+
+    constexpr span_iterator& operator-=(const difference_type n) noexcept { return *this += -n; }
+
+    friend constexpr span_iterator operator+(span_iterator i, const difference_type n) noexcept { return i += n; }
+    friend constexpr span_iterator operator+(const difference_type n, span_iterator i) noexcept { return i += n; }
+    friend constexpr span_iterator operator-(span_iterator i, const difference_type n) noexcept { return i -= n; }
+
+    friend constexpr difference_type operator-(const span_iterator& a, const span_iterator& b) noexcept
+    {
+      return (a.word_ - b.word_) * difference_type(word_bits) + difference_type(a.bit_) - difference_type(b.bit_);
+    }
+
+    friend constexpr bool operator==(const span_iterator& a, const span_iterator& b) noexcept
+    {
+      return a.word_ == b.word_ && a.bit_ == b.bit_;
+    }
+
+    friend constexpr bool operator!=(const span_iterator& a, const span_iterator& b) noexcept { return !(a == b); }
+    friend constexpr bool operator< (const span_iterator& a, const span_iterator& b) noexcept { return a - b < 0; }
+    friend constexpr bool operator> (const span_iterator& a, const span_iterator& b) noexcept { return b < a; }
+    friend constexpr bool operator<=(const span_iterator& a, const span_iterator& b) noexcept { return !(b < a); }
+    friend constexpr bool operator>=(const span_iterator& a, const span_iterator& b) noexcept { return !(a < b); }
+
+  private:
+    Word*        word_ = nullptr;
+    unsigned int bit_  = 0;
+  };
+
+  template <typename Word>
+  constexpr std::size_t span_iterator<Word>::word_bits;
+
+  // The bits of one integer. A signed T is addressed through its unsigned
+  // counterpart, which may alias it.
+  template <typename T> using iterator               = span_iterator<std::make_unsigned_t<T>>;
+  template <typename T> using const_iterator         = span_iterator<const std::make_unsigned_t<T>>;
+  template <typename T> using reverse_iterator       = std::reverse_iterator<iterator<T>>;
+  template <typename T> using const_reverse_iterator = std::reverse_iterator<const_iterator<T>>;
+
+  namespace detail
+  {
+    template <typename T>
+    inline
+    std::make_unsigned_t<T>* words_of(T& data) noexcept
+    {
+      return reinterpret_cast<std::make_unsigned_t<T>*>(std::addressof(data));
+    }
+
+    template <typename T>
+    inline
+    const std::make_unsigned_t<T>* words_of(const T& data) noexcept
+    {
+      return reinterpret_cast<const std::make_unsigned_t<T>*>(std::addressof(data));
+    }
+  }
+
+  template <typename T> inline auto begin  (      T& data) { return iterator<T>{detail::words_of(data), 0};                 }
+  template <typename T> inline auto begin  (const T& data) { return const_iterator<T>{detail::words_of(data), 0};           }
+  template <typename T> inline auto cbegin (const T& data) { return const_iterator<T>{detail::words_of(data), 0};           }
+  template <typename T> inline auto end    (      T& data) { return iterator<T>{detail::words_of(data), width<T>()};        }
+  template <typename T> inline auto end    (const T& data) { return const_iterator<T>{detail::words_of(data), width<T>()};  }
+  template <typename T> inline auto cend   (const T& data) { return const_iterator<T>{detail::words_of(data), width<T>()};  }
+  template <typename T> inline auto rbegin (      T& data) { return reverse_iterator<T>{bit::end(data)};                    }
+  template <typename T> inline auto rbegin (const T& data) { return const_reverse_iterator<T>{bit::cend(data)};             }
+  template <typename T> inline auto crbegin(const T& data) { return const_reverse_iterator<T>{bit::cend(data)};             }
+  template <typename T> inline auto rend   (      T& data) { return reverse_iterator<T>{bit::begin(data)};                  }
+  template <typename T> inline auto rend   (const T& data) { return const_reverse_iterator<T>{bit::cbegin(data)};           }
+  template <typename T> inline auto crend  (const T& data) { return const_reverse_iterator<T>{bit::cbegin(data)};           }
+
+  template <typename T>
+  class const_range
+  {
+  public:
+    constexpr const_range(const T& data) noexcept : data_(data) {}
+
+    constexpr auto begin()   const noexcept { return bit::cbegin(data_.get());  }
+    constexpr auto cbegin()  const noexcept { return bit::cbegin(data_.get());  }
+
+    constexpr auto end()     const noexcept { return bit::cend(data_.get());    }
+    constexpr auto cend()    const noexcept { return bit::cend(data_.get());    }
+
+    constexpr auto rbegin()  const noexcept { return bit::crbegin(data_.get()); }
+    constexpr auto crbegin() const noexcept { return bit::crbegin(data_.get()); }
+
+    constexpr auto rend()    const noexcept { return bit::crend(data_.get());   }
+    constexpr auto crend()   const noexcept { return bit::crend(data_.get());   }
+
+  protected:
+    std::reference_wrapper<const T> data_;
+  };
+
+  template <typename T>
+  class const_reverse_range
+  {
+  public:
+    constexpr const_reverse_range(const T& data) noexcept : data_(data) {}
+
+    constexpr auto begin()   const noexcept { return bit::crbegin(data_.get()); }
+    constexpr auto cbegin()  const noexcept { return bit::crbegin(data_.get()); }
+
+    constexpr auto end()     const noexcept { return bit::crend(data_.get());   }
+    constexpr auto cend()    const noexcept { return bit::crend(data_.get());   }
+
+    constexpr auto rbegin()  const noexcept { return bit::cbegin(data_.get());  }
+    constexpr auto crbegin() const noexcept { return bit::cbegin(data_.get());  }
+
+    constexpr auto rend()    const noexcept { return bit::cend(data_.get());    }
+    constexpr auto crend()   const noexcept { return bit::cend(data_.get());    }
+
+  protected:
+    std::reference_wrapper<const T> data_;
+  };
+
+  template <typename T>
+  class range : public const_range<const T>
+  {
+  public:
+    constexpr range(T& data) noexcept : const_range<const T>(data) {}
+
+    constexpr auto begin()  noexcept { return bit::begin (const_cast<T&>(const_range<const T>::data_.get())); }
+    constexpr auto end()    noexcept { return bit::end   (const_cast<T&>(const_range<const T>::data_.get())); }
+    constexpr auto rbegin() noexcept { return bit::rbegin(const_cast<T&>(const_range<const T>::data_.get())); }
+    constexpr auto rend()   noexcept { return bit::rend  (const_cast<T&>(const_range<const T>::data_.get())); }
+  };
+
+  template <typename T>
+  class reverse_range : public const_reverse_range<const T>
+  {
+  public:
+    constexpr reverse_range(T& data) noexcept : const_reverse_range<const T>(data) {}
+
+    constexpr auto begin()  noexcept { return bit::rbegin(const_cast<T&>(const_reverse_range<const T>::data_.get())); }
+    constexpr auto end()    noexcept { return bit::rend  (const_cast<T&>(const_reverse_range<const T>::data_.get())); }
+    constexpr auto rbegin() noexcept { return bit::begin (const_cast<T&>(const_reverse_range<const T>::data_.get())); }
+    constexpr auto rend()   noexcept { return bit::end   (const_cast<T&>(const_reverse_range<const T>::data_.get())); }
+  };
+
+  template <typename T>
+  inline constexpr
+  auto make_range(T& data) noexcept
+  {
+    return range<T>(data);
+  }
+
+  template <typename T>
+  inline constexpr
+  auto make_range(const T& data) noexcept
+  {
+    return const_range<T>{data};
+  }
+
+  template <typename T>
+  inline constexpr
+  auto make_reverse_range(T& data) noexcept
+  {
+    return reverse_range<T>{data};
+  }
+
+  template <typename T>
+  inline constexpr
+  auto make_reverse_range(const T& data) noexcept
+  {
+    return const_reverse_range<T>{data};
+  }
+
+  // Number of set bits in data, the sign bit included.
+  template <typename T>
+  inline constexpr
+  std::enable_if_t<std::is_integral<T>::value, unsigned int> count(const T data) noexcept
+  {
+    using U = std::make_unsigned_t<T>;
+    const U bits = static_cast<U>(data);
+
+#if BIT_USE_INTRINSICS
+    return sizeof(U) <= sizeof(unsigned int) ? __builtin_popcount(bits) : __builtin_popcountll(bits);
+#else
+    unsigned int n = 0;
+
+    for (std::size_t byte = 0; byte != sizeof(U); ++byte)
+    {
+      n += tables::bytes::popcount[static_cast<std::uint8_t>(bits >> (8 * byte))];
+    }
+
+    return n;
+#endif
+  }
+
+  // data with the order of all its bits reversed.
+  template <typename T>
+  inline constexpr
+  T reverse(const T data) noexcept
+  {
+    using U = std::make_unsigned_t<T>;
+    U bits = static_cast<U>(data);
+
+#if BIT_USE_INTRINSICS
+    // Reverse the bits of every byte, then the bytes.
+    const U ones = static_cast<U>(~U{0});
+    bits = static_cast<U>(((bits >> 1) & (ones / 3))  | ((bits & (ones / 3))  << 1));
+    bits = static_cast<U>(((bits >> 2) & (ones / 5))  | ((bits & (ones / 5))  << 2));
+    bits = static_cast<U>(((bits >> 4) & (ones / 17)) | ((bits & (ones / 17)) << 4));
+
+    return static_cast<T>(sizeof(U) == 1 ? bits :
+                          sizeof(U) == 2 ? __builtin_bswap16(static_cast<std::uint16_t>(bits)) :
+                          sizeof(U) == 4 ? __builtin_bswap32(static_cast<std::uint32_t>(bits)) :
+                                           __builtin_bswap64(static_cast<std::uint64_t>(bits)));
+#else
+    U reversed = 0;
+
+    for (std::size_t byte = 0; byte != sizeof(U); ++byte)
+    {
+      reversed = static_cast<U>(reversed << 8);
+      reversed |= tables::bytes::reverse[static_cast<std::uint8_t>(bits >> (8 * byte))];
+    }
+
+    return static_cast<T>(reversed);
+#endif
+  }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bulk bit kernels over arrays of words, compiled once per
+// instruction set and dispatched at run time. The best level the CPU
+// supports is picked the first time any kernel runs; select() overrides
+// it, which is how tests compare the levels against each other and how
+// benchmarks measure each one on the same machine.
+namespace bit
+{
+  namespace kernels
+  {
+    enum class isa
+    {
+      generic, // portable C++
+      sse42,   // POPCNT and SSE4.2
+      avx2,    // AVX2 and BMI2 (Haswell, Zen)
+      avx512   // AVX-512 F and VPOPCNTDQ (Ice Lake, Zen 4)
+    };
+
+    constexpr isa all_isas[] = {isa::generic, isa::sse42, isa::avx2, isa::avx512};
+
+    const char* name(isa level) noexcept;
+
+    // True if this CPU can run the kernels built for level.
+    bool supported(isa level) noexcept;
+
+    // The level the kernels currently run at.
+    isa selected() noexcept;
+
+    // Runs the kernels at level from now on, for every thread. Throws
+    // std::invalid_argument if the CPU does not support it.
+    void select(isa level);
+
+    // Number of set bits in words[0, n).
+    std::uint64_t count(const std::uint64_t* words, std::size_t n) noexcept;
+
+    // Number of bits that differ between a[0, n) and b[0, n).
+    std::uint64_t hamming_distance(const std::uint64_t* a, const std::uint64_t* b, std::size_t n) noexcept;
+
+    // out[i] = the bits of words[i] selected by mask, packed into the low
+    // bits (PEXT).
+    void extract(const std::uint64_t* words, std::size_t n, std::uint64_t mask, std::uint64_t* out) noexcept;
+
+    // out[i] = the low bits of words[i] scattered to the positions set in
+    // mask (PDEP).
+    void deposit(const std::uint64_t* words, std::size_t n, std::uint64_t mask, std::uint64_t* out) noexcept;
+
+    // out[i] = bit::bit_width(values[i]), the number of bits needed to
+    // hold it, so floor(log2) + 1 and 0 for zero: a bucket index for
+    // log-scale histograms and size classes.
+    void bit_width(const std::uint32_t* values, std::size_t n, std::uint8_t* out) noexcept;
+    void bit_width(const std::uint64_t* values, std::size_t n, std::uint8_t* out) noexcept;
+
+    // Transposes each of the n 64x64 bit matrices in matrices[0, 64 * n)
+    // in place, as bit::transpose64 does one.
+    void transpose64(std::uint64_t* matrices, std::size_t n) noexcept;
+
+    // The vertical bit-packed layout of Lemire and Boytsov's SIMD-BP128:
+    // each block of 128 values is four interleaved lanes, value i in lane
+    // i % 4, and each lane packs its 32 values width bits apiece, so a
+    // block takes 4 * width words and word w of lane l is word 4 * w + l.
+    // pack128 packs blocks[0, n) of values (width 0 to 32; only the low
+    // width bits of each value are kept); unpack128 reverses it.
+    void pack128(const std::uint32_t* values, std::size_t blocks, unsigned int width, std::uint32_t* out) noexcept;
+    void unpack128(const std::uint32_t* packed, std::size_t blocks, unsigned int width, std::uint32_t* out) noexcept;
+
+    // Writes the values common to the strictly increasing arrays a[0, na)
+    // and b[0, nb) to out, in order, and returns how many there are. out
+    // overlaps neither input and has room for min(na, nb) + 8 values: the
+    // SIMD levels store eight at a time.
+    std::size_t intersect16(const std::uint16_t* a, std::size_t na, const std::uint16_t* b, std::size_t nb,
+                            std::uint16_t* out) noexcept;
+
+    // Batched blocked Bloom filter probes over nblocks 64-byte blocks of
+    // eight words at blocks, laid out as bit::bloom describes. Keys go
+    // bloom_group at a time: the group is hashed and all its blocks
+    // prefetched before the first is probed, so their misses overlap.
+    // bloom_insert adds keys[0, n); bloom_query sets out[i] to whether
+    // keys[i] may be present and returns how many may be.
+    constexpr std::size_t bloom_group = 16;
+
+    void bloom_insert(std::uint64_t* blocks, std::size_t nblocks, const std::uint64_t* keys, std::size_t n) noexcept;
+    std::size_t bloom_query(const std::uint64_t* blocks, std::size_t nblocks, const std::uint64_t* keys,
+                            std::size_t n, std::uint8_t* out) noexcept;
+  }
+}
@@ -0,0 +1,509 @@
+#pragma once
+
+#include "bit/bit.hpp"
+#include "bit/kernels.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Bit packing of unsigned integers that fit in fewer bits than their
+// type: n values of width bits take n * width bits instead of n words.
+//
+// The horizontal layout writes value i at bit i * width of a stream of
+// words of the value's own type, least significant bit first, so a value
+// may straddle two words; any element can be read in place with get().
+// The vertical layout (pack_vertical) is SIMD-BP128's, for 32-bit values
+// in blocks of 128, and unpacks four values per instruction.
+//
+// Frame of reference and delta coding in front of either narrow the
+// values first: subtracting the smallest value, or each value's
+// predecessor for sorted input.
+namespace bit
+{
+  namespace packing
+  {
+    template <typename T>
+    using enable_if_word = std::enable_if_t<std::is_same<T, std::uint32_t>::value ||
+                                            std::is_same<T, std::uint64_t>::value>;
+
+    // Words of T holding n values of width bits.
+    template <typename T, typename = enable_if_word<T>>
+    inline constexpr
+    std::size_t words(const std::size_t n, const unsigned int width) noexcept
+    {
+      return (n * width + std::numeric_limits<T>::digits - 1) / std::numeric_limits<T>::digits;
+    }
+
+    // The narrowest width that holds every one of values[0, n).
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    unsigned int required_width(const T* values, const std::size_t n) noexcept
+    {
+      T any = 0;
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        any |= values[i];
+      }
+
+      return bit_width(any);
+    }
+
+    namespace detail
+    {
+      template <typename T, unsigned int Width>
+      constexpr T low_bits = Width == std::numeric_limits<T>::digits ? static_cast<T>(~T{0})
+                                                                      : static_cast<T>((T{1} << Width) - 1);
+
+      // count values, fewer than a full group.
+      template <typename T, unsigned int Width>
+      inline
+      void pack_group(const T* values, const std::size_t count, T* out) noexcept
+      {
+        constexpr unsigned int bits = std::numeric_limits<T>::digits;
+
+        T            word = 0;
+        unsigned int used = 0;
+
+        for (std::size_t i = 0; i != count; ++i)
+        {
+          const T value = values[i] & low_bits<T, Width>;
+
+          word |= static_cast<T>(value << used);
+          used += Width;
+
+          if (used >= bits)
+          {
+            *out++ = word;
+            used  -= bits;
+            word   = used != 0 ? static_cast<T>(value >> (Width - used)) : T{0};
+          }
+        }
+
+        if (used != 0)
+        {
+          *out = word;
+        }
+      }
+
+      template <typename T, unsigned int Width>
+      inline
+      void unpack_group(const T* packed, const std::size_t count, T* out) noexcept
+      {
+        constexpr unsigned int bits = std::numeric_limits<T>::digits;
+
+        unsigned int used = 0;
+
+        for (std::size_t i = 0; i != count; ++i)
+        {
+          T value = static_cast<T>(*packed >> used);
+          used += Width;
+
+          if (used >= bits)
+          {
+            ++packed;
+            used -= bits;
+
+            if (used != 0)
+            {
+              value |= static_cast<T>(*packed << (Width - used));
+            }
+          }
+
+          out[i] = value & low_bits<T, Width>;
+        }
+      }
+
+      // Value I of a full group: its word and shift are constants, so a
+      // group unpacks as straight-line code with no loop or branch.
+      template <typename T, unsigned int Width, std::size_t I>
+      inline
+      T extract(const T* packed) noexcept
+      {
+        constexpr unsigned int bits  = std::numeric_limits<T>::digits;
+        constexpr std::size_t  word  = I * Width / bits;
+        constexpr unsigned int shift = I * Width % bits;
+
+        T value = static_cast<T>(packed[word] >> shift);
+
+        if (shift + Width > bits)
+        {
+          value |= static_cast<T>(packed[word + 1] << ((bits - shift) % bits));
+        }
+
+        return value & low_bits<T, Width>;
+      }
+
+      template <typename T, unsigned int Width, std::size_t I>
+      inline
+      void insert(const T value, T* out) noexcept
+      {
+        constexpr unsigned int bits  = std::numeric_limits<T>::digits;
+        constexpr std::size_t  word  = I * Width / bits;
+        constexpr unsigned int shift = I * Width % bits;
+
+        out[word] |= static_cast<T>((value & low_bits<T, Width>) << shift);
+
+        if (shift + Width > bits)
+        {
+          out[word + 1] |= static_cast<T>((value & low_bits<T, Width>) >> ((bits - shift) % bits));
+        }
+      }
+
+      template <typename T, unsigned int Width, std::size_t... I>
+      inline
+      void pack_full_group(const T* values, T* out, std::index_sequence<I...>) noexcept
+      {
+        for (unsigned int w = 0; w != Width; ++w)
+        {
+          out[w] = 0;
+        }
+
+        const int expand[] = {(insert<T, Width, I>(values[I], out), 0)...};
+        static_cast<void>(expand);
+      }
+
+      template <typename T, unsigned int Width, std::size_t... I>
+      inline
+      void unpack_full_group(const T* packed, T* out, std::index_sequence<I...>) noexcept
+      {
+        const int expand[] = {(out[I] = extract<T, Width, I>(packed), 0)...};
+        static_cast<void>(expand);
+      }
+
+      // The kernels for one width: whole groups of digits<T> values,
+      // which fill exactly Width words, then the rest.
+      template <typename T, unsigned int Width>
+      struct fixed
+      {
+        using group = std::make_index_sequence<std::numeric_limits<T>::digits>;
+
+        static void pack(const T* values, const std::size_t n, T* out) noexcept
+        {
+          constexpr unsigned int bits = std::numeric_limits<T>::digits;
+          std::size_t i = 0;
+
+          for (; i + bits <= n; i += bits, out += Width)
+          {
+            pack_full_group<T, Width>(values + i, out, group{});
+          }
+
+          pack_group<T, Width>(values + i, n - i, out);
+        }
+
+        static void unpack(const T* packed, const std::size_t n, T* out) noexcept
+        {
+          constexpr unsigned int bits = std::numeric_limits<T>::digits;
+          std::size_t i = 0;
+
+          for (; i + bits <= n; i += bits, packed += Width)
+          {
+            unpack_full_group<T, Width>(packed, out + i, group{});
+          }
+
+          unpack_group<T, Width>(packed, n - i, out + i);
+        }
+      };
+
+      template <typename T>
+      struct fixed<T, 0>
+      {
+        static void pack(const T*, std::size_t, T*) noexcept {}
+
+        static void unpack(const T*, const std::size_t n, T* out) noexcept
+        {
+          std::fill(out, out + n, T{0});
+        }
+      };
+
+      template <typename T>
+      using kernel = void (*)(const T*, std::size_t, T*);
+
+      template <typename T>
+      struct kernels
+      {
+        kernel<T> pack;
+        kernel<T> unpack;
+      };
+
+      template <typename T, unsigned int... Widths>
+      inline
+      const kernels<T>* kernels_for(std::integer_sequence<unsigned int, Widths...>) noexcept
+      {
+        static const kernels<T> table[] = {{&fixed<T, Widths>::pack, &fixed<T, Widths>::unpack}...};
+        return table;
+      }
+
+      // The kernels for width, from a table of one per width 0 ..
+      // digits<T> generated at compile time.
+      template <typename T>
+      inline
+      const kernels<T>& kernels_for(const unsigned int width) noexcept
+      {
+        assert(width <= std::numeric_limits<T>::digits);
+        return kernels_for<T>(std::make_integer_sequence<unsigned int, std::numeric_limits<T>::digits + 1>{})[width];
+      }
+    }
+
+    namespace detail
+    {
+      // Every function taking a width checks it: past digits<T> there is
+      // no kernel to call and no shift that is defined.
+      template <typename T>
+      inline
+      void check_width(const unsigned int width)
+      {
+        if (width > std::numeric_limits<T>::digits)
+        {
+          throw std::invalid_argument("bit::packing: width wider than the value type");
+        }
+      }
+    }
+
+    // Packs values[0, n) at width bits each into words<T>(n, width) words
+    // at out. Bits of a value above width are dropped. This and the other
+    // functions taking a width throw std::invalid_argument if it is above
+    // digits<T>.
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    void pack(const T* values, const std::size_t n, const unsigned int width, T* out)
+    {
+      detail::check_width<T>(width);
+      detail::kernels_for<T>(width).pack(values, n, out);
+    }
+
+    // The n values packed at width bits each, into out[0, n).
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    void unpack(const T* packed, const std::size_t n, const unsigned int width, T* out)
+    {
+      detail::check_width<T>(width);
+      detail::kernels_for<T>(width).unpack(packed, n, out);
+    }
+
+    // Value i of a stream packed at width bits each, without unpacking
+    // the rest.
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    T get(const T* packed, const unsigned int width, const std::size_t i)
+    {
+      constexpr unsigned int bits = std::numeric_limits<T>::digits;
+
+      detail::check_width<T>(width);
+
+      if (width == 0)
+      {
+        return 0;
+      }
+
+      const std::size_t  position = i * width;
+      const std::size_t  word     = position / bits;
+      const unsigned int shift    = position % bits;
+
+      T value = static_cast<T>(packed[word] >> shift);
+
+      if (shift + width > bits)
+      {
+        value |= static_cast<T>(packed[word + 1] << (bits - shift));
+      }
+
+      return width == bits ? value : static_cast<T>(value & ((T{1} << width) - 1));
+    }
+
+    // Words holding n 32-bit values in the vertical layout: whole blocks
+    // of 128, then the rest packed horizontally.
+    inline constexpr
+    std::size_t vertical_words(const std::size_t n, const unsigned int width) noexcept
+    {
+      return n / 128 * 4 * width + words<std::uint32_t>(n % 128, width);
+    }
+
+    // The vertical layout holds 32-bit values, so it takes widths up to
+    // 32 and throws std::invalid_argument above, as the horizontal one
+    // does above digits<T>.
+    inline
+    void pack_vertical(const std::uint32_t* values, const std::size_t n, const unsigned int width,
+                       std::uint32_t* out)
+    {
+      detail::check_width<std::uint32_t>(width);
+
+      const std::size_t blocks = n / 128;
+
+      kernels::pack128(values, blocks, width, out);
+      pack(values + 128 * blocks, n % 128, width, out + 4 * width * blocks);
+    }
+
+    inline
+    void unpack_vertical(const std::uint32_t* packed, const std::size_t n, const unsigned int width,
+                         std::uint32_t* out)
+    {
+      detail::check_width<std::uint32_t>(width);
+
+      const std::size_t blocks = n / 128;
+
+      kernels::unpack128(packed, blocks, width, out);
+      unpack(packed + 4 * width * blocks, n % 128, width, out + 128 * blocks);
+    }
+
+    // Value i of a stream in the vertical layout: position i / 4 of its
+    // lane, whose words are every fourth one of the block.
+    inline
+    std::uint32_t get_vertical(const std::uint32_t* packed, const std::size_t n, const unsigned int width,
+                               const std::size_t i)
+    {
+      detail::check_width<std::uint32_t>(width);
+
+      const std::size_t blocks = n / 128;
+
+      if (i >= 128 * blocks)
+      {
+        return get(packed + 4 * width * blocks, width, i - 128 * blocks);
+      }
+
+      if (width == 0)
+      {
+        return 0;
+      }
+
+      const std::uint32_t* const block    = packed + 4 * width * (i / 128);
+      const unsigned int         lane     = i % 4;
+      const unsigned int         position = (i % 128) / 4 * width;
+      const unsigned int         shift    = position % 32;
+
+      std::uint32_t value = block[4 * (position / 32) + lane] >> shift;
+
+      if (shift + width > 32)
+      {
+        value |= block[4 * (position / 32 + 1) + lane] << (32 - shift);
+      }
+
+      return width == 32 ? value : value & ((1U << width) - 1);
+    }
+
+    // Frame of reference: values stored as their distance from the
+    // smallest, in as many bits as the largest distance needs.
+    template <typename T>
+    struct frame
+    {
+      T            base  = 0;
+      unsigned int width = 0;
+    };
+
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    frame<T> frame_of(const T* values, const std::size_t n) noexcept
+    {
+      if (n == 0)
+      {
+        return {};
+      }
+
+      const auto range = std::minmax_element(values, values + n);
+      return {*range.first, bit_width(static_cast<T>(*range.second - *range.first))};
+    }
+
+    // Packs values[0, n), none below f.base, into words<T>(n, f.width)
+    // words at out, a group at a time through a small buffer.
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    void pack_for(const T* values, const std::size_t n, const frame<T> f, T* out)
+    {
+      constexpr std::size_t group = std::numeric_limits<T>::digits;
+      T offsets[group];
+
+      detail::check_width<T>(f.width);
+
+      for (std::size_t i = 0; i < n; i += group)
+      {
+        const std::size_t count = std::min(group, n - i);
+
+        for (std::size_t k = 0; k != count; ++k)
+        {
+          offsets[k] = static_cast<T>(values[i + k] - f.base);
+        }
+
+        pack(offsets, count, f.width, out + i / group * f.width);
+      }
+    }
+
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    void unpack_for(const T* packed, const std::size_t n, const frame<T> f, T* out)
+    {
+      unpack(packed, n, f.width, out);
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        out[i] = static_cast<T>(out[i] + f.base);
+      }
+    }
+
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    T get_for(const T* packed, const frame<T> f, const std::size_t i)
+    {
+      return static_cast<T>(f.base + get(packed, f.width, i));
+    }
+
+    // Delta coding: value i stored as values[i] - values[i - 1], with base
+    // before values[0]. Sorted input gives small gaps; unsorted input
+    // still round-trips, as differences modulo 2^digits<T>, but may need
+    // the full width. Random access needs a prefix sum, so there is no
+    // get for it.
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    unsigned int delta_width(const T* values, const std::size_t n, const T base = 0) noexcept
+    {
+      T any = 0;
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        any |= static_cast<T>(values[i] - (i == 0 ? base : values[i - 1]));
+      }
+
+      return bit_width(any);
+    }
+
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    void pack_delta(const T* values, const std::size_t n, const T base, const unsigned int width, T* out)
+    {
+      constexpr std::size_t group = std::numeric_limits<T>::digits;
+      T gaps[group];
+
+      detail::check_width<T>(width);
+
+      for (std::size_t i = 0; i < n; i += group)
+      {
+        const std::size_t count = std::min(group, n - i);
+
+        for (std::size_t k = 0; k != count; ++k)
+        {
+          gaps[k] = static_cast<T>(values[i + k] - (i + k == 0 ? base : values[i + k - 1]));
+        }
+
+        pack(gaps, count, width, out + i / group * width);
+      }
+    }
+
+    template <typename T, typename = enable_if_word<T>>
+    inline
+    void unpack_delta(const T* packed, const std::size_t n, const T base, const unsigned int width, T* out)
+    {
+      unpack(packed, n, width, out);
+
+      T previous = base;
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        previous = out[i] = static_cast<T>(previous + out[i]);
+      }
+    }
+  }
+}
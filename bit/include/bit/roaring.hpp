@@ -0,0 +1,1376 @@
+#pragma once
+
+#include "bit/bit.hpp"
+#include "bit/kernels.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Compressed bitmaps of 32-bit values (Chambi, Lemire, Kaser and Godin,
+// "Better bitmap performance with Roaring bitmaps", 2016). The values are
+// split into chunks of 2^16 by their high half, and each chunk that has
+// any keeps its low halves in the smallest of three containers:
+//
+//   array   the sorted values, for up to 4096 of them;
+//   bitmap  1024 words, one bit per value, for more;
+//   run     (start, length - 1) pairs, for long stretches of consecutive
+//           values, chosen by optimize().
+//
+// A set costs about two bytes per value when sparse and one bit per
+// possible value when dense. Set operations run chunk by chunk, on
+// whole words for bitmaps and with SIMD intersection for arrays, and
+// every container keeps its cardinality, so cardinality() adds up one
+// number per chunk.
+//
+// serialize() writes the portable Roaring format shared by the C, Java
+// and Go implementations; roaring::view answers queries on such bytes
+// in place, e.g. over a mapped file, without building the containers.
+namespace bit
+{
+  class roaring
+  {
+  public:
+    using value_type = std::uint32_t;
+
+    enum class kind : std::uint8_t
+    {
+      array,
+      bitmap,
+      run
+    };
+
+    class view;
+
+    roaring() = default;
+
+    // Sorted input is appended without searching.
+    template <typename InputIt>
+    roaring(InputIt first, const InputIt last)
+    {
+      for (; first != last; ++first)
+      {
+        add(static_cast<value_type>(*first));
+      }
+    }
+
+    roaring(const std::initializer_list<value_type> values)
+      : roaring(values.begin(), values.end()) {}
+
+    explicit roaring(const view& frozen);
+
+    void add(const value_type x)
+    {
+      container& c = slot(static_cast<std::uint16_t>(x >> 16));
+      const std::uint16_t low = static_cast<std::uint16_t>(x);
+
+      if (c.type == kind::run)
+      {
+        c = expanded(c);
+      }
+
+      if (c.type == kind::array)
+      {
+        if (c.values.empty() || c.values.back() < low)
+        {
+          c.values.push_back(low);
+        }
+        else
+        {
+          const auto at = std::lower_bound(c.values.begin(), c.values.end(), low);
+
+          if (*at == low)
+          {
+            return;
+          }
+
+          c.values.insert(at, low);
+        }
+
+        if (++c.cardinality > array_limit)
+        {
+          c = bitmap_of(c.values);
+        }
+      }
+      else
+      {
+        std::uint64_t& word = c.words[low / 64];
+        const std::uint64_t bit = std::uint64_t{1} << (low % 64);
+
+        c.cardinality += (word & bit) == 0;
+        word          |= bit;
+      }
+    }
+
+    void remove(const value_type x)
+    {
+      const auto at = std::lower_bound(keys_.begin(), keys_.end(), static_cast<std::uint16_t>(x >> 16));
+
+      if (at == keys_.end() || *at != x >> 16)
+      {
+        return;
+      }
+
+      container& c = containers_[at - keys_.begin()];
+      const std::uint16_t low = static_cast<std::uint16_t>(x);
+
+      if (c.type == kind::run)
+      {
+        c = expanded(c);
+      }
+
+      if (c.type == kind::array)
+      {
+        const auto value = std::lower_bound(c.values.begin(), c.values.end(), low);
+
+        if (value != c.values.end() && *value == low)
+        {
+          c.values.erase(value);
+          --c.cardinality;
+        }
+      }
+      else
+      {
+        std::uint64_t& word = c.words[low / 64];
+        const std::uint64_t bit = std::uint64_t{1} << (low % 64);
+
+        c.cardinality -= (word & bit) != 0;
+        word          &= ~bit;
+
+        if (c.cardinality <= array_limit)
+        {
+          c = array_of(c.words);
+        }
+      }
+
+      if (c.cardinality == 0)
+      {
+        containers_.erase(containers_.begin() + (at - keys_.begin()));
+        keys_.erase(at);
+      }
+    }
+
+    bool contains(const value_type x) const noexcept
+    {
+      const auto at = std::lower_bound(keys_.begin(), keys_.end(), static_cast<std::uint16_t>(x >> 16));
+
+      return at != keys_.end() && *at == x >> 16 &&
+             holds(containers_[at - keys_.begin()], static_cast<std::uint16_t>(x));
+    }
+
+    std::uint64_t cardinality() const noexcept
+    {
+      std::uint64_t total = 0;
+
+      for (const container& c : containers_)
+      {
+        total += c.cardinality;
+      }
+
+      return total;
+    }
+
+    bool empty() const noexcept { return keys_.empty(); }
+
+    // Number of chunks, and of those held in containers of one kind.
+    std::size_t containers() const noexcept { return keys_.size(); }
+
+    std::size_t containers(const kind type) const noexcept
+    {
+      return static_cast<std::size_t>(std::count_if(containers_.begin(), containers_.end(),
+                                                    [type](const container& c) { return c.type == type; }));
+    }
+
+    // Calls f(x) for every value, in increasing order.
+    template <typename Function>
+    void for_each(Function f) const
+    {
+      for (std::size_t i = 0; i != keys_.size(); ++i)
+      {
+        const value_type base = value_type{keys_[i]} << 16;
+        const container& c    = containers_[i];
+
+        switch (c.type)
+        {
+          case kind::array:
+            for (const std::uint16_t low : c.values)
+            {
+              f(base | low);
+            }
+            break;
+
+          case kind::bitmap:
+            for (std::size_t k = 0; k != bitmap_words; ++k)
+            {
+              for (std::uint64_t word = c.words[k]; word != 0; word &= word - 1)
+              {
+                f(base | static_cast<value_type>(64 * k + countr_zero(word)));
+              }
+            }
+            break;
+
+          case kind::run:
+            for (std::size_t r = 0; r != c.values.size(); r += 2)
+            {
+              const value_type start = base | c.values[r];
+
+              for (value_type x = start; x != start + c.values[r + 1] + 1; ++x)
+              {
+                f(x);
+              }
+            }
+            break;
+        }
+      }
+    }
+
+    std::vector<value_type> to_vector() const
+    {
+      std::vector<value_type> values;
+      values.reserve(cardinality());
+      for_each([&values](const value_type x) { values.push_back(x); });
+      return values;
+    }
+
+    // Moves every chunk to whichever container serializes smallest, which
+    // turns long stretches of consecutive values into runs.
+    void optimize()
+    {
+      for (container& c : containers_)
+      {
+        const std::size_t runs  = runs_in(c);
+        const std::size_t run   = run_bytes(runs);
+        const std::size_t other = std::min<std::size_t>(bitmap_words * 8, 2 * std::size_t{c.cardinality});
+
+        if (run < other && c.type != kind::run)
+        {
+          c = runs_of(c, runs);
+        }
+        else if (run >= other && c.type == kind::run)
+        {
+          c = expanded(c);
+        }
+      }
+    }
+
+    roaring& operator&=(const roaring& other) { return *this = *this & other; }
+    roaring& operator|=(const roaring& other) { return *this = *this | other; }
+    roaring& operator^=(const roaring& other) { return *this = *this ^ other; }
+    roaring& operator-=(const roaring& other) { return *this = *this - other; }
+
+    friend roaring operator&(const roaring& x, const roaring& y)
+    {
+      return merge(x, y, intersection, false, false);
+    }
+
+    friend roaring operator|(const roaring& x, const roaring& y)
+    {
+      return merge(x, y, union_of, true, true);
+    }
+
+    friend roaring operator^(const roaring& x, const roaring& y)
+    {
+      return merge(x, y, symmetric_difference, true, true);
+    }
+
+    // The values of x that are not in y (andnot).
+    friend roaring operator-(const roaring& x, const roaring& y)
+    {
+      return merge(x, y, difference, true, false);
+    }
+
+    // |x & y| without building the intersection: bitmap pairs as
+    // (|a| + |b| - |a ^ b|) / 2 on the population count kernels.
+    friend std::uint64_t and_cardinality(const roaring& x, const roaring& y)
+    {
+      std::uint64_t total = 0;
+      std::size_t   i = 0, j = 0;
+
+      while (i != x.keys_.size() && j != y.keys_.size())
+      {
+        if (x.keys_[i] < y.keys_[j])
+        {
+          ++i;
+        }
+        else if (y.keys_[j] < x.keys_[i])
+        {
+          ++j;
+        }
+        else
+        {
+          const container& a = x.containers_[i++];
+          const container& b = y.containers_[j++];
+
+          if (a.type == kind::bitmap && b.type == kind::bitmap)
+          {
+            total += (a.cardinality + b.cardinality -
+                      kernels::hamming_distance(a.words.data(), b.words.data(), bitmap_words)) / 2;
+          }
+          else
+          {
+            total += intersection(a, b).cardinality;
+          }
+        }
+      }
+
+      return total;
+    }
+
+    friend bool operator==(const roaring& x, const roaring& y)
+    {
+      if (x.keys_ != y.keys_)
+      {
+        return false;
+      }
+
+      for (std::size_t i = 0; i != x.keys_.size(); ++i)
+      {
+        const container& a = x.containers_[i];
+        const container& b = y.containers_[i];
+
+        if (a.cardinality != b.cardinality || words_of(a) != words_of(b))
+        {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    friend bool operator!=(const roaring& x, const roaring& y)
+    {
+      return !(x == y);
+    }
+
+    // Bytes serialize() writes.
+    std::size_t serialized_size() const noexcept
+    {
+      std::size_t size = header_bytes(keys_.size(), containers(kind::run) != 0);
+
+      for (const container& c : containers_)
+      {
+        size += payload_bytes(c);
+      }
+
+      return size;
+    }
+
+    // Writes serialized_size() bytes of the portable format to out:
+    //
+    //   cookie      without runs, 12346 and the number of containers n as
+    //               two 32-bit words; with runs, 12347 | (n - 1) << 16 and
+    //               a bitset of which containers are runs, (n + 7) / 8 bytes
+    //   n pairs     16-bit key and cardinality - 1
+    //   n offsets   32-bit, from the start, of each container; left out
+    //               when there are runs and fewer than four containers
+    //   containers  arrays as 16-bit values, bitmaps as 1024 64-bit words,
+    //               runs as a 16-bit count and (start, length - 1) pairs
+    //
+    // All little-endian and unaligned. A container without its run bit
+    // is a bitmap if it holds more than 4096 values, else an array.
+    void serialize(std::uint8_t* out) const noexcept
+    {
+      const std::size_t n       = keys_.size();
+      const bool        has_run = containers(kind::run) != 0;
+      std::uint8_t*     at      = out;
+
+      if (has_run)
+      {
+        at = store(at, static_cast<std::uint32_t>(run_cookie | (n - 1) << 16));
+        std::memset(at, 0, (n + 7) / 8);
+
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          at[i / 8] |= static_cast<std::uint8_t>((containers_[i].type == kind::run) << (i % 8));
+        }
+
+        at += (n + 7) / 8;
+      }
+      else
+      {
+        at = store(at, std::uint32_t{cookie});
+        at = store(at, static_cast<std::uint32_t>(n));
+      }
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        at = store(at, keys_[i]);
+        at = store(at, static_cast<std::uint16_t>(containers_[i].cardinality - 1));
+      }
+
+      if (!has_run || n >= no_offset_threshold)
+      {
+        std::size_t offset = header_bytes(n, has_run);
+
+        for (const container& c : containers_)
+        {
+          at      = store(at, static_cast<std::uint32_t>(offset));
+          offset += payload_bytes(c);
+        }
+      }
+
+      for (const container& c : containers_)
+      {
+        switch (c.type)
+        {
+          case kind::array:
+            for (const std::uint16_t low : c.values)
+            {
+              at = store(at, low);
+            }
+            break;
+
+          case kind::bitmap:
+            for (const std::uint64_t word : c.words)
+            {
+              at = store(at, word);
+            }
+            break;
+
+          case kind::run:
+            at = store(at, static_cast<std::uint16_t>(c.values.size() / 2));
+
+            for (const std::uint16_t half : c.values)
+            {
+              at = store(at, half);
+            }
+            break;
+        }
+      }
+    }
+
+    std::vector<std::uint8_t> serialize() const
+    {
+      std::vector<std::uint8_t> bytes(serialized_size());
+      serialize(bytes.data());
+      return bytes;
+    }
+
+  private:
+    enum : std::uint32_t
+    {
+      array_limit         = 4096,
+      bitmap_words        = 1024,
+      cookie              = 12346,
+      run_cookie          = 12347,
+      no_offset_threshold = 4
+    };
+
+    // One chunk's low halves. Runs keep their (start, length - 1) pairs
+    // in values.
+    struct container
+    {
+      kind                       type        = kind::array;
+      std::uint32_t              cardinality = 0;
+      std::vector<std::uint16_t> values;
+      std::vector<std::uint64_t> words;
+    };
+
+    // The container for key, created empty if there is none; appending
+    // to the last chunk skips the search.
+    container& slot(const std::uint16_t key)
+    {
+      if (keys_.empty() || keys_.back() < key)
+      {
+        keys_.push_back(key);
+        containers_.emplace_back();
+        return containers_.back();
+      }
+
+      const auto at = std::lower_bound(keys_.begin(), keys_.end(), key);
+      const auto i  = at - keys_.begin();
+
+      if (*at != key)
+      {
+        keys_.insert(at, key);
+        containers_.emplace(containers_.begin() + i);
+      }
+
+      return containers_[i];
+    }
+
+    static bool holds(const container& c, const std::uint16_t low) noexcept
+    {
+      switch (c.type)
+      {
+        case kind::array:
+          return std::binary_search(c.values.begin(), c.values.end(), low);
+
+        case kind::bitmap:
+          return (c.words[low / 64] >> (low % 64)) & 1;
+
+        case kind::run:
+          break;
+      }
+
+      // The last run starting at or below low.
+      std::size_t lo = 0, hi = c.values.size() / 2;
+
+      while (lo != hi)
+      {
+        const std::size_t mid = (lo + hi) / 2;
+
+        if (c.values[2 * mid] <= low)
+        {
+          lo = mid + 1;
+        }
+        else
+        {
+          hi = mid;
+        }
+      }
+
+      return lo != 0 && low - c.values[2 * (lo - 1)] <= c.values[2 * (lo - 1) + 1];
+    }
+
+    static container array_of(std::vector<std::uint16_t> values)
+    {
+      container c;
+      c.cardinality = static_cast<std::uint32_t>(values.size());
+      c.values      = std::move(values);
+      return c;
+    }
+
+    static container array_of(const std::vector<std::uint64_t>& words)
+    {
+      container c;
+      c.values.reserve(array_limit);
+
+      for (std::size_t k = 0; k != bitmap_words; ++k)
+      {
+        for (std::uint64_t word = words[k]; word != 0; word &= word - 1)
+        {
+          c.values.push_back(static_cast<std::uint16_t>(64 * k + countr_zero(word)));
+        }
+      }
+
+      c.cardinality = static_cast<std::uint32_t>(c.values.size());
+      return c;
+    }
+
+    static container bitmap_of(std::vector<std::uint64_t> words, const std::uint32_t cardinality)
+    {
+      container c;
+      c.type        = kind::bitmap;
+      c.cardinality = cardinality;
+      c.words       = std::move(words);
+      return c;
+    }
+
+    static container bitmap_of(const std::vector<std::uint16_t>& values)
+    {
+      std::vector<std::uint64_t> words(bitmap_words);
+
+      for (const std::uint16_t low : values)
+      {
+        words[low / 64] |= std::uint64_t{1} << (low % 64);
+      }
+
+      return bitmap_of(std::move(words), static_cast<std::uint32_t>(values.size()));
+    }
+
+    // The container that suits a chunk of these bits or values.
+    static container fitting(std::vector<std::uint64_t> words)
+    {
+      const std::uint32_t cardinality = static_cast<std::uint32_t>(kernels::count(words.data(), bitmap_words));
+      return cardinality <= array_limit ? array_of(words) : bitmap_of(std::move(words), cardinality);
+    }
+
+    static container fitting(std::vector<std::uint16_t> values)
+    {
+      return values.size() <= array_limit ? array_of(std::move(values)) : bitmap_of(values);
+    }
+
+    static std::vector<std::uint64_t> words_of(const container& c)
+    {
+      if (c.type == kind::bitmap)
+      {
+        return c.words;
+      }
+
+      std::vector<std::uint64_t> words(bitmap_words);
+
+      if (c.type == kind::array)
+      {
+        for (const std::uint16_t low : c.values)
+        {
+          words[low / 64] |= std::uint64_t{1} << (low % 64);
+        }
+      }
+      else
+      {
+        for (std::size_t r = 0; r != c.values.size(); r += 2)
+        {
+          set_range(words.data(), c.values[r], std::uint32_t{c.values[r]} + c.values[r + 1]);
+        }
+      }
+
+      return words;
+    }
+
+    // Sets bits first to last, both included.
+    static void set_range(std::uint64_t* words, const std::uint32_t first, const std::uint32_t last) noexcept
+    {
+      const std::uint32_t k = first / 64, end = last / 64;
+      const std::uint64_t head = ~std::uint64_t{0} << (first % 64);
+      const std::uint64_t tail = ~std::uint64_t{0} >> (63 - last % 64);
+
+      if (k == end)
+      {
+        words[k] |= head & tail;
+        return;
+      }
+
+      words[k] |= head;
+      std::fill(words + k + 1, words + end, ~std::uint64_t{0});
+      words[end] |= tail;
+    }
+
+    // A run container as an array or a bitmap, whichever its size calls
+    // for; operations other than lookups work on these two.
+    static container expanded(const container& c)
+    {
+      if (c.cardinality > array_limit)
+      {
+        return bitmap_of(words_of(c), c.cardinality);
+      }
+
+      container array;
+      array.cardinality = c.cardinality;
+      array.values.reserve(c.cardinality);
+
+      for (std::size_t r = 0; r != c.values.size(); r += 2)
+      {
+        for (std::uint32_t low = c.values[r]; low <= std::uint32_t{c.values[r]} + c.values[r + 1]; ++low)
+        {
+          array.values.push_back(static_cast<std::uint16_t>(low));
+        }
+      }
+
+      return array;
+    }
+
+    static std::size_t runs_in(const container& c) noexcept
+    {
+      switch (c.type)
+      {
+        case kind::array:
+        {
+          std::size_t runs = c.values.empty() ? 0 : 1;
+
+          for (std::size_t i = 1; i < c.values.size(); ++i)
+          {
+            runs += c.values[i] != c.values[i - 1] + 1;
+          }
+
+          return runs;
+        }
+
+        case kind::bitmap:
+        {
+          // A run starts at every set bit whose lower neighbour is clear.
+          std::size_t   runs  = 0;
+          std::uint64_t carry = 0;
+
+          for (const std::uint64_t word : c.words)
+          {
+            runs += count(word & ~(word << 1 | carry));
+            carry = word >> 63;
+          }
+
+          return runs;
+        }
+
+        case kind::run:
+          break;
+      }
+
+      return c.values.size() / 2;
+    }
+
+    static container runs_of(const container& c, const std::size_t runs)
+    {
+      container result;
+      result.type        = kind::run;
+      result.cardinality = c.cardinality;
+      result.values.reserve(2 * runs);
+
+      std::uint32_t start = 0, previous = 0;
+      bool          open  = false;
+
+      const auto extend = [&](const std::uint32_t low)
+      {
+        if (open && low == previous + 1)
+        {
+          previous = low;
+          return;
+        }
+
+        if (open)
+        {
+          result.values.push_back(static_cast<std::uint16_t>(start));
+          result.values.push_back(static_cast<std::uint16_t>(previous - start));
+        }
+
+        start = previous = low;
+        open  = true;
+      };
+
+      if (c.type == kind::array)
+      {
+        std::for_each(c.values.begin(), c.values.end(), extend);
+      }
+      else
+      {
+        for (std::size_t k = 0; k != bitmap_words; ++k)
+        {
+          for (std::uint64_t word = c.words[k]; word != 0; word &= word - 1)
+          {
+            extend(static_cast<std::uint32_t>(64 * k + countr_zero(word)));
+          }
+        }
+      }
+
+      if (open)
+      {
+        result.values.push_back(static_cast<std::uint16_t>(start));
+        result.values.push_back(static_cast<std::uint16_t>(previous - start));
+      }
+
+      return result;
+    }
+
+    // Container pairs. Runs are expanded first; the result is an array
+    // or a bitmap, possibly empty.
+
+    static container intersection(const container& x, const container& y)
+    {
+      const container a = x.type == kind::run ? expanded(x) : container{};
+      const container b = y.type == kind::run ? expanded(y) : container{};
+      const container& left  = x.type == kind::run ? a : x;
+      const container& right = y.type == kind::run ? b : y;
+
+      if (left.type == kind::array && right.type == kind::array)
+      {
+        const container& small = left.cardinality <= right.cardinality ? left : right;
+        const container& large = left.cardinality <= right.cardinality ? right : left;
+
+        std::vector<std::uint16_t> values(small.cardinality + 8);
+
+        // Far apart in size, a search per value of the smaller array
+        // beats a merge through the larger.
+        if (64 * std::size_t{small.cardinality} < large.cardinality)
+        {
+          std::size_t n = 0;
+          auto        from = large.values.begin();
+
+          for (const std::uint16_t low : small.values)
+          {
+            from = std::lower_bound(from, large.values.end(), low);
+
+            if (from == large.values.end())
+            {
+              break;
+            }
+
+            values[n] = low;
+            n        += *from == low;
+          }
+
+          values.resize(n);
+        }
+        else
+        {
+          values.resize(kernels::intersect16(left.values.data(), left.cardinality,
+                                             right.values.data(), right.cardinality, values.data()));
+        }
+
+        return array_of(std::move(values));
+      }
+
+      if (left.type == kind::array || right.type == kind::array)
+      {
+        const container& array  = left.type == kind::array ? left : right;
+        const container& bitmap = left.type == kind::array ? right : left;
+
+        std::vector<std::uint16_t> values(array.cardinality);
+        std::size_t n = 0;
+
+        for (const std::uint16_t low : array.values)
+        {
+          values[n] = low;
+          n        += (bitmap.words[low / 64] >> (low % 64)) & 1;
+        }
+
+        values.resize(n);
+        return array_of(std::move(values));
+      }
+
+      std::vector<std::uint64_t> words(bitmap_words);
+
+      for (std::size_t k = 0; k != bitmap_words; ++k)
+      {
+        words[k] = left.words[k] & right.words[k];
+      }
+
+      return fitting(std::move(words));
+    }
+
+    static container union_of(const container& x, const container& y)
+    {
+      if (x.type == kind::array && y.type == kind::array)
+      {
+        std::vector<std::uint16_t> values;
+        values.reserve(x.cardinality + y.cardinality);
+        std::set_union(x.values.begin(), x.values.end(), y.values.begin(), y.values.end(),
+                       std::back_inserter(values));
+        return fitting(std::move(values));
+      }
+
+      return bitwise(x, y, [](const std::uint64_t a, const std::uint64_t b) { return a | b; });
+    }
+
+    static container symmetric_difference(const container& x, const container& y)
+    {
+      if (x.type == kind::array && y.type == kind::array)
+      {
+        std::vector<std::uint16_t> values;
+        values.reserve(x.cardinality + y.cardinality);
+        std::set_symmetric_difference(x.values.begin(), x.values.end(), y.values.begin(), y.values.end(),
+                                      std::back_inserter(values));
+        return fitting(std::move(values));
+      }
+
+      return bitwise(x, y, [](const std::uint64_t a, const std::uint64_t b) { return a ^ b; });
+    }
+
+    static container difference(const container& x, const container& y)
+    {
+      const container a = x.type == kind::run ? expanded(x) : container{};
+      const container& left = x.type == kind::run ? a : x;
+
+      if (left.type == kind::array)
+      {
+        std::vector<std::uint16_t> values(left.cardinality);
+        std::size_t n = 0;
+
+        for (const std::uint16_t low : left.values)
+        {
+          values[n] = low;
+          n        += !holds(y, low);
+        }
+
+        values.resize(n);
+        return array_of(std::move(values));
+      }
+
+      return bitwise(left, y, [](const std::uint64_t a, const std::uint64_t b) { return a & ~b; });
+    }
+
+    template <typename Op>
+    static container bitwise(const container& x, const container& y, Op op)
+    {
+      std::vector<std::uint64_t> words = words_of(x);
+
+      if (y.type == kind::bitmap)
+      {
+        for (std::size_t k = 0; k != bitmap_words; ++k)
+        {
+          words[k] = op(words[k], y.words[k]);
+        }
+      }
+      else
+      {
+        const std::vector<std::uint64_t> other = words_of(y);
+
+        for (std::size_t k = 0; k != bitmap_words; ++k)
+        {
+          words[k] = op(words[k], other[k]);
+        }
+      }
+
+      return fitting(std::move(words));
+    }
+
+    // Walks the chunks of x and y together, combining the ones both have
+    // and copying those only one has when asked to.
+    static roaring merge(const roaring& x, const roaring& y, container (*op)(const container&, const container&),
+                         const bool keep_x, const bool keep_y)
+    {
+      roaring result;
+      std::size_t i = 0, j = 0;
+
+      const auto keep = [&result](const std::uint16_t key, container c)
+      {
+        if (c.cardinality != 0)
+        {
+          result.keys_.push_back(key);
+          result.containers_.push_back(std::move(c));
+        }
+      };
+
+      while (i != x.keys_.size() || j != y.keys_.size())
+      {
+        if (j == y.keys_.size() || (i != x.keys_.size() && x.keys_[i] < y.keys_[j]))
+        {
+          if (keep_x)
+          {
+            keep(x.keys_[i], x.containers_[i]);
+          }
+
+          ++i;
+        }
+        else if (i == x.keys_.size() || y.keys_[j] < x.keys_[i])
+        {
+          if (keep_y)
+          {
+            keep(y.keys_[j], y.containers_[j]);
+          }
+
+          ++j;
+        }
+        else
+        {
+          keep(x.keys_[i], op(x.containers_[i], y.containers_[j]));
+          ++i;
+          ++j;
+        }
+      }
+
+      return result;
+    }
+
+    static std::size_t run_bytes(const std::size_t runs) noexcept
+    {
+      return 2 + 4 * runs;
+    }
+
+    static std::size_t payload_bytes(const container& c) noexcept
+    {
+      switch (c.type)
+      {
+        case kind::array:  return 2 * std::size_t{c.cardinality};
+        case kind::bitmap: return 8 * std::size_t{bitmap_words};
+        case kind::run:    break;
+      }
+
+      return run_bytes(c.values.size() / 2);
+    }
+
+    static std::size_t header_bytes(const std::size_t n, const bool has_run) noexcept
+    {
+      const std::size_t cookies = has_run ? 4 + (n + 7) / 8 : 8;
+      const std::size_t offsets = !has_run || n >= no_offset_threshold ? 4 * n : 0;
+
+      return cookies + 4 * n + offsets;
+    }
+
+    template <typename T>
+    static std::uint8_t* store(std::uint8_t* out, T value) noexcept
+    {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      value = byteswap(value);
+#endif
+      std::memcpy(out, &value, sizeof(T));
+      return out + sizeof(T);
+    }
+
+    template <typename T>
+    static T load(const std::uint8_t* in) noexcept
+    {
+      T value;
+      std::memcpy(&value, in, sizeof(T));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      value = byteswap(value);
+#endif
+      return value;
+    }
+
+    std::vector<std::uint16_t> keys_;
+    std::vector<container>     containers_;
+  };
+
+  // A serialized roaring bitmap read where it lies. The constructor checks
+  // that the header and every container fit in the bytes given and that
+  // each container holds what a roaring of its own would (sorted arrays
+  // and runs, cardinalities that match the payload), and throws
+  // std::invalid_argument if not; the bytes must outlive the view.
+  class roaring::view
+  {
+  public:
+    view(const std::uint8_t* bytes, const std::size_t size)
+      : bytes_(bytes), size_(size)
+    {
+      if (size < 4)
+      {
+        throw std::invalid_argument("roaring::view: truncated header");
+      }
+
+      const std::uint32_t first = load<std::uint32_t>(bytes);
+      std::size_t         at    = 4;
+
+      if ((first & 0xffff) == run_cookie)
+      {
+        n_    = (first >> 16) + 1;
+        runs_ = bytes + at;
+        at   += (n_ + 7) / 8;
+      }
+      else if (first == cookie && size >= 8)
+      {
+        n_  = load<std::uint32_t>(bytes + 4);
+        at += 4;
+
+        if (n_ > 65536)
+        {
+          throw std::invalid_argument("roaring::view: too many containers");
+        }
+      }
+      else
+      {
+        throw std::invalid_argument("roaring::view: not a roaring bitmap");
+      }
+
+      descriptions_ = bytes + at;
+      at           += 4 * n_;
+
+      if (runs_ == nullptr || n_ >= no_offset_threshold)
+      {
+        offsets_ = bytes + at;
+        at      += 4 * n_;
+      }
+
+      if (at > size)
+      {
+        throw std::invalid_argument("roaring::view: truncated header");
+      }
+
+      // Without an offset header the containers follow each other.
+      end_ = at;
+
+      for (std::size_t i = 0; i != n_; ++i)
+      {
+        if (i != 0 && key(i) <= key(i - 1))
+        {
+          throw std::invalid_argument("roaring::view: keys out of order");
+        }
+
+        const std::size_t start = offsets_ != nullptr ? load<std::uint32_t>(offsets_ + 4 * i) : end_;
+
+        if (offsets_ == nullptr)
+        {
+          inline_offsets_[i] = static_cast<std::uint32_t>(start);
+        }
+
+        if (start + 2 > size)
+        {
+          throw std::invalid_argument("roaring::view: container out of bounds");
+        }
+
+        const std::size_t bytes_needed = type(i) == kind::array  ? 2 * cardinality(i)
+                                       : type(i) == kind::bitmap ? 8 * std::size_t{bitmap_words}
+                                       : run_bytes(load<std::uint16_t>(bytes + start));
+
+        if (start + bytes_needed > size)
+        {
+          throw std::invalid_argument("roaring::view: container out of bounds");
+        }
+
+        check_payload(i, bytes + start);
+
+        end_ = std::max(end_, start + bytes_needed);
+      }
+    }
+
+    explicit view(const std::vector<std::uint8_t>& bytes)
+      : view(bytes.data(), bytes.size()) {}
+
+    std::size_t containers() const noexcept { return n_; }
+
+    // Bytes of the serialized bitmap, which may be fewer than were given.
+    std::size_t size() const noexcept { return end_; }
+
+    std::uint64_t cardinality() const noexcept
+    {
+      std::uint64_t total = 0;
+
+      for (std::size_t i = 0; i != n_; ++i)
+      {
+        total += cardinality(i);
+      }
+
+      return total;
+    }
+
+    bool contains(const value_type x) const noexcept
+    {
+      const std::uint16_t high = static_cast<std::uint16_t>(x >> 16);
+      const std::uint16_t low  = static_cast<std::uint16_t>(x);
+
+      std::size_t lo = 0, hi = n_;
+
+      while (lo != hi)
+      {
+        const std::size_t mid = (lo + hi) / 2;
+
+        if (key(mid) < high)
+        {
+          lo = mid + 1;
+        }
+        else
+        {
+          hi = mid;
+        }
+      }
+
+      if (lo == n_ || key(lo) != high)
+      {
+        return false;
+      }
+
+      const std::uint8_t* data = payload(lo);
+
+      switch (type(lo))
+      {
+        case kind::array:
+        {
+          std::size_t first = 0, last = cardinality(lo);
+
+          while (first != last)
+          {
+            const std::size_t mid = (first + last) / 2;
+
+            if (load<std::uint16_t>(data + 2 * mid) < low)
+            {
+              first = mid + 1;
+            }
+            else
+            {
+              last = mid;
+            }
+          }
+
+          return first != cardinality(lo) && load<std::uint16_t>(data + 2 * first) == low;
+        }
+
+        case kind::bitmap:
+          return (data[low / 8] >> (low % 8)) & 1;
+
+        case kind::run:
+          break;
+      }
+
+      // The last run starting at or below low.
+      const std::size_t runs = load<std::uint16_t>(data);
+      std::size_t first = 0, last = runs;
+
+      while (first != last)
+      {
+        const std::size_t mid = (first + last) / 2;
+
+        if (load<std::uint16_t>(data + 2 + 4 * mid) <= low)
+        {
+          first = mid + 1;
+        }
+        else
+        {
+          last = mid;
+        }
+      }
+
+      return first != 0 &&
+             low - load<std::uint16_t>(data + 2 + 4 * (first - 1)) <= load<std::uint16_t>(data + 4 + 4 * (first - 1));
+    }
+
+    template <typename Function>
+    void for_each(Function f) const
+    {
+      for (std::size_t i = 0; i != n_; ++i)
+      {
+        const value_type    base = value_type{key(i)} << 16;
+        const std::uint8_t* data = payload(i);
+
+        switch (type(i))
+        {
+          case kind::array:
+            for (std::size_t k = 0; k != cardinality(i); ++k)
+            {
+              f(base | load<std::uint16_t>(data + 2 * k));
+            }
+            break;
+
+          case kind::bitmap:
+            for (std::size_t k = 0; k != bitmap_words; ++k)
+            {
+              for (std::uint64_t word = load<std::uint64_t>(data + 8 * k); word != 0; word &= word - 1)
+              {
+                f(base | static_cast<value_type>(64 * k + countr_zero(word)));
+              }
+            }
+            break;
+
+          case kind::run:
+            for (std::size_t r = 0; r != load<std::uint16_t>(data); ++r)
+            {
+              const value_type start = base | load<std::uint16_t>(data + 2 + 4 * r);
+              const value_type last  = start + load<std::uint16_t>(data + 4 + 4 * r);
+
+              for (value_type x = start; x <= last && x >= start; ++x)
+              {
+                f(x);
+              }
+            }
+            break;
+        }
+      }
+    }
+
+  private:
+    friend class roaring;
+
+    std::uint16_t key(const std::size_t i) const noexcept
+    {
+      return load<std::uint16_t>(descriptions_ + 4 * i);
+    }
+
+    std::size_t cardinality(const std::size_t i) const noexcept
+    {
+      return std::size_t{load<std::uint16_t>(descriptions_ + 4 * i + 2)} + 1;
+    }
+
+    kind type(const std::size_t i) const noexcept
+    {
+      if (runs_ != nullptr && (runs_[i / 8] >> (i % 8)) & 1)
+      {
+        return kind::run;
+      }
+
+      return cardinality(i) > array_limit ? kind::bitmap : kind::array;
+    }
+
+    const std::uint8_t* payload(const std::size_t i) const noexcept
+    {
+      return bytes_ + (offsets_ != nullptr ? load<std::uint32_t>(offsets_ + 4 * i) : inline_offsets_[i]);
+    }
+
+    // Checks that container i, whose payload at data lies in bounds, keeps
+    // the invariants add() and remove() rely on once it is copied into a
+    // roaring.
+    void check_payload(const std::size_t i, const std::uint8_t* data) const
+    {
+      std::size_t values = 0;
+
+      switch (type(i))
+      {
+        case kind::array:
+          for (std::size_t k = 1; k < cardinality(i); ++k)
+          {
+            if (load<std::uint16_t>(data + 2 * k) <= load<std::uint16_t>(data + 2 * (k - 1)))
+            {
+              throw std::invalid_argument("roaring::view: array values out of order");
+            }
+          }
+          return;
+
+        case kind::bitmap:
+          for (std::size_t k = 0; k != bitmap_words; ++k)
+          {
+            values += count(load<std::uint64_t>(data + 8 * k));
+          }
+          break;
+
+        case kind::run:
+          for (std::size_t r = 0; r != load<std::uint16_t>(data); ++r)
+          {
+            const std::size_t start  = load<std::uint16_t>(data + 2 + 4 * r);
+            const std::size_t length = load<std::uint16_t>(data + 4 + 4 * r);
+
+            // A run past the end of its chunk would spill into the next.
+            if (start + length > 0xffff)
+            {
+              throw std::invalid_argument("roaring::view: run out of range");
+            }
+
+            if (r != 0 && start <= std::size_t{load<std::uint16_t>(data + 2 + 4 * (r - 1))} +
+                                   load<std::uint16_t>(data + 4 + 4 * (r - 1)))
+            {
+              throw std::invalid_argument("roaring::view: runs out of order or overlapping");
+            }
+
+            values += length + 1;
+          }
+          break;
+      }
+
+      if (values != cardinality(i))
+      {
+        throw std::invalid_argument("roaring::view: cardinality does not match the container");
+      }
+    }
+
+    const std::uint8_t* bytes_        = nullptr;
+    std::size_t         size_         = 0;
+    std::size_t         n_            = 0;
+    std::size_t         end_          = 0;
+    const std::uint8_t* runs_         = nullptr;
+    const std::uint8_t* descriptions_ = nullptr;
+    const std::uint8_t* offsets_      = nullptr;
+
+    // Offsets of the up to three containers a header without offsets
+    // describes.
+    std::uint32_t inline_offsets_[no_offset_threshold - 1] = {};
+  };
+
+  inline roaring::roaring(const view& frozen)
+  {
+    keys_.reserve(frozen.containers());
+    containers_.reserve(frozen.containers());
+
+    for (std::size_t i = 0; i != frozen.containers(); ++i)
+    {
+      const std::uint8_t* data = frozen.payload(i);
+      container c;
+
+      c.type        = frozen.type(i);
+      c.cardinality = static_cast<std::uint32_t>(frozen.cardinality(i));
+
+      switch (c.type)
+      {
+        case kind::array:
+          c.values.resize(c.cardinality);
+
+          for (std::size_t k = 0; k != c.values.size(); ++k)
+          {
+            c.values[k] = load<std::uint16_t>(data + 2 * k);
+          }
+          break;
+
+        case kind::bitmap:
+          c.words.resize(bitmap_words);
+
+          for (std::size_t k = 0; k != bitmap_words; ++k)
+          {
+            c.words[k] = load<std::uint64_t>(data + 8 * k);
+          }
+          break;
+
+        case kind::run:
+          c.values.resize(2 * std::size_t{load<std::uint16_t>(data)});
+
+          for (std::size_t k = 0; k != c.values.size(); ++k)
+          {
+            c.values[k] = load<std::uint16_t>(data + 2 + 2 * k);
+          }
+          break;
+      }
+
+      keys_.push_back(frozen.key(i));
+      containers_.push_back(std::move(c));
+    }
+  }
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "bit/kernels.hpp"
+#include "bit/span.hpp"
+#include "bit/transpose.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// Bit-sliced storage of integers: instead of one word per value, one run
+// of bits per bit position (a bit plane), so that plane j holds bit j of
+// every value, value i at bit i. Reading one bit of every value touches
+// contiguous words instead of striding across the whole array, counting
+// a column is a popcount, and a comparison against a constant runs on 64
+// values per word operation.
+namespace bit
+{
+  template <typename T>
+  class sliced
+  {
+  public:
+    using value_type = T;
+    using word_type  = std::uint64_t;
+
+    static_assert(std::is_integral<T>::value && sizeof(T) <= sizeof(word_type),
+                  "bit::sliced needs an integral type of at most 64 bits");
+
+    // One plane per bit of T, the sign bit included.
+    static constexpr unsigned int planes = std::numeric_limits<std::make_unsigned_t<T>>::digits;
+
+    sliced() = default;
+
+    template <typename ForwardIt>
+    sliced(ForwardIt first, const ForwardIt last)
+      : sliced(static_cast<std::size_t>(std::distance(first, last)))
+    {
+      fill([&first] { return *first++; });
+    }
+
+    // The n values value_of(0) .. value_of(n - 1), sliced as they are
+    // produced, without an intermediate array.
+    template <typename Function>
+    static sliced generate(const std::size_t n, Function value_of)
+    {
+      sliced result{n};
+      std::size_t i = 0;
+
+      result.fill([&] { return value_of(i++); });
+      return result;
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    // Words in each plane.
+    std::size_t words() const noexcept { return words_; }
+
+    T operator[](const std::size_t i) const noexcept
+    {
+      assert(i < size_);
+
+      std::make_unsigned_t<T> value = 0;
+
+      for (unsigned int j = 0; j != planes; ++j)
+      {
+        value |= static_cast<std::make_unsigned_t<T>>((plane_words(j)[i / 64] >> (i % 64)) & 1) << j;
+      }
+
+      return static_cast<T>(value);
+    }
+
+    // Bit j of every value.
+    const_span<word_type> plane(const unsigned int j) const noexcept
+    {
+      return const_span<word_type>{plane_words(j), size_};
+    }
+
+    // Number of values with bit j set.
+    std::size_t count(const unsigned int j) const noexcept
+    {
+      return kernels::count(plane_words(j), words_);
+    }
+
+    // Selections: bit i of the result, words() words long, is set if
+    // value i satisfies the predicate. Comparisons follow T, so negative
+    // values order below zero for signed types.
+
+    std::vector<word_type> equal(const T value) const
+    {
+      std::vector<word_type> lt(words_), eq(words_);
+      compare(value, lt.data(), eq.data());
+      return eq;
+    }
+
+    std::vector<word_type> less(const T value) const
+    {
+      std::vector<word_type> lt(words_), eq(words_);
+      compare(value, lt.data(), eq.data());
+      return lt;
+    }
+
+    // low <= value <= high.
+    std::vector<word_type> between(const T low, const T high) const
+    {
+      std::vector<word_type> result(words_), lt(words_), eq(words_);
+
+      compare(high, result.data(), eq.data());
+
+      for (std::size_t k = 0; k != words_; ++k)
+      {
+        result[k] |= eq[k];
+      }
+
+      compare(low, lt.data(), eq.data());
+
+      for (std::size_t k = 0; k != words_; ++k)
+      {
+        result[k] &= ~lt[k];
+      }
+
+      return result;
+    }
+
+  private:
+    explicit sliced(const std::size_t n)
+      : size_(n), words_((n + 63) / 64), bits_(planes * words_) {}
+
+    const word_type* plane_words(const unsigned int j) const noexcept
+    {
+      assert(j < planes);
+      return bits_.data() + j * words_;
+    }
+
+    // Takes size_ values from next(), 64 at a time: the block is a 64x64
+    // bit matrix with a value per row, and its transpose has a plane per
+    // row. Rows past the end stay zero, so the planes' padding bits are
+    // clear.
+    template <typename Next>
+    void fill(Next next)
+    {
+      for (std::size_t block = 0; block != words_; ++block)
+      {
+        std::uint64_t rows[64] = {};
+        const std::size_t n = std::min<std::size_t>(64, size_ - 64 * block);
+
+        for (std::size_t r = 0; r != n; ++r)
+        {
+          rows[r] = static_cast<std::make_unsigned_t<T>>(next());
+        }
+
+        transpose64(rows);
+
+        for (unsigned int j = 0; j != planes; ++j)
+        {
+          bits_[j * words_ + block] = rows[j];
+        }
+      }
+    }
+
+    // lt and eq, words() words each, select the values below and equal to
+    // value. The planes are scanned from the most significant down, each
+    // a contiguous run, narrowing eq and adding to lt where value has a
+    // one. Flipping the sign plane and the sign of value orders signed
+    // types as unsigned ones.
+    void compare(const T value, word_type* lt, word_type* eq) const noexcept
+    {
+      using U = std::make_unsigned_t<T>;
+      const U sign = std::is_signed<T>::value ? static_cast<U>(U{1} << (planes - 1)) : U{0};
+      const U key  = static_cast<U>(static_cast<U>(value) ^ sign);
+
+      for (std::size_t k = 0; k != words_; ++k)
+      {
+        lt[k] = 0;
+        eq[k] = ~word_type{0};
+      }
+
+      for (unsigned int j = planes; j-- != 0;)
+      {
+        const word_type* p    = plane_words(j);
+        const word_type  flip = (sign >> j) & 1 ? ~word_type{0} : word_type{0};
+
+        if ((key >> j) & 1)
+        {
+          for (std::size_t k = 0; k != words_; ++k)
+          {
+            lt[k] |= eq[k] & ~(p[k] ^ flip);
+            eq[k] &= p[k] ^ flip;
+          }
+        }
+        else
+        {
+          for (std::size_t k = 0; k != words_; ++k)
+          {
+            eq[k] &= ~(p[k] ^ flip);
+          }
+        }
+      }
+
+      if (size_ % 64 != 0)
+      {
+        const word_type valid = (word_type{1} << (size_ % 64)) - 1;
+        lt[words_ - 1] &= valid;
+        eq[words_ - 1] &= valid;
+      }
+    }
+
+    std::size_t            size_  = 0;
+    std::size_t            words_ = 0;
+    std::vector<word_type> bits_;
+  };
+
+  template <typename T>
+  constexpr unsigned int sliced<T>::planes;
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "bit/bit.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+// Non-owning views of a run of bits inside an array of unsigned words:
+// packets, framebuffers, mapped files, anything already in memory. Bit i
+// of a span is bit (offset + i) % W of word (offset + i) / W, where W is
+// the width of the word type, least significant bit first.
+namespace bit
+{
+  template <typename Word>
+  class span
+  {
+  public:
+    using word_type              = std::remove_const_t<Word>;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using value_type             = bool;
+    using iterator               = span_iterator<Word>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using reference              = typename iterator::reference;
+
+    static_assert(std::is_unsigned<word_type>::value, "bit::span needs an unsigned word type");
+
+    static constexpr std::size_t word_bits = std::numeric_limits<word_type>::digits;
+
+    constexpr span() noexcept = default;
+
+    // size bits starting at bit offset of words[0].
+    constexpr span(Word* words, const std::size_t offset, const std::size_t size) noexcept
+      : words_(words + offset / word_bits), offset_(offset % word_bits), size_(size) {}
+
+    constexpr span(Word* words, const std::size_t size) noexcept
+      : span(words, 0, size) {}
+
+    template <typename Other,
+              typename = std::enable_if_t<std::is_convertible<Other*, Word*>::value>>
+    constexpr span(const span<Other>& other) noexcept
+      : words_(other.words()), offset_(other.offset()), size_(other.size()) {}
+
+    // The word holding the first bit, and the first bit's index in it.
+    constexpr Word* words() const noexcept { return words_; }
+    constexpr std::size_t offset() const noexcept { return offset_; }
+
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    constexpr iterator begin() const noexcept { return iterator{words_, offset_}; }
+    constexpr iterator end() const noexcept { return iterator{words_, offset_ + size_}; }
+
+    constexpr reverse_iterator rbegin() const noexcept { return reverse_iterator{end()}; }
+    constexpr reverse_iterator rend() const noexcept { return reverse_iterator{begin()}; }
+
+    constexpr reference operator[](const std::size_t i) const noexcept
+    {
+      assert(i < size_);
+      return begin()[i];
+    }
+
+    constexpr span subspan(const std::size_t position, const std::size_t count) const noexcept
+    {
+      assert(position + count <= size_);
+      return span{words_, offset_ + position, count};
+    }
+
+    constexpr span subspan(const std::size_t position) const noexcept
+    {
+      return subspan(position, size_ - position);
+    }
+
+    constexpr span first(const std::size_t count) const noexcept { return subspan(0, count); }
+    constexpr span last(const std::size_t count) const noexcept { return subspan(size_ - count, count); }
+
+  private:
+    Word*       words_  = nullptr;
+    std::size_t offset_ = 0;
+    std::size_t size_   = 0;
+  };
+
+  template <typename Word>
+  constexpr std::size_t span<Word>::word_bits;
+
+  template <typename Word>
+  using const_span = span<const Word>;
+
+  template <typename Word>
+  inline constexpr
+  span<Word> make_span(Word* words, const std::size_t offset, const std::size_t size) noexcept
+  {
+    return span<Word>{words, offset, size};
+  }
+
+  template <typename Word>
+  inline constexpr
+  span<Word> make_span(Word* words, const std::size_t size) noexcept
+  {
+    return span<Word>{words, size};
+  }
+
+  namespace detail
+  {
+    // Bits [first, last) of a word, 0 <= first < last <= W.
+    template <typename Word>
+    inline constexpr
+    Word word_mask(const std::size_t first, const std::size_t last) noexcept
+    {
+      return static_cast<Word>(static_cast<Word>(static_cast<Word>(~Word{0}) >> (std::numeric_limits<Word>::digits - (last - first))) << first);
+    }
+
+    // Calls function(word, mask) for every word the bits [offset, offset +
+    // size) of words touch, mask selecting the bits inside the range, until
+    // function returns true. Returns the index of that word, or the number
+    // of words visited.
+    template <typename Word, typename Function>
+    inline
+    std::size_t for_each_word(Word* words, const std::size_t offset, const std::size_t size, Function function)
+    {
+      using word_type = std::remove_const_t<Word>;
+      constexpr std::size_t W = std::numeric_limits<word_type>::digits;
+
+      if (size == 0)
+      {
+        return 0;
+      }
+
+      const std::size_t end  = offset + size;
+      const std::size_t last = (end - 1) / W;
+
+      if (last == 0)
+      {
+        return function(words[0], word_mask<word_type>(offset, end)) ? 0 : 1;
+      }
+
+      if (function(words[0], word_mask<word_type>(offset, W)))
+      {
+        return 0;
+      }
+
+      for (std::size_t i = 1; i != last; ++i)
+      {
+        if (function(words[i], static_cast<word_type>(~word_type{0})))
+        {
+          return i;
+        }
+      }
+
+      return function(words[last], word_mask<word_type>(0, end - last * W)) ? last : last + 1;
+    }
+
+    // len <= W bits starting at bit position of words, in the low bits.
+    template <typename Word>
+    inline
+    std::remove_const_t<Word> read_bits(Word* words, const std::size_t position, const std::size_t len) noexcept
+    {
+      using word_type = std::remove_const_t<Word>;
+      constexpr std::size_t W = std::numeric_limits<word_type>::digits;
+
+      const std::size_t word = position / W;
+      const std::size_t bit  = position % W;
+
+      word_type value = static_cast<word_type>(words[word] >> bit);
+
+      if (bit + len > W)
+      {
+        value |= static_cast<word_type>(words[word + 1] << (W - bit));
+      }
+
+      return len == W ? value : static_cast<word_type>(value & word_mask<word_type>(0, len));
+    }
+
+    // Writes the low len bits of value at bit position, all within one word.
+    template <typename Word>
+    inline
+    void write_bits(Word* words, const std::size_t position, const std::size_t len, const Word value) noexcept
+    {
+      constexpr std::size_t W = std::numeric_limits<Word>::digits;
+
+      const std::size_t word = position / W;
+      const std::size_t bit  = position % W;
+      const Word        mask = word_mask<Word>(bit, bit + len);
+
+      words[word] = static_cast<Word>((words[word] & ~mask) | (static_cast<Word>(value << bit) & mask));
+    }
+  }
+
+  // Number of set bits in bits, a word at a time.
+  template <typename Word>
+  inline
+  std::size_t count(const span<Word> bits) noexcept
+  {
+    std::size_t n = 0;
+
+    detail::for_each_word(bits.words(), bits.offset(), bits.size(), [&](const auto word, const auto mask)
+    {
+      n += bit::count(static_cast<std::remove_const_t<Word>>(word & mask));
+      return false;
+    });
+
+    return n;
+  }
+
+  // Index of the first bit equal to value, or bits.size() if there is none.
+  template <typename Word>
+  inline
+  std::size_t find(const span<Word> bits, const bool value) noexcept
+  {
+    using word_type = std::remove_const_t<Word>;
+
+    const word_type flip = value ? word_type{0} : static_cast<word_type>(~word_type{0});
+    bool         found = false;
+    unsigned int bit   = 0;
+
+    const std::size_t word = detail::for_each_word(bits.words(), bits.offset(), bits.size(),
+                                                   [&](const auto w, const auto mask)
+    {
+      const word_type match = static_cast<word_type>((w ^ flip) & mask);
+
+      if (match != 0)
+      {
+        found = true;
+        bit   = detail::lowest_set(match);
+      }
+
+      return found;
+    });
+
+    return found ? word * span<Word>::word_bits + bit - bits.offset() : bits.size();
+  }
+
+  // Sets every bit of bits to value.
+  template <typename Word>
+  inline
+  void fill(const span<Word> bits, const bool value) noexcept
+  {
+    static_assert(!std::is_const<Word>::value, "cannot fill a const_span");
+
+    detail::for_each_word(bits.words(), bits.offset(), bits.size(), [&](Word& word, const Word mask)
+    {
+      word = static_cast<Word>(value ? (word | mask) : (word & ~mask));
+      return false;
+    });
+  }
+
+  // Copies from into the first from.size() bits of to, a word of to at a
+  // time whatever the two offsets. As with std::copy, to must not start
+  // inside from.
+  template <typename From, typename To>
+  inline
+  void copy(const span<From> from, const span<To> to) noexcept
+  {
+    static_assert(std::is_same<std::remove_const_t<From>, To>::value,
+                  "bit::copy needs a mutable destination of the same word type");
+    assert(from.size() <= to.size());
+
+    constexpr std::size_t W = span<To>::word_bits;
+
+    for (std::size_t done = 0; done != from.size();)
+    {
+      const std::size_t position = to.offset() + done;
+      const std::size_t len      = std::min(W - position % W, from.size() - done);
+
+      detail::write_bits(to.words(), position, len, detail::read_bits(from.words(), from.offset() + done, len));
+      done += len;
+    }
+  }
+
+  // True if a and b hold the same bits, compared a word at a time.
+  template <typename A, typename B>
+  inline
+  bool equal(const span<A> a, const span<B> b) noexcept
+  {
+    static_assert(std::is_same<std::remove_const_t<A>, std::remove_const_t<B>>::value,
+                  "bit::equal needs spans of the same word type");
+
+    constexpr std::size_t W = span<A>::word_bits;
+
+    if (a.size() != b.size())
+    {
+      return false;
+    }
+
+    for (std::size_t done = 0; done != a.size();)
+    {
+      const std::size_t len = std::min(W - (a.offset() + done) % W, a.size() - done);
+
+      if (detail::read_bits(a.words(), a.offset() + done, len) != detail::read_bits(b.words(), b.offset() + done, len))
+      {
+        return false;
+      }
+
+      done += len;
+    }
+
+    return true;
+  }
+}
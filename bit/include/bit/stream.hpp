@@ -0,0 +1,446 @@
+#pragma once
+
+#include "bit/bit.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Bit-granular streams: a writer that appends fields of any width up to
+// 64 bits to a byte buffer, and a reader that takes them back from bytes
+// it does not own, e.g. a mapped file. Fields are laid out least
+// significant bit first: bit k of the stream is bit k % 8 of byte k / 8,
+// so the bytes are the same on any host.
+//
+// Both sides keep a 64-bit accumulator. The writer stores a whole word
+// each time 64 bits have accumulated; the reader tops its accumulator up
+// to at least 56 bits with one unaligned load and no loop, so any field
+// of up to 56 bits is a shift and a mask.
+//
+// The variable-length codes of bit::codes (Elias gamma and delta,
+// Golomb-Rice, varint) are written and read through the same two types.
+namespace bit
+{
+  namespace detail
+  {
+    inline std::uint64_t load_le64(const std::uint8_t* bytes) noexcept
+    {
+      std::uint64_t word;
+      std::memcpy(&word, bytes, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      word = byteswap(word);
+#endif
+      return word;
+    }
+
+    inline void store_le64(std::uint64_t word, std::uint8_t* bytes) noexcept
+    {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      word = byteswap(word);
+#endif
+      std::memcpy(bytes, &word, sizeof(word));
+    }
+
+    // The low width bits of value, 0 <= width <= 64.
+    inline constexpr std::uint64_t low(const std::uint64_t value, const unsigned int width) noexcept
+    {
+      return width == 64 ? value : value & ((std::uint64_t{1} << width) - 1);
+    }
+  }
+
+  class writer
+  {
+  public:
+    writer() = default;
+
+    // Reserves room for bytes of output up front.
+    explicit writer(const std::size_t bytes)
+    {
+      bytes_.reserve(bytes);
+    }
+
+    // Appends the low width bits of value, 0 <= width <= 64.
+    void write(const std::uint64_t value, const unsigned int width)
+    {
+      assert(width <= 64);
+
+      const std::uint64_t field = detail::low(value, width);
+
+      accumulator_ |= field << used_;
+      used_        += width;
+
+      if (used_ >= 64)
+      {
+        flush();
+        used_       -= 64;
+        accumulator_ = used_ != 0 ? field >> (width - used_) : 0;
+      }
+    }
+
+    // Pads with zero bits up to the next byte boundary.
+    void align()
+    {
+      write(0, (8 - used_ % 8) % 8);
+    }
+
+    // Bits written so far.
+    std::size_t size() const noexcept
+    {
+      return 8 * bytes_.size() + used_;
+    }
+
+    // The stream, its last byte padded with zero bits. The writer is left
+    // empty.
+    std::vector<std::uint8_t> finish()
+    {
+      std::uint8_t tail[8];
+      detail::store_le64(accumulator_, tail);
+      bytes_.insert(bytes_.end(), tail, tail + (used_ + 7) / 8);
+
+      accumulator_ = 0;
+      used_        = 0;
+
+      return std::move(bytes_);
+    }
+
+  private:
+    void flush()
+    {
+      const std::size_t end = bytes_.size();
+      bytes_.resize(end + 8);
+      detail::store_le64(accumulator_, bytes_.data() + end);
+    }
+
+    std::vector<std::uint8_t> bytes_;
+    std::uint64_t             accumulator_ = 0;
+    unsigned int              used_        = 0;
+  };
+
+  // Reads a stream in place. The bytes must outlive the reader. Past the
+  // end the stream reads as zero bits; overrun() tells a caller that a
+  // truncated input was decoded into them, so a record can be checked
+  // once instead of every field.
+  class reader
+  {
+  public:
+    reader(const std::uint8_t* bytes, const std::size_t size) noexcept
+      : bytes_(bytes), size_(size) {}
+
+    explicit reader(const std::vector<std::uint8_t>& bytes) noexcept
+      : reader(bytes.data(), bytes.size()) {}
+
+    // The next width bits, 0 <= width <= 56, without consuming them.
+    std::uint64_t peek(const unsigned int width) noexcept
+    {
+      assert(width <= 56);
+
+      if (available_ < width)
+      {
+        refill();
+      }
+
+      return detail::low(accumulator_, width);
+    }
+
+    // Consumes width bits that a peek() has made available.
+    void skip(const unsigned int width) noexcept
+    {
+      assert(width <= available_);
+
+      accumulator_ >>= width;
+      available_    -= width;
+    }
+
+    // The next width bits, 0 <= width <= 64.
+    std::uint64_t read(const unsigned int width) noexcept
+    {
+      assert(width <= 64);
+
+      if (width <= 56)
+      {
+        const std::uint64_t value = peek(width);
+        skip(width);
+        return value;
+      }
+
+      const std::uint64_t low = read(32);
+      return low | read(width - 32) << 32;
+    }
+
+    // Number of zero bits before the next one bit, which is consumed too.
+    // The bits already held are searched before any refill.
+    std::uint64_t read_unary() noexcept
+    {
+      std::uint64_t zeros = 0;
+
+      for (;;)
+      {
+        const std::uint64_t window = detail::low(accumulator_, available_);
+
+        if (window != 0)
+        {
+          const unsigned int n = countr_zero(window);
+          skip(n + 1);
+          return zeros + n;
+        }
+
+        zeros += available_;
+        skip(available_);
+
+        if (overrun())
+        {
+          return zeros;
+        }
+
+        refill();
+      }
+    }
+
+    // Skips to the next byte boundary.
+    void align() noexcept
+    {
+      read((8 - position() % 8) % 8);
+    }
+
+    // Bits consumed so far.
+    std::size_t position() const noexcept
+    {
+      return 8 * next_ - available_;
+    }
+
+    // Whether more bits have been consumed than the input holds.
+    bool overrun() const noexcept
+    {
+      return position() > 8 * size_;
+    }
+
+  private:
+    // Branch-free top-up (Giesen, "Reading bits in far too many ways"):
+    // load the eight bytes at next_ above the bits still held, advance
+    // next_ by the whole bytes that fit, and the accumulator holds 56 to
+    // 63 bits. Bits above available_ may already be set, but only to the
+    // values the next load ORs in again. Only the last eight bytes of the
+    // input are assembled a byte at a time.
+    void refill() noexcept
+    {
+      const std::uint64_t word = next_ + 8 <= size_ ? detail::load_le64(bytes_ + next_) : tail();
+
+      accumulator_ |= word << available_;
+      next_        += (63 - available_) / 8;
+      available_   |= 56;
+    }
+
+    std::uint64_t tail() const noexcept
+    {
+      std::uint64_t word = 0;
+
+      for (std::size_t i = next_; i < size_; ++i)
+      {
+        word |= std::uint64_t{bytes_[i]} << 8 * (i - next_);
+      }
+
+      return word;
+    }
+
+    const std::uint8_t* bytes_       = nullptr;
+    std::size_t         size_        = 0;
+    std::size_t         next_        = 0;
+    std::uint64_t       accumulator_ = 0;
+    unsigned int        available_   = 0;
+  };
+
+  // Universal and parameterised codes for unsigned integers: each is a
+  // pair of overloads, one writing to a writer and one reading from a
+  // reader.
+  namespace codes
+  {
+    // n zero bits and a one. Throws std::length_error if the stream's
+    // size in bits could not count them.
+    inline void unary(writer& out, std::uint64_t n)
+    {
+      if (n >= std::numeric_limits<std::size_t>::max() - out.size())
+      {
+        throw std::length_error("bit::codes: code longer than a stream can hold");
+      }
+
+      for (; n >= 32; n -= 32)
+      {
+        out.write(0, 32);
+      }
+
+      out.write(std::uint64_t{1} << n, static_cast<unsigned int>(n) + 1);
+    }
+
+    inline std::uint64_t unary(reader& in) noexcept
+    {
+      return in.read_unary();
+    }
+
+    // Elias gamma, x >= 1: floor(log2 x) in unary, then the bits of x
+    // below its leading one. 2 floor(log2 x) + 1 bits.
+    inline void gamma(writer& out, const std::uint64_t x)
+    {
+      assert(x != 0);
+
+      const unsigned int n = floor_log2(x);
+
+      if (n < 32)
+      {
+        out.write((x << (n + 1)) | (std::uint64_t{1} << n), 2 * n + 1);
+      }
+      else
+      {
+        out.write(std::uint64_t{1} << n, n + 1);
+        out.write(x, n);
+      }
+    }
+
+    // Codes of up to 55 bits, x < 2^27, come out of one peek: the zeros,
+    // the one and the bits below it are a single field.
+    inline std::uint64_t gamma(reader& in) noexcept
+    {
+      const std::uint64_t window = in.peek(56);
+      const unsigned int  n      = countr_zero(window);
+
+      if (n < 28)
+      {
+        in.skip(2 * n + 1);
+        return detail::low(window >> n, n + 1) >> 1 | std::uint64_t{1} << n;
+      }
+
+      const unsigned int m = static_cast<unsigned int>(in.read_unary()) & 63;
+      return std::uint64_t{1} << m | in.read(m);
+    }
+
+    // Elias delta, x >= 1: floor(log2 x) + 1 in gamma, then the bits of x
+    // below its leading one. Shorter than gamma from x = 32 on.
+    inline void delta(writer& out, const std::uint64_t x)
+    {
+      assert(x != 0);
+
+      const unsigned int n = floor_log2(x);
+
+      gamma(out, n + 1);
+      out.write(x, n);
+    }
+
+    inline std::uint64_t delta(reader& in) noexcept
+    {
+      const unsigned int n = static_cast<unsigned int>(gamma(in) - 1) & 63;
+      return std::uint64_t{1} << n | in.read(n);
+    }
+
+    // Golomb-Rice with parameter k < 64: x >> k in unary, then the low k
+    // bits of x. Suits geometrically distributed values with a mean
+    // around 2^k. Throws std::length_error as unary does.
+    inline void rice(writer& out, const std::uint64_t x, const unsigned int k)
+    {
+      assert(k < 64);
+
+      const std::uint64_t q = x >> k;
+
+      // q + 1 + k <= 64, compared without the sum, which wraps for
+      // q = 2^64 - 1.
+      if (q <= 63 - k)
+      {
+        out.write(std::uint64_t{1} << q | detail::low(x, k) << q << 1, static_cast<unsigned int>(q) + 1 + k);
+      }
+      else
+      {
+        if (q >= std::numeric_limits<std::size_t>::max() - out.size() - k)
+        {
+          throw std::length_error("bit::codes: code longer than a stream can hold");
+        }
+
+        unary(out, q);
+        out.write(x, k);
+      }
+    }
+
+    // As gamma, a code of up to 56 bits is one peek.
+    inline std::uint64_t rice(reader& in, const unsigned int k) noexcept
+    {
+      assert(k < 64);
+
+      const std::uint64_t window = in.peek(56);
+      const unsigned int  q      = countr_zero(window);
+
+      if (q + 1 + k <= 56)
+      {
+        in.skip(q + 1 + k);
+        return std::uint64_t{q} << k | detail::low(window >> q >> 1, k);
+      }
+
+      const std::uint64_t quotient = in.read_unary();
+      return quotient << k | in.read(k);
+    }
+
+    // LEB128: seven bits at a time from the least significant, the eighth
+    // bit of each group set when another follows. Groups are not aligned
+    // to bytes unless the stream is.
+    inline void varint(writer& out, std::uint64_t x)
+    {
+      for (; x >= std::uint64_t{1} << 56; x >>= 7)
+      {
+        out.write((x & 0x7f) | 0x80, 8);
+      }
+
+      // The last eight groups or fewer go out as one field.
+      std::uint64_t groups = 0;
+      unsigned int  width  = 0;
+
+      for (; x >= 0x80; x >>= 7, width += 8)
+      {
+        groups |= ((x & 0x7f) | 0x80) << width;
+      }
+
+      out.write(groups | x << width, width + 8);
+    }
+
+    // A varint of up to seven groups is found in one peek by its first
+    // clear continuation bit, then its groups are gathered without a
+    // branch on each.
+    inline std::uint64_t varint(reader& in) noexcept
+    {
+      const std::uint64_t window = in.peek(56);
+      const std::uint64_t last   = ~window & 0x0080808080808080ULL;
+
+      if (last != 0)
+      {
+        const unsigned int  width = countr_zero(last) + 1;
+        const std::uint64_t bytes = detail::low(window, width);
+
+        in.skip(width);
+
+        std::uint64_t x = 0;
+
+        for (unsigned int g = 0; g != 7; ++g)
+        {
+          x |= (bytes >> (8 * g) & 0x7f) << (7 * g);
+        }
+
+        return x;
+      }
+
+      std::uint64_t x = 0;
+
+      for (unsigned int shift = 0; shift < 64; shift += 7)
+      {
+        const std::uint64_t group = in.read(8);
+        x |= (group & 0x7f) << shift;
+
+        if ((group & 0x80) == 0)
+        {
+          break;
+        }
+      }
+
+      return x;
+    }
+  }
+}
@@ -0,0 +1,367 @@
+#pragma once
+
+#include "bit/bit.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Subset dynamic programming over bitmask indices: a table of 2^n values,
+// the value of set S at index S. Enumerations of the subsets and
+// supersets of a mask and of the masks of each popcount, and the
+// transforms that sum every value over the subsets (zeta) or supersets of
+// each index, with their inverses (Moebius).
+//
+// A transform is n passes, one per bit, each combining every pair of
+// indices that differ in that bit. Done pass by pass over a table larger
+// than the cache that is n trips through memory. Here the passes are
+// grouped instead: the low bits are finished one cache-sized block at a
+// time, then the higher bits a group at a time over tiles of short runs
+// strided 2^lo apart, so a table of 2^26 values goes through memory
+// three or four times rather than 26. Blocks and tiles are independent
+// and split across threads.
+namespace bit
+{
+  // The next larger value with as many set bits as x (Gosper's hack,
+  // HAKMEM 175), for unsigned x != 0 with such a value in T: the lowest
+  // run of ones moves its top bit up one place and the rest to the
+  // bottom.
+  template <typename T>
+  inline constexpr
+  T next_combination(const T x) noexcept
+  {
+    static_assert(std::is_unsigned<T>::value, "next_combination needs an unsigned type");
+
+    const T lowest = static_cast<T>(x & (~x + 1));
+    const T ripple = static_cast<T>(x + lowest);
+
+    return static_cast<T>(ripple | static_cast<T>(static_cast<T>(ripple ^ x) >> 2 >> countr_zero(x)));
+  }
+
+  // f(s) for every subset s of mask, from mask itself down to 0.
+  template <typename T, typename F>
+  inline void for_each_subset(const T mask, F f)
+  {
+    static_assert(std::is_unsigned<T>::value, "for_each_subset needs an unsigned type");
+
+    for (T s = mask;; s = static_cast<T>((s - 1) & mask))
+    {
+      f(s);
+
+      if (s == 0)
+      {
+        return;
+      }
+    }
+  }
+
+  // f(s) for every superset s of mask among the n-bit masks, from mask
+  // up to 2^n - 1, for mask < 2^n and n < 64.
+  template <typename F>
+  inline void for_each_superset(const std::uint64_t mask, const unsigned int n, F f)
+  {
+    const std::uint64_t all = (std::uint64_t{1} << n) - 1;
+
+    for (std::uint64_t s = mask;; s = (s + 1) | mask)
+    {
+      f(s);
+
+      if (s == all)
+      {
+        return;
+      }
+    }
+  }
+
+  // f(s) for every n-bit mask with k set bits in ascending order,
+  // k <= n < 64.
+  template <typename F>
+  inline void for_each_combination(const unsigned int n, const unsigned int k, F f)
+  {
+    if (k == 0)
+    {
+      f(std::uint64_t{0});
+      return;
+    }
+
+    const std::uint64_t last = ((std::uint64_t{1} << k) - 1) << (n - k);
+
+    for (std::uint64_t s = (std::uint64_t{1} << k) - 1;; s = next_combination(s))
+    {
+      f(s);
+
+      if (s == last)
+      {
+        return;
+      }
+    }
+  }
+
+  // f(s) for every n-bit mask by popcount layers, 0 first and 2^n - 1
+  // last: a set comes after all of its proper subsets, the order of a DP
+  // whose value at S reads its values at smaller sets.
+  template <typename F>
+  inline void for_each_layer(const unsigned int n, F f)
+  {
+    for (unsigned int k = 0; k <= n; ++k)
+    {
+      for_each_combination(n, k, f);
+    }
+  }
+
+  namespace detail
+  {
+    // f(i) for i in [0, count), split into contiguous ranges over threads
+    // threads, 0 for one per hardware thread, the caller running the
+    // first range.
+    template <typename F>
+    void parallel_for(const std::size_t count, unsigned int threads, F f)
+    {
+      if (threads == 0)
+      {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+
+      const std::size_t parts = std::min<std::size_t>(threads, count);
+
+      if (parts <= 1)
+      {
+        for (std::size_t i = 0; i != count; ++i)
+        {
+          f(i);
+        }
+
+        return;
+      }
+
+      const auto range = [&](const std::size_t part)
+      {
+        for (std::size_t i = count * part / parts; i != count * (part + 1) / parts; ++i)
+        {
+          f(i);
+        }
+      };
+
+      std::vector<std::thread> workers;
+      workers.reserve(parts - 1);
+
+      for (std::size_t part = 1; part != parts; ++part)
+      {
+        workers.emplace_back(range, part);
+      }
+
+      range(0);
+
+      for (std::thread& worker : workers)
+      {
+        worker.join();
+      }
+    }
+
+    // One bit's combination over length pairs: towards the larger sets
+    // for subsets, values[S | bit] from values[S], towards the smaller
+    // for supersets.
+    template <bool Subsets, typename T, typename Op>
+    inline void combine(T* without, T* with, const std::size_t length, Op& op)
+    {
+      for (std::size_t k = 0; k != length; ++k)
+      {
+        if (Subsets)
+        {
+          op(with[k], static_cast<const T&>(without[k]));
+        }
+        else
+        {
+          op(without[k], static_cast<const T&>(with[k]));
+        }
+      }
+    }
+
+    // Bits [0, bits) of the 2^bits values at block. The three lowest
+    // would pair runs of one, two and four values; they go eight values
+    // at a time instead, unrolled, which the compiler vectorizes.
+    template <bool Subsets, typename T, typename Op>
+    void transform_block(T* block, const unsigned int bits, Op& op)
+    {
+      unsigned int j = 0;
+
+      if (bits >= 3)
+      {
+        for (std::size_t i = 0; i != std::size_t{1} << bits; i += 8)
+        {
+          for (unsigned int half = 1; half != 8; half *= 2)
+          {
+            for (unsigned int k = 0; k != 8; ++k)
+            {
+              if ((k & half) != 0)
+              {
+                combine<Subsets>(block + i + (k ^ half), block + i + k, 1, op);
+              }
+            }
+          }
+        }
+
+        j = 3;
+      }
+
+      for (; j != bits; ++j)
+      {
+        const std::size_t half = std::size_t{1} << j;
+
+        for (std::size_t i = 0; i != std::size_t{1} << bits; i += 2 * half)
+        {
+          combine<Subsets>(block + i, block + i + half, half, op);
+        }
+      }
+    }
+
+    // Bits [lo, lo + bits) of the 2^bits runs of length values at first,
+    // first + 2^lo, first + 2 * 2^lo and so on.
+    template <bool Subsets, typename T, typename Op>
+    void transform_rows(T* first, const unsigned int lo, const unsigned int bits, const std::size_t length, Op& op)
+    {
+      for (unsigned int j = 0; j != bits; ++j)
+      {
+        const std::size_t half = std::size_t{1} << j;
+
+        for (std::size_t r = 0; r != std::size_t{1} << bits; r += 2 * half)
+        {
+          for (std::size_t q = r; q != r + half; ++q)
+          {
+            combine<Subsets>(first + (q << lo), first + ((q + half) << lo), length, op);
+          }
+        }
+      }
+    }
+
+    // Blocks of 2^tile values, about 128 KiB, stay in the L2 cache while
+    // all their passes run; runs of 2^run values, about 1 KiB, are long
+    // enough to stream and vectorize.
+    template <typename T>
+    inline constexpr
+    unsigned int tile_bits() noexcept
+    {
+      return 17 - std::min(10u, floor_log2(sizeof(T)));
+    }
+
+    template <typename T>
+    inline constexpr
+    unsigned int run_bits() noexcept
+    {
+      return 10 - std::min(10u, floor_log2(sizeof(T)));
+    }
+
+    template <bool Subsets, typename T, typename Op>
+    void transform(T* values, const unsigned int n, Op op, const unsigned int threads,
+                   const unsigned int tile, const unsigned int run)
+    {
+      const unsigned int low = std::min(n, tile);
+
+      parallel_for(std::size_t{1} << (n - low), threads, [&](const std::size_t b)
+      {
+        transform_block<Subsets>(values + (b << low), low, op);
+      });
+
+      for (unsigned int lo = low, bits; lo != n; lo += bits)
+      {
+        bits = std::min(n - lo, tile - run);
+
+        // A tile is a run position below bit lo and a choice of the bits
+        // above lo + bits.
+        const unsigned int runs = lo - run;
+
+        parallel_for(std::size_t{1} << (n - bits - run), threads, [&, bits](const std::size_t t)
+        {
+          T* first = values + ((t >> runs) << (lo + bits)) + ((t & ((std::size_t{1} << runs) - 1)) << run);
+          transform_rows<Subsets>(first, lo, bits, std::size_t{1} << run, op);
+        });
+      }
+    }
+
+    template <typename T>
+    unsigned int table_bits(const std::vector<T>& values)
+    {
+      if (values.empty() || (values.size() & (values.size() - 1)) != 0)
+      {
+        throw std::invalid_argument("bit: a subset table needs a power-of-two size");
+      }
+
+      return floor_log2(values.size());
+    }
+  }
+
+  // values[S] = op-fold of values[T] over every subset T of S, for the
+  // 2^n values at values: op(into, from) folds from into into, e.g.
+  // into += from or into = std::max(into, from). With threads other
+  // than 1 (0 for one per hardware thread) op runs concurrently on
+  // distinct values and must not throw.
+  template <typename T, typename Op>
+  void subset_transform(T* values, const unsigned int n, Op op, const unsigned int threads = 1)
+  {
+    detail::transform<true>(values, n, op, threads, detail::tile_bits<T>(), detail::run_bits<T>());
+  }
+
+  // values[S] = op-fold of values[T] over every superset T of S.
+  template <typename T, typename Op>
+  void superset_transform(T* values, const unsigned int n, Op op, const unsigned int threads = 1)
+  {
+    detail::transform<false>(values, n, op, threads, detail::tile_bits<T>(), detail::run_bits<T>());
+  }
+
+  // Sum over subsets: values[S] = sum of values[T] for T a subset of S.
+  template <typename T>
+  void subset_zeta(T* values, const unsigned int n, const unsigned int threads = 1)
+  {
+    subset_transform(values, n, [](T& into, const T& from) { into += from; }, threads);
+  }
+
+  // The inverse of subset_zeta: from sums over subsets, the values.
+  template <typename T>
+  void subset_mobius(T* values, const unsigned int n, const unsigned int threads = 1)
+  {
+    subset_transform(values, n, [](T& into, const T& from) { into -= from; }, threads);
+  }
+
+  // Sum over supersets: values[S] = sum of values[T] for T a superset of
+  // S.
+  template <typename T>
+  void superset_zeta(T* values, const unsigned int n, const unsigned int threads = 1)
+  {
+    superset_transform(values, n, [](T& into, const T& from) { into += from; }, threads);
+  }
+
+  template <typename T>
+  void superset_mobius(T* values, const unsigned int n, const unsigned int threads = 1)
+  {
+    superset_transform(values, n, [](T& into, const T& from) { into -= from; }, threads);
+  }
+
+  // Whole tables, n taken from the size, which must be a power of two.
+  template <typename T>
+  void subset_zeta(std::vector<T>& values, const unsigned int threads = 1)
+  {
+    subset_zeta(values.data(), detail::table_bits(values), threads);
+  }
+
+  template <typename T>
+  void subset_mobius(std::vector<T>& values, const unsigned int threads = 1)
+  {
+    subset_mobius(values.data(), detail::table_bits(values), threads);
+  }
+
+  template <typename T>
+  void superset_zeta(std::vector<T>& values, const unsigned int threads = 1)
+  {
+    superset_zeta(values.data(), detail::table_bits(values), threads);
+  }
+
+  template <typename T>
+  void superset_mobius(std::vector<T>& values, const unsigned int threads = 1)
+  {
+    superset_mobius(values.data(), detail::table_bits(values), threads);
+  }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Lookup tables computed by the compiler. They live in read-only data,
+// need no initialization at run time, and can be read in constant
+// expressions, so the kernels built on them are constexpr too.
+namespace bit
+{
+  template <typename T, std::size_t N>
+  struct lookup_table
+  {
+    T entries[N];
+
+    constexpr const T& operator[](const std::size_t i) const noexcept
+    {
+      return entries[i];
+    }
+
+    static constexpr std::size_t size() noexcept
+    {
+      return N;
+    }
+  };
+
+  // The table of function(0) .. function(N - 1). Function must be a
+  // literal type with a constexpr call operator.
+  template <typename T, std::size_t N, typename Function>
+  inline constexpr
+  lookup_table<T, N> make_table(const Function function) noexcept
+  {
+    lookup_table<T, N> table{};
+
+    for (std::size_t i = 0; i != N; ++i)
+    {
+      table.entries[i] = function(i);
+    }
+
+    return table;
+  }
+
+  namespace tables
+  {
+    struct popcount_of
+    {
+      constexpr std::uint8_t operator()(std::size_t byte) const noexcept
+      {
+        std::uint8_t n = 0;
+
+        for (; byte != 0; byte &= byte - 1)
+        {
+          ++n;
+        }
+
+        return n;
+      }
+    };
+
+    struct reverse_of
+    {
+      constexpr std::uint8_t operator()(const std::size_t byte) const noexcept
+      {
+        std::uint8_t reversed = 0;
+
+        for (unsigned int i = 0; i != 8; ++i)
+        {
+          reversed |= ((byte >> i) & 1) << (7 - i);
+        }
+
+        return reversed;
+      }
+    };
+
+    struct leading_zeros_of
+    {
+      constexpr std::uint8_t operator()(const std::size_t byte) const noexcept
+      {
+        std::uint8_t n = 0;
+
+        while (n != 8 && !(byte & (0x80 >> n)))
+        {
+          ++n;
+        }
+
+        return n;
+      }
+    };
+
+    struct trailing_zeros_of
+    {
+      constexpr std::uint8_t operator()(const std::size_t byte) const noexcept
+      {
+        std::uint8_t n = 0;
+
+        while (n != 8 && !(byte & (1 << n)))
+        {
+          ++n;
+        }
+
+        return n;
+      }
+    };
+
+    // Static members of a class template have one definition across the
+    // program, where a namespace-scope constexpr array would be copied
+    // into every translation unit.
+    template <typename = void>
+    struct bytes_
+    {
+      static constexpr lookup_table<std::uint8_t, 256> popcount       = make_table<std::uint8_t, 256>(popcount_of{});
+      static constexpr lookup_table<std::uint8_t, 256> reverse        = make_table<std::uint8_t, 256>(reverse_of{});
+      static constexpr lookup_table<std::uint8_t, 256> leading_zeros  = make_table<std::uint8_t, 256>(leading_zeros_of{});
+      static constexpr lookup_table<std::uint8_t, 256> trailing_zeros = make_table<std::uint8_t, 256>(trailing_zeros_of{});
+    };
+
+    template <typename D> constexpr lookup_table<std::uint8_t, 256> bytes_<D>::popcount;
+    template <typename D> constexpr lookup_table<std::uint8_t, 256> bytes_<D>::reverse;
+    template <typename D> constexpr lookup_table<std::uint8_t, 256> bytes_<D>::leading_zeros;
+    template <typename D> constexpr lookup_table<std::uint8_t, 256> bytes_<D>::trailing_zeros;
+
+    // Per byte value: set bits, the byte with its bits in reverse order,
+    // and zero bits above the highest and below the lowest set bit (8 for
+    // a zero byte).
+    using bytes = bytes_<>;
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bit-matrix transposes. A matrix is an array of rows, one word per row,
+// bit c of row r being element (r, c): after transposing, bit c of row r
+// is what bit r of row c was.
+namespace bit
+{
+  // Transposes the 8x8 matrix held in one word, row r in byte r, with
+  // three shift-and-mask delta swaps: the off-diagonal bits of every 2x2
+  // block, the off-diagonal 2x2 blocks of every 4x4 block, then the two
+  // off-diagonal 4x4 blocks.
+  inline constexpr
+  std::uint64_t transpose8(std::uint64_t x) noexcept
+  {
+    std::uint64_t t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x ^= t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x ^= t ^ (t << 14);
+
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    return x ^ t ^ (t << 28);
+  }
+
+  // Transposes the 64x64 matrix rows[0, 64) in place by recursive block
+  // swaps (Warren, Hacker's Delight, 7-3): swap the top-right and
+  // bottom-left 32x32 blocks, then the off-diagonal 16x16 blocks of each
+  // quadrant, and so on down to single bits. Six rounds of 32 masked
+  // exchanges instead of 4096 single-bit moves.
+  inline constexpr
+  void transpose64(std::uint64_t* rows) noexcept
+  {
+    std::uint64_t mask = 0x00000000ffffffffULL;
+
+    for (unsigned int j = 32; j != 0; j >>= 1, mask ^= mask << j)
+    {
+      for (unsigned int k = 0; k != 64; k = ((k | j) + 1) & ~j)
+      {
+        const std::uint64_t t = ((rows[k] >> j) ^ rows[k | j]) & mask;
+
+        rows[k | j] ^= t;
+        rows[k]     ^= t << j;
+      }
+    }
+  }
+}
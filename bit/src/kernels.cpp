@@ -0,0 +1,1307 @@
+#include "bit/kernels.hpp"
+#include "bit/bit.hpp"
+#include "bit/bloom.hpp"
+#include "bit/transpose.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BIT_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace bit
+{
+  namespace kernels
+  {
+    namespace
+    {
+      using count_fn    = std::uint64_t (*)(const std::uint64_t*, std::size_t);
+      using hamming_fn  = std::uint64_t (*)(const std::uint64_t*, const std::uint64_t*, std::size_t);
+      using transform_fn = void (*)(const std::uint64_t*, std::size_t, std::uint64_t, std::uint64_t*);
+      using width32_fn   = void (*)(const std::uint32_t*, std::size_t, std::uint8_t*);
+      using width64_fn   = void (*)(const std::uint64_t*, std::size_t, std::uint8_t*);
+      using matrix_fn    = void (*)(std::uint64_t*, std::size_t);
+      using block_fn     = void (*)(const std::uint32_t*, std::uint32_t*);
+      using blocks_fn    = const block_fn* (*)();
+      using intersect_fn = std::size_t (*)(const std::uint16_t*, std::size_t, const std::uint16_t*, std::size_t,
+                                           std::uint16_t*);
+      using bloom_insert_fn = void (*)(std::uint64_t*, std::size_t, const std::uint64_t*, std::size_t);
+      using bloom_query_fn  = std::size_t (*)(const std::uint64_t*, std::size_t, const std::uint64_t*, std::size_t,
+                                              std::uint8_t*);
+
+      struct table
+      {
+        count_fn     count;
+        hamming_fn   hamming_distance;
+        transform_fn extract;
+        transform_fn deposit;
+        width32_fn   bit_width32;
+        width64_fn   bit_width64;
+        matrix_fn    transpose64;
+        blocks_fn    pack128;
+        blocks_fn    unpack128;
+        intersect_fn intersect16;
+        bloom_insert_fn bloom_insert;
+        bloom_query_fn  bloom_query;
+      };
+
+      // A kernel per width 0 .. 32, each with the width as a constant so
+      // that its shifts and word boundaries are fixed at compile time.
+      template <template <unsigned int> class Kernel, unsigned int... Widths>
+      const block_fn* per_width(std::integer_sequence<unsigned int, Widths...>)
+      {
+        static const block_fn kernels[] = {&Kernel<Widths>::run...};
+        return kernels;
+      }
+
+      template <template <unsigned int> class Kernel>
+      const block_fn* per_width()
+      {
+        return per_width<Kernel>(std::make_integer_sequence<unsigned int, 33>{});
+      }
+
+      // Generic: SWAR population count, bit-by-bit PEXT/PDEP and the
+      // scalar bit_width.
+
+      inline std::uint64_t popcount(std::uint64_t x) noexcept
+      {
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return (x * 0x0101010101010101ULL) >> 56;
+      }
+
+      std::uint64_t count_generic(const std::uint64_t* words, const std::size_t n)
+      {
+        std::uint64_t total = 0;
+
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          total += popcount(words[i]);
+        }
+
+        return total;
+      }
+
+      std::uint64_t hamming_generic(const std::uint64_t* a, const std::uint64_t* b, const std::size_t n)
+      {
+        std::uint64_t total = 0;
+
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          total += popcount(a[i] ^ b[i]);
+        }
+
+        return total;
+      }
+
+      void extract_generic(const std::uint64_t* words, const std::size_t n, const std::uint64_t mask,
+                           std::uint64_t* out)
+      {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          std::uint64_t result = 0;
+          std::uint64_t bit    = 1;
+
+          for (std::uint64_t m = mask; m != 0; m &= m - 1, bit <<= 1)
+          {
+            if (words[i] & m & -m) result |= bit;
+          }
+
+          out[i] = result;
+        }
+      }
+
+      void deposit_generic(const std::uint64_t* words, const std::size_t n, const std::uint64_t mask,
+                           std::uint64_t* out)
+      {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          std::uint64_t result = 0;
+          std::uint64_t bit    = 1;
+
+          for (std::uint64_t m = mask; m != 0; m &= m - 1, bit <<= 1)
+          {
+            if (words[i] & bit) result |= m & -m;
+          }
+
+          out[i] = result;
+        }
+      }
+
+      template <typename Word>
+      void bit_width_generic(const Word* values, const std::size_t n, std::uint8_t* out)
+      {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          out[i] = static_cast<std::uint8_t>(bit::bit_width(values[i]));
+        }
+      }
+
+      void transpose64_generic(std::uint64_t* matrices, const std::size_t n)
+      {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          bit::transpose64(matrices + 64 * i);
+        }
+      }
+
+      // One lane of a vertical block at a time.
+
+      template <unsigned int Width>
+      struct pack128_generic
+      {
+        static void run(const std::uint32_t* values, std::uint32_t* out)
+        {
+          const std::uint32_t mask = Width == 32 ? ~0U : (1U << Width) - 1;
+
+          for (unsigned int lane = 0; lane != 4 && Width != 0; ++lane)
+          {
+            std::uint32_t* words = out + lane;
+            std::uint32_t  word  = 0;
+            unsigned int   used  = 0;
+
+            for (unsigned int i = 0; i != 32; ++i)
+            {
+              const std::uint32_t value = values[4 * i + lane] & mask;
+
+              word |= value << used;
+              used += Width;
+
+              if (used >= 32)
+              {
+                *words = word;
+                words += 4;
+                used -= 32;
+                word = used != 0 ? value >> (Width - used) : 0;
+              }
+            }
+          }
+        }
+      };
+
+      template <unsigned int Width>
+      struct unpack128_generic
+      {
+        static void run(const std::uint32_t* packed, std::uint32_t* out)
+        {
+          const std::uint32_t mask = Width == 32 ? ~0U : (1U << Width) - 1;
+
+          for (unsigned int lane = 0; lane != 4; ++lane)
+          {
+            const std::uint32_t* words = packed + lane;
+            unsigned int         used  = 0;
+
+            for (unsigned int i = 0; i != 32; ++i)
+            {
+              std::uint32_t value = Width == 0 ? 0 : *words >> used;
+
+              used += Width;
+
+              if (used >= 32 && i != 31)
+              {
+                words += 4;
+                used -= 32;
+
+                if (used != 0)
+                {
+                  value |= *words << (Width - used);
+                }
+              }
+
+              out[4 * i + lane] = value & mask;
+            }
+          }
+        }
+      };
+
+      const block_fn* pack128_generic_kernels() { return per_width<pack128_generic>(); }
+      const block_fn* unpack128_generic_kernels() { return per_width<unpack128_generic>(); }
+
+      // A merge, from position i of a and j of b.
+      std::size_t intersect16_merge(const std::uint16_t* a, std::size_t i, const std::size_t na,
+                                    const std::uint16_t* b, std::size_t j, const std::size_t nb,
+                                    std::uint16_t* out) noexcept
+      {
+        std::size_t n = 0;
+
+        while (i != na && j != nb)
+        {
+          if (a[i] < b[j])
+          {
+            ++i;
+          }
+          else if (b[j] < a[i])
+          {
+            ++j;
+          }
+          else
+          {
+            out[n++] = a[i];
+            ++i;
+            ++j;
+          }
+        }
+
+        return n;
+      }
+
+      std::size_t intersect16_generic(const std::uint16_t* a, const std::size_t na, const std::uint16_t* b,
+                                      const std::size_t nb, std::uint16_t* out)
+      {
+        return intersect16_merge(a, 0, na, b, 0, nb, out);
+      }
+
+      // Up to bloom_group keys hashed, and the blocks they fall in
+      // prefetched, before any of them is probed.
+      struct bloom_keys
+      {
+        bloom_keys(const std::uint64_t* blocks, const std::size_t nblocks, const std::uint64_t* keys,
+                   const std::size_t n) noexcept
+          : size(n)
+        {
+          for (std::size_t j = 0; j != n; ++j)
+          {
+            const std::uint64_t hash = detail::bloom_hash(keys[j]);
+
+            bits[j]  = detail::bloom_bits(hash);
+            block[j] = 8 * detail::bloom_block(hash, nblocks);
+            __builtin_prefetch(blocks + block[j]);
+          }
+        }
+
+        std::size_t   size;
+        std::uint64_t bits[bloom_group];
+        std::size_t   block[bloom_group];
+      };
+
+      void bloom_insert_generic(std::uint64_t* blocks, const std::size_t nblocks, const std::uint64_t* keys,
+                                const std::size_t n)
+      {
+        for (std::size_t first = 0; first < n; first += bloom_group)
+        {
+          const bloom_keys group(blocks, nblocks, keys + first, std::min(bloom_group, n - first));
+
+          for (std::size_t j = 0; j != group.size; ++j)
+          {
+            std::uint64_t* block = blocks + group.block[j];
+
+            for (unsigned int w = 0; w != 8; ++w)
+            {
+              block[w] |= detail::bloom_mask(group.bits[j], w);
+            }
+          }
+        }
+      }
+
+      std::size_t bloom_query_generic(const std::uint64_t* blocks, const std::size_t nblocks,
+                                      const std::uint64_t* keys, const std::size_t n, std::uint8_t* out)
+      {
+        std::size_t hits = 0;
+
+        for (std::size_t first = 0; first < n; first += bloom_group)
+        {
+          const bloom_keys group(blocks, nblocks, keys + first, std::min(bloom_group, n - first));
+
+          for (std::size_t j = 0; j != group.size; ++j)
+          {
+            const std::uint64_t* block = blocks + group.block[j];
+            std::uint64_t        miss  = 0;
+
+            for (unsigned int w = 0; w != 8; ++w)
+            {
+              miss |= detail::bloom_mask(group.bits[j], w) & ~block[w];
+            }
+
+            out[first + j] = miss == 0;
+            hits          += miss == 0;
+          }
+        }
+
+        return hits;
+      }
+
+      constexpr table generic_table = {count_generic, hamming_generic, extract_generic, deposit_generic,
+                                       bit_width_generic<std::uint32_t>, bit_width_generic<std::uint64_t>,
+                                       transpose64_generic, pack128_generic_kernels, unpack128_generic_kernels,
+                                       intersect16_generic, bloom_insert_generic, bloom_query_generic};
+
+#if defined(BIT_KERNELS_X86)
+
+      // SSE4.2: the POPCNT instruction, four independent accumulators to
+      // hide its latency.
+
+      __attribute__((target("popcnt")))
+      std::uint64_t count_sse42(const std::uint64_t* words, const std::size_t n)
+      {
+        std::uint64_t t0 = 0, t1 = 0, t2 = 0, t3 = 0;
+        std::size_t i = 0;
+
+        for (; i + 4 <= n; i += 4)
+        {
+          t0 += _mm_popcnt_u64(words[i]);
+          t1 += _mm_popcnt_u64(words[i + 1]);
+          t2 += _mm_popcnt_u64(words[i + 2]);
+          t3 += _mm_popcnt_u64(words[i + 3]);
+        }
+
+        for (; i != n; ++i)
+        {
+          t0 += _mm_popcnt_u64(words[i]);
+        }
+
+        return t0 + t1 + t2 + t3;
+      }
+
+      __attribute__((target("popcnt")))
+      std::uint64_t hamming_sse42(const std::uint64_t* a, const std::uint64_t* b, const std::size_t n)
+      {
+        std::uint64_t t0 = 0, t1 = 0, t2 = 0, t3 = 0;
+        std::size_t i = 0;
+
+        for (; i + 4 <= n; i += 4)
+        {
+          t0 += _mm_popcnt_u64(a[i] ^ b[i]);
+          t1 += _mm_popcnt_u64(a[i + 1] ^ b[i + 1]);
+          t2 += _mm_popcnt_u64(a[i + 2] ^ b[i + 2]);
+          t3 += _mm_popcnt_u64(a[i + 3] ^ b[i + 3]);
+        }
+
+        for (; i != n; ++i)
+        {
+          t0 += _mm_popcnt_u64(a[i] ^ b[i]);
+        }
+
+        return t0 + t1 + t2 + t3;
+      }
+
+      // BSR, with a branch for zero, since LZCNT is not part of this level.
+      template <typename Word>
+      void bit_width_sse42(const Word* values, const std::size_t n, std::uint8_t* out)
+      {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          out[i] = static_cast<std::uint8_t>(values[i] == 0 ? 0 : 64 - __builtin_clzll(values[i]));
+        }
+      }
+
+      // SIMD-BP128 proper: the four lanes of a block are the four 32-bit
+      // elements of an SSE register, so each instruction packs or unpacks
+      // one value of every lane. SSE2 is all it needs; the wider levels
+      // use it too, since the layout is fixed at 128 bits.
+
+      // Position I of every lane: its word and shift are constants, so a
+      // block is straight-line code.
+      template <unsigned int Width, unsigned int I>
+      inline __m128i extract128_sse(const __m128i* words) noexcept
+      {
+        constexpr unsigned int word  = I * Width / 32;
+        constexpr unsigned int shift = I * Width % 32;
+
+        __m128i value = _mm_srli_epi32(_mm_loadu_si128(words + word), shift);
+
+        if (shift + Width > 32)
+        {
+          value = _mm_or_si128(value, _mm_slli_epi32(_mm_loadu_si128(words + word + 1), (32 - shift) % 32));
+        }
+
+        return Width == 32 ? value : _mm_and_si128(value, _mm_set1_epi32(static_cast<int>((1U << (Width % 32)) - 1)));
+      }
+
+      template <unsigned int Width, unsigned int I>
+      inline void insert128_sse(const __m128i value, __m128i* words) noexcept
+      {
+        constexpr unsigned int word  = I * Width / 32;
+        constexpr unsigned int shift = I * Width % 32;
+
+        const __m128i low = Width == 32 ? value
+                                        : _mm_and_si128(value, _mm_set1_epi32(static_cast<int>((1U << (Width % 32)) - 1)));
+
+        words[word] = _mm_or_si128(words[word], _mm_slli_epi32(low, shift));
+
+        if (shift + Width > 32)
+        {
+          words[word + 1] = _mm_or_si128(words[word + 1], _mm_srli_epi32(low, (32 - shift) % 32));
+        }
+      }
+
+      template <unsigned int Width, unsigned int... I>
+      inline void pack128_sse(const std::uint32_t* values, std::uint32_t* out,
+                              std::integer_sequence<unsigned int, I...>) noexcept
+      {
+        __m128i words[Width + 1] = {};
+
+        const int expand[] = {(insert128_sse<Width, I>(
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(values) + I), words), 0)...};
+        static_cast<void>(expand);
+
+        for (unsigned int w = 0; w != Width; ++w)
+        {
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + w, words[w]);
+        }
+      }
+
+      template <unsigned int Width, unsigned int... I>
+      inline void unpack128_sse(const std::uint32_t* packed, std::uint32_t* out,
+                                std::integer_sequence<unsigned int, I...>) noexcept
+      {
+        const __m128i* words = reinterpret_cast<const __m128i*>(packed);
+
+        const int expand[] = {(_mm_storeu_si128(reinterpret_cast<__m128i*>(out) + I,
+                                                extract128_sse<Width, I>(words)), 0)...};
+        static_cast<void>(expand);
+      }
+
+      template <unsigned int Width>
+      struct pack128_sse_kernel
+      {
+        static void run(const std::uint32_t* values, std::uint32_t* out)
+        {
+          pack128_sse<Width>(values, out, std::make_integer_sequence<unsigned int, 32>{});
+        }
+      };
+
+      template <>
+      struct pack128_sse_kernel<0>
+      {
+        static void run(const std::uint32_t*, std::uint32_t*) {}
+      };
+
+      template <unsigned int Width>
+      struct unpack128_sse_kernel
+      {
+        static void run(const std::uint32_t* packed, std::uint32_t* out)
+        {
+          unpack128_sse<Width>(packed, out, std::make_integer_sequence<unsigned int, 32>{});
+        }
+      };
+
+      template <>
+      struct unpack128_sse_kernel<0>
+      {
+        static void run(const std::uint32_t*, std::uint32_t* out)
+        {
+          std::memset(out, 0, 128 * sizeof(std::uint32_t));
+        }
+      };
+
+      const block_fn* pack128_sse_kernels() { return per_width<pack128_sse_kernel>(); }
+      const block_fn* unpack128_sse_kernels() { return per_width<unpack128_sse_kernel>(); }
+
+      // Eight values of a against eight of b with one PCMPESTRM (Schlegel,
+      // Willhalm and Lehner, "Fast Sorted-Set Intersection using SIMD
+      // Instructions", 2011): the result masks the values of a found in b,
+      // and a byte shuffle picked by that mask moves them to the front.
+      // Whichever block ends lower is done with and the next is loaded;
+      // the remainder is merged. The explicit-length form is needed since
+      // zero is a value, not a terminator.
+
+      struct compress16_table
+      {
+        std::uint8_t shuffle[256][16];
+
+        constexpr compress16_table() : shuffle{}
+        {
+          for (unsigned int mask = 0; mask != 256; ++mask)
+          {
+            unsigned int k = 0;
+
+            for (unsigned int lane = 0; lane != 8; ++lane)
+            {
+              if ((mask >> lane) & 1)
+              {
+                shuffle[mask][2 * k]     = static_cast<std::uint8_t>(2 * lane);
+                shuffle[mask][2 * k + 1] = static_cast<std::uint8_t>(2 * lane + 1);
+                ++k;
+              }
+            }
+
+            for (unsigned int b = 2 * k; b != 16; ++b)
+            {
+              shuffle[mask][b] = 0x80;
+            }
+          }
+        }
+      };
+
+      constexpr compress16_table compress16{};
+
+      __attribute__((target("sse4.2,popcnt")))
+      std::size_t intersect16_sse42(const std::uint16_t* a, const std::size_t na, const std::uint16_t* b,
+                                    const std::size_t nb, std::uint16_t* out)
+      {
+        constexpr int mode = _SIDD_UWORD_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+
+        std::size_t i = 0, j = 0, n = 0;
+
+        if (na >= 8 && nb >= 8)
+        {
+          __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+          __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+
+          for (;;)
+          {
+            const unsigned int found = static_cast<unsigned int>(_mm_cvtsi128_si32(_mm_cmpestrm(vb, 8, va, 8, mode)));
+            const __m128i      kept  = _mm_shuffle_epi8(va, _mm_loadu_si128(reinterpret_cast<const __m128i*>(compress16.shuffle[found])));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), kept);
+            n += _mm_popcnt_u32(found);
+
+            const std::uint16_t a_last = a[i + 7];
+            const std::uint16_t b_last = b[j + 7];
+
+            if (a_last <= b_last)
+            {
+              i += 8;
+
+              if (i + 8 > na)
+              {
+                break;
+              }
+
+              va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            }
+
+            if (b_last <= a_last)
+            {
+              j += 8;
+
+              if (j + 8 > nb)
+              {
+                break;
+              }
+
+              vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+            }
+          }
+        }
+
+        return n + intersect16_merge(a, i, na, b, j, nb, out + n);
+      }
+
+      constexpr table sse42_table = {count_sse42, hamming_sse42, extract_generic, deposit_generic,
+                                     bit_width_sse42<std::uint32_t>, bit_width_sse42<std::uint64_t>,
+                                     transpose64_generic, pack128_sse_kernels, unpack128_sse_kernels,
+                                     intersect16_sse42, bloom_insert_generic, bloom_query_generic};
+
+      // AVX2: nibble lookups through VPSHUFB summed with VPSADBW (Mula,
+      // Kurz and Lemire, "Faster population counts using AVX2
+      // instructions", 2018); BMI2 for PEXT/PDEP.
+
+      __attribute__((target("avx2")))
+      inline __m256i popcount_avx2(const __m256i v) noexcept
+      {
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low = _mm256_set1_epi8(0x0f);
+
+        const __m256i lo = _mm256_and_si256(v, low);
+        const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+        const __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                               _mm256_shuffle_epi8(lookup, hi));
+
+        return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+      }
+
+      __attribute__((target("avx2")))
+      inline std::uint64_t sum_avx2(const __m256i v) noexcept
+      {
+        return static_cast<std::uint64_t>(_mm256_extract_epi64(v, 0)) +
+               static_cast<std::uint64_t>(_mm256_extract_epi64(v, 1)) +
+               static_cast<std::uint64_t>(_mm256_extract_epi64(v, 2)) +
+               static_cast<std::uint64_t>(_mm256_extract_epi64(v, 3));
+      }
+
+      __attribute__((target("avx2,popcnt")))
+      std::uint64_t count_avx2(const std::uint64_t* words, const std::size_t n)
+      {
+        __m256i total = _mm256_setzero_si256();
+        std::size_t i = 0;
+
+        for (; i + 4 <= n; i += 4)
+        {
+          const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+          total = _mm256_add_epi64(total, popcount_avx2(v));
+        }
+
+        std::uint64_t result = sum_avx2(total);
+
+        for (; i != n; ++i)
+        {
+          result += _mm_popcnt_u64(words[i]);
+        }
+
+        return result;
+      }
+
+      __attribute__((target("avx2,popcnt")))
+      std::uint64_t hamming_avx2(const std::uint64_t* a, const std::uint64_t* b, const std::size_t n)
+      {
+        __m256i total = _mm256_setzero_si256();
+        std::size_t i = 0;
+
+        for (; i + 4 <= n; i += 4)
+        {
+          const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+          const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+          total = _mm256_add_epi64(total, popcount_avx2(_mm256_xor_si256(x, y)));
+        }
+
+        std::uint64_t result = sum_avx2(total);
+
+        for (; i != n; ++i)
+        {
+          result += _mm_popcnt_u64(a[i] ^ b[i]);
+        }
+
+        return result;
+      }
+
+      __attribute__((target("bmi2")))
+      void extract_bmi2(const std::uint64_t* words, const std::size_t n, const std::uint64_t mask,
+                        std::uint64_t* out)
+      {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          out[i] = _pext_u64(words[i], mask);
+        }
+      }
+
+      __attribute__((target("bmi2")))
+      void deposit_bmi2(const std::uint64_t* words, const std::size_t n, const std::uint64_t mask,
+                        std::uint64_t* out)
+      {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+          out[i] = _pdep_u64(words[i], mask);
+        }
+      }
+
+      // AVX2 has no vector LZCNT, but smearing the highest set bit into
+      // every lower one leaves bit_width set bits to count.
+
+      __attribute__((target("avx2")))
+      inline __m256i smear64_avx2(__m256i v) noexcept
+      {
+        v = _mm256_or_si256(v, _mm256_srli_epi64(v, 1));
+        v = _mm256_or_si256(v, _mm256_srli_epi64(v, 2));
+        v = _mm256_or_si256(v, _mm256_srli_epi64(v, 4));
+        v = _mm256_or_si256(v, _mm256_srli_epi64(v, 8));
+        v = _mm256_or_si256(v, _mm256_srli_epi64(v, 16));
+        return _mm256_or_si256(v, _mm256_srli_epi64(v, 32));
+      }
+
+      __attribute__((target("avx2")))
+      inline __m256i smear32_avx2(__m256i v) noexcept
+      {
+        v = _mm256_or_si256(v, _mm256_srli_epi32(v, 1));
+        v = _mm256_or_si256(v, _mm256_srli_epi32(v, 2));
+        v = _mm256_or_si256(v, _mm256_srli_epi32(v, 4));
+        v = _mm256_or_si256(v, _mm256_srli_epi32(v, 8));
+        return _mm256_or_si256(v, _mm256_srli_epi32(v, 16));
+      }
+
+      // Set bits per byte, by nibble lookups.
+      __attribute__((target("avx2")))
+      inline __m256i byte_counts_avx2(const __m256i v) noexcept
+      {
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low = _mm256_set1_epi8(0x0f);
+
+        return _mm256_add_epi8(_mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low)),
+                               _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+      }
+
+      __attribute__((target("avx2")))
+      inline __m256i bit_width32x8_avx2(const std::uint32_t* values) noexcept
+      {
+        const __m256i v = smear32_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values)));
+        return _mm256_madd_epi16(_mm256_maddubs_epi16(byte_counts_avx2(v), _mm256_set1_epi8(1)),
+                                 _mm256_set1_epi16(1));
+      }
+
+      __attribute__((target("avx2")))
+      inline __m256i bit_width64x4_avx2(const std::uint64_t* values) noexcept
+      {
+        const __m256i v = smear64_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values)));
+        return _mm256_sad_epu8(byte_counts_avx2(v), _mm256_setzero_si256());
+      }
+
+      // Thirty-two values a round: the four vectors of 32-bit counts narrow
+      // to bytes with two saturating packs, which interleave the 128-bit
+      // lanes, and one permute puts them back in order.
+      __attribute__((target("avx2")))
+      void bit_width32_avx2(const std::uint32_t* values, const std::size_t n, std::uint8_t* out)
+      {
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        std::size_t i = 0;
+
+        for (; i + 32 <= n; i += 32)
+        {
+          const __m256i ab = _mm256_packus_epi32(bit_width32x8_avx2(values + i), bit_width32x8_avx2(values + i + 8));
+          const __m256i cd = _mm256_packus_epi32(bit_width32x8_avx2(values + i + 16),
+                                                 bit_width32x8_avx2(values + i + 24));
+          const __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(ab, cd), order);
+
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), bytes);
+        }
+
+        for (; i != n; ++i)
+        {
+          out[i] = static_cast<std::uint8_t>(bit::bit_width(values[i]));
+        }
+      }
+
+      // Sixteen values a round: the count of each 64-bit lane is in its low
+      // byte, so four vectors of counts fold into one of 32-bit pairs, pack
+      // to bytes, and a byte shuffle restores the order.
+      __attribute__((target("avx2")))
+      void bit_width64_avx2(const std::uint64_t* values, const std::size_t n, std::uint8_t* out)
+      {
+        const __m128i order = _mm_setr_epi8(0, 2, 8, 10, 1, 3, 9, 11, 4, 6, 12, 14, 5, 7, 13, 15);
+        std::size_t i = 0;
+
+        for (; i + 16 <= n; i += 16)
+        {
+          const __m256i ab = _mm256_or_si256(bit_width64x4_avx2(values + i),
+                                             _mm256_slli_epi64(bit_width64x4_avx2(values + i + 4), 32));
+          const __m256i cd = _mm256_or_si256(bit_width64x4_avx2(values + i + 8),
+                                             _mm256_slli_epi64(bit_width64x4_avx2(values + i + 12), 32));
+          const __m256i words = _mm256_packus_epi32(ab, cd);
+          const __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                           _mm_shuffle_epi8(_mm256_castsi256_si128(bytes), order));
+        }
+
+        for (; i != n; ++i)
+        {
+          out[i] = static_cast<std::uint8_t>(bit::bit_width(values[i]));
+        }
+      }
+
+      // The block swaps of bit::transpose64 on four rows at a time, the
+      // matrix held in sixteen registers. Rounds that pair rows four or
+      // more apart exchange whole registers; the last two pair lanes of
+      // one register, brought side by side with a permute.
+      __attribute__((target("avx2")))
+      void transpose64_avx2(std::uint64_t* matrices, const std::size_t n)
+      {
+        for (std::size_t m = 0; m != n; ++m)
+        {
+          std::uint64_t* const rows = matrices + 64 * m;
+          __m256i r[16];
+
+          for (unsigned int i = 0; i != 16; ++i)
+          {
+            r[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + 4 * i));
+          }
+
+          std::uint64_t mask = 0x00000000ffffffffULL;
+          unsigned int  j    = 32;
+
+          for (; j >= 4; j >>= 1, mask ^= mask << j)
+          {
+            const __m256i vmask = _mm256_set1_epi64x(static_cast<long long>(mask));
+            const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(j));
+
+            for (unsigned int k = 0; k != 64; k = ((k | j) + 4) & ~j)
+            {
+              __m256i& a = r[k / 4];
+              __m256i& b = r[(k | j) / 4];
+              const __m256i t = _mm256_and_si256(_mm256_xor_si256(_mm256_srl_epi64(a, shift), b), vmask);
+
+              b = _mm256_xor_si256(b, t);
+              a = _mm256_xor_si256(a, _mm256_sll_epi64(t, shift));
+            }
+          }
+
+          // j = 2 pairs lanes 0, 1 with 2, 3; j = 1 pairs 0 with 1 and 2
+          // with 3. A is each pair's low row and B its high row, in both
+          // of its lanes.
+          const __m256i vmask2 = _mm256_set1_epi64x(static_cast<long long>(mask));
+          const __m256i vmask1 = _mm256_set1_epi64x(static_cast<long long>(mask ^ (mask << 1)));
+
+          for (__m256i& v : r)
+          {
+            __m256i w = _mm256_permute4x64_epi64(v, 0x4e);
+            __m256i a = _mm256_blend_epi32(v, w, 0xf0);
+            __m256i b = _mm256_blend_epi32(w, v, 0xf0);
+            __m256i t = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi64(a, 2), b), vmask2);
+
+            v = _mm256_xor_si256(v, _mm256_blend_epi32(_mm256_slli_epi64(t, 2), t, 0xf0));
+
+            w = _mm256_permute4x64_epi64(v, 0xb1);
+            a = _mm256_blend_epi32(v, w, 0xcc);
+            b = _mm256_blend_epi32(w, v, 0xcc);
+            t = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi64(a, 1), b), vmask1);
+
+            v = _mm256_xor_si256(v, _mm256_blend_epi32(_mm256_slli_epi64(t, 1), t, 0xcc));
+          }
+
+          for (unsigned int i = 0; i != 16; ++i)
+          {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows + 4 * i), r[i]);
+          }
+        }
+      }
+
+      // The eight masks of a key as two vectors: lane w shifts one left by
+      // bits 16 + 6w .. 21 + 6w of bits.
+      __attribute__((target("avx2")))
+      inline void bloom_masks_avx2(const std::uint64_t bits, __m256i& low, __m256i& high) noexcept
+      {
+        const __m256i v    = _mm256_set1_epi64x(static_cast<long long>(bits));
+        const __m256i one  = _mm256_set1_epi64x(1);
+        const __m256i bit  = _mm256_set1_epi64x(63);
+
+        low  = _mm256_sllv_epi64(one, _mm256_and_si256(_mm256_srlv_epi64(v, _mm256_setr_epi64x(16, 22, 28, 34)), bit));
+        high = _mm256_sllv_epi64(one, _mm256_and_si256(_mm256_srlv_epi64(v, _mm256_setr_epi64x(40, 46, 52, 58)), bit));
+      }
+
+      __attribute__((target("avx2")))
+      void bloom_insert_avx2(std::uint64_t* blocks, const std::size_t nblocks, const std::uint64_t* keys,
+                             const std::size_t n)
+      {
+        for (std::size_t first = 0; first < n; first += bloom_group)
+        {
+          const bloom_keys group(blocks, nblocks, keys + first, std::min(bloom_group, n - first));
+
+          for (std::size_t j = 0; j != group.size; ++j)
+          {
+            __m256i* block = reinterpret_cast<__m256i*>(blocks + group.block[j]);
+            __m256i  low, high;
+
+            bloom_masks_avx2(group.bits[j], low, high);
+            _mm256_storeu_si256(block, _mm256_or_si256(_mm256_loadu_si256(block), low));
+            _mm256_storeu_si256(block + 1, _mm256_or_si256(_mm256_loadu_si256(block + 1), high));
+          }
+        }
+      }
+
+      __attribute__((target("avx2")))
+      std::size_t bloom_query_avx2(const std::uint64_t* blocks, const std::size_t nblocks,
+                                   const std::uint64_t* keys, const std::size_t n, std::uint8_t* out)
+      {
+        std::size_t hits = 0;
+
+        for (std::size_t first = 0; first < n; first += bloom_group)
+        {
+          const bloom_keys group(blocks, nblocks, keys + first, std::min(bloom_group, n - first));
+
+          for (std::size_t j = 0; j != group.size; ++j)
+          {
+            const __m256i* block = reinterpret_cast<const __m256i*>(blocks + group.block[j]);
+            __m256i        low, high;
+
+            bloom_masks_avx2(group.bits[j], low, high);
+
+            const int hit = _mm256_testc_si256(_mm256_loadu_si256(block), low) &
+                            _mm256_testc_si256(_mm256_loadu_si256(block + 1), high);
+
+            out[first + j] = static_cast<std::uint8_t>(hit);
+            hits          += static_cast<std::size_t>(hit);
+          }
+        }
+
+        return hits;
+      }
+
+      constexpr table avx2_table = {count_avx2, hamming_avx2, extract_bmi2, deposit_bmi2,
+                                    bit_width32_avx2, bit_width64_avx2, transpose64_avx2,
+                                    pack128_sse_kernels, unpack128_sse_kernels, intersect16_sse42,
+                                    bloom_insert_avx2, bloom_query_avx2};
+
+      // AVX-512: VPOPCNTQ on eight words at a time, with a masked load for
+      // the tail.
+
+      __attribute__((target("avx512f,avx512vpopcntdq")))
+      std::uint64_t count_avx512(const std::uint64_t* words, const std::size_t n)
+      {
+        __m512i total = _mm512_setzero_si512();
+        std::size_t i = 0;
+
+        for (; i + 8 <= n; i += 8)
+        {
+          total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_loadu_si512(words + i)));
+        }
+
+        const __mmask8 tail = static_cast<__mmask8>((1U << (n - i)) - 1);
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(tail, words + i)));
+
+        return _mm512_reduce_add_epi64(total);
+      }
+
+      __attribute__((target("avx512f,avx512vpopcntdq")))
+      std::uint64_t hamming_avx512(const std::uint64_t* a, const std::uint64_t* b, const std::size_t n)
+      {
+        __m512i total = _mm512_setzero_si512();
+        std::size_t i = 0;
+
+        for (; i + 8 <= n; i += 8)
+        {
+          const __m512i x = _mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+          total = _mm512_add_epi64(total, _mm512_popcnt_epi64(x));
+        }
+
+        const __mmask8 tail = static_cast<__mmask8>((1U << (n - i)) - 1);
+        const __m512i x = _mm512_xor_si512(_mm512_maskz_loadu_epi64(tail, a + i),
+                                           _mm512_maskz_loadu_epi64(tail, b + i));
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(x));
+
+        return _mm512_reduce_add_epi64(total);
+      }
+
+      // VPLZCNT belongs to AVX-512 CD, which this level does not require;
+      // smear and VPOPCNT instead, and narrow the counts to bytes with
+      // VPMOV.
+
+      __attribute__((target("avx512f,avx512vpopcntdq")))
+      void bit_width32_avx512(const std::uint32_t* values, const std::size_t n, std::uint8_t* out)
+      {
+        for (std::size_t i = 0; i < n; i += 16)
+        {
+          const __mmask16 lanes = n - i >= 16 ? static_cast<__mmask16>(0xffff)
+                                              : static_cast<__mmask16>((1U << (n - i)) - 1);
+          __m512i v = _mm512_maskz_loadu_epi32(lanes, values + i);
+
+          v = _mm512_or_si512(v, _mm512_srli_epi32(v, 1));
+          v = _mm512_or_si512(v, _mm512_srli_epi32(v, 2));
+          v = _mm512_or_si512(v, _mm512_srli_epi32(v, 4));
+          v = _mm512_or_si512(v, _mm512_srli_epi32(v, 8));
+          v = _mm512_or_si512(v, _mm512_srli_epi32(v, 16));
+
+          _mm512_mask_cvtepi32_storeu_epi8(out + i, lanes, _mm512_popcnt_epi32(v));
+        }
+      }
+
+      __attribute__((target("avx512f,avx512vpopcntdq")))
+      void bit_width64_avx512(const std::uint64_t* values, const std::size_t n, std::uint8_t* out)
+      {
+        for (std::size_t i = 0; i < n; i += 8)
+        {
+          const __mmask8 lanes = n - i >= 8 ? static_cast<__mmask8>(0xff)
+                                            : static_cast<__mmask8>((1U << (n - i)) - 1);
+          __m512i v = _mm512_maskz_loadu_epi64(lanes, values + i);
+
+          v = _mm512_or_si512(v, _mm512_srli_epi64(v, 1));
+          v = _mm512_or_si512(v, _mm512_srli_epi64(v, 2));
+          v = _mm512_or_si512(v, _mm512_srli_epi64(v, 4));
+          v = _mm512_or_si512(v, _mm512_srli_epi64(v, 8));
+          v = _mm512_or_si512(v, _mm512_srli_epi64(v, 16));
+          v = _mm512_or_si512(v, _mm512_srli_epi64(v, 32));
+
+          _mm512_mask_cvtepi64_storeu_epi8(out + i, lanes, _mm512_popcnt_epi64(v));
+        }
+      }
+
+      // As the AVX2 kernel with eight rows a register, so the whole matrix
+      // fits in eight registers and the last three rounds are in-register.
+      __attribute__((target("avx512f")))
+      void transpose64_avx512(std::uint64_t* matrices, const std::size_t n)
+      {
+        for (std::size_t m = 0; m != n; ++m)
+        {
+          std::uint64_t* const rows = matrices + 64 * m;
+          __m512i r[8];
+
+          for (unsigned int i = 0; i != 8; ++i)
+          {
+            r[i] = _mm512_loadu_si512(rows + 8 * i);
+          }
+
+          std::uint64_t mask = 0x00000000ffffffffULL;
+          unsigned int  j    = 32;
+
+          for (; j >= 8; j >>= 1, mask ^= mask << j)
+          {
+            const __m512i vmask = _mm512_set1_epi64(static_cast<long long>(mask));
+            const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(j));
+
+            for (unsigned int k = 0; k != 64; k = ((k | j) + 8) & ~j)
+            {
+              __m512i& a = r[k / 8];
+              __m512i& b = r[(k | j) / 8];
+              const __m512i t = _mm512_and_si512(_mm512_xor_si512(_mm512_srl_epi64(a, shift), b), vmask);
+
+              b = _mm512_xor_si512(b, t);
+              a = _mm512_xor_si512(a, _mm512_sll_epi64(t, shift));
+            }
+          }
+
+          // Lanes i and i ^ j pair up; high selects the lanes holding each
+          // pair's high row.
+          for (; j != 0; j >>= 1, mask ^= mask << j)
+          {
+            const __m512i   vmask   = _mm512_set1_epi64(static_cast<long long>(mask));
+            const __m128i   shift   = _mm_cvtsi32_si128(static_cast<int>(j));
+            const __m512i   partner = _mm512_xor_si512(_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7),
+                                                       _mm512_set1_epi64(j));
+            const __mmask8  high    = j == 4 ? 0xf0 : j == 2 ? 0xcc : 0xaa;
+
+            for (__m512i& v : r)
+            {
+              const __m512i w = _mm512_permutexvar_epi64(partner, v);
+              const __m512i a = _mm512_mask_blend_epi64(high, v, w);
+              const __m512i b = _mm512_mask_blend_epi64(high, w, v);
+              const __m512i t = _mm512_and_si512(_mm512_xor_si512(_mm512_srl_epi64(a, shift), b), vmask);
+
+              v = _mm512_xor_si512(v, _mm512_mask_blend_epi64(high, _mm512_sll_epi64(t, shift), t));
+            }
+          }
+
+          for (unsigned int i = 0; i != 8; ++i)
+          {
+            _mm512_storeu_si512(rows + 8 * i, r[i]);
+          }
+        }
+      }
+
+      // All eight masks of a key in one vector.
+      __attribute__((target("avx512f")))
+      inline __m512i bloom_masks_avx512(const std::uint64_t bits) noexcept
+      {
+        const __m512i shifts = _mm512_set_epi64(58, 52, 46, 40, 34, 28, 22, 16);
+        const __m512i v      = _mm512_set1_epi64(static_cast<long long>(bits));
+
+        return _mm512_sllv_epi64(_mm512_set1_epi64(1),
+                                 _mm512_and_si512(_mm512_srlv_epi64(v, shifts), _mm512_set1_epi64(63)));
+      }
+
+      __attribute__((target("avx512f")))
+      void bloom_insert_avx512(std::uint64_t* blocks, const std::size_t nblocks, const std::uint64_t* keys,
+                               const std::size_t n)
+      {
+        for (std::size_t first = 0; first < n; first += bloom_group)
+        {
+          const bloom_keys group(blocks, nblocks, keys + first, std::min(bloom_group, n - first));
+
+          for (std::size_t j = 0; j != group.size; ++j)
+          {
+            std::uint64_t* block = blocks + group.block[j];
+            _mm512_storeu_si512(block, _mm512_or_si512(_mm512_loadu_si512(block), bloom_masks_avx512(group.bits[j])));
+          }
+        }
+      }
+
+      // A lane is flagged when its mask has a bit the block lacks.
+      __attribute__((target("avx512f")))
+      std::size_t bloom_query_avx512(const std::uint64_t* blocks, const std::size_t nblocks,
+                                     const std::uint64_t* keys, const std::size_t n, std::uint8_t* out)
+      {
+        std::size_t hits = 0;
+
+        for (std::size_t first = 0; first < n; first += bloom_group)
+        {
+          const bloom_keys group(blocks, nblocks, keys + first, std::min(bloom_group, n - first));
+
+          for (std::size_t j = 0; j != group.size; ++j)
+          {
+            const __m512i masks = bloom_masks_avx512(group.bits[j]);
+            const __m512i block = _mm512_loadu_si512(blocks + group.block[j]);
+            const bool    hit   = _mm512_test_epi64_mask(masks, _mm512_andnot_si512(block, masks)) == 0;
+
+            out[first + j] = hit;
+            hits          += hit;
+          }
+        }
+
+        return hits;
+      }
+
+      constexpr table avx512_table = {count_avx512, hamming_avx512, extract_bmi2, deposit_bmi2,
+                                      bit_width32_avx512, bit_width64_avx512, transpose64_avx512,
+                                      pack128_sse_kernels, unpack128_sse_kernels, intersect16_sse42,
+                                      bloom_insert_avx512, bloom_query_avx512};
+
+#endif
+
+      const table& table_for(const isa level) noexcept
+      {
+#if defined(BIT_KERNELS_X86)
+        switch (level)
+        {
+          case isa::generic: return generic_table;
+          case isa::sse42:   return sse42_table;
+          case isa::avx2:    return avx2_table;
+          case isa::avx512:  return avx512_table;
+        }
+#else
+        static_cast<void>(level);
+#endif
+        return generic_table;
+      }
+
+      // The BIT_KERNELS environment variable (generic, sse42, avx2 or
+      // avx512) caps the level, e.g. to reproduce a result from an older
+      // machine.
+      isa detect() noexcept
+      {
+        isa best = isa::generic;
+
+        for (const isa level : all_isas)
+        {
+          if (supported(level)) best = level;
+        }
+
+        if (const char* cap = std::getenv("BIT_KERNELS"))
+        {
+          for (const isa level : all_isas)
+          {
+            if (std::strcmp(cap, name(level)) == 0 && level < best) best = level;
+          }
+        }
+
+        return best;
+      }
+
+      std::atomic<isa>& current() noexcept
+      {
+        static std::atomic<isa> level{detect()};
+        return level;
+      }
+
+      const table& active() noexcept
+      {
+        return table_for(current().load(std::memory_order_relaxed));
+      }
+    }
+
+    const char* name(const isa level) noexcept
+    {
+      switch (level)
+      {
+        case isa::generic: return "generic";
+        case isa::sse42:   return "sse42";
+        case isa::avx2:    return "avx2";
+        case isa::avx512:  return "avx512";
+      }
+
+      return "unknown";
+    }
+
+    bool supported(const isa level) noexcept
+    {
+#if defined(BIT_KERNELS_X86)
+      __builtin_cpu_init();
+
+      switch (level)
+      {
+        case isa::generic:
+          return true;
+        case isa::sse42:
+          return __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("sse4.2");
+        case isa::avx2:
+          return supported(isa::sse42) && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+        case isa::avx512:
+          return supported(isa::avx2) && __builtin_cpu_supports("avx512f") &&
+                 __builtin_cpu_supports("avx512vpopcntdq");
+      }
+
+      return false;
+#else
+      return level == isa::generic;
+#endif
+    }
+
+    isa selected() noexcept
+    {
+      return current().load(std::memory_order_relaxed);
+    }
+
+    void select(const isa level)
+    {
+      if (!supported(level))
+      {
+        throw std::invalid_argument(std::string("this CPU cannot run the ") + name(level) + " kernels");
+      }
+
+      current().store(level, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count(const std::uint64_t* words, const std::size_t n) noexcept
+    {
+      return active().count(words, n);
+    }
+
+    std::uint64_t hamming_distance(const std::uint64_t* a, const std::uint64_t* b, const std::size_t n) noexcept
+    {
+      return active().hamming_distance(a, b, n);
+    }
+
+    void extract(const std::uint64_t* words, const std::size_t n, const std::uint64_t mask,
+                 std::uint64_t* out) noexcept
+    {
+      active().extract(words, n, mask, out);
+    }
+
+    void deposit(const std::uint64_t* words, const std::size_t n, const std::uint64_t mask,
+                 std::uint64_t* out) noexcept
+    {
+      active().deposit(words, n, mask, out);
+    }
+
+    void bit_width(const std::uint32_t* values, const std::size_t n, std::uint8_t* out) noexcept
+    {
+      active().bit_width32(values, n, out);
+    }
+
+    void bit_width(const std::uint64_t* values, const std::size_t n, std::uint8_t* out) noexcept
+    {
+      active().bit_width64(values, n, out);
+    }
+
+    void transpose64(std::uint64_t* matrices, const std::size_t n) noexcept
+    {
+      active().transpose64(matrices, n);
+    }
+
+    void pack128(const std::uint32_t* values, const std::size_t blocks, const unsigned int width,
+                 std::uint32_t* out) noexcept
+    {
+      const block_fn kernel = active().pack128()[width];
+
+      for (std::size_t b = 0; b != blocks; ++b)
+      {
+        kernel(values + 128 * b, out + 4 * width * b);
+      }
+    }
+
+    void unpack128(const std::uint32_t* packed, const std::size_t blocks, const unsigned int width,
+                   std::uint32_t* out) noexcept
+    {
+      const block_fn kernel = active().unpack128()[width];
+
+      for (std::size_t b = 0; b != blocks; ++b)
+      {
+        kernel(packed + 4 * width * b, out + 128 * b);
+      }
+    }
+
+    std::size_t intersect16(const std::uint16_t* a, const std::size_t na, const std::uint16_t* b,
+                            const std::size_t nb, std::uint16_t* out) noexcept
+    {
+      return active().intersect16(a, na, b, nb, out);
+    }
+
+    void bloom_insert(std::uint64_t* blocks, const std::size_t nblocks, const std::uint64_t* keys,
+                      const std::size_t n) noexcept
+    {
+      active().bloom_insert(blocks, nblocks, keys, n);
+    }
+
+    std::size_t bloom_query(const std::uint64_t* blocks, const std::size_t nblocks, const std::uint64_t* keys,
+                            const std::size_t n, std::uint8_t* out) noexcept
+    {
+      return active().bloom_query(blocks, nblocks, keys, n, out);
+    }
+  }
+}
@@ -0,0 +1,200 @@
+#include "bit/algorithm.hpp"
+#include "../../differential.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+static_assert(std::is_same<std::iterator_traits<bit::iterator<int>>::iterator_category,
+                           std::random_access_iterator_tag>::value, "");
+static_assert(std::is_same<std::iterator_traits<bit::const_reverse_iterator<std::uint8_t>>::iterator_category,
+                           std::random_access_iterator_tag>::value, "");
+
+TEST(bit_iterators, random_access_over_one_integer)
+{
+  std::uint64_t value = 0;
+
+  *(bit::begin(value) + 40) = true;
+  bit::begin(value)[63]     = true;
+
+  ASSERT_EQ((std::uint64_t{1} << 40) | (std::uint64_t{1} << 63), value);
+  ASSERT_EQ(64, bit::end(value) - bit::begin(value));
+  ASSERT_EQ(23, std::find(bit::rbegin(value) + 1, bit::rend(value), true) - bit::rbegin(value));
+}
+
+TEST(bit_iterators, signed_integers_stop_below_the_sign_bit)
+{
+  const int value = -1;
+
+  ASSERT_EQ(31, bit::cend(value) - bit::cbegin(value));
+  ASSERT_EQ(31, std::count(bit::cbegin(value), bit::cend(value), true));
+}
+
+namespace
+{
+  // Generic code written against iterators: unqualified calls find the
+  // word-level algorithms for bit iterators by argument-dependent lookup.
+  template <typename InputIt>
+  auto generic_count(const InputIt first, const InputIt last)
+  {
+    using std::count;
+    return count(first, last, true);
+  }
+
+  template <typename InputIt, typename OutputIt>
+  OutputIt generic_copy(const InputIt first, const InputIt last, const OutputIt d_first)
+  {
+    using std::copy;
+    return copy(first, last, d_first);
+  }
+
+  struct algorithm_case
+  {
+    std::uint64_t seed;
+    std::size_t   first, last, destination;
+    bool          value;
+  };
+
+  void PrintTo(const algorithm_case& c, std::ostream* os)
+  {
+    *os << "{seed=" << c.seed << ", [" << c.first << ", " << c.last << "), destination="
+        << c.destination << ", value=" << c.value << '}';
+  }
+
+  constexpr std::size_t num_words = 6;
+
+  std::vector<std::uint16_t> random_words(const std::uint64_t seed)
+  {
+    std::vector<std::uint16_t> words(num_words);
+    generator::fill_uniform(words.begin(), words.end(), seed, std::uint16_t{0}, std::numeric_limits<std::uint16_t>::max());
+    return words;
+  }
+
+  // Runs every algorithm over the case's ranges, either the bit:: word
+  // level ones or the std:: ones going a bit at a time through proxies.
+  template <bool word_level>
+  std::vector<std::ptrdiff_t> run_algorithms(const algorithm_case& c)
+  {
+    std::vector<std::uint16_t> words = random_words(c.seed);
+    std::vector<std::uint16_t> other = random_words(generator::derive_seed(c.seed, 1));
+
+    const bit::span<std::uint16_t> a{words.data(), 16 * num_words};
+    const bit::span<std::uint16_t> b{other.data(), 16 * num_words};
+
+    const auto first = a.begin() + c.first;
+    const auto last  = a.begin() + c.last;
+    const auto out   = b.begin() + c.destination;
+
+    std::vector<std::ptrdiff_t> results;
+
+    if (word_level)
+    {
+      results.push_back(bit::count(first, last, c.value));
+      results.push_back(bit::find(first, last, c.value) - a.begin());
+      results.push_back(bit::equal(first, last, out));
+      results.push_back(bit::copy(first, last, out) - b.begin());
+      results.push_back(bit::equal(first, last, out));
+      bit::fill(first, last, c.value);
+    }
+    else
+    {
+      results.push_back(std::count(first, last, c.value));
+      results.push_back(std::find(first, last, c.value) - a.begin());
+      results.push_back(std::equal(first, last, out));
+      results.push_back(std::copy(first, last, out) - b.begin());
+      results.push_back(std::equal(first, last, out));
+      std::fill(first, last, c.value);
+    }
+
+    results.insert(results.end(), words.begin(), words.end());
+    results.insert(results.end(), other.begin(), other.end());
+    return results;
+  }
+}
+
+TEST(bit_algorithms, found_by_argument_dependent_lookup)
+{
+  const std::uint64_t words[2] = {0xff00ff00ff00ff00ULL, 0x1};
+  const bit::const_span<std::uint64_t> bits{words, 4, 100};
+
+  ASSERT_EQ(33, generic_count(bits.begin(), bits.end()));
+
+  std::uint64_t copied[2] = {};
+  const bit::span<std::uint64_t> to{copied, 7, 100};
+
+  ASSERT_EQ(to.end(), generic_copy(bits.begin(), bits.end(), to.begin()));
+  ASSERT_TRUE(bit::equal(bits, to));
+
+  // Other iterators still get the standard algorithms.
+  const std::vector<int> ints = {1, 0, 1};
+  ASSERT_EQ(2, generic_count(ints.begin(), ints.end()));
+}
+
+TEST(bit_algorithms, differential)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  const std::size_t bits = 16 * num_words;
+  std::vector<algorithm_case> cases;
+
+  for (std::size_t i = 0; i != differential::iterations(); ++i)
+  {
+    const std::uint64_t stream = generator::derive_seed(seed, i);
+    const auto draw = [&](const std::uint64_t k, const std::size_t bound)
+    {
+      return static_cast<std::size_t>(generator::splitmix64::at(stream, k) % (bound + 1));
+    };
+
+    algorithm_case c{};
+    c.seed        = stream;
+    c.first       = draw(0, bits);
+    c.last        = c.first + draw(1, bits - c.first);
+    c.destination = draw(2, bits - (c.last - c.first));
+    c.value       = draw(3, 1);
+    cases.push_back(c);
+  }
+
+  EXPECT_TRUE(differential::agree("bit algorithms", run_algorithms<true>, run_algorithms<false>, cases));
+}
+
+// The same generic call with and without the word-level overloads in
+// reach: on std::vector<bool> it can only go a bit at a time.
+template <bool bit_iterators>
+void generic_count_benchmark(benchmark::State& state)
+{
+  std::vector<std::uint64_t> words(state.range(0) / 64);
+  generator::fill_uniform(words.begin(), words.end(), 1, std::uint64_t{0}, std::numeric_limits<std::uint64_t>::max());
+
+  const bit::const_span<std::uint64_t> bits{words.data(), words.size() * 64};
+  const std::vector<bool> bools(bits.begin(), bits.end());
+
+  for (auto _ : state)
+  {
+    if (bit_iterators)
+    {
+      benchmark::DoNotOptimize(generic_count(bits.begin(), bits.end()));
+    }
+    else
+    {
+      benchmark::DoNotOptimize(generic_count(bools.begin(), bools.end()));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * bits.size());
+}
+
+BENCHMARK_TEMPLATE(generic_count_benchmark, true)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(generic_count_benchmark, false)->Range(64, 1 << 16);
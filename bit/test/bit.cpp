@@ -0,0 +1,346 @@
+#include "bit/bit.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// The tables and the kernels built on them are usable at compile time.
+static_assert(bit::tables::bytes::popcount[0xff] == 8, "");
+static_assert(bit::tables::bytes::reverse[0x01] == 0x80, "");
+static_assert(bit::tables::bytes::leading_zeros[0] == 8, "");
+static_assert(bit::tables::bytes::trailing_zeros[0x40] == 6, "");
+
+static_assert(bit::width<std::uint8_t>() == 8, "");
+static_assert(bit::width<std::int32_t>() == 31, "");
+static_assert(bit::width<std::uint64_t>() == 64, "");
+static_assert(bit::width(std::uint64_t{1} << 63) == 64, "");
+static_assert(bit::width(0) == 0, "");
+
+static_assert(bit::odd_pattern<std::uint64_t>() == 0x5555555555555555ULL, "");
+static_assert(bit::even_pattern<std::uint64_t>() == 0xaaaaaaaaaaaaaaaaULL, "");
+static_assert(bit::even_pattern<std::uint8_t>() == 0xaa, "");
+static_assert(bit::mask<std::uint64_t>(0, 63) == ~std::uint64_t{0}, "");
+static_assert(bit::mask<std::uint32_t>(4, 7) == 0xf0, "");
+
+static_assert(bit::count(std::uint64_t{0xf0f0}) == 8, "");
+
+static_assert(bit::countl_zero(std::uint32_t{1}) == 31, "");
+static_assert(bit::countl_zero(std::int8_t{-1}) == 0, "");
+static_assert(bit::countl_zero(std::uint16_t{0}) == 16, "");
+static_assert(bit::countr_zero(std::uint64_t{1} << 40) == 40, "");
+static_assert(bit::countr_zero(std::uint8_t{0}) == 8, "");
+static_assert(bit::bit_width(std::int16_t{-1}) == 16, "");
+static_assert(bit::floor_log2(std::uint32_t{1000}) == 9, "");
+static_assert(bit::ceil_log2(std::uint32_t{1000}) == 10, "");
+static_assert(bit::ceil_log2(std::uint32_t{1024}) == 10, "");
+static_assert(bit::next_power_of_two(std::uint32_t{0}) == 1, "");
+static_assert(bit::next_power_of_two(std::uint64_t{(1ULL << 40) + 1}) == 1ULL << 41, "");
+static_assert(bit::rotl(std::uint8_t{0x81}, 1) == 0x03, "");
+static_assert(bit::rotr(std::uint8_t{0x81}, 1) == 0xc0, "");
+static_assert(bit::rotl(std::uint32_t{1}, -1) == 0x80000000u, "");
+static_assert(bit::rotr(std::uint32_t{1}, 33) == 0x80000000u, "");
+static_assert(bit::byteswap(std::uint32_t{0x01020304}) == 0x04030201u, "");
+static_assert(bit::byteswap(std::int16_t{0x0180}) == std::int16_t(0x8001), "");
+static_assert(bit::reverse(std::uint16_t{0x0001}) == 0x8000, "");
+
+namespace
+{
+  template <typename T>
+  using unsigned_of = std::make_unsigned_t<T>;
+
+  template <typename T>
+  unsigned int naive_count(const T value)
+  {
+    unsigned int n = 0;
+
+    for (unsigned int i = 0; i != std::numeric_limits<unsigned_of<T>>::digits; ++i)
+    {
+      n += (static_cast<unsigned_of<T>>(value) >> i) & 1;
+    }
+
+    return n;
+  }
+
+  template <typename T>
+  T naive_reverse(const T value)
+  {
+    const unsigned int bits = std::numeric_limits<unsigned_of<T>>::digits;
+    unsigned_of<T> reversed = 0;
+
+    for (unsigned int i = 0; i != bits; ++i)
+    {
+      if ((static_cast<unsigned_of<T>>(value) >> i) & 1)
+      {
+        reversed |= unsigned_of<T>{1} << (bits - 1 - i);
+      }
+    }
+
+    return static_cast<T>(reversed);
+  }
+
+  template <typename T>
+  unsigned int naive_width(const T value)
+  {
+    unsigned int n = 0;
+
+    for (unsigned_of<T> bits = static_cast<unsigned_of<T>>(value); bits != 0; bits >>= 1)
+    {
+      ++n;
+    }
+
+    return n;
+  }
+
+  template <typename T>
+  unsigned int naive_countr_zero(const T value)
+  {
+    const unsigned int bits = std::numeric_limits<unsigned_of<T>>::digits;
+    unsigned int n = 0;
+
+    while (n != bits && !((static_cast<unsigned_of<T>>(value) >> n) & 1))
+    {
+      ++n;
+    }
+
+    return n;
+  }
+
+  template <typename T>
+  T naive_rotl(const T value, const int shift)
+  {
+    const int bits = std::numeric_limits<unsigned_of<T>>::digits;
+    unsigned_of<T> rotated = 0;
+
+    for (int i = 0; i != bits; ++i)
+    {
+      if ((static_cast<unsigned_of<T>>(value) >> i) & 1)
+      {
+        rotated |= unsigned_of<T>{1} << (((i + shift) % bits + bits) % bits);
+      }
+    }
+
+    return static_cast<T>(rotated);
+  }
+
+  template <typename T>
+  T naive_byteswap(const T value)
+  {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    std::reverse(bytes, bytes + sizeof(T));
+
+    T swapped;
+    std::memcpy(&swapped, bytes, sizeof(T));
+    return swapped;
+  }
+
+  // Random values plus zero, one, every single bit and the extremes of T.
+  template <typename T>
+  std::vector<T> test_values(const std::uint64_t seed)
+  {
+    std::vector<T> values(1000);
+    generator::fill_uniform(values.begin(), values.end(), seed,
+                            std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+
+    values.push_back(0);
+    values.push_back(1);
+    values.push_back(std::numeric_limits<T>::min());
+    values.push_back(std::numeric_limits<T>::max());
+
+    for (unsigned int i = 0; i != std::numeric_limits<unsigned_of<T>>::digits; ++i)
+    {
+      values.push_back(static_cast<T>(unsigned_of<T>{1} << i));
+    }
+
+    return values;
+  }
+}
+
+template <typename T>
+class bit_kernels : public Test {};
+
+using integral_types = Types<std::uint8_t, std::uint16_t, std::uint32_t, std::uint64_t,
+                             std::int8_t, std::int16_t, std::int32_t, std::int64_t>;
+TYPED_TEST_SUITE(bit_kernels, integral_types);
+
+TYPED_TEST(bit_kernels, match_bit_by_bit_loops)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (const TypeParam value : test_values<TypeParam>(seed))
+  {
+    ASSERT_EQ(naive_count(value), bit::count(value)) << +value;
+    ASSERT_EQ(naive_reverse(value), bit::reverse(value)) << +value;
+    ASSERT_EQ(naive_width(value), bit::width(value)) << +value;
+  }
+}
+
+TYPED_TEST(bit_kernels, scans_match_bit_by_bit_loops)
+{
+  using U = unsigned_of<TypeParam>;
+  const int bits = std::numeric_limits<U>::digits;
+
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (const TypeParam value : test_values<TypeParam>(seed))
+  {
+    ASSERT_EQ(bits - naive_width(value), bit::countl_zero(value)) << +value;
+    ASSERT_EQ(naive_countr_zero(value), bit::countr_zero(value)) << +value;
+    ASSERT_EQ(naive_width(value), bit::bit_width(value)) << +value;
+    ASSERT_EQ(naive_byteswap(value), bit::byteswap(value)) << +value;
+
+    for (const int shift : {0, 1, 3, bits - 1, bits, bits + 5, -1, -bits - 2})
+    {
+      ASSERT_EQ(naive_rotl(value, shift), bit::rotl(value, shift)) << +value << " by " << shift;
+      ASSERT_EQ(naive_rotl(value, -shift), bit::rotr(value, shift)) << +value << " by " << shift;
+    }
+  }
+}
+
+TYPED_TEST(bit_kernels, logarithms_bracket_the_value)
+{
+  using U = unsigned_of<TypeParam>;
+
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (const TypeParam value : test_values<TypeParam>(seed))
+  {
+    const U x = static_cast<U>(value);
+
+    if (x == 0)
+    {
+      continue;
+    }
+
+    const unsigned int floor = bit::floor_log2(x);
+    const unsigned int ceil  = bit::ceil_log2(x);
+
+    ASSERT_LE(U(U{1} << floor), x) << +x;
+    ASSERT_TRUE(floor + 1 == std::numeric_limits<U>::digits || x < U(U{1} << (floor + 1))) << +x;
+    ASSERT_EQ(ceil, floor + (bit::count(x) == 1 ? 0 : 1)) << +x;
+
+    if (ceil < std::numeric_limits<U>::digits)
+    {
+      ASSERT_EQ(U(U{1} << ceil), bit::next_power_of_two(x)) << +x;
+    }
+  }
+}
+
+#if defined(__SIZEOF_INT128__)
+TEST(bit_kernels_128, match_the_64_bit_halves)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  std::vector<std::uint64_t> halves(2000);
+  generator::fill_uniform(halves.begin(), halves.end(), seed, std::uint64_t{0},
+                          std::numeric_limits<std::uint64_t>::max());
+
+  for (unsigned int i = 0; i != 64; ++i)
+  {
+    halves.push_back(0);
+    halves.push_back(std::uint64_t{1} << i);
+  }
+
+  for (std::size_t i = 0; i + 1 < halves.size(); i += 2)
+  {
+    const std::uint64_t high = halves[i];
+    const std::uint64_t low  = halves[i + 1];
+    const bit::uint128_t u = static_cast<bit::uint128_t>(high) << 64 | low;
+    const bit::int128_t  s = static_cast<bit::int128_t>(u);
+
+    const unsigned int leading  = high != 0 ? bit::countl_zero(high) : 64 + bit::countl_zero(low);
+    const unsigned int trailing = low != 0 ? bit::countr_zero(low) : 64 + bit::countr_zero(high);
+
+    ASSERT_EQ(leading, bit::countl_zero(u)) << high << ':' << low;
+    ASSERT_EQ(leading, bit::countl_zero(s)) << high << ':' << low;
+    ASSERT_EQ(trailing, bit::countr_zero(u)) << high << ':' << low;
+    ASSERT_EQ(128 - leading, bit::bit_width(s)) << high << ':' << low;
+
+    const bit::uint128_t swapped = bit::byteswap(u);
+    ASSERT_EQ(bit::byteswap(low), static_cast<std::uint64_t>(swapped >> 64)) << high << ':' << low;
+    ASSERT_EQ(bit::byteswap(high), static_cast<std::uint64_t>(swapped)) << high << ':' << low;
+
+    const bit::uint128_t rotated = bit::rotl(u, 64);
+    ASSERT_EQ(low, static_cast<std::uint64_t>(rotated >> 64)) << high << ':' << low;
+    ASSERT_EQ(high, static_cast<std::uint64_t>(rotated)) << high << ':' << low;
+    ASSERT_EQ(u, bit::rotr(bit::rotl(u, 77), 77)) << high << ':' << low;
+  }
+}
+#endif
+
+TYPED_TEST(bit_kernels, patterns_cover_every_bit_once)
+{
+  using U = unsigned_of<TypeParam>;
+
+  const U odd  = static_cast<U>(bit::odd_pattern<TypeParam>());
+  const U even = static_cast<U>(bit::even_pattern<TypeParam>());
+
+  ASSERT_EQ(0u, U(odd & even));
+  ASSERT_EQ(std::numeric_limits<U>::max(), U(odd | even));
+  ASSERT_EQ(1u, U(odd & 1));
+}
+
+TYPED_TEST(bit_kernels, mask_of_the_full_width)
+{
+  using U = unsigned_of<TypeParam>;
+  const unsigned int bits = std::numeric_limits<U>::digits;
+
+  ASSERT_EQ(std::numeric_limits<U>::max(), static_cast<U>(bit::mask<TypeParam>(0, bits - 1)));
+  ASSERT_EQ(U(U{1} << (bits - 1)), static_cast<U>(bit::mask<TypeParam>(bits - 1, bits - 1)));
+}
+
+template <typename T>
+void reverse_benchmark(benchmark::State& state)
+{
+  std::vector<T> values(state.range(0));
+  generator::fill_uniform(values.begin(), values.end(), 1, T{0}, std::numeric_limits<T>::max());
+
+  for (auto _ : state)
+  {
+    for (const T value : values)
+    {
+      benchmark::DoNotOptimize(bit::reverse(value));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <typename T>
+void width_benchmark(benchmark::State& state)
+{
+  std::vector<T> values(state.range(0));
+  generator::fill_uniform(values.begin(), values.end(), 1, T{0}, std::numeric_limits<T>::max());
+
+  for (auto _ : state)
+  {
+    for (const T value : values)
+    {
+      benchmark::DoNotOptimize(bit::bit_width(value));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK_TEMPLATE(reverse_benchmark, std::uint8_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(reverse_benchmark, std::uint32_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(reverse_benchmark, std::uint64_t)->Range(64, 1 << 16);
+
+BENCHMARK_TEMPLATE(width_benchmark, std::uint8_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(width_benchmark, std::uint32_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(width_benchmark, std::uint64_t)->Range(64, 1 << 16);
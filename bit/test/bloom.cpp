@@ -0,0 +1,365 @@
+#include "bit/bloom.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+  std::vector<std::uint64_t> random_keys(const std::size_t n, const std::uint64_t seed)
+  {
+    std::vector<std::uint64_t> keys(n);
+    generator::fill_uniform(keys.begin(), keys.end(), seed, std::uint64_t{0},
+                            std::numeric_limits<std::uint64_t>::max());
+    return keys;
+  }
+
+  // Consecutive keys too, the worst case for a weak hash.
+  std::vector<std::uint64_t> sequential_keys(const std::size_t n, const std::uint64_t first)
+  {
+    std::vector<std::uint64_t> keys(n);
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      keys[i] = first + i;
+    }
+
+    return keys;
+  }
+
+  double false_positive_rate(const bit::bloom& filter, const std::vector<std::uint64_t>& absent)
+  {
+    std::vector<std::uint8_t> out(absent.size());
+    return static_cast<double>(filter.contains(absent.data(), absent.size(), out.data())) / absent.size();
+  }
+}
+
+TEST(bloom, sizes_in_whole_blocks)
+{
+  EXPECT_EQ(1u, bit::bloom(0).blocks());
+  EXPECT_EQ(1u, bit::bloom(1).blocks());
+  EXPECT_EQ(24u, bit::bloom(1024).blocks());
+  EXPECT_EQ(16u, bit::bloom(1024, 8).blocks());
+  EXPECT_EQ(64 * 24u, bit::bloom(1024).bytes());
+}
+
+TEST(bloom, rejects_more_than_2_to_the_32_blocks_before_allocating)
+{
+  EXPECT_THROW(bit::bloom(std::numeric_limits<std::size_t>::max()), std::invalid_argument);
+  EXPECT_THROW(bit::bloom(std::numeric_limits<std::size_t>::max() / 8, 16), std::invalid_argument);
+  EXPECT_THROW(bit::bloom((std::size_t{1} << 41) + 1, 1), std::invalid_argument);
+}
+
+TEST(bloom, has_no_false_negatives)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const std::vector<std::uint64_t> keys = random_keys(50000, seed);
+  bit::bloom single(keys.size()), batched(keys.size());
+
+  for (const std::uint64_t key : keys)
+  {
+    single.insert(key);
+  }
+
+  batched.insert(keys.data(), keys.size());
+
+  EXPECT_TRUE(single == batched);
+
+  for (const std::uint64_t key : keys)
+  {
+    ASSERT_TRUE(single.contains(key)) << key;
+  }
+
+  std::vector<std::uint8_t> out(keys.size());
+  EXPECT_EQ(keys.size(), batched.contains(keys.data(), keys.size(), out.data()));
+  EXPECT_THAT(out, Each(1));
+}
+
+TEST(bloom, batched_queries_match_single_ones)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  // Half and twice the load the filter is sized for, so that both
+  // answers are common.
+  for (const std::size_t n : {1000, 4000})
+  {
+    bit::bloom filter(2000, 4);
+    const std::vector<std::uint64_t> keys    = random_keys(n, generator::derive_seed(seed, 2 * n));
+    const std::vector<std::uint64_t> queries = random_keys(5000, generator::derive_seed(seed, 2 * n + 1));
+
+    filter.insert(keys.data(), keys.size());
+
+    std::vector<std::uint8_t> out(queries.size());
+    const std::size_t         hits = filter.contains(queries.data(), queries.size(), out.data());
+
+    EXPECT_EQ(static_cast<std::size_t>(std::count(out.begin(), out.end(), 1)), hits);
+
+    for (std::size_t i = 0; i != queries.size(); ++i)
+    {
+      ASSERT_EQ(filter.contains(queries[i]), out[i] == 1) << "n=" << n << ", i=" << i;
+    }
+
+    EXPECT_GT(hits, 0u);
+    EXPECT_LT(hits, queries.size());
+  }
+}
+
+TEST(bloom, false_positive_rate_is_about_one_percent)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const std::size_t n = 1 << 18;
+
+  for (const bool sequential : {false, true})
+  {
+    const std::vector<std::uint64_t> keys   = sequential ? sequential_keys(n, 0) : random_keys(n, seed);
+    const std::vector<std::uint64_t> absent = sequential ? sequential_keys(n, n)
+                                                         : random_keys(n, generator::derive_seed(seed, 1));
+
+    bit::bloom filter(n);
+    filter.insert(keys.data(), keys.size());
+
+    const double measured = false_positive_rate(filter, absent);
+
+    EXPECT_LT(measured, 0.015) << "sequential=" << sequential;
+    EXPECT_NEAR(filter.false_positive_rate(), measured, 0.003) << "sequential=" << sequential;
+  }
+}
+
+TEST(bloom, more_bits_per_key_fewer_false_positives)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const std::size_t n = 1 << 16;
+  const std::vector<std::uint64_t> keys   = random_keys(n, seed);
+  const std::vector<std::uint64_t> absent = random_keys(4 * n, generator::derive_seed(seed, 1));
+
+  double previous = 1;
+
+  for (const unsigned int bits_per_key : {6, 8, 12, 16, 24})
+  {
+    bit::bloom filter(n, bits_per_key);
+    filter.insert(keys.data(), keys.size());
+
+    const double rate = false_positive_rate(filter, absent);
+
+    EXPECT_LT(rate, previous) << "bits_per_key=" << bits_per_key;
+    previous = rate;
+  }
+}
+
+TEST(bloom, concurrent_inserts_match_serial_ones)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const std::vector<std::uint64_t> keys = random_keys(1 << 17, seed);
+  const std::size_t threads = 4, share = keys.size() / threads;
+
+  bit::bloom serial(keys.size()), concurrent(keys.size());
+  serial.insert(keys.data(), keys.size());
+
+  std::vector<std::thread> workers;
+
+  for (std::size_t t = 0; t != threads; ++t)
+  {
+    workers.emplace_back([&, t]
+    {
+      // Half the threads a key at a time, half batched.
+      if (t % 2 == 0)
+      {
+        concurrent.insert_concurrent(keys.data() + t * share, share);
+      }
+      else
+      {
+        for (std::size_t i = t * share; i != (t + 1) * share; ++i)
+        {
+          concurrent.insert_concurrent(keys[i]);
+        }
+      }
+    });
+  }
+
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+
+  EXPECT_TRUE(serial == concurrent);
+}
+
+TEST(bloom, union_matches_one_filter_of_all_keys)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const std::vector<std::uint64_t> keys = random_keys(30000, seed);
+  const std::size_t half = keys.size() / 2;
+
+  bit::bloom all(keys.size()), first(keys.size()), second(keys.size());
+  all.insert(keys.data(), keys.size());
+  first.insert(keys.data(), half);
+  second.insert(keys.data() + half, keys.size() - half);
+
+  EXPECT_TRUE(first != all);
+
+  first |= second;
+  EXPECT_TRUE(first == all);
+
+  first.clear();
+  EXPECT_TRUE(first == bit::bloom(keys.size()));
+  EXPECT_FALSE(first.contains(keys[0]));
+}
+
+TEST(bloom, union_needs_equal_sizes)
+{
+  bit::bloom x(1000), y(2000);
+  EXPECT_THROW(x |= y, std::invalid_argument);
+}
+
+TEST(bloom, moves_keep_their_keys)
+{
+  bit::bloom x(1000);
+  x.insert(42);
+
+  bit::bloom y(std::move(x));
+  EXPECT_TRUE(y.contains(42));
+
+  bit::bloom z(10);
+  z = std::move(y);
+  EXPECT_TRUE(z.contains(42));
+  EXPECT_EQ(bit::bloom(1000).blocks(), z.blocks());
+}
+
+namespace
+{
+  // Filters of 2^20 and 2^24 keys at 12 bits each, 1.5 and 24 MiB, in
+  // and out of the last-level cache; a filter of 10^9 keys behaves as
+  // the larger one, only more so. Inserts start from an empty filter
+  // each time, so that every word is written.
+  void bloom_insert_single_benchmark(benchmark::State& state)
+  {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const std::vector<std::uint64_t> keys = random_keys(n, generator::default_seed());
+    bit::bloom filter(n);
+
+    for (auto _ : state)
+    {
+      state.PauseTiming();
+      filter.clear();
+      state.ResumeTiming();
+
+      for (const std::uint64_t key : keys)
+      {
+        filter.insert(key);
+      }
+
+      benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+  }
+
+  void bloom_insert_batched_benchmark(benchmark::State& state)
+  {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const std::vector<std::uint64_t> keys = random_keys(n, generator::default_seed());
+    bit::bloom filter(n);
+
+    for (auto _ : state)
+    {
+      state.PauseTiming();
+      filter.clear();
+      state.ResumeTiming();
+
+      filter.insert(keys.data(), keys.size());
+      benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+  }
+
+  void bloom_insert_concurrent_benchmark(benchmark::State& state)
+  {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const std::vector<std::uint64_t> keys = random_keys(n, generator::default_seed());
+    bit::bloom filter(n);
+
+    for (auto _ : state)
+    {
+      state.PauseTiming();
+      filter.clear();
+      state.ResumeTiming();
+
+      filter.insert_concurrent(keys.data(), keys.size());
+      benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+  }
+
+  // Queries of absent keys, the common case for a filter in front of a
+  // slower lookup.
+  void bloom_query_single_benchmark(benchmark::State& state)
+  {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const std::vector<std::uint64_t> keys    = random_keys(n, generator::default_seed());
+    const std::vector<std::uint64_t> queries = random_keys(n, generator::derive_seed(generator::default_seed(), 1));
+    bit::bloom filter(n);
+    filter.insert(keys.data(), keys.size());
+
+    for (auto _ : state)
+    {
+      std::size_t hits = 0;
+
+      for (const std::uint64_t key : queries)
+      {
+        hits += filter.contains(key);
+      }
+
+      benchmark::DoNotOptimize(hits);
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+  }
+
+  void bloom_query_batched_benchmark(benchmark::State& state)
+  {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const std::vector<std::uint64_t> keys    = random_keys(n, generator::default_seed());
+    const std::vector<std::uint64_t> queries = random_keys(n, generator::derive_seed(generator::default_seed(), 1));
+    bit::bloom filter(n);
+    filter.insert(keys.data(), keys.size());
+
+    std::vector<std::uint8_t> out(n);
+
+    for (auto _ : state)
+    {
+      benchmark::DoNotOptimize(filter.contains(queries.data(), queries.size(), out.data()));
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+  }
+}
+
+BENCHMARK(bloom_insert_single_benchmark)->Arg(1 << 20)->Arg(1 << 24);
+BENCHMARK(bloom_insert_batched_benchmark)->Arg(1 << 20)->Arg(1 << 24);
+BENCHMARK(bloom_insert_concurrent_benchmark)->Arg(1 << 20)->Arg(1 << 24);
+BENCHMARK(bloom_query_single_benchmark)->Arg(1 << 20)->Arg(1 << 24);
+BENCHMARK(bloom_query_batched_benchmark)->Arg(1 << 20)->Arg(1 << 24);
@@ -0,0 +1,593 @@
+#include "bit/kernels.hpp"
+#include "bit/bit.hpp"
+#include "bit/transpose.hpp"
+#include "../../differential.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // Runs the kernels at one level for as long as it lives.
+  class selection
+  {
+  public:
+    explicit selection(const bit::kernels::isa level)
+      : saved_(bit::kernels::selected())
+    {
+      bit::kernels::select(level);
+    }
+
+    selection(const selection&) = delete;
+    selection& operator=(const selection&) = delete;
+
+    ~selection()
+    {
+      bit::kernels::select(saved_);
+    }
+
+  private:
+    bit::kernels::isa saved_;
+  };
+
+  std::vector<std::uint64_t> random_words(const std::size_t n, const std::uint64_t seed)
+  {
+    std::vector<std::uint64_t> words(n);
+    generator::fill_uniform(words.begin(), words.end(), seed, std::uint64_t{0},
+                            std::numeric_limits<std::uint64_t>::max());
+    return words;
+  }
+
+  // Lengths around every vector width, so that each tail path runs.
+  const std::size_t lengths[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 100, 1000};
+}
+
+class kernels : public TestWithParam<bit::kernels::isa>
+{
+protected:
+  void SetUp() override
+  {
+    if (!bit::kernels::supported(GetParam()))
+    {
+      GTEST_SKIP() << "this CPU cannot run the " << bit::kernels::name(GetParam()) << " kernels";
+    }
+  }
+};
+
+TEST_P(kernels, count_matches_generic)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (const std::size_t n : lengths)
+  {
+    const std::vector<std::uint64_t> words = random_words(n, generator::derive_seed(seed, n));
+
+    std::uint64_t expected;
+    {
+      const selection generic{bit::kernels::isa::generic};
+      expected = bit::kernels::count(words.data(), n);
+    }
+
+    const selection level{GetParam()};
+    ASSERT_EQ(expected, bit::kernels::count(words.data(), n)) << "n=" << n;
+  }
+}
+
+TEST_P(kernels, count_extremes)
+{
+  const selection level{GetParam()};
+
+  for (const std::size_t n : lengths)
+  {
+    const std::vector<std::uint64_t> zeros(n, 0);
+    const std::vector<std::uint64_t> ones(n, ~std::uint64_t{0});
+
+    ASSERT_EQ(0u, bit::kernels::count(zeros.data(), n)) << "n=" << n;
+    ASSERT_EQ(64 * n, bit::kernels::count(ones.data(), n)) << "n=" << n;
+  }
+}
+
+TEST_P(kernels, hamming_distance_matches_generic)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (const std::size_t n : lengths)
+  {
+    const std::vector<std::uint64_t> a = random_words(n, generator::derive_seed(seed, 2 * n));
+    const std::vector<std::uint64_t> b = random_words(n, generator::derive_seed(seed, 2 * n + 1));
+
+    std::uint64_t expected;
+    {
+      const selection generic{bit::kernels::isa::generic};
+      expected = bit::kernels::hamming_distance(a.data(), b.data(), n);
+    }
+
+    const selection level{GetParam()};
+    ASSERT_EQ(expected, bit::kernels::hamming_distance(a.data(), b.data(), n)) << "n=" << n;
+    ASSERT_EQ(0u, bit::kernels::hamming_distance(a.data(), a.data(), n)) << "n=" << n;
+  }
+}
+
+TEST_P(kernels, extract_and_deposit_match_generic)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const std::size_t n = 64;
+  const std::vector<std::uint64_t> words = random_words(n, seed);
+  std::vector<std::uint64_t> masks = random_words(16, generator::derive_seed(seed, 1));
+  masks.push_back(0);
+  masks.push_back(~std::uint64_t{0});
+  masks.push_back(0x8000000000000001ULL);
+  masks.push_back(0x5555555555555555ULL);
+
+  for (const std::uint64_t mask : masks)
+  {
+    std::vector<std::uint64_t> extracted(n), deposited(n);
+    {
+      const selection generic{bit::kernels::isa::generic};
+      bit::kernels::extract(words.data(), n, mask, extracted.data());
+      bit::kernels::deposit(words.data(), n, mask, deposited.data());
+    }
+
+    std::vector<std::uint64_t> out(n);
+    const selection level{GetParam()};
+
+    bit::kernels::extract(words.data(), n, mask, out.data());
+    ASSERT_EQ(extracted, out) << std::hex << "mask=" << mask;
+
+    bit::kernels::deposit(words.data(), n, mask, out.data());
+    ASSERT_EQ(deposited, out) << std::hex << "mask=" << mask;
+
+    // Depositing what was extracted puts back exactly the masked bits.
+    bit::kernels::deposit(extracted.data(), n, mask, out.data());
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      ASSERT_EQ(words[i] & mask, out[i]) << std::hex << "mask=" << mask;
+    }
+  }
+}
+
+TEST_P(kernels, bit_width_matches_scalar)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const selection level{GetParam()};
+
+  for (const std::size_t n : lengths)
+  {
+    // Random words have their top bit set half the time; shifting each
+    // right by a random amount spreads the widths over every bucket.
+    std::vector<std::uint64_t> wide = random_words(n + 1, generator::derive_seed(seed, n));
+    std::vector<std::uint32_t> narrow(n + 1);
+
+    for (std::size_t i = 0; i != n + 1; ++i)
+    {
+      wide[i] >>= wide[i] % 65 == 64 ? 63 : wide[i] % 64;
+      narrow[i] = static_cast<std::uint32_t>(wide[i] >> (i % 33 == 32 ? 31 : i % 32));
+    }
+
+    wide[0]   = 0;
+    narrow[0] = 0;
+
+    // Off by one element, so that the vector loads are unaligned.
+    std::vector<std::uint8_t> out(n, 0xff);
+
+    bit::kernels::bit_width(wide.data() + 1, n, out.data());
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      ASSERT_EQ(bit::bit_width(wide[i + 1]), out[i]) << "n=" << n << ", i=" << i;
+    }
+
+    bit::kernels::bit_width(narrow.data() + 1, n, out.data());
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      ASSERT_EQ(bit::bit_width(narrow[i + 1]), out[i]) << "n=" << n << ", i=" << i;
+    }
+
+    bit::kernels::bit_width(wide.data(), n, out.data());
+    ASSERT_TRUE(n == 0 || out[0] == 0);
+  }
+}
+
+TEST_P(kernels, transpose64_matches_scalar)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const selection level{GetParam()};
+
+  for (const std::size_t n : {0, 1, 2, 5})
+  {
+    // One word in, so that no matrix is aligned.
+    std::vector<std::uint64_t> matrices = random_words(64 * n + 1, generator::derive_seed(seed, n));
+    std::vector<std::uint64_t> expected(matrices.begin() + 1, matrices.end());
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      bit::transpose64(expected.data() + 64 * i);
+    }
+
+    bit::kernels::transpose64(matrices.data() + 1, n);
+    ASSERT_EQ(expected, std::vector<std::uint64_t>(matrices.begin() + 1, matrices.end())) << "n=" << n;
+  }
+}
+
+TEST_P(kernels, pack128_matches_generic)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const std::size_t blocks = 3;
+
+  for (unsigned int width = 0; width <= 32; ++width)
+  {
+    std::vector<std::uint32_t> values(128 * blocks);
+    generator::fill_uniform(values.begin(), values.end(), generator::derive_seed(seed, width), std::uint32_t{0},
+                            std::numeric_limits<std::uint32_t>::max());
+
+    std::vector<std::uint32_t> expected(4 * width * blocks), unpacked(values.size());
+    {
+      const selection generic{bit::kernels::isa::generic};
+      bit::kernels::pack128(values.data(), blocks, width, expected.data());
+    }
+
+    const selection level{GetParam()};
+
+    std::vector<std::uint32_t> packed(expected.size());
+    bit::kernels::pack128(values.data(), blocks, width, packed.data());
+    ASSERT_EQ(expected, packed) << "width=" << width;
+
+    // The bits above width are dropped.
+    bit::kernels::unpack128(packed.data(), blocks, width, unpacked.data());
+
+    for (std::size_t i = 0; i != values.size(); ++i)
+    {
+      const std::uint32_t low = width == 32 ? ~0U : (1U << width) - 1;
+      ASSERT_EQ(values[i] & low, unpacked[i]) << "width=" << width << ", i=" << i;
+    }
+  }
+}
+
+TEST_P(kernels, intersect16_matches_set_intersection)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const selection level{GetParam()};
+
+  // Strictly increasing values below limit, zero and 65535 included
+  // often enough to catch a kernel that takes zero for a terminator.
+  const auto sorted_set = [](const std::size_t n, const std::uint16_t limit, const std::uint64_t stream)
+  {
+    std::vector<std::uint16_t> values(n);
+    generator::fill_uniform(values.begin(), values.end(), stream, std::uint16_t{0}, limit);
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+  };
+
+  const std::size_t sizes[] = {0, 1, 7, 8, 9, 16, 63, 200, 1000, 4096};
+  const std::uint16_t limits[] = {15, 300, 5000, 65535};
+  std::uint64_t stream = 0;
+
+  for (const std::size_t na : sizes)
+  {
+    for (const std::size_t nb : sizes)
+    {
+      for (const std::uint16_t limit : limits)
+      {
+        const std::vector<std::uint16_t> a = sorted_set(na, limit, generator::derive_seed(seed, ++stream));
+        const std::vector<std::uint16_t> b = sorted_set(nb, limit, generator::derive_seed(seed, ++stream));
+
+        std::vector<std::uint16_t> expected;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+
+        std::vector<std::uint16_t> out(std::min(a.size(), b.size()) + 8);
+        out.resize(bit::kernels::intersect16(a.data(), a.size(), b.data(), b.size(), out.data()));
+
+        ASSERT_EQ(expected, out) << "na=" << na << ", nb=" << nb << ", limit=" << limit;
+      }
+    }
+  }
+}
+
+TEST_P(kernels, bloom_matches_generic)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  // Blocks misaligned by a word, so that no level relies on the 64-byte
+  // alignment bit::bloom gives them.
+  const std::size_t nblocks = 97;
+
+  for (const std::size_t n : lengths)
+  {
+    const std::vector<std::uint64_t> keys    = random_words(n, generator::derive_seed(seed, 2 * n));
+    const std::vector<std::uint64_t> queries = random_words(n, generator::derive_seed(seed, 2 * n + 1));
+
+    std::vector<std::uint64_t> expected(8 * nblocks + 1), actual(8 * nblocks + 1);
+    std::vector<std::uint8_t>  expected_out(2 * n), actual_out(2 * n);
+    std::size_t                expected_hits, actual_hits;
+
+    {
+      const selection generic{bit::kernels::isa::generic};
+      bit::kernels::bloom_insert(expected.data() + 1, nblocks, keys.data(), n);
+      expected_hits  = bit::kernels::bloom_query(expected.data() + 1, nblocks, keys.data(), n, expected_out.data());
+      expected_hits += bit::kernels::bloom_query(expected.data() + 1, nblocks, queries.data(), n,
+                                                 expected_out.data() + n);
+    }
+
+    const selection level{GetParam()};
+    bit::kernels::bloom_insert(actual.data() + 1, nblocks, keys.data(), n);
+    actual_hits  = bit::kernels::bloom_query(actual.data() + 1, nblocks, keys.data(), n, actual_out.data());
+    actual_hits += bit::kernels::bloom_query(actual.data() + 1, nblocks, queries.data(), n, actual_out.data() + n);
+
+    ASSERT_EQ(expected, actual) << "n=" << n;
+    ASSERT_EQ(expected_out, actual_out) << "n=" << n;
+    ASSERT_EQ(expected_hits, actual_hits) << "n=" << n;
+    ASSERT_THAT(std::vector<std::uint8_t>(actual_out.begin(), actual_out.begin() + n), Each(1)) << "n=" << n;
+  }
+}
+
+namespace
+{
+  // A buffer of n random words starting offset words into its
+  // allocation, so that vector loads see every alignment.
+  struct kernel_case
+  {
+    std::uint64_t seed;
+    std::size_t   offset;
+    std::size_t   n;
+    std::uint64_t mask;
+  };
+
+  void PrintTo(const kernel_case& c, std::ostream* os)
+  {
+    *os << "{seed=" << c.seed << ", offset=" << c.offset << ", n=" << c.n
+        << ", mask=0x" << std::hex << c.mask << std::dec << '}';
+  }
+
+  // Every kernel's output on the case, including the aliased calls:
+  // hamming_distance of a buffer with itself, and extract and deposit
+  // writing over their own input.
+  std::vector<std::uint64_t> run_kernels(const kernel_case& c)
+  {
+    std::vector<std::uint64_t> a = random_words(c.offset + c.n, c.seed);
+    std::vector<std::uint64_t> b = random_words(c.offset + c.n, generator::derive_seed(c.seed, 1));
+    std::uint64_t* const words = a.data() + c.offset;
+    std::uint64_t* const other = b.data() + c.offset;
+
+    std::vector<std::uint64_t> results =
+    {
+      bit::kernels::count(words, c.n),
+      bit::kernels::hamming_distance(words, other, c.n),
+      bit::kernels::hamming_distance(words, words, c.n)
+    };
+
+    bit::kernels::extract(words, c.n, c.mask, words);
+    results.insert(results.end(), words, words + c.n);
+
+    bit::kernels::deposit(other, c.n, c.mask, other);
+    results.insert(results.end(), other, other + c.n);
+
+    std::vector<std::uint8_t> widths(c.n);
+    bit::kernels::bit_width(other, c.n, widths.data());
+    results.insert(results.end(), widths.begin(), widths.end());
+
+    std::vector<std::uint64_t> matrix(b.begin(), b.begin() + std::min<std::size_t>(b.size(), 64));
+    matrix.resize(64);
+    bit::kernels::transpose64(matrix.data(), 1);
+    results.insert(results.end(), matrix.begin(), matrix.end());
+
+    const std::vector<std::uint32_t> halves(reinterpret_cast<const std::uint32_t*>(words),
+                                            reinterpret_cast<const std::uint32_t*>(words + c.n));
+    widths.resize(halves.size());
+    bit::kernels::bit_width(halves.data(), halves.size(), widths.data());
+    results.insert(results.end(), widths.begin(), widths.end());
+
+    return results;
+  }
+}
+
+TEST_P(kernels, differential)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  std::vector<kernel_case> cases;
+
+  for (std::size_t i = 0; i != differential::iterations(); ++i)
+  {
+    const std::uint64_t stream = generator::derive_seed(seed, i);
+    const std::uint64_t mask   = generator::splitmix64::at(stream, 2);
+
+    // Half the masks are sparse, the way PEXT/PDEP selectors usually are.
+    cases.push_back({stream,
+                     generator::splitmix64::at(stream, 0) % 8,
+                     generator::splitmix64::at(stream, 1) % 70,
+                     i % 2 ? mask : mask & generator::splitmix64::at(stream, 3)});
+  }
+
+  const bit::kernels::isa level = GetParam();
+
+  EXPECT_TRUE(differential::agree(std::string("kernels at ") + bit::kernels::name(level),
+                                  [level](const kernel_case& c)
+                                  {
+                                    const selection selected{level};
+                                    return run_kernels(c);
+                                  },
+                                  [](const kernel_case& c)
+                                  {
+                                    const selection selected{bit::kernels::isa::generic};
+                                    return run_kernels(c);
+                                  },
+                                  cases));
+}
+
+INSTANTIATE_TEST_SUITE_P(isa, kernels, ValuesIn(bit::kernels::all_isas),
+                         [](const TestParamInfo<bit::kernels::isa>& info)
+                         {
+                           return std::string(bit::kernels::name(info.param));
+                         });
+
+TEST(kernels_dispatch, defaults_to_the_best_supported_level)
+{
+  if (std::getenv("BIT_KERNELS") != nullptr)
+  {
+    GTEST_SKIP() << "BIT_KERNELS caps the level";
+  }
+
+  bit::kernels::isa best = bit::kernels::isa::generic;
+
+  for (const bit::kernels::isa level : bit::kernels::all_isas)
+  {
+    if (bit::kernels::supported(level)) best = level;
+  }
+
+  ASSERT_EQ(best, bit::kernels::selected());
+}
+
+TEST(kernels_dispatch, rejects_unsupported_levels)
+{
+  ASSERT_TRUE(bit::kernels::supported(bit::kernels::isa::generic));
+
+  for (const bit::kernels::isa level : bit::kernels::all_isas)
+  {
+    if (!bit::kernels::supported(level))
+    {
+      const bit::kernels::isa before = bit::kernels::selected();
+      ASSERT_THROW(bit::kernels::select(level), std::invalid_argument);
+      ASSERT_EQ(before, bit::kernels::selected());
+    }
+  }
+}
+
+template <bit::kernels::isa level>
+void kernels_count_benchmark(benchmark::State& state)
+{
+  if (!bit::kernels::supported(level))
+  {
+    state.SkipWithError("not supported by this CPU");
+    return;
+  }
+
+  const selection selected{level};
+  const std::vector<std::uint64_t> words = random_words(state.range(0), 1);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(bit::kernels::count(words.data(), words.size()));
+  }
+
+  state.SetBytesProcessed(state.iterations() * words.size() * sizeof(std::uint64_t));
+}
+
+template <bit::kernels::isa level>
+void kernels_extract_benchmark(benchmark::State& state)
+{
+  if (!bit::kernels::supported(level))
+  {
+    state.SkipWithError("not supported by this CPU");
+    return;
+  }
+
+  const selection selected{level};
+  const std::vector<std::uint64_t> words = random_words(state.range(0), 1);
+  std::vector<std::uint64_t> out(words.size());
+
+  for (auto _ : state)
+  {
+    bit::kernels::extract(words.data(), words.size(), 0x0f0f0f0f0f0f0f0fULL, out.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+
+// Bucket indices of a million values of every width, as a log-scale
+// histogram computes them.
+template <bit::kernels::isa level>
+void kernels_bit_width_benchmark(benchmark::State& state)
+{
+  if (!bit::kernels::supported(level))
+  {
+    state.SkipWithError("not supported by this CPU");
+    return;
+  }
+
+  const selection selected{level};
+  std::vector<std::uint64_t> values = random_words(state.range(0), 1);
+  std::vector<std::uint8_t> out(values.size());
+
+  for (std::uint64_t& value : values)
+  {
+    value >>= value % 64;
+  }
+
+  for (auto _ : state)
+  {
+    bit::kernels::bit_width(values.data(), values.size(), out.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <bit::kernels::isa level>
+void kernels_transpose64_benchmark(benchmark::State& state)
+{
+  if (!bit::kernels::supported(level))
+  {
+    state.SkipWithError("not supported by this CPU");
+    return;
+  }
+
+  const selection selected{level};
+  std::vector<std::uint64_t> matrices = random_words(64 * state.range(0), 1);
+
+  for (auto _ : state)
+  {
+    bit::kernels::transpose64(matrices.data(), state.range(0));
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * matrices.size() * sizeof(std::uint64_t));
+}
+
+BENCHMARK_TEMPLATE(kernels_count_benchmark, bit::kernels::isa::generic)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(kernels_count_benchmark, bit::kernels::isa::sse42)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(kernels_count_benchmark, bit::kernels::isa::avx2)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(kernels_count_benchmark, bit::kernels::isa::avx512)->Range(64, 1 << 16);
+
+BENCHMARK_TEMPLATE(kernels_extract_benchmark, bit::kernels::isa::generic)->Range(64, 1 << 12);
+BENCHMARK_TEMPLATE(kernels_extract_benchmark, bit::kernels::isa::avx2)->Range(64, 1 << 12);
+
+BENCHMARK_TEMPLATE(kernels_bit_width_benchmark, bit::kernels::isa::generic)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(kernels_bit_width_benchmark, bit::kernels::isa::sse42)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(kernels_bit_width_benchmark, bit::kernels::isa::avx2)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(kernels_bit_width_benchmark, bit::kernels::isa::avx512)->Arg(1 << 20);
+
+BENCHMARK_TEMPLATE(kernels_transpose64_benchmark, bit::kernels::isa::generic)->Arg(192);
+BENCHMARK_TEMPLATE(kernels_transpose64_benchmark, bit::kernels::isa::avx2)->Arg(192);
+BENCHMARK_TEMPLATE(kernels_transpose64_benchmark, bit::kernels::isa::avx512)->Arg(192);
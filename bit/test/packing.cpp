@@ -0,0 +1,264 @@
+#include "bit/packing.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+  // Values of exactly width bits, the top one set in about half.
+  template <typename T>
+  std::vector<T> random_values(const std::size_t n, const unsigned int width, const std::uint64_t seed)
+  {
+    const T high = width == 0 ? T{0} : static_cast<T>(static_cast<T>(~T{0}) >> (std::numeric_limits<T>::digits - width));
+
+    std::vector<T> values(n);
+    generator::fill_uniform(values.begin(), values.end(), seed, T{0}, high);
+    return values;
+  }
+
+  // The stream a bit at a time.
+  template <typename T>
+  std::vector<T> naive_pack(const std::vector<T>& values, const unsigned int width)
+  {
+    const unsigned int bits = std::numeric_limits<T>::digits;
+    std::vector<T> packed(bit::packing::words<T>(values.size(), width), 0);
+
+    for (std::size_t i = 0; i != values.size(); ++i)
+    {
+      for (unsigned int b = 0; b != width; ++b)
+      {
+        const std::size_t position = i * width + b;
+        packed[position / bits] |= static_cast<T>(((values[i] >> b) & 1) << (position % bits));
+      }
+    }
+
+    return packed;
+  }
+
+  const std::size_t sizes[] = {0, 1, 31, 32, 33, 64, 65, 127, 128, 129, 300, 1000};
+}
+
+template <typename T>
+class packing : public Test {};
+
+using word_types = Types<std::uint32_t, std::uint64_t>;
+TYPED_TEST_SUITE(packing, word_types);
+
+TYPED_TEST(packing, every_width_round_trips)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (unsigned int width = 0; width <= std::numeric_limits<TypeParam>::digits; ++width)
+  {
+    for (const std::size_t n : sizes)
+    {
+      const std::vector<TypeParam> values =
+        random_values<TypeParam>(n, width, generator::derive_seed(seed, 100 * width + n));
+
+      // A guard word past the end catches overruns.
+      std::vector<TypeParam> packed(bit::packing::words<TypeParam>(n, width) + 1, 0x5a);
+      bit::packing::pack(values.data(), n, width, packed.data());
+
+      ASSERT_EQ(TypeParam{0x5a}, packed.back()) << "width=" << width << ", n=" << n;
+      packed.pop_back();
+      ASSERT_EQ(naive_pack(values, width), packed) << "width=" << width << ", n=" << n;
+
+      std::vector<TypeParam> unpacked(n);
+      bit::packing::unpack(packed.data(), n, width, unpacked.data());
+      ASSERT_EQ(values, unpacked) << "width=" << width << ", n=" << n;
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        ASSERT_EQ(values[i], bit::packing::get(packed.data(), width, i)) << "width=" << width << ", i=" << i;
+      }
+
+      ASSERT_EQ(n == 0 ? 0u : bit::packing::required_width(values.data(), n),
+                bit::bit_width(std::accumulate(values.begin(), values.end(), TypeParam{0},
+                                               [](TypeParam a, TypeParam b) { return a | b; })));
+    }
+  }
+}
+
+TYPED_TEST(packing, frame_of_reference_and_delta)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (const std::size_t n : sizes)
+  {
+    // Large values in a narrow range, and their running sum.
+    std::vector<TypeParam> values = random_values<TypeParam>(n, 11, generator::derive_seed(seed, n));
+    const TypeParam base = std::numeric_limits<TypeParam>::max() / 3;
+
+    for (TypeParam& value : values)
+    {
+      value += base;
+    }
+
+    const bit::packing::frame<TypeParam> frame = bit::packing::frame_of(values.data(), n);
+    ASSERT_LE(frame.width, 11u);
+
+    std::vector<TypeParam> packed(bit::packing::words<TypeParam>(n, frame.width));
+    bit::packing::pack_for(values.data(), n, frame, packed.data());
+
+    std::vector<TypeParam> unpacked(n);
+    bit::packing::unpack_for(packed.data(), n, frame, unpacked.data());
+    ASSERT_EQ(values, unpacked) << "n=" << n;
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      ASSERT_EQ(values[i], bit::packing::get_for(packed.data(), frame, i)) << "i=" << i;
+    }
+
+    std::partial_sum(values.begin(), values.end(), values.begin());
+    std::sort(values.begin(), values.end());
+
+    const unsigned int width = bit::packing::delta_width(values.data(), n, values.empty() ? 0 : values[0]);
+    ASSERT_LE(width, std::numeric_limits<TypeParam>::digits);
+
+    packed.assign(bit::packing::words<TypeParam>(n, width), 0);
+    bit::packing::pack_delta(values.data(), n, values.empty() ? 0 : values[0], width, packed.data());
+    bit::packing::unpack_delta(packed.data(), n, values.empty() ? 0 : values[0], width, unpacked.data());
+    ASSERT_EQ(values, unpacked) << "n=" << n;
+  }
+}
+
+TEST(packing_vertical, every_width_round_trips)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (unsigned int width = 0; width <= 32; ++width)
+  {
+    for (const std::size_t n : {0, 1, 128, 200, 512, 1000})
+    {
+      const std::vector<std::uint32_t> values =
+        random_values<std::uint32_t>(n, width, generator::derive_seed(seed, 100 * width + n));
+
+      std::vector<std::uint32_t> packed(bit::packing::vertical_words(n, width));
+      bit::packing::pack_vertical(values.data(), n, width, packed.data());
+
+      std::vector<std::uint32_t> unpacked(n);
+      bit::packing::unpack_vertical(packed.data(), n, width, unpacked.data());
+      ASSERT_EQ(values, unpacked) << "width=" << width << ", n=" << n;
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        ASSERT_EQ(values[i], bit::packing::get_vertical(packed.data(), n, width, i))
+          << "width=" << width << ", i=" << i;
+      }
+    }
+  }
+}
+
+TYPED_TEST(packing, rejects_widths_above_digits)
+{
+  constexpr unsigned int digits = std::numeric_limits<TypeParam>::digits;
+
+  const std::vector<TypeParam> values(100, 1);
+  std::vector<TypeParam> packed(bit::packing::words<TypeParam>(values.size(), 2 * digits));
+  std::vector<TypeParam> out(values.size());
+  const bit::packing::frame<TypeParam> frame{0, digits + 1};
+
+  for (const unsigned int width : {digits + 1, 2 * digits})
+  {
+    EXPECT_THROW(bit::packing::pack(values.data(), values.size(), width, packed.data()), std::invalid_argument);
+    EXPECT_THROW(bit::packing::unpack(packed.data(), values.size(), width, out.data()), std::invalid_argument);
+    EXPECT_THROW(bit::packing::get(packed.data(), width, 0), std::invalid_argument);
+    EXPECT_THROW(bit::packing::pack_delta(values.data(), values.size(), TypeParam{0}, width, packed.data()),
+                 std::invalid_argument);
+    EXPECT_THROW(bit::packing::unpack_delta(packed.data(), values.size(), TypeParam{0}, width, out.data()),
+                 std::invalid_argument);
+  }
+
+  EXPECT_THROW(bit::packing::pack_for(values.data(), values.size(), frame, packed.data()), std::invalid_argument);
+  EXPECT_THROW(bit::packing::unpack_for(packed.data(), values.size(), frame, out.data()), std::invalid_argument);
+  EXPECT_THROW(bit::packing::get_for(packed.data(), frame, 0), std::invalid_argument);
+
+  EXPECT_NO_THROW(bit::packing::pack(values.data(), values.size(), digits, packed.data()));
+}
+
+TEST(packing_vertical, rejects_widths_above_32)
+{
+  const std::vector<std::uint32_t> values(128, 1);
+  std::vector<std::uint32_t> packed(bit::packing::vertical_words(values.size(), 64));
+
+  for (const unsigned int width : {33U, 64U})
+  {
+    EXPECT_THROW(bit::packing::pack_vertical(values.data(), values.size(), width, packed.data()),
+                 std::invalid_argument);
+    EXPECT_THROW(bit::packing::unpack_vertical(packed.data(), values.size(), width, packed.data()),
+                 std::invalid_argument);
+    EXPECT_THROW(bit::packing::get_vertical(packed.data(), values.size(), width, 0), std::invalid_argument);
+  }
+}
+
+template <typename T, unsigned int width>
+void packing_unpack_benchmark(benchmark::State& state)
+{
+  const std::vector<T> values = random_values<T>(state.range(0), width, 1);
+  std::vector<T> packed(bit::packing::words<T>(values.size(), width));
+  std::vector<T> out(values.size());
+
+  bit::packing::pack(values.data(), values.size(), width, packed.data());
+
+  for (auto _ : state)
+  {
+    bit::packing::unpack(packed.data(), values.size(), width, out.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <unsigned int width>
+void packing_unpack_vertical_benchmark(benchmark::State& state)
+{
+  const std::vector<std::uint32_t> values = random_values<std::uint32_t>(state.range(0), width, 1);
+  std::vector<std::uint32_t> packed(bit::packing::vertical_words(values.size(), width));
+  std::vector<std::uint32_t> out(values.size());
+
+  bit::packing::pack_vertical(values.data(), values.size(), width, packed.data());
+
+  for (auto _ : state)
+  {
+    bit::packing::unpack_vertical(packed.data(), values.size(), width, out.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <unsigned int width>
+void packing_pack_vertical_benchmark(benchmark::State& state)
+{
+  const std::vector<std::uint32_t> values = random_values<std::uint32_t>(state.range(0), width, 1);
+  std::vector<std::uint32_t> packed(bit::packing::vertical_words(values.size(), width));
+
+  for (auto _ : state)
+  {
+    bit::packing::pack_vertical(values.data(), values.size(), width, packed.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK_TEMPLATE(packing_unpack_benchmark, std::uint32_t, 5)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(packing_unpack_benchmark, std::uint32_t, 17)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(packing_unpack_benchmark, std::uint64_t, 41)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(packing_unpack_vertical_benchmark, 5)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(packing_unpack_vertical_benchmark, 17)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(packing_pack_vertical_benchmark, 17)->Arg(1 << 16);
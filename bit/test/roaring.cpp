@@ -0,0 +1,391 @@
+#include "bit/roaring.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+  // n distinct values below limit, sorted.
+  std::vector<std::uint32_t> random_set(const std::size_t n, const std::uint64_t limit, const std::uint64_t seed)
+  {
+    std::vector<std::uint32_t> values(n);
+    generator::fill_uniform(values.begin(), values.end(), seed, std::uint32_t{0},
+                            static_cast<std::uint32_t>(limit - 1));
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+  }
+
+  // A set with a chunk of every shape: sparse, at the array limit, dense,
+  // long ranges, and the last chunk of the 32-bit range. Seeds that
+  // differ give sets that share chunks but few values.
+  std::vector<std::uint32_t> mixed_set(const std::uint64_t seed)
+  {
+    std::vector<std::uint32_t> values;
+
+    const auto chunk = [&](const std::uint32_t key, const std::size_t n, const std::uint64_t stream)
+    {
+      for (const std::uint32_t low : random_set(n, 1 << 16, generator::derive_seed(seed, stream)))
+      {
+        values.push_back(key << 16 | low);
+      }
+    };
+
+    chunk(0, 100, 0);
+    chunk(1, 30000, 1);
+    chunk(3, 4090, 2);
+    chunk(4, 5000, 3);
+
+    const std::uint32_t offset = static_cast<std::uint32_t>(generator::derive_seed(seed, 4) % 1000);
+
+    for (std::uint32_t x = (5 << 16) + offset; x != (7 << 16) + 3 * offset; ++x)
+    {
+      values.push_back(x);
+    }
+
+    chunk(0xffff, 50, 5);
+    values.push_back(0xffffffff);
+
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+  }
+
+  std::vector<std::uint32_t> values_of(const bit::roaring::view& frozen)
+  {
+    std::vector<std::uint32_t> values;
+    frozen.for_each([&values](const std::uint32_t x) { values.push_back(x); });
+    return values;
+  }
+}
+
+TEST(roaring, adds_and_removes_like_std_set)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  // Mostly adds into three chunks, so that arrays grow into bitmaps and
+  // shrink back as removals catch up.
+  std::vector<std::uint32_t> operations(60000);
+  generator::fill_uniform(operations.begin(), operations.end(), seed, std::uint32_t{0}, std::uint32_t{3 << 16});
+
+  bit::roaring       set;
+  std::set<std::uint32_t> expected;
+
+  for (std::size_t i = 0; i != operations.size(); ++i)
+  {
+    const std::uint32_t x = operations[i];
+
+    if (i % 3 == 2 || i > 45000)
+    {
+      set.remove(x);
+      expected.erase(x);
+    }
+    else
+    {
+      set.add(x);
+      expected.insert(x);
+    }
+
+    if (i % 5000 == 0)
+    {
+      ASSERT_EQ(set.cardinality(), expected.size()) << i;
+    }
+  }
+
+  EXPECT_EQ(set.cardinality(), expected.size());
+  EXPECT_EQ(set.to_vector(), std::vector<std::uint32_t>(expected.begin(), expected.end()));
+
+  for (std::uint32_t x = 0; x < 3 << 16; x += 7)
+  {
+    ASSERT_EQ(set.contains(x), expected.count(x) != 0) << x;
+  }
+
+  for (const std::uint32_t x : std::vector<std::uint32_t>(expected.begin(), expected.end()))
+  {
+    set.remove(x);
+  }
+
+  EXPECT_TRUE(set.empty());
+}
+
+TEST(roaring, containers_follow_the_density)
+{
+  bit::roaring set;
+
+  for (std::uint32_t x = 0; x != 4096; ++x)
+  {
+    set.add(2 * x);
+  }
+
+  EXPECT_EQ(set.containers(bit::roaring::kind::array), 1u);
+
+  set.add(1);
+  EXPECT_EQ(set.containers(bit::roaring::kind::bitmap), 1u);
+
+  set.remove(1);
+  EXPECT_EQ(set.containers(bit::roaring::kind::array), 1u);
+
+  // 0 .. 99999 is one run in chunk 0 and one in chunk 1.
+  bit::roaring range;
+
+  for (std::uint32_t x = 0; x != 100000; ++x)
+  {
+    range.add(x);
+  }
+
+  range.optimize();
+
+  EXPECT_EQ(range.containers(bit::roaring::kind::run), 2u);
+  EXPECT_EQ(range.cardinality(), 100000u);
+  EXPECT_TRUE(range.contains(65535));
+  EXPECT_TRUE(range.contains(99999));
+  EXPECT_FALSE(range.contains(100000));
+
+  range.add(200000);
+  range.remove(70000);
+  EXPECT_EQ(range.cardinality(), 100000u);
+  EXPECT_FALSE(range.contains(70000));
+}
+
+TEST(roaring, operations_match_sorted_set_algorithms)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (std::uint64_t round = 0; round != 4; ++round)
+  {
+    const std::vector<std::uint32_t> a = mixed_set(generator::derive_seed(seed, 2 * round));
+    const std::vector<std::uint32_t> b = mixed_set(generator::derive_seed(seed, 2 * round + 1));
+
+    bit::roaring x(a.begin(), a.end());
+    bit::roaring y(b.begin(), b.end());
+
+    // Rounds 1 and 3 take the run containers through every operation.
+    if (round % 2 == 1)
+    {
+      x.optimize();
+      y.optimize();
+      ASSERT_NE(x.containers(bit::roaring::kind::run), 0u);
+    }
+
+    std::vector<std::uint32_t> both, either, one, only_a;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(both));
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(either));
+    std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(one));
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(only_a));
+
+    EXPECT_EQ((x & y).to_vector(), both);
+    EXPECT_EQ((x | y).to_vector(), either);
+    EXPECT_EQ((x ^ y).to_vector(), one);
+    EXPECT_EQ((x - y).to_vector(), only_a);
+
+    EXPECT_EQ(and_cardinality(x, y), both.size());
+    EXPECT_EQ((x | y).cardinality(), either.size());
+    EXPECT_EQ(x.cardinality(), a.size());
+
+    bit::roaring z = x;
+    z -= y;
+    z |= y;
+    EXPECT_EQ(z, x | y);
+    EXPECT_EQ(x & x, x);
+    EXPECT_TRUE((x ^ x).empty());
+  }
+}
+
+TEST(roaring, serializes_in_the_portable_format)
+{
+  // Cookie 12346, one container: key 0 and cardinality - 1 = 2, at
+  // offset 16, holding 1, 2 and 3.
+  EXPECT_THAT((bit::roaring{1, 2, 3}).serialize(),
+              ElementsAre(0x3a, 0x30, 0, 0, 1, 0, 0, 0,
+                          0, 0, 2, 0,
+                          16, 0, 0, 0,
+                          1, 0, 2, 0, 3, 0));
+
+  // As a run: cookie 12347 for one container, its run bit, no offsets
+  // for so few containers, then one run from 1 of length 5. Three
+  // values would tie with the array, which is kept.
+  bit::roaring run{1, 2, 3, 4, 5};
+  run.optimize();
+
+  EXPECT_THAT(run.serialize(), ElementsAre(0x3b, 0x30, 0, 0, 1,
+                                           0, 0, 4, 0,
+                                           1, 0, 1, 0, 4, 0));
+
+  EXPECT_THAT(bit::roaring{}.serialize(), ElementsAre(0x3a, 0x30, 0, 0, 0, 0, 0, 0));
+}
+
+TEST(roaring, view_reads_serialized_bytes_in_place)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const std::vector<std::uint32_t> values = mixed_set(seed);
+
+  bit::roaring plain(values.begin(), values.end());
+  bit::roaring optimized = plain;
+  optimized.optimize();
+
+  // A few runs in fewer than four chunks leaves the offsets out.
+  bit::roaring small{7, 8, 9, 10, 70000};
+  small.optimize();
+
+  for (const bit::roaring* set : {&plain, &optimized, &small})
+  {
+    const std::vector<std::uint8_t> bytes = set->serialize();
+    ASSERT_EQ(bytes.size(), set->serialized_size());
+
+    const bit::roaring::view frozen{bytes};
+
+    EXPECT_EQ(frozen.size(), bytes.size());
+    EXPECT_EQ(frozen.containers(), set->containers());
+    EXPECT_EQ(frozen.cardinality(), set->cardinality());
+    EXPECT_EQ(values_of(frozen), set->to_vector());
+    EXPECT_EQ(bit::roaring{frozen}, *set);
+
+    for (std::uint32_t x = 0; x < 8u << 16; x += 13)
+    {
+      ASSERT_EQ(frozen.contains(x), set->contains(x)) << x;
+    }
+
+    EXPECT_EQ(frozen.contains(0xffffffff), set->contains(0xffffffff));
+  }
+
+  EXPECT_LT(optimized.serialized_size(), plain.serialized_size());
+}
+
+TEST(roaring, view_rejects_malformed_bytes)
+{
+  const std::vector<std::uint32_t> values = mixed_set(1);
+  bit::roaring set(values.begin(), values.end());
+  set.optimize();
+
+  const std::vector<std::uint8_t> bytes = set.serialize();
+
+  for (const std::size_t cut : {std::size_t{0}, std::size_t{3}, std::size_t{7}, std::size_t{40}, bytes.size() - 1})
+  {
+    EXPECT_THROW((bit::roaring::view{bytes.data(), cut}), std::invalid_argument) << cut;
+  }
+
+  std::vector<std::uint8_t> wrong = bytes;
+  wrong[0] ^= 1;
+  EXPECT_THROW(bit::roaring::view{wrong}, std::invalid_argument);
+
+  // In bounds but not a valid set: {1, 2, 3} (see serializes_in_the_
+  // portable_format) with its array unsorted, then with a cardinality of
+  // two for three values.
+  const std::vector<std::uint8_t> array = bit::roaring{1, 2, 3}.serialize();
+
+  std::vector<std::uint8_t> unsorted = array;
+  std::swap(unsorted[16], unsorted[18]);
+  EXPECT_THROW(bit::roaring::view{unsorted}, std::invalid_argument);
+
+  std::vector<std::uint8_t> duplicate = array;
+  duplicate[18] = duplicate[16];
+  EXPECT_THROW(bit::roaring::view{duplicate}, std::invalid_argument);
+
+  // A bitmap whose header claims one value fewer than it holds.
+  bit::roaring dense;
+
+  for (std::uint32_t x = 0; x != 5000; ++x)
+  {
+    dense.add(2 * x);
+  }
+
+  std::vector<std::uint8_t> miscounted = dense.serialize();
+  ASSERT_EQ(miscounted[10] | miscounted[11] << 8, 4999);
+  miscounted[10] -= 1;
+  EXPECT_THROW(bit::roaring::view{miscounted}, std::invalid_argument);
+
+  // Runs 1-5 and 3-4: sorted by start but overlapping, and a cardinality
+  // that no longer adds up once the second run is dropped.
+  bit::roaring runs{1, 2, 3, 4, 5, 10, 11, 12, 13};
+  runs.optimize();
+
+  std::vector<std::uint8_t> overlapping = runs.serialize();
+  ASSERT_EQ(overlapping.size(), 5U + 4 + 2 + 2 * 4);
+  overlapping[15] = 3;
+  overlapping[17] = 1;
+  overlapping[7]  = 6;
+  EXPECT_THROW(bit::roaring::view{overlapping}, std::invalid_argument);
+
+  std::vector<std::uint8_t> short_run = runs.serialize();
+  short_run[13] = 1;
+  EXPECT_THROW(bit::roaring::view{short_run}, std::invalid_argument);
+
+  EXPECT_NO_THROW(bit::roaring::view{runs.serialize()});
+}
+
+namespace
+{
+  // Two sets of about n values each, drawn from n * spread: a spread of
+  // 2 fills bitmap containers, 1024 leaves sparse arrays.
+  struct intersection_input
+  {
+    std::vector<std::uint32_t> a, b;
+
+    explicit intersection_input(const benchmark::State& state)
+      : a(random_set(state.range(0), std::uint64_t(state.range(0)) * state.range(1), 1)),
+        b(random_set(state.range(0), std::uint64_t(state.range(0)) * state.range(1), 2)) {}
+  };
+}
+
+void roaring_and_benchmark(benchmark::State& state)
+{
+  const intersection_input input{state};
+  const bit::roaring x(input.a.begin(), input.a.end());
+  const bit::roaring y(input.b.begin(), input.b.end());
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(x & y);
+  }
+
+  state.SetItemsProcessed(state.iterations() * (input.a.size() + input.b.size()));
+}
+
+void roaring_and_cardinality_benchmark(benchmark::State& state)
+{
+  const intersection_input input{state};
+  const bit::roaring x(input.a.begin(), input.a.end());
+  const bit::roaring y(input.b.begin(), input.b.end());
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(and_cardinality(x, y));
+  }
+
+  state.SetItemsProcessed(state.iterations() * (input.a.size() + input.b.size()));
+}
+
+void sorted_vector_intersection_benchmark(benchmark::State& state)
+{
+  const intersection_input input{state};
+  std::vector<std::uint32_t> both;
+  both.reserve(std::min(input.a.size(), input.b.size()));
+
+  for (auto _ : state)
+  {
+    both.clear();
+    std::set_intersection(input.a.begin(), input.a.end(), input.b.begin(), input.b.end(), std::back_inserter(both));
+    benchmark::DoNotOptimize(both.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * (input.a.size() + input.b.size()));
+}
+
+BENCHMARK(roaring_and_benchmark)->ArgsProduct({{1 << 20, 1 << 23}, {2, 1024}})->ArgNames({"n", "spread"});
+BENCHMARK(roaring_and_cardinality_benchmark)->ArgsProduct({{1 << 20, 1 << 23}, {2, 1024}})->ArgNames({"n", "spread"});
+BENCHMARK(sorted_vector_intersection_benchmark)->ArgsProduct({{1 << 20, 1 << 23}, {2, 1024}})->ArgNames({"n", "spread"});
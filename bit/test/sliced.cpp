@@ -0,0 +1,170 @@
+#include "bit/sliced.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+  template <typename T>
+  std::vector<T> random_values(const std::size_t n, const std::uint64_t seed)
+  {
+    std::vector<T> values(n);
+    generator::fill_uniform(values.begin(), values.end(), seed,
+                            std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+    return values;
+  }
+
+  // The selection a predicate makes, one value at a time.
+  template <typename T, typename Predicate>
+  std::vector<std::uint64_t> naive_select(const std::vector<T>& values, Predicate predicate)
+  {
+    std::vector<std::uint64_t> selected((values.size() + 63) / 64, 0);
+
+    for (std::size_t i = 0; i != values.size(); ++i)
+    {
+      if (predicate(values[i]))
+      {
+        selected[i / 64] |= std::uint64_t{1} << (i % 64);
+      }
+    }
+
+    return selected;
+  }
+
+  const std::size_t sizes[] = {0, 1, 63, 64, 65, 127, 128, 1000};
+}
+
+template <typename T>
+class sliced : public Test {};
+
+using sliced_types = Types<std::uint8_t, std::int8_t, std::uint16_t, std::int32_t, std::uint64_t, std::int64_t>;
+TYPED_TEST_SUITE(sliced, sliced_types);
+
+TYPED_TEST(sliced, holds_the_values)
+{
+  using U = std::make_unsigned_t<TypeParam>;
+
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (const std::size_t n : sizes)
+  {
+    const std::vector<TypeParam> values = random_values<TypeParam>(n, generator::derive_seed(seed, n));
+    const bit::sliced<TypeParam> planes{values.begin(), values.end()};
+
+    ASSERT_EQ(n, planes.size());
+    ASSERT_EQ((n + 63) / 64, planes.words());
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      ASSERT_EQ(values[i], planes[i]) << "i=" << i;
+    }
+
+    for (unsigned int j = 0; j != bit::sliced<TypeParam>::planes; ++j)
+    {
+      std::size_t ones = 0;
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        const bool set = (static_cast<U>(values[i]) >> j) & 1;
+        ones += set;
+        ASSERT_EQ(set, static_cast<bool>(planes.plane(j)[i])) << "i=" << i << ", j=" << j;
+      }
+
+      ASSERT_EQ(ones, planes.count(j)) << "j=" << j;
+    }
+  }
+}
+
+TYPED_TEST(sliced, predicates_match_scalar_comparisons)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (const std::size_t n : sizes)
+  {
+    // Few distinct keys, so that equal has something to find.
+    std::vector<TypeParam> values = random_values<TypeParam>(n, generator::derive_seed(seed, n));
+
+    for (std::size_t i = 0; i < n; i += 3)
+    {
+      values[i] = values[i / 3 % 4];
+    }
+
+    const bit::sliced<TypeParam> planes =
+      bit::sliced<TypeParam>::generate(n, [&](const std::size_t i) { return values[i]; });
+
+    std::vector<TypeParam> keys = random_values<TypeParam>(8, generator::derive_seed(seed, n + 1));
+    keys.push_back(0);
+    keys.push_back(std::numeric_limits<TypeParam>::min());
+    keys.push_back(std::numeric_limits<TypeParam>::max());
+    keys.insert(keys.end(), values.begin(), values.begin() + std::min<std::size_t>(n, 4));
+
+    for (const TypeParam key : keys)
+    {
+      ASSERT_EQ(naive_select(values, [=](const TypeParam v) { return v == key; }), planes.equal(key)) << +key;
+      ASSERT_EQ(naive_select(values, [=](const TypeParam v) { return v < key; }), planes.less(key)) << +key;
+
+      for (const TypeParam high : keys)
+      {
+        ASSERT_EQ(naive_select(values, [=](const TypeParam v) { return key <= v && v <= high; }),
+                  planes.between(key, high)) << +key << ".." << +high;
+      }
+    }
+  }
+}
+
+template <typename T>
+void sliced_less_benchmark(benchmark::State& state)
+{
+  const std::vector<T> values = random_values<T>(state.range(0), 1);
+  const bit::sliced<T> planes{values.begin(), values.end()};
+  const T key = values[values.size() / 2];
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(planes.less(key));
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <typename T>
+void scalar_less_benchmark(benchmark::State& state)
+{
+  const std::vector<T> values = random_values<T>(state.range(0), 1);
+  const T key = values[values.size() / 2];
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(naive_select(values, [=](const T v) { return v < key; }));
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <typename T>
+void sliced_construct_benchmark(benchmark::State& state)
+{
+  const std::vector<T> values = random_values<T>(state.range(0), 1);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(bit::sliced<T>{values.begin(), values.end()});
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK_TEMPLATE(sliced_less_benchmark, std::uint16_t)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(scalar_less_benchmark, std::uint16_t)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(sliced_construct_benchmark, std::uint32_t)->Range(1 << 10, 1 << 20);
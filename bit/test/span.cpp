@@ -0,0 +1,278 @@
+#include "bit/span.hpp"
+#include "../../differential.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+TEST(proxy, every_bit_of_a_64_bit_word)
+{
+  for (unsigned int i = 0; i != 64; ++i)
+  {
+    std::uint64_t word = 0;
+    bit::proxy<std::uint64_t>{word, i} = true;
+
+    ASSERT_EQ(std::uint64_t{1} << i, word);
+    ASSERT_TRUE(bit::const_proxy<std::uint64_t>(word, i));
+
+    bit::proxy<std::uint64_t>{word, i} = false;
+    ASSERT_EQ(0u, word);
+  }
+}
+
+TEST(proxy, sign_bit)
+{
+  std::int32_t word = 0;
+  bit::proxy<std::int32_t>{word, 31} = true;
+
+  ASSERT_EQ(std::numeric_limits<std::int32_t>::min(), word);
+}
+
+TEST(span, random_access_iterators)
+{
+  std::uint8_t bytes[] = {0b10100000, 0b00000101};
+  const auto bits = bit::make_span(bytes, 5, 6); // bits 5 .. 10: 1, 0, 1, 1, 0, 1
+
+  ASSERT_EQ(6, bits.end() - bits.begin());
+  ASSERT_TRUE(bits[0]);
+  ASSERT_FALSE(bits.begin()[1]);
+  ASSERT_TRUE(*(bits.end() - 1));
+  ASSERT_TRUE(bits.begin() + 4 < bits.end());
+  ASSERT_EQ(bits.begin() + 3, bits.end() - 3);
+  ASSERT_EQ(4, std::count(bits.begin(), bits.end(), true));
+
+  std::reverse(bits.begin(), bits.end());
+  ASSERT_EQ(0b10100000, bytes[0]);
+  ASSERT_EQ(0b00000101, bytes[1]);
+
+  std::sort(bits.begin(), bits.end());
+  ASSERT_EQ(0b10000000, bytes[0] & 0b11100000);
+  ASSERT_EQ(0b00000111, bytes[1]);
+}
+
+TEST(span, converts_to_const_span)
+{
+  std::uint32_t words[2] = {0xffffffff, 0};
+  const bit::span<std::uint32_t> bits{words, 64};
+  const bit::const_span<std::uint32_t> view = bits.subspan(16, 32);
+
+  ASSERT_EQ(16u, bit::count(view));
+  ASSERT_EQ(16u, bit::find(view, false));
+  ASSERT_EQ(0u, bit::find(view.last(16), false));
+  ASSERT_EQ(16u, bit::find(view.first(16), false));
+}
+
+namespace
+{
+  // One round of operations on a span over a few words: count and find,
+  // fill a subrange, copy in bits from another buffer at an unrelated
+  // offset, and read back every bit.
+  struct span_case
+  {
+    std::uint64_t seed;
+    std::size_t   offset, size;
+    std::size_t   fill_position, fill_size;
+    bool          fill_value;
+    std::size_t   copy_position, copy_size, source_offset;
+  };
+
+  void PrintTo(const span_case& c, std::ostream* os)
+  {
+    *os << "{seed=" << c.seed << ", offset=" << c.offset << ", size=" << c.size
+        << ", fill=" << c.fill_position << '+' << c.fill_size << '=' << c.fill_value
+        << ", copy=" << c.copy_position << '+' << c.copy_size << " from " << c.source_offset << '}';
+  }
+
+  constexpr std::size_t num_bytes = 40;
+
+  template <typename Word>
+  std::vector<Word> random_buffer(const std::uint64_t seed)
+  {
+    std::vector<Word> words(num_bytes / sizeof(Word));
+    generator::fill_uniform(words.begin(), words.end(), seed, Word{0}, std::numeric_limits<Word>::max());
+    return words;
+  }
+
+  template <typename Word>
+  std::vector<std::size_t> exercise_span(const span_case& c)
+  {
+    std::vector<Word> words        = random_buffer<Word>(c.seed);
+    const std::vector<Word> source = random_buffer<Word>(generator::derive_seed(c.seed, 1));
+
+    const bit::span<Word> bits{words.data(), c.offset, c.size};
+    std::vector<std::size_t> results = {bit::count(bits), bit::find(bits, true), bit::find(bits, false)};
+
+    bit::fill(bits.subspan(c.fill_position, c.fill_size), c.fill_value);
+    bit::copy(bit::const_span<Word>{source.data(), c.source_offset, c.copy_size},
+              bits.subspan(c.copy_position, c.copy_size));
+
+    results.insert(results.end(), bits.begin(), bits.end());
+
+    // Nothing outside the span changed.
+    const std::vector<Word> before = random_buffer<Word>(c.seed);
+    const bit::const_span<Word> all{words.data(), 8 * num_bytes};
+    const bit::const_span<Word> original{before.data(), 8 * num_bytes};
+
+    for (std::size_t i = 0; i != all.size(); ++i)
+    {
+      if ((i < c.offset || i >= c.offset + c.size) && all[i] != original[i])
+      {
+        results.push_back(i);
+      }
+    }
+
+    return results;
+  }
+
+  template <typename Word>
+  std::vector<std::size_t> exercise_model(const span_case& c)
+  {
+    const auto to_bools = [](const std::vector<Word>& words)
+    {
+      std::vector<bool> bools;
+
+      for (const Word word : words)
+      {
+        for (unsigned int i = 0; i != std::numeric_limits<Word>::digits; ++i)
+        {
+          bools.push_back((word >> i) & 1);
+        }
+      }
+
+      return bools;
+    };
+
+    const std::vector<bool> source = to_bools(random_buffer<Word>(generator::derive_seed(c.seed, 1)));
+    std::vector<bool> bits = to_bools(random_buffer<Word>(c.seed));
+
+    const auto first = bits.begin() + c.offset;
+    const auto last  = first + c.size;
+
+    const auto one  = std::find(first, last, true);
+    const auto zero = std::find(first, last, false);
+
+    std::vector<std::size_t> results = {static_cast<std::size_t>(std::count(first, last, true)),
+                                        static_cast<std::size_t>(one - first),
+                                        static_cast<std::size_t>(zero - first)};
+
+    std::fill(first + c.fill_position, first + c.fill_position + c.fill_size, c.fill_value);
+    std::copy(source.begin() + c.source_offset, source.begin() + c.source_offset + c.copy_size,
+              first + c.copy_position);
+
+    results.insert(results.end(), first, last);
+    return results;
+  }
+}
+
+template <typename Word>
+class span_differential : public Test {};
+
+using word_types = Types<std::uint8_t, std::uint16_t, std::uint32_t, std::uint64_t>;
+TYPED_TEST_SUITE(span_differential, word_types);
+
+TYPED_TEST(span_differential, matches_vector_of_bool)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  const std::size_t total = 8 * num_bytes;
+  std::vector<span_case> cases;
+
+  for (std::size_t i = 0; i != differential::iterations(); ++i)
+  {
+    const std::uint64_t stream = generator::derive_seed(seed, i);
+    const auto draw = [&](const std::uint64_t k, const std::size_t bound)
+    {
+      return static_cast<std::size_t>(generator::splitmix64::at(stream, k) % (bound + 1));
+    };
+
+    span_case c{};
+    c.seed          = stream;
+    c.offset        = draw(0, total);
+    c.size          = draw(1, total - c.offset);
+    c.fill_position = draw(2, c.size);
+    c.fill_size     = draw(3, c.size - c.fill_position);
+    c.fill_value    = draw(4, 1);
+    c.copy_position = draw(5, c.size);
+    c.copy_size     = draw(6, c.size - c.copy_position);
+    c.source_offset = draw(7, total - c.copy_size);
+    cases.push_back(c);
+  }
+
+  EXPECT_TRUE(differential::agree("bit::span", exercise_span<TypeParam>, exercise_model<TypeParam>, cases));
+}
+
+// Word-level algorithms against the standard ones running a bit at a
+// time through the span's iterators, over range(0) bits at offset 3.
+template <bool word_level>
+void span_count_benchmark(benchmark::State& state)
+{
+  std::vector<std::uint64_t> words(state.range(0) / 64 + 1);
+  generator::fill_uniform(words.begin(), words.end(), 1, std::uint64_t{0}, std::numeric_limits<std::uint64_t>::max());
+  const bit::const_span<std::uint64_t> bits{words.data(), 3, static_cast<std::size_t>(state.range(0))};
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(word_level ? bit::count(bits) : std::count(bits.begin(), bits.end(), true));
+  }
+
+  state.SetItemsProcessed(state.iterations() * bits.size());
+}
+
+template <bool word_level>
+void span_find_benchmark(benchmark::State& state)
+{
+  std::vector<std::uint64_t> words(state.range(0) / 64 + 1);
+  const bit::span<std::uint64_t> bits{words.data(), 3, static_cast<std::size_t>(state.range(0))};
+  bits[bits.size() - 1] = true;
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(word_level ? bit::find(bits, true)
+                                        : std::size_t(std::find(bits.begin(), bits.end(), true) - bits.begin()));
+  }
+
+  state.SetItemsProcessed(state.iterations() * bits.size());
+}
+
+template <bool word_level>
+void span_copy_benchmark(benchmark::State& state)
+{
+  std::vector<std::uint64_t> from(state.range(0) / 64 + 1), to(from.size());
+  generator::fill_uniform(from.begin(), from.end(), 1, std::uint64_t{0}, std::numeric_limits<std::uint64_t>::max());
+  const bit::const_span<std::uint64_t> source{from.data(), 3, static_cast<std::size_t>(state.range(0))};
+  const bit::span<std::uint64_t> destination{to.data(), 50, source.size()};
+
+  for (auto _ : state)
+  {
+    if (word_level)
+    {
+      bit::copy(source, destination);
+    }
+    else
+    {
+      std::copy(source.begin(), source.end(), destination.begin());
+    }
+
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * source.size());
+}
+
+BENCHMARK_TEMPLATE(span_count_benchmark, true)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(span_count_benchmark, false)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(span_find_benchmark, true)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(span_find_benchmark, false)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(span_copy_benchmark, true)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(span_copy_benchmark, false)->Range(64, 1 << 16);
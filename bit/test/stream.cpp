@@ -0,0 +1,378 @@
+#include "bit/stream.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+  // Values spread over every magnitude: a random word shifted down by a
+  // random amount, never zero.
+  std::vector<std::uint64_t> random_magnitudes(const std::size_t n, const std::uint64_t seed)
+  {
+    std::vector<std::uint64_t> words(n), shifts(n);
+    generator::fill_uniform(words.begin(), words.end(), seed, std::uint64_t{0}, ~std::uint64_t{0});
+    generator::fill_uniform(shifts.begin(), shifts.end(), generator::derive_seed(seed, 1), std::uint64_t{0}, std::uint64_t{63});
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      words[i] = (words[i] >> shifts[i]) | 1;
+    }
+
+    return words;
+  }
+
+  // Values of about 2^k, as a Rice code expects.
+  std::vector<std::uint64_t> random_geometric(const std::size_t n, const unsigned int k, const std::uint64_t seed)
+  {
+    std::vector<std::uint64_t> values(n);
+    generator::fill_uniform(values.begin(), values.end(), seed, std::uint64_t{1}, std::uint64_t{4} << k);
+    return values;
+  }
+
+  const std::uint64_t edges[] = {1, 2, 3, 4, 7, 8, 31, 32, 33, 127, 128, 255, 256,
+                                 (std::uint64_t{1} << 32) - 1, std::uint64_t{1} << 32,
+                                 std::uint64_t{1} << 63, ~std::uint64_t{0}};
+}
+
+TEST(stream, fields_land_least_significant_bit_first)
+{
+  bit::writer out;
+  out.write(0b101, 3);
+  out.write(0b11110, 5);
+  out.write(0xabc, 12);
+
+  EXPECT_EQ(out.size(), 20u);
+  EXPECT_THAT(out.finish(), ElementsAre(0xf5, 0xbc, 0x0a));
+}
+
+TEST(stream, mixed_widths_round_trip)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const std::size_t n = 5000;
+  std::vector<std::uint64_t> values(n), widths(n);
+  generator::fill_uniform(values.begin(), values.end(), seed, std::uint64_t{0}, ~std::uint64_t{0});
+  generator::fill_uniform(widths.begin(), widths.end(), generator::derive_seed(seed, 1), std::uint64_t{0}, std::uint64_t{64});
+
+  bit::writer out;
+  std::size_t bits = 0;
+
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    out.write(values[i], widths[i]);
+    bits += widths[i];
+  }
+
+  ASSERT_EQ(out.size(), bits);
+
+  const std::vector<std::uint8_t> bytes = out.finish();
+  ASSERT_EQ(bytes.size(), (bits + 7) / 8);
+
+  bit::reader in{bytes};
+
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    const unsigned int width = widths[i];
+    ASSERT_EQ(in.read(width), width == 64 ? values[i] : values[i] & ((std::uint64_t{1} << width) - 1)) << i;
+  }
+
+  EXPECT_EQ(in.position(), bits);
+  EXPECT_FALSE(in.overrun());
+}
+
+TEST(stream, align_pads_to_a_byte)
+{
+  bit::writer out;
+  out.write(1, 3);
+  out.align();
+  out.write(0xff, 8);
+  out.align();
+
+  EXPECT_EQ(out.size(), 16u);
+
+  const std::vector<std::uint8_t> bytes = out.finish();
+  bit::reader in{bytes};
+
+  EXPECT_EQ(in.read(3), 1u);
+  in.align();
+  EXPECT_EQ(in.position(), 8u);
+  EXPECT_EQ(in.read(8), 0xffu);
+}
+
+TEST(stream, reading_past_the_end_is_reported)
+{
+  const std::vector<std::uint8_t> bytes = {0xff, 0x01};
+  bit::reader in{bytes};
+
+  EXPECT_EQ(in.read(9), 0x1ffu);
+  EXPECT_FALSE(in.overrun());
+  EXPECT_EQ(in.read(7), 0u);
+  EXPECT_FALSE(in.overrun());
+  EXPECT_EQ(in.read(30), 0u);
+  EXPECT_TRUE(in.overrun());
+
+  // A unary run into the zero padding stops instead of spinning.
+  in.read_unary();
+  EXPECT_TRUE(in.overrun());
+}
+
+TEST(codes, lengths_are_as_specified)
+{
+  for (const std::uint64_t x : edges)
+  {
+    SCOPED_TRACE(x);
+    const unsigned int n = bit::floor_log2(x);
+
+    bit::writer gamma, delta, varint;
+    bit::codes::gamma(gamma, x);
+    bit::codes::delta(delta, x);
+    bit::codes::varint(varint, x);
+
+    EXPECT_EQ(gamma.size(), 2 * n + 1);
+    EXPECT_EQ(delta.size(), n + 2 * bit::floor_log2(n + 1) + 1);
+    EXPECT_EQ(varint.size(), 8 * (n / 7 + 1));
+  }
+
+  bit::writer rice;
+  bit::codes::rice(rice, 100, 4);
+  EXPECT_EQ(rice.size(), 100 / 16 + 1 + 4);
+
+  // The longest rice code written as one field, and the first that is not.
+  bit::writer edge;
+  bit::codes::rice(edge, 63, 0);
+  EXPECT_EQ(edge.size(), 64U);
+  bit::codes::rice(edge, 64, 0);
+  EXPECT_EQ(edge.size(), 64U + 65U);
+
+  // A quotient of 2^64 - 1 needs more bits than a stream can count.
+  EXPECT_THROW(bit::codes::rice(edge, UINT64_MAX, 0), std::length_error);
+  EXPECT_THROW(bit::codes::unary(edge, UINT64_MAX), std::length_error);
+  EXPECT_EQ(edge.size(), 64U + 65U);
+
+  // 5 in gamma: two zeros, the one, then 01 least significant first.
+  bit::writer five;
+  bit::codes::gamma(five, 5);
+  EXPECT_THAT(five.finish(), ElementsAre(0b01100));
+}
+
+TEST(codes, every_code_round_trips)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  std::vector<std::uint64_t> values = random_magnitudes(3000, seed);
+  values.insert(values.end(), std::begin(edges), std::end(edges));
+
+  const std::vector<std::uint64_t> small = random_geometric(3000, 6, generator::derive_seed(seed, 2));
+
+  bit::writer out;
+
+  for (const std::uint64_t x : values)
+  {
+    bit::codes::gamma(out, x);
+    bit::codes::delta(out, x);
+    bit::codes::varint(out, x);
+    bit::codes::rice(out, x >> 40, 20);
+  }
+
+  for (const std::uint64_t x : small)
+  {
+    bit::codes::rice(out, x, 6);
+    bit::codes::unary(out, x);
+  }
+
+  const std::vector<std::uint8_t> bytes = out.finish();
+  bit::reader in{bytes};
+
+  for (const std::uint64_t x : values)
+  {
+    ASSERT_EQ(bit::codes::gamma(in), x);
+    ASSERT_EQ(bit::codes::delta(in), x);
+    ASSERT_EQ(bit::codes::varint(in), x);
+    ASSERT_EQ(bit::codes::rice(in, 20), x >> 40);
+  }
+
+  for (const std::uint64_t x : small)
+  {
+    ASSERT_EQ(bit::codes::rice(in, 6), x);
+    ASSERT_EQ(bit::codes::unary(in), x);
+  }
+
+  EXPECT_FALSE(in.overrun());
+}
+
+// The reader decodes straight out of a mapped file, without copying it.
+TEST(stream, reads_a_mapped_file_in_place)
+{
+  const std::vector<std::uint64_t> values = random_magnitudes(1000, generator::default_seed());
+
+  bit::writer out;
+
+  for (const std::uint64_t x : values)
+  {
+    bit::codes::delta(out, x);
+  }
+
+  const std::vector<std::uint8_t> bytes = out.finish();
+
+  const char* directory = std::getenv("TMPDIR");
+  std::string path = std::string(directory && *directory ? directory : "/tmp") + "/bit-stream-XXXXXX";
+
+  const int fd = ::mkstemp(&path[0]);
+  ASSERT_GE(fd, 0);
+  ::unlink(path.c_str());
+
+  ASSERT_EQ(::write(fd, bytes.data(), bytes.size()), static_cast<ssize_t>(bytes.size()));
+
+  void* mapping = ::mmap(nullptr, bytes.size(), PROT_READ, MAP_PRIVATE, fd, 0);
+  ASSERT_NE(mapping, MAP_FAILED);
+
+  bit::reader in{static_cast<const std::uint8_t*>(mapping), bytes.size()};
+
+  for (const std::uint64_t x : values)
+  {
+    ASSERT_EQ(bit::codes::delta(in), x);
+  }
+
+  EXPECT_FALSE(in.overrun());
+
+  ::munmap(mapping, bytes.size());
+  ::close(fd);
+}
+
+namespace
+{
+  struct gamma_code
+  {
+    static void write(bit::writer& out, const std::uint64_t x) { bit::codes::gamma(out, x); }
+    static std::uint64_t read(bit::reader& in) { return bit::codes::gamma(in); }
+  };
+
+  struct delta_code
+  {
+    static void write(bit::writer& out, const std::uint64_t x) { bit::codes::delta(out, x); }
+    static std::uint64_t read(bit::reader& in) { return bit::codes::delta(in); }
+  };
+
+  struct rice_code
+  {
+    static void write(bit::writer& out, const std::uint64_t x) { bit::codes::rice(out, x, 6); }
+    static std::uint64_t read(bit::reader& in) { return bit::codes::rice(in, 6); }
+  };
+
+  struct varint_code
+  {
+    static void write(bit::writer& out, const std::uint64_t x) { bit::codes::varint(out, x); }
+    static std::uint64_t read(bit::reader& in) { return bit::codes::varint(in); }
+  };
+
+  // values through one code, into a buffer reserved once.
+  std::vector<std::uint8_t> encode_with(void (*write)(bit::writer&, std::uint64_t), const std::vector<std::uint64_t>& values)
+  {
+    bit::writer out{values.size() * 4};
+
+    for (const std::uint64_t x : values)
+    {
+      write(out, x);
+    }
+
+    return out.finish();
+  }
+}
+
+// Throughput in bytes of encoded stream.
+template <typename Code>
+void stream_write_benchmark(benchmark::State& state)
+{
+  const std::vector<std::uint64_t> values = random_geometric(state.range(0), 6, 1);
+  std::size_t bytes = 0;
+
+  for (auto _ : state)
+  {
+    bytes = encode_with(Code::write, values).size();
+    benchmark::DoNotOptimize(bytes);
+  }
+
+  state.SetBytesProcessed(state.iterations() * bytes);
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <typename Code>
+void stream_read_benchmark(benchmark::State& state)
+{
+  const std::vector<std::uint64_t> values = random_geometric(state.range(0), 6, 1);
+  const std::vector<std::uint8_t>  bytes  = encode_with(Code::write, values);
+
+  for (auto _ : state)
+  {
+    bit::reader   in{bytes};
+    std::uint64_t sum = 0;
+
+    for (std::size_t i = 0; i != values.size(); ++i)
+    {
+      sum += Code::read(in);
+    }
+
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+// Fixed 13-bit fields, for the accumulator alone.
+void stream_read_fields_benchmark(benchmark::State& state)
+{
+  std::vector<std::uint64_t> values(state.range(0));
+  generator::fill_uniform(values.begin(), values.end(), 1, std::uint64_t{0}, std::uint64_t{(1 << 13) - 1});
+
+  bit::writer out;
+
+  for (const std::uint64_t x : values)
+  {
+    out.write(x, 13);
+  }
+
+  const std::vector<std::uint8_t> bytes = out.finish();
+
+  for (auto _ : state)
+  {
+    bit::reader   in{bytes};
+    std::uint64_t sum = 0;
+
+    for (std::size_t i = 0; i != values.size(); ++i)
+    {
+      sum += in.read(13);
+    }
+
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK_TEMPLATE(stream_write_benchmark, gamma_code)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(stream_write_benchmark, delta_code)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(stream_write_benchmark, rice_code)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(stream_write_benchmark, varint_code)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(stream_read_benchmark, gamma_code)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(stream_read_benchmark, delta_code)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(stream_read_benchmark, rice_code)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(stream_read_benchmark, varint_code)->Arg(1 << 16);
+BENCHMARK(stream_read_fields_benchmark)->Arg(1 << 16);
@@ -0,0 +1,387 @@
+#include "bit/subset.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+  std::vector<std::uint64_t> random_table(const unsigned int n, const std::uint64_t seed)
+  {
+    std::vector<std::uint64_t> values(std::size_t{1} << n);
+    generator::fill_uniform(values.begin(), values.end(), seed, std::uint64_t{0},
+                            std::numeric_limits<std::uint64_t>::max());
+    return values;
+  }
+
+  // The definition: every pair of sets, 3^n of them that matter.
+  std::vector<std::uint64_t> naive_subset_sums(const std::vector<std::uint64_t>& values)
+  {
+    std::vector<std::uint64_t> sums(values.size());
+
+    for (std::size_t s = 0; s != values.size(); ++s)
+    {
+      for (std::size_t t = 0; t != values.size(); ++t)
+      {
+        if ((t & s) == t)
+        {
+          sums[s] += values[t];
+        }
+      }
+    }
+
+    return sums;
+  }
+
+  std::vector<std::uint64_t> naive_superset_sums(const std::vector<std::uint64_t>& values)
+  {
+    std::vector<std::uint64_t> sums(values.size());
+
+    for (std::size_t s = 0; s != values.size(); ++s)
+    {
+      for (std::size_t t = 0; t != values.size(); ++t)
+      {
+        if ((t & s) == s)
+        {
+          sums[s] += values[t];
+        }
+      }
+    }
+
+    return sums;
+  }
+
+  // One pass per bit over the whole table: the plain algorithm, and the
+  // baseline the blocked one is benchmarked against.
+  void unblocked_subset_zeta(std::uint64_t* values, const unsigned int n)
+  {
+    for (unsigned int j = 0; j != n; ++j)
+    {
+      for (std::size_t s = 0; s != std::size_t{1} << n; ++s)
+      {
+        if (s >> j & 1)
+        {
+          values[s] += values[s ^ (std::size_t{1} << j)];
+        }
+      }
+    }
+  }
+}
+
+TEST(next_combination, matches_the_next_value_of_equal_count)
+{
+  for (std::uint32_t x = 1; x != 1 << 16; ++x)
+  {
+    std::uint32_t next = x + 1;
+
+    while (bit::count(next) != bit::count(x))
+    {
+      ++next;
+    }
+
+    ASSERT_EQ(next, bit::next_combination(x)) << x;
+  }
+
+  EXPECT_EQ(std::uint64_t{1} << 63, bit::next_combination(std::uint64_t{1} << 62));
+  EXPECT_EQ(std::uint8_t{0xf0}, bit::next_combination(std::uint8_t{0xe8}));
+}
+
+TEST(for_each_subset, visits_every_subset_once_descending)
+{
+  for (const std::uint32_t mask : {0u, 1u, 0x80000000u, 0x5au, 0xf00fu})
+  {
+    std::vector<std::uint32_t> seen;
+    bit::for_each_subset(mask, [&](const std::uint32_t s) { seen.push_back(s); });
+
+    ASSERT_EQ(std::size_t{1} << bit::count(mask), seen.size()) << mask;
+    EXPECT_EQ(mask, seen.front());
+    EXPECT_EQ(0u, seen.back());
+    EXPECT_TRUE(std::is_sorted(seen.rbegin(), seen.rend())) << mask;
+    EXPECT_EQ(seen.end(), std::adjacent_find(seen.begin(), seen.end())) << mask;
+    EXPECT_THAT(seen, Each(Truly([mask](const std::uint32_t s) { return (s & mask) == s; })));
+  }
+}
+
+TEST(for_each_superset, visits_every_superset_once_ascending)
+{
+  const unsigned int n = 10;
+
+  for (const std::uint64_t mask : {0u, 1u, 0x200u, 0x155u, 0x3ffu})
+  {
+    std::vector<std::uint64_t> seen;
+    bit::for_each_superset(mask, n, [&](const std::uint64_t s) { seen.push_back(s); });
+
+    ASSERT_EQ(std::size_t{1} << (n - bit::count(mask)), seen.size()) << mask;
+    EXPECT_EQ(mask, seen.front());
+    EXPECT_EQ(0x3ffu, seen.back());
+    EXPECT_TRUE(std::is_sorted(seen.begin(), seen.end())) << mask;
+    EXPECT_EQ(seen.end(), std::adjacent_find(seen.begin(), seen.end())) << mask;
+    EXPECT_THAT(seen, Each(Truly([mask](const std::uint64_t s) { return (s & mask) == mask && s < 0x400; })));
+  }
+}
+
+TEST(for_each_layer, visits_every_mask_after_its_subsets)
+{
+  for (const unsigned int n : {0u, 1u, 5u, 12u})
+  {
+    std::vector<std::size_t> position(std::size_t{1} << n, 0);
+    std::size_t              next = 0;
+
+    bit::for_each_layer(n, [&](const std::uint64_t s)
+    {
+      ASSERT_LT(s, position.size());
+      ASSERT_EQ(0u, position[s]) << "visited twice: " << s;
+      position[s] = ++next;
+    });
+
+    ASSERT_EQ(position.size(), next) << "n=" << n;
+
+    for (std::size_t s = 1; s != position.size(); ++s)
+    {
+      for (std::size_t bit = 1; bit <= s; bit <<= 1)
+      {
+        if (s & bit)
+        {
+          ASSERT_LT(position[s ^ bit], position[s]) << "n=" << n << ", s=" << s;
+        }
+      }
+    }
+  }
+}
+
+TEST(subset_zeta, matches_the_definition)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (const unsigned int n : {0u, 1u, 2u, 7u, 10u})
+  {
+    const std::vector<std::uint64_t> values = random_table(n, generator::derive_seed(seed, n));
+
+    std::vector<std::uint64_t> subsets = values, supersets = values;
+    bit::subset_zeta(subsets);
+    bit::superset_zeta(supersets);
+
+    ASSERT_EQ(naive_subset_sums(values), subsets) << "n=" << n;
+    ASSERT_EQ(naive_superset_sums(values), supersets) << "n=" << n;
+  }
+}
+
+// Tiny blocks and runs, so that small tables take every path of the
+// blocked transform: several groups of high bits, a short last group,
+// more tiles than threads and fewer.
+TEST(subset_zeta, blocked_matches_unblocked)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const struct { unsigned int tile, run; } shapes[] = {{1, 0}, {3, 1}, {4, 2}, {5, 0}, {6, 3}};
+
+  for (const unsigned int n : {1u, 4u, 9u, 13u})
+  {
+    const std::vector<std::uint64_t> values = random_table(n, generator::derive_seed(seed, n));
+
+    std::vector<std::uint64_t> expected = values;
+    unblocked_subset_zeta(expected.data(), n);
+
+    for (const auto shape : shapes)
+    {
+      for (const unsigned int threads : {1u, 3u, 64u})
+      {
+        std::vector<std::uint64_t> actual = values;
+        bit::detail::transform<true>(actual.data(), n, [](std::uint64_t& into, const std::uint64_t& from) { into += from; },
+                                     threads, shape.tile, shape.run);
+
+        ASSERT_EQ(expected, actual) << "n=" << n << ", tile=" << shape.tile << ", run=" << shape.run
+                                    << ", threads=" << threads;
+      }
+    }
+  }
+}
+
+TEST(subset_mobius, inverts_zeta)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  // Within one block of 2^14 words, and past it and past the first group
+  // of seven high bits, so that every stage runs at the real sizes; sums
+  // wrap, and still invert.
+  for (const unsigned int n : {3u, 14u, 22u})
+  {
+    for (const unsigned int threads : {1u, 4u})
+    {
+      const std::vector<std::uint64_t> values = random_table(n, generator::derive_seed(seed, n));
+
+      std::vector<std::uint64_t> subsets = values, supersets = values;
+
+      bit::subset_zeta(subsets, threads);
+      bit::subset_mobius(subsets, threads);
+      bit::superset_zeta(supersets, threads);
+      bit::superset_mobius(supersets, threads);
+
+      ASSERT_EQ(values, subsets) << "n=" << n << ", threads=" << threads;
+      ASSERT_EQ(values, supersets) << "n=" << n << ", threads=" << threads;
+    }
+  }
+}
+
+TEST(subset_transform, folds_with_any_operation)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  const unsigned int n = 10;
+  const std::vector<std::uint64_t> values = random_table(n, seed);
+
+  std::vector<std::uint64_t> maxima = values, minima = values;
+  bit::subset_transform(maxima.data(), n, [](std::uint64_t& into, const std::uint64_t& from) { into = std::max(into, from); });
+  bit::superset_transform(minima.data(), n, [](std::uint64_t& into, const std::uint64_t& from) { into = std::min(into, from); });
+
+  for (std::uint64_t s = 0; s != values.size(); ++s)
+  {
+    std::uint64_t maximum = 0, minimum = std::numeric_limits<std::uint64_t>::max();
+
+    bit::for_each_subset(s, [&](const std::uint64_t t) { maximum = std::max(maximum, values[t]); });
+    bit::for_each_superset(s, n, [&](const std::uint64_t t) { minimum = std::min(minimum, values[t]); });
+
+    ASSERT_EQ(maximum, maxima[s]) << s;
+    ASSERT_EQ(minimum, minima[s]) << s;
+  }
+}
+
+// Inclusion-exclusion through the Moebius transform: (2^|S|)^2 pairs
+// of sets lie within S, and 3^|S| of them have S for their union, each
+// element being in the first, the second or both.
+TEST(subset_mobius, counts_pairs_by_union)
+{
+  const unsigned int n = 12;
+  std::vector<std::uint64_t> pairs(std::size_t{1} << n);
+
+  for (std::size_t s = 0; s != pairs.size(); ++s)
+  {
+    pairs[s] = std::uint64_t{1} << (2 * bit::count(s));
+  }
+
+  bit::subset_mobius(pairs);
+
+  for (std::size_t s = 0; s != pairs.size(); ++s)
+  {
+    std::uint64_t power = 1;
+
+    for (unsigned int i = 0; i != bit::count(s); ++i)
+    {
+      power *= 3;
+    }
+
+    ASSERT_EQ(power, pairs[s]) << s;
+  }
+}
+
+TEST(subset_zeta, needs_a_power_of_two)
+{
+  std::vector<std::uint64_t> empty, three(3), four(4, 1);
+
+  EXPECT_THROW(bit::subset_zeta(empty), std::invalid_argument);
+  EXPECT_THROW(bit::superset_mobius(three), std::invalid_argument);
+  EXPECT_NO_THROW(bit::subset_zeta(four));
+  EXPECT_THAT(four, ElementsAre(1, 2, 2, 4));
+}
+
+namespace
+{
+  // Tables of 2^20 words (8 MiB) and 2^24 (128 MiB). Bytes processed are
+  // the table once a transform, so the rate compares directly with one
+  // streaming pass: the unblocked transform makes n of them, the blocked
+  // one about three.
+  void stream_pass_benchmark(benchmark::State& state)
+  {
+    const unsigned int n = static_cast<unsigned int>(state.range(0));
+    std::vector<std::uint64_t> values = random_table(n, generator::default_seed());
+
+    for (auto _ : state)
+    {
+      for (std::uint64_t& value : values)
+      {
+        value += 1;
+      }
+
+      benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(std::uint64_t));
+  }
+
+  void unblocked_subset_zeta_benchmark(benchmark::State& state)
+  {
+    const unsigned int n = static_cast<unsigned int>(state.range(0));
+    std::vector<std::uint64_t> values = random_table(n, generator::default_seed());
+
+    for (auto _ : state)
+    {
+      unblocked_subset_zeta(values.data(), n);
+      benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(std::uint64_t));
+  }
+
+  void subset_zeta_benchmark(benchmark::State& state)
+  {
+    const unsigned int n       = static_cast<unsigned int>(state.range(0));
+    const unsigned int threads = static_cast<unsigned int>(state.range(1));
+    std::vector<std::uint64_t> values = random_table(n, generator::default_seed());
+
+    for (auto _ : state)
+    {
+      bit::subset_zeta(values, threads);
+      benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(std::uint64_t));
+  }
+
+  void superset_mobius_benchmark(benchmark::State& state)
+  {
+    const unsigned int n       = static_cast<unsigned int>(state.range(0));
+    const unsigned int threads = static_cast<unsigned int>(state.range(1));
+    std::vector<std::uint64_t> values = random_table(n, generator::default_seed());
+
+    for (auto _ : state)
+    {
+      bit::superset_mobius(values, threads);
+      benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(std::uint64_t));
+  }
+
+  // Every 16-bit mask with k bits set, by popcount layer.
+  void for_each_combination_benchmark(benchmark::State& state)
+  {
+    const unsigned int k = static_cast<unsigned int>(state.range(0));
+    std::size_t        visited = 0;
+
+    for (auto _ : state)
+    {
+      bit::for_each_combination(16, k, [&](const std::uint64_t s) { benchmark::DoNotOptimize(s); ++visited; });
+    }
+
+    state.SetItemsProcessed(visited);
+  }
+}
+
+BENCHMARK(stream_pass_benchmark)->Arg(20)->Arg(24)->ArgName("n");
+BENCHMARK(unblocked_subset_zeta_benchmark)->Arg(20)->Arg(24)->ArgName("n");
+BENCHMARK(subset_zeta_benchmark)->ArgsProduct({{20, 24}, {1, 0}})->ArgNames({"n", "threads"});
+BENCHMARK(superset_mobius_benchmark)->ArgsProduct({{20, 24}, {1, 0}})->ArgNames({"n", "threads"});
+BENCHMARK(for_each_combination_benchmark)->Arg(4)->Arg(8)->ArgName("k");
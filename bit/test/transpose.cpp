@@ -0,0 +1,121 @@
+#include "bit/transpose.hpp"
+#include "../../generator.hpp"
+
+#include <gmock/gmock.h>
+using namespace ::testing;
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+  std::vector<std::uint64_t> random_rows(const std::size_t n, const std::uint64_t seed)
+  {
+    std::vector<std::uint64_t> rows(n);
+    generator::fill_uniform(rows.begin(), rows.end(), seed, std::uint64_t{0},
+                            std::numeric_limits<std::uint64_t>::max());
+    return rows;
+  }
+
+  std::vector<std::uint64_t> naive_transpose64(const std::vector<std::uint64_t>& rows)
+  {
+    std::vector<std::uint64_t> transposed(64, 0);
+
+    for (unsigned int r = 0; r != 64; ++r)
+    {
+      for (unsigned int c = 0; c != 64; ++c)
+      {
+        transposed[c] |= ((rows[r] >> c) & 1) << r;
+      }
+    }
+
+    return transposed;
+  }
+}
+
+static_assert(bit::transpose8(0x0000000000000080ULL) == 0x0100000000000000ULL, "");
+static_assert(bit::transpose8(0x8040201008040201ULL) == 0x8040201008040201ULL, "");
+
+TEST(transpose8, matches_bit_by_bit_transpose)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  std::vector<std::uint64_t> matrices = random_rows(1000, seed);
+
+  for (unsigned int i = 0; i != 64; ++i)
+  {
+    matrices.push_back(std::uint64_t{1} << i);
+  }
+
+  for (const std::uint64_t x : matrices)
+  {
+    std::uint64_t expected = 0;
+
+    for (unsigned int r = 0; r != 8; ++r)
+    {
+      for (unsigned int c = 0; c != 8; ++c)
+      {
+        expected |= ((x >> (8 * r + c)) & 1) << (8 * c + r);
+      }
+    }
+
+    ASSERT_EQ(expected, bit::transpose8(x)) << std::hex << x;
+    ASSERT_EQ(x, bit::transpose8(bit::transpose8(x))) << std::hex << x;
+  }
+}
+
+TEST(transpose64, matches_bit_by_bit_transpose)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE(seed);
+
+  for (std::uint64_t i = 0; i != 100; ++i)
+  {
+    std::vector<std::uint64_t> rows = random_rows(64, generator::derive_seed(seed, i));
+    const std::vector<std::uint64_t> expected = naive_transpose64(rows);
+
+    bit::transpose64(rows.data());
+    ASSERT_EQ(expected, rows);
+  }
+}
+
+TEST(transpose64, single_bits_and_involution)
+{
+  for (unsigned int r = 0; r != 64; ++r)
+  {
+    for (unsigned int c = 0; c != 64; ++c)
+    {
+      std::uint64_t rows[64] = {};
+      rows[r] = std::uint64_t{1} << c;
+
+      bit::transpose64(rows);
+
+      ASSERT_EQ(std::uint64_t{1} << r, rows[c]) << r << ',' << c;
+      ASSERT_EQ(1, std::count_if(rows, rows + 64, [](const std::uint64_t row) { return row != 0; }));
+
+      bit::transpose64(rows);
+      ASSERT_EQ(std::uint64_t{1} << c, rows[r]) << r << ',' << c;
+    }
+  }
+}
+
+void transpose64_benchmark(benchmark::State& state)
+{
+  std::vector<std::uint64_t> rows = random_rows(64, 1);
+
+  for (auto _ : state)
+  {
+    bit::transpose64(rows.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * 64 * sizeof(std::uint64_t));
+}
+
+BENCHMARK(transpose64_benchmark);
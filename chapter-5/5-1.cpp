@@ -1,8 +1,21 @@
-#include "bit.hpp"
+#include "bit/bit.hpp"
+#include "bit/packing.hpp"
+#include "../differential.hpp"
+#include "../generator.hpp"
 
 #include "gmock/gmock.h"
 using namespace ::testing;
 
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
 template <typename T>
 inline constexpr
 T insert_bit_pattern(const T   N,
@@ -17,3 +30,120 @@ TEST(insert_bit_pattern, validate)
 {
   ASSERT_EQ(insert_bit_pattern(0b10000000000, 0b10011, 2, 6), 0b10001001100);
 }
+
+// Packs values[0, n) at width bits each, value i at bit i * width, one
+// insert_bit_pattern per field, or two for a field that straddles a word:
+// the layout bit::packing::pack produces with a kernel per width.
+template <typename T>
+std::vector<T> pack_with_insert_bit_pattern(const std::vector<T>& values, const int width)
+{
+  const int bits = std::numeric_limits<T>::digits;
+  std::vector<T> packed(bit::packing::words<T>(values.size(), width), 0);
+
+  for (std::size_t i = 0; i != values.size() && width != 0; ++i)
+  {
+    const std::size_t position = i * width;
+    const std::size_t word     = position / bits;
+    const int         low      = position % bits;
+    const int         high     = std::min(low + width, bits) - 1;
+
+    packed[word] = insert_bit_pattern<T>(packed[word], values[i], low, high);
+
+    if (low + width > bits)
+    {
+      packed[word + 1] = insert_bit_pattern<T>(packed[word + 1], values[i] >> (bits - low), 0, low + width - bits - 1);
+    }
+  }
+
+  return packed;
+}
+
+// n random fields of width bits, 1 <= width <= 64.
+std::vector<std::uint64_t> random_fields(const std::size_t n, const int width, const std::uint64_t seed)
+{
+  std::vector<std::uint64_t> values(n);
+  generator::fill_uniform(values.begin(), values.end(), seed, std::uint64_t{0},
+                          std::numeric_limits<std::uint64_t>::max() >> (64 - width));
+  return values;
+}
+
+TEST(insert_bit_pattern, differential_packs_like_bit_packing)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  std::vector<int> widths(64);
+  std::iota(widths.begin(), widths.end(), 1);
+
+  const auto fast = [&](const int width)
+  {
+    const std::vector<std::uint64_t> values = random_fields(257, width, generator::derive_seed(seed, width));
+
+    std::vector<std::uint64_t> packed(bit::packing::words<std::uint64_t>(values.size(), width));
+    bit::packing::pack(values.data(), values.size(), width, packed.data());
+    return packed;
+  };
+
+  const auto reference = [&](const int width)
+  {
+    return pack_with_insert_bit_pattern(random_fields(257, width, generator::derive_seed(seed, width)), width);
+  };
+
+  EXPECT_TRUE(differential::agree("bit::packing::pack", fast, reference, widths));
+}
+
+template <typename T>
+void insert_bit_pattern_benchmark(benchmark::State& state)
+{
+  const int half = bit::width<T>() / 2;
+
+  std::vector<T> values(state.range(0));
+  generator::fill_uniform(values.begin(), values.end(), 1, T{0}, std::numeric_limits<T>::max());
+
+  for (auto _ : state)
+  {
+    for (std::size_t k = 0; k != values.size(); ++k)
+    {
+      const int i = k % half;
+      benchmark::DoNotOptimize(insert_bit_pattern<T>(values[k], T{0b10011}, i, i + half - 1));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK_TEMPLATE(insert_bit_pattern_benchmark, std::uint8_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(insert_bit_pattern_benchmark, std::uint16_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(insert_bit_pattern_benchmark, std::uint32_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(insert_bit_pattern_benchmark, std::uint64_t)->Range(64, 1 << 16);
+
+// A stream of 13-bit fields, a field at a time and with the per-width
+// kernel.
+void pack_with_insert_bit_pattern_benchmark(benchmark::State& state)
+{
+  const std::vector<std::uint64_t> values = random_fields(state.range(0), 13, 1);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(pack_with_insert_bit_pattern(values, 13));
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+void pack_benchmark(benchmark::State& state)
+{
+  const std::vector<std::uint64_t> values = random_fields(state.range(0), 13, 1);
+
+  for (auto _ : state)
+  {
+    std::vector<std::uint64_t> packed(bit::packing::words<std::uint64_t>(values.size(), 13));
+    bit::packing::pack(values.data(), values.size(), 13, packed.data());
+    benchmark::DoNotOptimize(packed);
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK(pack_with_insert_bit_pattern_benchmark)->Arg(1 << 16);
+BENCHMARK(pack_benchmark)->Arg(1 << 16);
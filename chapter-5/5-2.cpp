@@ -1,8 +1,12 @@
+#include "../allocation.hpp"
+
 #include "gmock/gmock.h"
 using namespace ::testing;
 
+#include <benchmark/benchmark.h>
+
 #include <cmath>
-#include <iostream>
+#include <string>
 
 std::string get_binary_representation(double value)
 {
@@ -10,7 +14,7 @@ std::string get_binary_representation(double value)
   auto iteration_count = 0;
 
   std::string output{};
-  output.reserve(max_iterations);
+  output.reserve(2 + max_iterations);
 
   output = "0.";
 
@@ -51,3 +55,33 @@ TEST(print_binary_representation, validate)
   EXPECT_THAT(get_binary_representation(0.72), Eq("ERROR"));
   EXPECT_THAT(get_binary_representation(M_PI), Eq("ERROR"));
 }
+
+// The up-front reserve, sized for "0." and every digit that can be
+// produced, is the only allocation.
+TEST(print_binary_representation, allocates_once)
+{
+  SKIP_WITHOUT_ALLOCATION_HOOKS();
+
+  for (const double value : {0.5, 0.125, 0.72})
+  {
+    std::string output;
+    const auto stats = allocation::measure([&] { output = get_binary_representation(value); });
+    EXPECT_THAT(stats.allocations, Eq(1U)) << value;
+  }
+}
+
+void get_binary_representation_benchmark(benchmark::State& state)
+{
+  const double value = std::exp2(-state.range(0));
+  const allocation::Scope scope;
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(get_binary_representation(value));
+  }
+
+  allocation::report(state, scope.stats());
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(get_binary_representation_benchmark)->DenseRange(1, 29, 7);
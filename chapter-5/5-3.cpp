@@ -1,25 +1,38 @@
-#include "bit.hpp"
+#include "bit/bit.hpp"
+#include "bit/subset.hpp"
+#include "../differential.hpp"
+#include "../generator.hpp"
 
 #include "gmock/gmock.h"
 using namespace ::testing;
 
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 template <typename ValueType>
 typename std::enable_if<std::is_integral<ValueType>::value, ValueType>::type
 get_binary_greater(const ValueType value)
 {
-  if (value == 0)
+  if (value <= 0)
   {
-    throw std::runtime_error("input cannot be zero");
+    throw std::runtime_error("input must be positive");
   }
 
+  using Bits = std::make_unsigned_t<ValueType>;
+  const Bits bits = static_cast<Bits>(value);
+
   for (std::size_t i = 0, first = 0;
        i != bit::width<ValueType>();
        ++i)
   {
-    const std::size_t bit_mask = (1 << i);
-    const bool        bit_set  = value & bit_mask;
+    const Bits bit_mask = Bits{1} << i;
+    const bool bit_set  = bits & bit_mask;
 
     if (!first && bit_set)
     {
@@ -27,7 +40,7 @@ get_binary_greater(const ValueType value)
     }
     else if (first && !bit_set)
     {
-      return bit_mask | (value & ~(bit_mask - 1)) | ((1 << (i - first)) - 1);
+      return static_cast<ValueType>(bit_mask | (bits & ~(bit_mask - 1)) | ((Bits{1} << (i - first)) - 1));
     }
   }
 
@@ -38,16 +51,19 @@ template <typename ValueType>
 typename std::enable_if<std::is_integral<ValueType>::value, ValueType>::type
 get_binary_lesser(const ValueType value)
 {
-  if (value == 0)
+  if (value <= 0)
   {
-    throw std::runtime_error("input cannot be zero");
+    throw std::runtime_error("input must be positive");
   }
 
+  using Bits = std::make_unsigned_t<ValueType>;
+  const Bits bits = static_cast<Bits>(value);
+
   for (std::size_t i = 0, zero_pos = 0;
        i != bit::width<ValueType>();
        ++i)
   {
-    const bool bit_set = value & (1 << i);
+    const bool bit_set = bits & (Bits{1} << i);
 
     if (!zero_pos)
     {
@@ -58,9 +74,9 @@ get_binary_lesser(const ValueType value)
     }
     else if (bit_set)
     {
-      return (((1 << (zero_pos - 1)) - 1) << (i - zero_pos))
-            | (value & ~((1 << (i + 1)) - 1))
-            | (1 << (i - 1));
+      return static_cast<ValueType>((((Bits{1} << (zero_pos - 1)) - 1) << (i - zero_pos))
+                                    | (bits & ~((Bits{1} << i << 1) - 1))
+                                    | (Bits{1} << (i - 1)));
     }
   }
 
@@ -71,11 +87,16 @@ template <typename ValueType>
 typename std::enable_if<std::is_integral<ValueType>::value, ValueType>::type
 get_binary_greater_naive(const ValueType value)
 {
+  if (value <= 0)
+  {
+    throw std::runtime_error("input must be positive");
+  }
+
   const std::size_t num_set_bits = bit::count(value);
 
-  for (ValueType i = value + 1; i != std::numeric_limits<ValueType>::max(); ++i)
+  for (ValueType i = value; i != std::numeric_limits<ValueType>::max();)
   {
-    if (bit::count(i) == num_set_bits)
+    if (bit::count(++i) == num_set_bits)
     {
       return i;
     }
@@ -88,6 +109,11 @@ template <typename ValueType>
 typename std::enable_if<std::is_integral<ValueType>::value, ValueType>::type
 get_binary_lesser_naive(const ValueType value)
 {
+  if (value <= 0)
+  {
+    throw std::runtime_error("input must be positive");
+  }
+
   const std::size_t num_set_bits = bit::count(value);
 
   for (ValueType i = value - 1; i != 0; --i)
@@ -126,7 +152,7 @@ TEST(get_binary_lesser, zero)
 
 TEST(get_binary_lesser, all_ones)
 {
-  for (int i = 1; i != bit::width<int>(); ++i)
+  for (int i = 1; i != static_cast<int>(bit::width<int>()); ++i)
   {
     ASSERT_THROW(get_binary_lesser((1 << i) - 1), std::runtime_error);
   }
@@ -165,3 +191,141 @@ TEST(get_binary_lesser_with_get_binary_greater, test)
     }
   }
 }
+
+// Next larger value with as many set bits, by Gosper's hack: an
+// independent reference for the types too wide for the naive search.
+template <typename ValueType>
+ValueType get_binary_greater_gosper(const ValueType value)
+{
+  if (value <= 0)
+  {
+    throw std::runtime_error("input must be positive");
+  }
+
+  using Bits = std::make_unsigned_t<ValueType>;
+  const Bits bits    = static_cast<Bits>(value);
+  const Bits lowest  = static_cast<Bits>(bits & (~bits + 1));
+  const Bits ripple  = static_cast<Bits>(bits + lowest);
+  const Bits greater = static_cast<Bits>((((ripple ^ bits) >> 2) / lowest) | ripple);
+
+  if (ripple == 0 || greater > static_cast<Bits>(std::numeric_limits<ValueType>::max()))
+  {
+    throw std::runtime_error("no greater number within bound exists");
+  }
+
+  return static_cast<ValueType>(greater);
+}
+
+template <typename T>
+std::vector<T> every_value()
+{
+  std::vector<T> values;
+
+  for (T value = std::numeric_limits<T>::min();; ++value)
+  {
+    values.push_back(value);
+
+    if (value == std::numeric_limits<T>::max())
+    {
+      return values;
+    }
+  }
+}
+
+template <typename T>
+class get_binary_differential : public Test {};
+
+using narrow_types = Types<std::uint8_t, std::int8_t, std::uint16_t, std::int16_t>;
+TYPED_TEST_SUITE(get_binary_differential, narrow_types);
+
+// Small enough to check every value against the naive search.
+TYPED_TEST(get_binary_differential, every_value_matches_naive)
+{
+  const std::vector<TypeParam> values = every_value<TypeParam>();
+
+  EXPECT_TRUE(differential::agree("get_binary_greater",
+                                  get_binary_greater<TypeParam>, get_binary_greater_naive<TypeParam>, values));
+  EXPECT_TRUE(differential::agree("get_binary_lesser",
+                                  get_binary_lesser<TypeParam>, get_binary_lesser_naive<TypeParam>, values));
+}
+
+template <typename T>
+class get_binary_greater_differential : public Test {};
+
+using wide_types = Types<std::uint32_t, std::int32_t, std::uint64_t, std::int64_t>;
+TYPED_TEST_SUITE(get_binary_greater_differential, wide_types);
+
+TYPED_TEST(get_binary_greater_differential, matches_gosper)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  EXPECT_TRUE(differential::agree("get_binary_greater", get_binary_greater<TypeParam>,
+                                  get_binary_greater_gosper<TypeParam>, differential::values<TypeParam>(seed)));
+}
+
+// get_binary_greater walks a popcount layer in order, the enumeration
+// subset DP over the masks of k elements runs on.
+TEST(get_binary_greater, walks_popcount_layers)
+{
+  for (unsigned int k = 1; k != 12; ++k)
+  {
+    std::vector<std::uint64_t> layer;
+    bit::for_each_combination(12, k, [&](const std::uint64_t s) { layer.push_back(s); });
+
+    std::vector<std::uint64_t> walked{(std::uint64_t{1} << k) - 1};
+
+    while (walked.size() != layer.size())
+    {
+      walked.push_back(get_binary_greater(walked.back()));
+    }
+
+    ASSERT_EQ(layer, walked) << "k=" << k;
+
+    for (std::size_t i = 1; i != layer.size(); ++i)
+    {
+      ASSERT_EQ(layer[i - 1], get_binary_lesser(layer[i])) << "k=" << k;
+    }
+  }
+}
+
+// Values below half the maximum always have a greater neighbour.
+template <typename T>
+void get_binary_greater_benchmark(benchmark::State& state)
+{
+  std::vector<T> values(state.range(0));
+  generator::fill_uniform(values.begin(), values.end(), 1, T{1}, T(std::numeric_limits<T>::max() / 2));
+
+  for (auto _ : state)
+  {
+    for (const T value : values)
+    {
+      benchmark::DoNotOptimize(get_binary_greater(value));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+// Against Gosper's hack, which subset DP uses to walk a layer.
+template <typename T>
+void next_combination_benchmark(benchmark::State& state)
+{
+  std::vector<T> values(state.range(0));
+  generator::fill_uniform(values.begin(), values.end(), 1, T{1}, T(std::numeric_limits<T>::max() / 2));
+
+  for (auto _ : state)
+  {
+    for (const T value : values)
+    {
+      benchmark::DoNotOptimize(bit::next_combination(value));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK_TEMPLATE(get_binary_greater_benchmark, std::uint8_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(get_binary_greater_benchmark, std::uint16_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(get_binary_greater_benchmark, std::uint32_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(next_combination_benchmark, std::uint32_t)->Range(64, 1 << 16);
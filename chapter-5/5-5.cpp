@@ -1,8 +1,15 @@
-#include "bit.hpp"
+#include "bit/bit.hpp"
+#include "../generator.hpp"
+#include "../profiling.hpp"
 
 #include <gmock/gmock.h>
 using namespace ::testing;
 
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
 template <typename T>
 inline constexpr
 T get_hamming_distance(const T a, const T b)
@@ -14,3 +21,52 @@ TEST(get_hamming_distance, validate)
 {
   ASSERT_EQ(2, get_hamming_distance(0b11101, 0b01111));
 }
+
+template <typename T>
+void count_benchmark(benchmark::State& state)
+{
+  std::vector<T> values(state.range(0));
+  generator::fill_uniform(values.begin(), values.end(), 1, T{0}, std::numeric_limits<T>::max());
+
+  profiling::Counters counters;
+
+  {
+    const profiling::Scope scope{counters};
+
+    for (auto _ : state)
+    {
+      for (const T value : values)
+      {
+        benchmark::DoNotOptimize(bit::count(value));
+      }
+    }
+  }
+
+  profiling::report(state, counters.read());
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+template <typename T>
+void get_hamming_distance_benchmark(benchmark::State& state)
+{
+  std::vector<T> values(state.range(0) + 1);
+  generator::fill_uniform(values.begin(), values.end(), 1, T{0}, std::numeric_limits<T>::max());
+
+  for (auto _ : state)
+  {
+    for (std::size_t i = 1; i != values.size(); ++i)
+    {
+      benchmark::DoNotOptimize(get_hamming_distance(values[i - 1], values[i]));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(count_benchmark, std::uint8_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(count_benchmark, std::uint16_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(count_benchmark, std::uint32_t)->Range(64, 1 << 16);
+
+BENCHMARK_TEMPLATE(get_hamming_distance_benchmark, std::uint8_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(get_hamming_distance_benchmark, std::uint16_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(get_hamming_distance_benchmark, std::uint32_t)->Range(64, 1 << 16);
@@ -1,8 +1,14 @@
-#include "bit.hpp"
+#include "bit/bit.hpp"
+#include "../generator.hpp"
 
 #include "gmock/gmock.h"
 using namespace ::testing;
 
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
 template <typename T>
 inline constexpr
 T swap_even_with_odd_bits(const T value)
@@ -20,3 +26,26 @@ TEST(swap_even_with_odd_bits, verify)
   EXPECT_EQ(0b01010101U, swap_even_with_odd_bits(0b10101010U));
   EXPECT_EQ(0b10101010U, swap_even_with_odd_bits(0b01010101U));
 }
+
+template <typename T>
+void swap_even_with_odd_bits_benchmark(benchmark::State& state)
+{
+  std::vector<T> values(state.range(0));
+  generator::fill_uniform(values.begin(), values.end(), 1, T{0}, std::numeric_limits<T>::max());
+
+  for (auto _ : state)
+  {
+    for (T& value : values)
+    {
+      value = swap_even_with_odd_bits(value);
+    }
+
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK_TEMPLATE(swap_even_with_odd_bits_benchmark, std::uint8_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(swap_even_with_odd_bits_benchmark, std::uint16_t)->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(swap_even_with_odd_bits_benchmark, std::uint32_t)->Range(64, 1 << 16);
@@ -1,36 +1,49 @@
 
-#include "bit.hpp"
+#include "bit/bit.hpp"
+#include "bit/sliced.hpp"
+#include "../allocation.hpp"
+#include "../generator.hpp"
 
 #include "gmock/gmock.h"
 using namespace ::testing;
 
+#include <benchmark/benchmark.h>
+
 #include <algorithm>
 #include <array>
 #include <cstdint>
-#include <numeric>
-#include <random>
+#include <string>
 #include <vector>
 
 namespace
 {
+  // The numbers stored bit-sliced: bit j of every number is one
+  // contiguous run of words, so the solver's pass over one bit position
+  // reads memory in order instead of striding across every number.
   template <typename T>
   class problem_data
   {
   public:
-    problem_data(const T N)
-      : data_(N + 1)
+    // The numbers 0 .. N in an order fixed by seed, minus the one that
+    // lands last; no iota or shuffle pass over the data.
+    problem_data(const T N, const std::uint64_t seed)
     {
-      std::iota(data_.begin(), data_.end(), 0);
-      std::shuffle(data_.begin(), data_.end(),
-        std::default_random_engine{std::random_device{}()});
+      const generator::permutation order{std::uint64_t(N) + 1, seed};
 
-      missing_ = data_.back();
-      data_.pop_back();
+      data_ = bit::sliced<T>::generate(N, [&](const std::size_t i) { return static_cast<T>(order[i]); });
+      missing_ = static_cast<T>(order[N]);
     }
 
+    // Bit j of the i-th number, the one access the problem allows.
     T access(const T i, const unsigned int j) const noexcept
     {
-      return data_[i] & (T{1} << j);
+      return data_.plane(j)[i] ? T{1} << j : T{0};
+    }
+
+    // Number of values with bit j set.
+    std::size_t ones(const unsigned int j) const noexcept
+    {
+      return data_.count(j);
     }
 
     T missing() const noexcept
@@ -49,7 +62,7 @@ namespace
     }
 
   private:
-    std::vector<T> data_;
+    bit::sliced<T> data_;
     T              missing_;
   };
 }
@@ -60,12 +73,11 @@ auto find_missing_sequence_element(const problem_data<T>& input)
   const auto input_width = bit::width(input.N());
   std::vector<int> counters(input_width);
 
-  for (std::uint32_t i = 0; i != input.size(); ++i)
+  // +1 for every one and -1 for every zero in column j: a popcount of
+  // the column's plane.
+  for (unsigned int j = 0; j != input_width; ++j)
   {
-    for (unsigned int j = 0; j != input_width; ++j)
-    {
-      counters[j] += input.access(i, j) ? 1 : -1;
-    }
+    counters[j] = 2 * static_cast<int>(input.ones(j)) - static_cast<int>(input.size());
   }
 
   std::uint32_t result = 0;
@@ -93,9 +105,73 @@ auto find_missing_sequence_element(const problem_data<T>& input)
 
 TEST(find_missing_sequence_element, validates)
 {
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
   for (int i = 1; i <= 1000; ++i)
   {
-    problem_data<int> data{i};
+    problem_data<int> data{i, generator::derive_seed(seed, i)};
     find_missing_sequence_element(data);
   }
 }
+
+// The planes read back, a bit at a time, as the numbers they were built
+// from: 0 .. N in permutation order, missing the last.
+TEST(problem_data, planes_hold_the_values)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  for (const int N : {1, 63, 64, 65, 1000})
+  {
+    const problem_data<int>     data{N, seed};
+    const generator::permutation order{std::uint64_t(N) + 1, seed};
+
+    for (int i = 0; i != N; ++i)
+    {
+      int value = 0;
+
+      for (unsigned int j = 0; j != bit::width<int>(); ++j)
+      {
+        value |= data.access(i, j);
+      }
+
+      ASSERT_EQ(static_cast<int>(order[i]), value) << "N=" << N << ", i=" << i;
+    }
+
+    EXPECT_EQ(static_cast<int>(order[N]), data.missing()) << "N=" << N;
+  }
+}
+
+// One allocation for the data itself, 32 planes of 16 words, and one for
+// the per-bit counters.
+TEST(find_missing_sequence_element, allocations)
+{
+  SKIP_WITHOUT_ALLOCATION_HOOKS();
+
+  const auto construct = allocation::measure([] { problem_data<int>{1000, 1}; });
+  EXPECT_THAT(construct.allocations, Eq(1U));
+  EXPECT_THAT(construct.bytes, Eq(32 * 16 * sizeof(std::uint64_t)));
+
+  const problem_data<int> data{1000, 1};
+  const auto find = allocation::measure([&] { find_missing_sequence_element(data); });
+  EXPECT_THAT(find.allocations, Eq(1U));
+}
+
+template <typename T>
+void find_missing_sequence_element_benchmark(benchmark::State& state)
+{
+  const problem_data<T> data{static_cast<T>(state.range(0)), 1};
+  const allocation::Scope scope;
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(find_missing_sequence_element(data));
+  }
+
+  allocation::report(state, scope.stats());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(find_missing_sequence_element_benchmark, int)->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(find_missing_sequence_element_benchmark, std::int64_t)->Range(64, 1 << 20);
@@ -1,12 +1,20 @@
-#include "bit.hpp"
+#include "bit/bit.hpp"
+#include "bit/kernels.hpp"
+#include "bit/transpose.hpp"
+#include "../allocation.hpp"
+#include "../generator.hpp"
+#include "../profiling.hpp"
 
 #include "gmock/gmock.h"
 using namespace ::testing;
 
+#include <benchmark/benchmark.h>
+
 #include <array>
 #include <cstddef>
 #include <cstdint>
 #include <stdexcept>
+#include <string>
 
 template <std::size_t num_cells>
 void draw_horizontal_line(std::array<std::uint8_t, num_cells>& screen,
@@ -49,6 +57,41 @@ void draw_horizontal_line(std::array<std::uint8_t, num_cells>& screen,
   }
 }
 
+namespace
+{
+  // The eight pixels of a screen byte, most significant bit first, as
+  // UTF-8: a full block for a set bit, a light shade for a clear one.
+  struct glyphs
+  {
+    static constexpr std::size_t pixel_size = 3;
+    static constexpr std::size_t size       = 8 * pixel_size;
+
+    char bytes[size];
+  };
+
+  struct glyphs_of
+  {
+    constexpr glyphs operator()(const std::size_t cell) const noexcept
+    {
+      glyphs g{};
+
+      // U+2588 FULL BLOCK is E2 96 88, U+2591 LIGHT SHADE is E2 96 91.
+      for (std::size_t i = 0; i != 8; ++i)
+      {
+        const bool set = cell & (0x80 >> i);
+
+        g.bytes[i * glyphs::pixel_size]     = '\xe2';
+        g.bytes[i * glyphs::pixel_size + 1] = '\x96';
+        g.bytes[i * glyphs::pixel_size + 2] = set ? '\x88' : '\x91';
+      }
+
+      return g;
+    }
+  };
+
+  constexpr bit::lookup_table<glyphs, 256> cell_glyphs = bit::make_table<glyphs, 256>(glyphs_of{});
+}
+
 template <std::size_t num_cells>
 std::string output_screen(
   const std::array<std::uint8_t, num_cells>& screen, const int width)
@@ -58,16 +101,15 @@ std::string output_screen(
   const auto num_x_cells = width / 8;
   const auto num_y_cells = num_cells / num_x_cells;
 
+  // Every pixel is a three-byte UTF-8 block and every row ends in a
+  // newline; reserving it all up front saves a reallocation per doubling.
+  output.reserve(num_y_cells * (num_x_cells * 8 * 3 + 1));
+
   for (auto y = 0; y != num_y_cells; ++y)
   {
     for (auto x = 0; x != num_x_cells; ++x)
     {
-      const std::uint8_t cell = screen[y * num_x_cells + x];
-
-      for (const auto& bit : bit::make_reverse_range(cell))
-      {
-        output += (bit ? u8"\u2588" : u8"\u2591");
-      }
+      output.append(cell_glyphs[screen[y * num_x_cells + x]].bytes, glyphs::size);
     }
 
     if (y != num_y_cells)
@@ -79,6 +121,182 @@ std::string output_screen(
   return output;
 }
 
+namespace
+{
+  // Number of rows of a screen of num_cells bytes, width pixels wide.
+  template <std::size_t num_cells>
+  int screen_height(const int width)
+  {
+    if ((width <= 0) || (width % 8 != 0))
+    {
+      throw std::invalid_argument("width must be positive and divisible by 8");
+    }
+    else if (num_cells % (width / 8) != 0)
+    {
+      throw std::invalid_argument("screen must hold a whole number of rows");
+    }
+
+    return static_cast<int>(num_cells / (width / 8));
+  }
+
+  // Turns the screen a quarter turn a tile at a time: 64x64 pixel tiles
+  // through the bit::kernels transpose when both sides are multiples of
+  // 64, 8x8 tiles through bit::transpose8 otherwise. A tile row is read
+  // as one big-endian word, so its leftmost pixel is the top bit.
+  // Reading the rows of a tile bottom up (counterclockwise) or writing
+  // them out bottom up (clockwise) turns the transpose into the
+  // rotation, so no pass reverses bits.
+  template <int tile, std::size_t num_cells>
+  void turn_tiles(const std::array<std::uint8_t, num_cells>& screen, const int width, const int height,
+                  const bool clockwise, std::array<std::uint8_t, num_cells>& turned)
+  {
+    constexpr int tile_bytes = tile / 8;
+
+    const int num_x_cells    = width / 8;
+    const int turned_x_cells = height / 8;
+    const int tiles_x        = width / tile;
+    const int tiles_y        = height / tile;
+
+    std::uint64_t rows[64];
+
+    for (int ty = 0; ty != tiles_y; ++ty)
+    {
+      for (int tx = 0; tx != tiles_x; ++tx)
+      {
+        for (int y = 0; y != tile; ++y)
+        {
+          const std::uint8_t* cells = &screen[(ty * tile + y) * num_x_cells + tx * tile_bytes];
+          std::uint64_t row = 0;
+
+          for (int b = 0; b != tile_bytes; ++b)
+          {
+            row = (row << 8) | cells[b];
+          }
+
+          rows[clockwise ? y : tile - 1 - y] = row;
+        }
+
+        if (tile == 64)
+        {
+          bit::kernels::transpose64(rows, 1);
+        }
+        else
+        {
+          std::uint64_t packed = 0;
+
+          for (int y = 0; y != 8; ++y)
+          {
+            packed |= rows[y] << (8 * y);
+          }
+
+          packed = bit::transpose8(packed);
+
+          for (int y = 0; y != 8; ++y)
+          {
+            rows[y] = static_cast<std::uint8_t>(packed >> (8 * y));
+          }
+        }
+
+        const int turned_tx = clockwise ? tiles_y - 1 - ty : ty;
+        const int turned_ty = clockwise ? tx : tiles_x - 1 - tx;
+
+        for (int y = 0; y != tile; ++y)
+        {
+          const std::uint64_t row = rows[clockwise ? tile - 1 - y : y];
+          std::uint8_t* cells = &turned[(turned_ty * tile + y) * turned_x_cells + turned_tx * tile_bytes];
+
+          for (int b = 0; b != tile_bytes; ++b)
+          {
+            cells[b] = static_cast<std::uint8_t>(row >> (8 * (tile_bytes - 1 - b)));
+          }
+        }
+      }
+    }
+  }
+
+  template <std::size_t num_cells>
+  std::array<std::uint8_t, num_cells> turn_screen(const std::array<std::uint8_t, num_cells>& screen,
+                                                  const int width, const bool clockwise)
+  {
+    const int height = screen_height<num_cells>(width);
+
+    if (height % 8 != 0)
+    {
+      throw std::invalid_argument("height must be divisible by 8");
+    }
+
+    std::array<std::uint8_t, num_cells> turned;
+
+    if (width % 64 == 0 && height % 64 == 0)
+    {
+      turn_tiles<64>(screen, width, height, clockwise, turned);
+    }
+    else
+    {
+      turn_tiles<8>(screen, width, height, clockwise, turned);
+    }
+
+    return turned;
+  }
+}
+
+// The screen turned a quarter turn clockwise. The result is as wide as
+// the screen was high, which must be a multiple of 8 too.
+template <std::size_t num_cells>
+std::array<std::uint8_t, num_cells> rotate_screen_90(const std::array<std::uint8_t, num_cells>& screen,
+                                                     const int width)
+{
+  return turn_screen(screen, width, true);
+}
+
+// The screen upside down: the cells in reverse order, each with its
+// pixels reversed.
+template <std::size_t num_cells>
+std::array<std::uint8_t, num_cells> rotate_screen_180(const std::array<std::uint8_t, num_cells>& screen,
+                                                      const int width)
+{
+  screen_height<num_cells>(width);
+
+  std::array<std::uint8_t, num_cells> turned;
+
+  for (std::size_t i = 0; i != num_cells; ++i)
+  {
+    turned[num_cells - 1 - i] = bit::reverse(screen[i]);
+  }
+
+  return turned;
+}
+
+// The screen turned a quarter turn counterclockwise; as wide as it was
+// high.
+template <std::size_t num_cells>
+std::array<std::uint8_t, num_cells> rotate_screen_270(const std::array<std::uint8_t, num_cells>& screen,
+                                                      const int width)
+{
+  return turn_screen(screen, width, false);
+}
+
+// The screen mirrored left to right.
+template <std::size_t num_cells>
+std::array<std::uint8_t, num_cells> mirror_screen(const std::array<std::uint8_t, num_cells>& screen,
+                                                  const int width)
+{
+  const int num_x_cells = width / 8;
+  const int num_y_cells = screen_height<num_cells>(width);
+
+  std::array<std::uint8_t, num_cells> mirrored;
+
+  for (int y = 0; y != num_y_cells; ++y)
+  {
+    for (int x = 0; x != num_x_cells; ++x)
+    {
+      mirrored[y * num_x_cells + x] = bit::reverse(screen[y * num_x_cells + num_x_cells - 1 - x]);
+    }
+  }
+
+  return mirrored;
+}
+
 TEST(draw_horizontal_line, verify)
 {
   const std::array<std::uint8_t, 4> expected =
@@ -99,3 +317,207 @@ TEST(draw_horizontal_line, verify)
 
   ASSERT_EQ(expected, screen);
 }
+
+TEST(output_screen, renders_most_significant_bit_first)
+{
+  const std::array<std::uint8_t, 2> screen = {0b10000001, 0b01100000};
+
+  ASSERT_EQ(u8"\u2588\u2591\u2591\u2591\u2591\u2591\u2591\u2588"
+            u8"\u2591\u2588\u2588\u2591\u2591\u2591\u2591\u2591\n",
+            output_screen(screen, 16));
+}
+
+namespace
+{
+  bool pixel(const std::uint8_t* screen, const int width, const int x, const int y)
+  {
+    return screen[y * (width / 8) + x / 8] & (0x80 >> (x % 8));
+  }
+
+  // A pixel at a time, the way the screen used to be turned.
+  template <std::size_t num_cells>
+  std::array<std::uint8_t, num_cells> rotate_screen_90_per_pixel(const std::array<std::uint8_t, num_cells>& screen,
+                                                                 const int width)
+  {
+    const int height = static_cast<int>(num_cells * 8 / width);
+    std::array<std::uint8_t, num_cells> turned{};
+
+    for (int y = 0; y != width; ++y)
+    {
+      for (int x = 0; x != height; ++x)
+      {
+        if (pixel(screen.data(), width, y, height - 1 - x))
+        {
+          turned[y * (height / 8) + x / 8] |= 0x80 >> (x % 8);
+        }
+      }
+    }
+
+    return turned;
+  }
+
+  template <int width, int height>
+  std::array<std::uint8_t, width * height / 8> random_screen(const std::uint64_t seed)
+  {
+    std::array<std::uint8_t, width * height / 8> screen;
+    generator::fill_uniform(screen.begin(), screen.end(), seed, std::uint8_t{0}, std::uint8_t{0xff});
+    return screen;
+  }
+
+  template <int width, int height>
+  void expect_rotations_match_pixels(const std::uint64_t seed)
+  {
+    SCOPED_TRACE(std::to_string(width) + "x" + std::to_string(height));
+
+    const auto screen = random_screen<width, height>(seed);
+
+    const auto turned_90  = rotate_screen_90(screen, width);
+    const auto turned_180 = rotate_screen_180(screen, width);
+    const auto turned_270 = rotate_screen_270(screen, width);
+    const auto mirrored   = mirror_screen(screen, width);
+
+    EXPECT_EQ(rotate_screen_90_per_pixel(screen, width), turned_90);
+
+    for (int y = 0; y != height; ++y)
+    {
+      for (int x = 0; x != width; ++x)
+      {
+        const bool set = pixel(screen.data(), width, x, y);
+
+        ASSERT_EQ(set, pixel(turned_90.data(), height, height - 1 - y, x)) << x << ',' << y;
+        ASSERT_EQ(set, pixel(turned_180.data(), width, width - 1 - x, height - 1 - y)) << x << ',' << y;
+        ASSERT_EQ(set, pixel(turned_270.data(), height, y, width - 1 - x)) << x << ',' << y;
+        ASSERT_EQ(set, pixel(mirrored.data(), width, width - 1 - x, y)) << x << ',' << y;
+      }
+    }
+
+    EXPECT_EQ(screen, rotate_screen_270(turned_90, height));
+    EXPECT_EQ(screen, rotate_screen_90(rotate_screen_90(turned_180, width), height));
+    EXPECT_EQ(screen, mirror_screen(mirrored, width));
+  }
+}
+
+TEST(rotate_screen, matches_per_pixel_rotation)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  // 8x8 tiles, square and not; 64x64 tiles, square and not.
+  expect_rotations_match_pixels<8, 8>(seed);
+  expect_rotations_match_pixels<16, 8>(generator::derive_seed(seed, 1));
+  expect_rotations_match_pixels<24, 40>(generator::derive_seed(seed, 2));
+  expect_rotations_match_pixels<64, 64>(generator::derive_seed(seed, 3));
+  expect_rotations_match_pixels<192, 128>(generator::derive_seed(seed, 4));
+  expect_rotations_match_pixels<64, 72>(generator::derive_seed(seed, 5));
+}
+
+TEST(rotate_screen, rejects_partial_tiles)
+{
+  const std::array<std::uint8_t, 6> screen{};
+
+  EXPECT_THROW(rotate_screen_90(screen, 16), std::invalid_argument);
+  EXPECT_THROW(rotate_screen_270(screen, 12), std::invalid_argument);
+  EXPECT_THROW(mirror_screen(screen, 32), std::invalid_argument);
+  EXPECT_NO_THROW(rotate_screen_180(screen, 16));
+}
+
+TEST(output_screen, allocates_once)
+{
+  SKIP_WITHOUT_ALLOCATION_HOOKS();
+
+  const std::array<std::uint8_t, 4> screen = {0b11011111, 0b11111011, 0b01101100, 0b00110110};
+  std::string output;
+
+  const auto stats = allocation::measure([&] { output = output_screen(screen, 16); });
+
+  EXPECT_THAT(stats.allocations, Eq(1U));
+  EXPECT_THAT(output.size(), Eq(2 * (16 * 3 + 1U)));
+  EXPECT_THAT(output.capacity(), Eq(output.size()));
+}
+
+TEST(draw_horizontal_line, does_not_allocate)
+{
+  std::array<std::uint8_t, 32> screen{};
+  EXPECT_NO_ALLOCATIONS(draw_horizontal_line(screen, 64, 3, 60, 2));
+}
+
+// Draws a line of range(0) pixels on every row of a width x height
+// screen, starting at a different offset on each row.
+template <int width, int height>
+void draw_horizontal_line_benchmark(benchmark::State& state)
+{
+  std::array<std::uint8_t, width * height / 8> screen{};
+  const int length = state.range(0);
+
+  profiling::Counters counters;
+
+  {
+    const profiling::Scope scope{counters};
+
+    for (auto _ : state)
+    {
+      for (int y = 0; y != height; ++y)
+      {
+        const int x1 = (y * 7) % (width - length + 1);
+        draw_horizontal_line(screen, width, x1, x1 + length - 1, y);
+      }
+
+      benchmark::ClobberMemory();
+    }
+  }
+
+  profiling::report(state, counters.read());
+  state.SetItemsProcessed(state.iterations() * height * length);
+}
+
+BENCHMARK_TEMPLATE(draw_horizontal_line_benchmark, 64, 64)->Range(1, 64);
+BENCHMARK_TEMPLATE(draw_horizontal_line_benchmark, 1024, 768)->Range(1, 1024);
+
+template <int width, int height>
+void output_screen_benchmark(benchmark::State& state)
+{
+  std::array<std::uint8_t, width * height / 8> screen{};
+  const allocation::Scope scope;
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(output_screen(screen, width));
+  }
+
+  allocation::report(state, scope.stats());
+  state.SetBytesProcessed(state.iterations() * screen.size());
+}
+
+BENCHMARK_TEMPLATE(output_screen_benchmark, 16, 2);
+BENCHMARK_TEMPLATE(output_screen_benchmark, 64, 64);
+BENCHMARK_TEMPLATE(output_screen_benchmark, 1024, 768);
+
+template <int width, int height>
+void rotate_screen_90_benchmark(benchmark::State& state)
+{
+  const auto screen = random_screen<width, height>(1);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(rotate_screen_90(screen, width));
+  }
+
+  state.SetBytesProcessed(state.iterations() * screen.size());
+}
+
+template <int width, int height>
+void rotate_screen_90_per_pixel_benchmark(benchmark::State& state)
+{
+  const auto screen = random_screen<width, height>(1);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(rotate_screen_90_per_pixel(screen, width));
+  }
+
+  state.SetBytesProcessed(state.iterations() * screen.size());
+}
+
+BENCHMARK_TEMPLATE(rotate_screen_90_benchmark, 1024, 768);
+BENCHMARK_TEMPLATE(rotate_screen_90_benchmark, 1024, 776);
+BENCHMARK_TEMPLATE(rotate_screen_90_per_pixel_benchmark, 1024, 768);
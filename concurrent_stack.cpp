@@ -0,0 +1,203 @@
+#include "concurrent_stack.hpp"
+#include "stack.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+
+namespace
+{
+	struct Tracked
+	{
+		static std::atomic<int> live;
+
+		Tracked(int value = 0) : value(value) { ++live; }
+		Tracked(const Tracked& other) : value(other.value) { ++live; }
+		Tracked& operator=(const Tracked&) = default;
+		~Tracked() { --live; }
+
+		int value;
+	};
+
+	std::atomic<int> Tracked::live{0};
+}
+
+TEST(ConcurrentStack, lifo)
+{
+	ConcurrentStack<int> stack;
+	int element = -1;
+
+	EXPECT_TRUE(stack.empty());
+	EXPECT_FALSE(stack.try_pop(element));
+
+	for (int i = 0; i != 1000; ++i)
+	{
+		stack.push(i);
+	}
+
+	for (int i = 999; i >= 0; --i)
+	{
+		ASSERT_TRUE(stack.try_pop(element));
+		ASSERT_THAT(element, Eq(i));
+	}
+
+	EXPECT_TRUE(stack.empty());
+}
+
+TEST(ConcurrentStack, move_only)
+{
+	ConcurrentStack<std::unique_ptr<int>> stack;
+	stack.push(std::unique_ptr<int>(new int(1)));
+	stack.emplace(new int(2));
+
+	std::unique_ptr<int> element;
+	ASSERT_TRUE(stack.try_pop(element));
+	EXPECT_THAT(*element, Eq(2));
+}
+
+// Running out of node indices must keep failing rather than wrap around
+// to indices of nodes that are still live.
+TEST(ConcurrentStack, index_exhaustion_is_sticky)
+{
+	std::atomic<std::uint32_t> next{UINT32_MAX - 1};
+
+	EXPECT_THAT(detail::claim_index(next), Eq(UINT32_MAX));
+
+	for (int i = 0; i != 3; ++i)
+	{
+		EXPECT_THROW(detail::claim_index(next), std::length_error);
+	}
+
+	EXPECT_THAT(next.load(), Eq(UINT32_MAX));
+}
+
+TEST(ConcurrentStack, destructor_releases_elements)
+{
+	{
+		ConcurrentStack<Tracked> stack;
+
+		for (int i = 0; i != 100; ++i)
+		{
+			stack.emplace(i);
+		}
+
+		Tracked element;
+		stack.try_pop(element);
+		EXPECT_THAT(Tracked::live.load(), Eq(100));
+	}
+
+	EXPECT_THAT(Tracked::live.load(), Eq(0));
+}
+
+// Every thread pushes its own range of values and pops as many as it
+// pushed, interleaved. Each value must come out exactly once.
+TEST(ConcurrentStack, stress)
+{
+	const int num_threads = 8;
+	const int per_thread  = 50000;
+
+	ConcurrentStack<int>           stack;
+	std::vector<std::atomic<int>>  seen(num_threads * per_thread);
+	std::vector<std::thread>       threads;
+
+	for (int t = 0; t != num_threads; ++t)
+	{
+		threads.emplace_back([&, t]
+		{
+			int popped = 0;
+			int element;
+
+			for (int i = 0; i != per_thread; ++i)
+			{
+				stack.push(t * per_thread + i);
+
+				if (i % 3 != 0 && stack.try_pop(element))
+				{
+					seen[element].fetch_add(1);
+					++popped;
+				}
+			}
+
+			while (popped != per_thread)
+			{
+				if (stack.try_pop(element))
+				{
+					seen[element].fetch_add(1);
+					++popped;
+				}
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_TRUE(stack.empty());
+
+	for (const auto& count : seen)
+	{
+		ASSERT_THAT(count.load(), Eq(1));
+	}
+}
+
+template <typename T>
+class MutexStack
+{
+public:
+	void push(T element)
+	{
+		std::lock_guard<std::mutex> lock{mutex_};
+		stack_.push(std::move(element));
+	}
+
+	bool try_pop(T& element)
+	{
+		std::lock_guard<std::mutex> lock{mutex_};
+
+		if (stack_.empty())
+		{
+			return false;
+		}
+
+		element = std::move(stack_.top());
+		stack_.pop();
+		return true;
+	}
+
+private:
+	std::mutex mutex_;
+	Stack<T>   stack_;
+};
+
+template <typename StackType>
+void ConcurrentStack_push_pop(benchmark::State& state)
+{
+	static StackType stack;
+	int element;
+
+	for (auto _ : state)
+	{
+		stack.push(1);
+		stack.push(2);
+		benchmark::DoNotOptimize(stack.try_pop(element));
+		benchmark::DoNotOptimize(stack.try_pop(element));
+	}
+
+	state.SetItemsProcessed(state.iterations() * 4);
+}
+
+BENCHMARK_TEMPLATE(ConcurrentStack_push_pop, ConcurrentStack<int>)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(ConcurrentStack_push_pop, MutexStack<int>)->ThreadRange(1, 32)->UseRealTime();
@@ -0,0 +1,357 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+struct ConcurrentStackStats
+{
+	std::uint64_t cas_failures; // lost races on the top of the stack
+	std::uint64_t eliminations; // pushes handed directly to a concurrent pop
+};
+
+namespace detail
+{
+	// Claims the next unused node index, 1 to 2^32 - 1, from a counter of
+	// the indices handed out so far. The counter never moves past the last
+	// index, so once they run out every call throws instead of handing out
+	// low indices that are still in use.
+	inline std::uint32_t claim_index(std::atomic<std::uint32_t>& next)
+	{
+		std::uint32_t claimed = next.load(std::memory_order_relaxed);
+
+		do
+		{
+			if (claimed == UINT32_MAX)
+			{
+				throw std::length_error("ConcurrentStack exhausted its 32-bit node indices");
+			}
+		}
+		while (!next.compare_exchange_weak(claimed, claimed + 1, std::memory_order_relaxed));
+
+		return claimed + 1;
+	}
+}
+
+// Lock-free Treiber stack with an elimination-backoff array.
+//
+// Nodes live in an arena of geometrically growing chunks and are named
+// by 32-bit indices. They are recycled through an internal free list but
+// never returned to the system before the stack is destroyed, so a thread
+// that reads a node after another thread popped it reads stale data and
+// not freed memory. Both list heads pair the index with a 32-bit tag that
+// changes on every update, so a CAS with a stale head fails even if the
+// same index has been pushed back in the meantime (ABA).
+//
+// A push or pop that loses the CAS on the head tries an elimination slot
+// before retrying. A push parks its node in a random slot for a short
+// while, and a pop that finds it there takes it. A push and pop that meet
+// this way cancel out without touching the head, so throughput goes up
+// instead of down under heavy contention.
+template <typename T, std::size_t EliminationSlots = 16>
+class ConcurrentStack
+{
+public:
+	ConcurrentStack()
+	{
+		for (auto& chunk : chunks_)
+		{
+			chunk.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	ConcurrentStack(const ConcurrentStack&) = delete;
+	ConcurrentStack& operator=(const ConcurrentStack&) = delete;
+
+	~ConcurrentStack()
+	{
+		for (std::uint32_t index = index_of(head_.load(std::memory_order_relaxed));
+		     index != 0;
+		     index = node(index).next.load(std::memory_order_relaxed))
+		{
+			node(index).data()->~T();
+		}
+
+		for (std::size_t chunk = 0; chunk != num_chunks; ++chunk)
+		{
+			delete[] chunks_[chunk].load(std::memory_order_relaxed);
+		}
+	}
+
+	// Approximate while other threads are operating on the stack.
+	bool empty() const noexcept
+	{
+		return index_of(head_.load(std::memory_order_relaxed)) == 0;
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args)
+	{
+		const std::uint32_t index = allocate();
+
+		try
+		{
+			::new (static_cast<void*>(&node(index).storage)) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			push_index(free_, index);
+			throw;
+		}
+
+		for (std::uint64_t head = head_.load(std::memory_order_relaxed);;)
+		{
+			if (push_index(head_, index, head))
+			{
+				return;
+			}
+
+			cas_failures_.fetch_add(1, std::memory_order_relaxed);
+
+			if (eliminate_push(index))
+			{
+				eliminations_.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			head = head_.load(std::memory_order_relaxed);
+		}
+	}
+
+	void push(const T& element)
+	{
+		emplace(element);
+	}
+
+	void push(T&& element)
+	{
+		emplace(std::move(element));
+	}
+
+	bool try_pop(T& element)
+	{
+		std::uint32_t index;
+
+		for (std::uint64_t head = head_.load(std::memory_order_acquire);;)
+		{
+			if (pop_index(head_, index, head))
+			{
+				break;
+			}
+
+			cas_failures_.fetch_add(1, std::memory_order_relaxed);
+
+			if ((index = eliminate_pop()) != 0)
+			{
+				break;
+			}
+
+			head = head_.load(std::memory_order_acquire);
+		}
+
+		if (index == 0)
+		{
+			return false;
+		}
+
+		T* data = node(index).data();
+		element = std::move(*data);
+		data->~T();
+		push_index(free_, index);
+
+		return true;
+	}
+
+	ConcurrentStackStats stats() const
+	{
+		return {
+			cas_failures_.load(std::memory_order_relaxed),
+			eliminations_.load(std::memory_order_relaxed)
+		};
+	}
+
+private:
+	static constexpr std::size_t   cache_line  = 64;
+	static constexpr std::uint32_t first_chunk = 64;
+	static constexpr std::size_t   num_chunks  = 27;
+	static constexpr int           elimination_spins = 128;
+
+	struct Node
+	{
+		std::atomic<std::uint32_t> next;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+		T* data() noexcept
+		{
+			return reinterpret_cast<T*>(&storage);
+		}
+	};
+
+	struct alignas(cache_line) Slot
+	{
+		std::atomic<std::uint64_t> value{0};
+	};
+
+	static constexpr std::uint32_t index_of(const std::uint64_t word) noexcept
+	{
+		return static_cast<std::uint32_t>(word);
+	}
+
+	static constexpr std::uint64_t tagged(const std::uint32_t index, const std::uint64_t previous) noexcept
+	{
+		return ((previous >> 32) + 1) << 32 | index;
+	}
+
+	// Index 0 is the null index; chunk c holds first_chunk << c nodes.
+	static void locate(const std::uint32_t index, std::size_t& chunk, std::size_t& offset) noexcept
+	{
+		const std::uint32_t position = index - 1;
+		chunk  = 31 - __builtin_clz(position / first_chunk + 1);
+		offset = position - first_chunk * ((std::uint32_t{1} << chunk) - 1);
+	}
+
+	Node& node(const std::uint32_t index) const noexcept
+	{
+		std::size_t chunk, offset;
+		locate(index, chunk, offset);
+		return chunks_[chunk].load(std::memory_order_acquire)[offset];
+	}
+
+	std::uint32_t allocate()
+	{
+		std::uint32_t index;
+
+		for (std::uint64_t head = free_.load(std::memory_order_acquire);;)
+		{
+			if (pop_index(free_, index, head))
+			{
+				break;
+			}
+		}
+
+		if (index != 0)
+		{
+			return index;
+		}
+
+		index = detail::claim_index(next_index_);
+
+		std::size_t chunk, offset;
+		locate(index, chunk, offset);
+
+		if (chunks_[chunk].load(std::memory_order_acquire) == nullptr)
+		{
+			std::unique_ptr<Node[]> fresh{new Node[std::size_t{first_chunk} << chunk]()};
+			Node* expected = nullptr;
+
+			if (chunks_[chunk].compare_exchange_strong(expected, fresh.get(), std::memory_order_acq_rel))
+			{
+				fresh.release();
+			}
+		}
+
+		return index;
+	}
+
+	bool push_index(std::atomic<std::uint64_t>& list, const std::uint32_t index, std::uint64_t& head) noexcept
+	{
+		node(index).next.store(index_of(head), std::memory_order_relaxed);
+		return list.compare_exchange_weak(head, tagged(index, head),
+		                                  std::memory_order_release, std::memory_order_relaxed);
+	}
+
+	void push_index(std::atomic<std::uint64_t>& list, const std::uint32_t index) noexcept
+	{
+		std::uint64_t head = list.load(std::memory_order_relaxed);
+
+		while (!push_index(list, index, head))
+		{
+		}
+	}
+
+	// Returns true when the attempt is final, with index 0 for an empty list.
+	bool pop_index(std::atomic<std::uint64_t>& list, std::uint32_t& index, std::uint64_t& head) noexcept
+	{
+		index = index_of(head);
+
+		if (index == 0)
+		{
+			return true;
+		}
+
+		const std::uint32_t next = node(index).next.load(std::memory_order_relaxed);
+		return list.compare_exchange_weak(head, tagged(next, head),
+		                                  std::memory_order_acquire, std::memory_order_acquire);
+	}
+
+	bool eliminate_push(const std::uint32_t index) noexcept
+	{
+		std::atomic<std::uint64_t>& slot = random_slot();
+		std::uint64_t value = slot.load(std::memory_order_relaxed);
+
+		if (index_of(value) != 0)
+		{
+			return false;
+		}
+
+		const std::uint64_t offer = tagged(index, value);
+
+		if (!slot.compare_exchange_strong(value, offer, std::memory_order_release, std::memory_order_relaxed))
+		{
+			return false;
+		}
+
+		for (int i = 0; i != elimination_spins; ++i)
+		{
+			if (slot.load(std::memory_order_relaxed) != offer)
+			{
+				return true;
+			}
+		}
+
+		// Withdrawing the offer fails only if a pop took it meanwhile.
+		value = offer;
+		return !slot.compare_exchange_strong(value, tagged(0, offer), std::memory_order_relaxed);
+	}
+
+	std::uint32_t eliminate_pop() noexcept
+	{
+		std::atomic<std::uint64_t>& slot = random_slot();
+		std::uint64_t value = slot.load(std::memory_order_acquire);
+
+		if (index_of(value) != 0 &&
+		    slot.compare_exchange_strong(value, tagged(0, value), std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			return index_of(value);
+		}
+
+		return 0;
+	}
+
+	std::atomic<std::uint64_t>& random_slot() noexcept
+	{
+		thread_local std::uint32_t state = static_cast<std::uint32_t>(
+			std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1;
+
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		return slots_[state % EliminationSlots].value;
+	}
+
+	alignas(cache_line) std::atomic<std::uint64_t> head_{0};
+	alignas(cache_line) std::atomic<std::uint64_t> free_{0};
+	alignas(cache_line) std::atomic<std::uint32_t> next_index_{0};
+	mutable std::atomic<Node*>                     chunks_[num_chunks];
+	alignas(cache_line) std::atomic<std::uint64_t> cas_failures_{0};
+	std::atomic<std::uint64_t>                     eliminations_{0};
+	Slot                                           slots_[EliminationSlots];
+};
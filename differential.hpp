@@ -0,0 +1,191 @@
+#pragma once
+
+#include "generator.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+// Differential testing: run a fast implementation and a reference one on
+// the same inputs, edge cases first and then random ones, and require
+// the same result or the same exception from both. The random inputs
+// come from generator.hpp, so a failure is replayed by rerunning with the
+// GENERATOR_SEED it reports, and nothing needs a corpus or a network.
+//
+// DIFFERENTIAL_ITERATIONS sets how many random inputs every check draws
+// (default 10000); raise it for a long fuzzing run, e.g.
+//
+//     DIFFERENTIAL_ITERATIONS=10000000 runTests --gtest_filter='*differential*'
+//
+// Each check also prints the throughput of both sides, so a fast path
+// that stops being fast shows up next to one that stops being right.
+namespace differential
+{
+	inline std::size_t iterations()
+	{
+		static const std::size_t iterations = []
+		{
+			const char* value = std::getenv("DIFFERENTIAL_ITERATIONS");
+			return value ? static_cast<std::size_t>(std::strtoull(value, nullptr, 0)) : std::size_t{10000};
+		}();
+
+		return iterations;
+	}
+
+	// Values where integer code usually breaks: zero and one, the extremes
+	// of T and their neighbours, -1, every single bit, every run of low
+	// ones and the alternating patterns.
+	template <typename T>
+	std::vector<T> edge_values()
+	{
+		static_assert(std::is_integral<T>::value, "edge_values needs an integral type");
+
+		using U = std::make_unsigned_t<T>;
+		const unsigned int bits = std::numeric_limits<U>::digits;
+
+		std::vector<T> values =
+		{
+			T(0), T(1), T(2),
+			std::numeric_limits<T>::min(), T(std::numeric_limits<T>::min() + 1),
+			std::numeric_limits<T>::max(), T(std::numeric_limits<T>::max() - 1),
+			static_cast<T>(static_cast<U>(~U{0})),
+			static_cast<T>(static_cast<U>(~U{0}) / 3),
+			static_cast<T>(static_cast<U>(static_cast<U>(~U{0}) / 3) << 1)
+		};
+
+		for (unsigned int i = 0; i != bits; ++i)
+		{
+			values.push_back(static_cast<T>(static_cast<U>(U{1} << i)));
+			values.push_back(static_cast<T>(static_cast<U>(static_cast<U>(~U{0}) >> i)));
+		}
+
+		return values;
+	}
+
+	// edge_values() followed by iterations() values drawn uniformly from
+	// [low, high].
+	template <typename T>
+	std::vector<T> values(const std::uint64_t seed,
+	                      const T low = std::numeric_limits<T>::min(),
+	                      const T high = std::numeric_limits<T>::max())
+	{
+		std::vector<T> values = edge_values<T>();
+		const std::size_t edges = values.size();
+
+		values.resize(edges + iterations());
+		generator::fill_uniform(values.begin() + edges, values.end(), seed, low, high);
+		return values;
+	}
+
+	// What a call did: returned a value or threw.
+	template <typename Result>
+	struct outcome
+	{
+		Result      value{};
+		bool        threw = false;
+		std::string exception; // the dynamic type of what was thrown
+
+		bool operator==(const outcome& other) const
+		{
+			return threw ? other.threw && exception == other.exception
+			             : !other.threw && value == other.value;
+		}
+
+		bool operator!=(const outcome& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	template <typename Result>
+	std::ostream& operator<<(std::ostream& os, const outcome<Result>& outcome)
+	{
+		if (outcome.threw)
+		{
+			return os << "threw " << outcome.exception;
+		}
+
+		return os << ::testing::PrintToString(outcome.value);
+	}
+
+	template <typename Function, typename Input>
+	auto run(Function& function, const Input& input) -> outcome<std::decay_t<decltype(function(input))>>
+	{
+		outcome<std::decay_t<decltype(function(input))>> result;
+
+		try
+		{
+			result.value = function(input);
+		}
+		catch (const std::exception& e)
+		{
+			result.threw     = true;
+			result.exception = typeid(e).name();
+		}
+
+		return result;
+	}
+
+	// Runs fast and then reference over every input and compares the
+	// outcomes, printing the rate of each side. The failure names the
+	// first input they disagree on.
+	template <typename Fast, typename Reference, typename Input>
+	::testing::AssertionResult agree(const std::string& name, Fast fast, Reference reference,
+	                                 const std::vector<Input>& inputs)
+	{
+		using clock = std::chrono::steady_clock;
+
+		const auto time = [&](auto& function)
+		{
+			std::vector<decltype(run(function, inputs.front()))> outcomes;
+			outcomes.reserve(inputs.size());
+
+			const auto start = clock::now();
+
+			for (const Input& input : inputs)
+			{
+				outcomes.push_back(run(function, input));
+			}
+
+			const std::chrono::duration<double> elapsed = clock::now() - start;
+			return std::make_pair(std::move(outcomes), inputs.size() / std::max(elapsed.count(), 1e-9));
+		};
+
+		if (inputs.empty())
+		{
+			return ::testing::AssertionSuccess();
+		}
+
+		const auto fast_run      = time(fast);
+		const auto reference_run = time(reference);
+
+		std::cout << "[ DIFF     ] " << name << ": " << inputs.size() << " inputs, fast "
+		          << static_cast<std::uint64_t>(fast_run.second) << "/s, reference "
+		          << static_cast<std::uint64_t>(reference_run.second) << "/s" << std::endl;
+
+		for (std::size_t i = 0; i != inputs.size(); ++i)
+		{
+			if (fast_run.first[i] != reference_run.first[i])
+			{
+				return ::testing::AssertionFailure()
+					<< name << " disagrees with its reference on input #" << i << ' '
+					<< ::testing::PrintToString(inputs[i]) << ": fast " << fast_run.first[i]
+					<< ", reference " << reference_run.first[i];
+			}
+		}
+
+		return ::testing::AssertionSuccess();
+	}
+}
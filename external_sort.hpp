@@ -0,0 +1,583 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+inline std::string default_temp_directory()
+{
+	const char* directory = std::getenv("TMPDIR");
+	return directory && *directory ? directory : "/tmp";
+}
+
+// Run files a sort may hold open at once: half the descriptor limit,
+// leaving the other half to the rest of the process.
+inline std::size_t open_run_limit() noexcept
+{
+	rlimit limit{};
+
+	if (::getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY)
+	{
+		return std::size_t{1} << 16;
+	}
+
+	return std::max<std::size_t>(2, static_cast<std::size_t>(limit.rlim_cur / 2));
+}
+
+inline void write_all(const int fd, const void* data, std::size_t bytes, const char* what)
+{
+	const char* p = static_cast<const char*>(data);
+
+	while (bytes)
+	{
+		const ssize_t written = ::write(fd, p, bytes);
+
+		if (written < 0)
+		{
+			if (errno == EINTR) continue;
+			throw std::system_error(errno, std::generic_category(), what);
+		}
+
+		p     += written;
+		bytes -= written;
+	}
+}
+
+struct ExternalSortOptions
+{
+	// Bytes of elements the sort may hold in memory at once, counting the
+	// run being built as well as the read and write buffers of a merge.
+	std::size_t memory_budget = std::size_t{64} << 20;
+
+	// Largest single read from a run during a merge.
+	std::size_t read_block = std::size_t{1} << 20;
+
+	// Smallest read per run a merge accepts, up to a sixteenth of the
+	// budget. Smaller reads turn the merge into seeks, so more runs than
+	// the budget can give this much each are merged in several passes.
+	std::size_t min_read_block = std::size_t{1} << 20;
+
+	// Where run files are created. They are unlinked as soon as they are
+	// opened, so nothing is left behind if the process dies.
+	std::string directory = default_temp_directory();
+
+	// Map runs into memory instead of reading them into buffers.
+	bool use_mmap = false;
+};
+
+struct ExternalSortStats
+{
+	std::size_t   runs          = 0; // sorted runs spilled to disk
+	std::size_t   passes        = 0; // merges over the spilled data
+	std::uint64_t bytes_spilled = 0; // bytes written to run files
+	std::size_t   peak_memory   = 0; // most bytes of element buffers held at once
+};
+
+// Unlinked temporary file holding one run of elements as raw bytes.
+class RunFile
+{
+public:
+	explicit RunFile(const std::string& directory)
+	{
+		std::string path = directory + "/sort-run-XXXXXX";
+		fd_ = ::mkstemp(&path[0]);
+
+		if (fd_ < 0)
+		{
+			throw std::system_error(errno, std::generic_category(),
+			                        "cannot create run file in " + directory);
+		}
+
+		::unlink(path.c_str());
+	}
+
+	RunFile(RunFile&& other) noexcept
+		: fd_(other.fd_), size_(other.size_)
+	{
+		other.fd_ = -1;
+	}
+
+	RunFile& operator=(RunFile&& other) noexcept
+	{
+		std::swap(fd_, other.fd_);
+		std::swap(size_, other.size_);
+		return *this;
+	}
+
+	~RunFile()
+	{
+		if (fd_ >= 0)
+		{
+			::close(fd_);
+		}
+	}
+
+	int fd() const noexcept
+	{
+		return fd_;
+	}
+
+	std::uint64_t size() const noexcept
+	{
+		return size_;
+	}
+
+	void append(const void* data, const std::size_t bytes)
+	{
+		write_all(fd_, data, bytes, "cannot write run file");
+		size_ += bytes;
+	}
+
+	void read(void* data, std::size_t bytes, std::uint64_t offset) const
+	{
+		char* p = static_cast<char*>(data);
+
+		while (bytes)
+		{
+			const ssize_t count = ::pread(fd_, p, bytes, offset);
+
+			if (count < 0)
+			{
+				if (errno == EINTR) continue;
+				throw std::system_error(errno, std::generic_category(), "cannot read run file");
+			}
+			else if (count == 0)
+			{
+				throw std::runtime_error("run file is shorter than written");
+			}
+
+			p      += count;
+			bytes  -= count;
+			offset += count;
+		}
+	}
+
+private:
+	int           fd_;
+	std::uint64_t size_ = 0;
+};
+
+// File the sorted elements are written to, created or truncated.
+class OutputFile
+{
+public:
+	explicit OutputFile(const std::string& path)
+		: fd_(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))
+	{
+		if (fd_ < 0)
+		{
+			throw std::system_error(errno, std::generic_category(), "cannot create " + path);
+		}
+	}
+
+	OutputFile(const OutputFile&) = delete;
+	OutputFile& operator=(const OutputFile&) = delete;
+
+	~OutputFile()
+	{
+		::close(fd_);
+	}
+
+	void append(const void* data, const std::size_t bytes)
+	{
+		write_all(fd_, data, bytes, "cannot write sorted file");
+	}
+
+private:
+	int fd_;
+};
+
+// Reads the elements of a run front to back or back to front, one block
+// of sequential I/O at a time, or straight from a read-only mapping.
+template <typename T>
+class RunReader
+{
+public:
+	RunReader(const RunFile& file, const std::size_t block, const bool backward, const bool use_mmap)
+		: file_(file),
+		  block_(std::max<std::size_t>(1, block)),
+		  remaining_(file.size() / sizeof(T)),
+		  backward_(backward)
+	{
+		if (use_mmap && remaining_ != 0)
+		{
+			mapping_size_ = file.size();
+			mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, file.fd(), 0);
+
+			if (mapping_ == MAP_FAILED)
+			{
+				mapping_ = nullptr;
+				throw std::system_error(errno, std::generic_category(), "cannot map run file");
+			}
+
+			::madvise(mapping_, mapping_size_, backward ? MADV_NORMAL : MADV_SEQUENTIAL);
+			window(static_cast<const T*>(mapping_), remaining_);
+			remaining_ = 0;
+		}
+		else
+		{
+			storage_.resize(std::min(block_, remaining_));
+			refill();
+		}
+	}
+
+	RunReader(const RunReader&) = delete;
+	RunReader& operator=(const RunReader&) = delete;
+
+	~RunReader()
+	{
+		if (mapping_)
+		{
+			::munmap(mapping_, mapping_size_);
+		}
+	}
+
+	bool done() const noexcept
+	{
+		return left_ == 0;
+	}
+
+	const T& front() const noexcept
+	{
+		return *current_;
+	}
+
+	void advance()
+	{
+		if (--left_ != 0)
+		{
+			backward_ ? --current_ : ++current_;
+		}
+		else
+		{
+			refill();
+		}
+	}
+
+private:
+	using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	void window(const T* data, const std::size_t n) noexcept
+	{
+		left_    = n;
+		current_ = backward_ ? data + n - 1 : data;
+	}
+
+	void refill()
+	{
+		const std::size_t n = std::min(block_, remaining_);
+
+		if (n == 0)
+		{
+			return;
+		}
+
+		remaining_ -= n;
+
+		const std::size_t first = backward_ ? remaining_ : loaded_;
+		file_.read(storage_.data(), n * sizeof(T), std::uint64_t{first} * sizeof(T));
+		loaded_ += n;
+
+		window(reinterpret_cast<const T*>(storage_.data()), n);
+	}
+
+	const RunFile&       file_;
+	std::size_t          block_;
+	std::size_t          remaining_;
+	std::size_t          loaded_ = 0;
+	bool                 backward_;
+	std::vector<Storage> storage_;
+	void*                mapping_      = nullptr;
+	std::size_t          mapping_size_ = 0;
+	const T*             current_      = nullptr;
+	std::size_t          left_         = 0;
+};
+
+// Stable sort whose input may not fit in memory. Elements are collected
+// until the memory budget is full, then sorted and written to a run file.
+// finish() merges the runs with a k-way heap merge, in several passes if
+// there are too many runs to give each a reasonable read buffer. Runs
+// are also merged while spilling once as many are open as the descriptor
+// limit allows.
+//
+// Elements are stored as raw bytes, so T must be trivially copyable.
+template <typename T, typename Compare>
+class ExternalSorter
+{
+	static_assert(std::is_trivially_copyable<T>::value,
+	              "ExternalSorter writes elements to disk as raw bytes");
+
+public:
+	explicit ExternalSorter(const ExternalSortOptions& options = ExternalSortOptions{},
+	                        Compare compare = Compare{})
+		: options_(options),
+		  compare_(compare),
+		  capacity_(std::max<std::size_t>(1, options.memory_budget / sizeof(T) / 3 * 2)),
+		  open_runs_(open_run_limit()),
+		  fan_in_(std::min(open_runs_, budget_fan_in(options))) { }
+
+	void push(const T& element)
+	{
+		if (buffer_.size() == capacity_)
+		{
+			spill();
+		}
+
+		if (buffer_.capacity() == 0)
+		{
+			buffer_.reserve(capacity_);
+		}
+
+		buffer_.push_back(element);
+	}
+
+	// Passes every element pushed to sink in sorted order, or in reverse
+	// sorted order, with equal elements in push order (reversed as well).
+	template <typename Sink>
+	void finish(Sink sink, const bool reverse = false)
+	{
+		if (runs_.empty())
+		{
+			sort_buffer();
+
+			if (reverse)
+			{
+				std::for_each(buffer_.rbegin(), buffer_.rend(), sink);
+			}
+			else
+			{
+				std::for_each(buffer_.begin(), buffer_.end(), sink);
+			}
+
+			std::vector<T>{}.swap(buffer_);
+			return;
+		}
+
+		if (!buffer_.empty())
+		{
+			spill();
+		}
+
+		std::vector<T>{}.swap(buffer_);
+
+		while (runs_.size() > fan_in_)
+		{
+			merge_pass();
+		}
+
+		merge(0, runs_.size(), reverse, block_elements(runs_.size()), sink);
+		runs_.clear();
+	}
+
+	// As finish(), writing the elements to the file at path as raw bytes
+	// through one block of the budget.
+	void finish_to_file(const std::string& path, const bool reverse = false)
+	{
+		OutputFile     file{path};
+		std::vector<T> output;
+
+		finish(appender(file, output, block_elements(fan_in_)), reverse);
+		file.append(output.data(), output.size() * sizeof(T));
+	}
+
+	const ExternalSortStats& stats() const noexcept
+	{
+		return stats_;
+	}
+
+private:
+	// Runs one merge can take while each still gets min_read_block bytes,
+	// or a sixteenth of the budget if that is less.
+	static std::size_t budget_fan_in(const ExternalSortOptions& options) noexcept
+	{
+		const std::size_t block  = std::max(sizeof(T), std::min({options.min_read_block, options.read_block,
+		                                                         options.memory_budget / 16}));
+		const std::size_t blocks = options.memory_budget / block;
+
+		return blocks > 2 ? blocks - 1 : 2;
+	}
+
+	void note_memory(const std::size_t bytes) noexcept
+	{
+		stats_.peak_memory = std::max(stats_.peak_memory, bytes);
+	}
+
+	// A sink collecting elements into output and appending each full block
+	// of them to file. The block is only allocated with the first element,
+	// once the merge has freed what it no longer needs.
+	template <typename File>
+	static auto appender(File& file, std::vector<T>& output, const std::size_t block)
+	{
+		return [&file, &output, block](const T& element)
+		{
+			if (output.capacity() == 0)
+			{
+				output.reserve(block);
+			}
+
+			output.push_back(element);
+
+			if (output.size() == block)
+			{
+				file.append(output.data(), output.size() * sizeof(T));
+				output.clear();
+			}
+		};
+	}
+
+	// std::stable_sort borrows a scratch buffer of up to half the elements,
+	// which is why the run buffer only gets two thirds of the budget.
+	void sort_buffer()
+	{
+		std::stable_sort(buffer_.begin(), buffer_.end(), compare_);
+		note_memory((buffer_.capacity() + (buffer_.size() + 1) / 2) * sizeof(T));
+	}
+
+	void spill()
+	{
+		sort_buffer();
+
+		runs_.emplace_back(options_.directory);
+		runs_.back().append(buffer_.data(), buffer_.size() * sizeof(T));
+
+		stats_.bytes_spilled += buffer_.size() * sizeof(T);
+		++stats_.runs;
+		buffer_.clear();
+
+		// The buffer goes back for the merge and is taken again by the next
+		// push, so that the two never share the budget.
+		if (runs_.size() >= open_runs_)
+		{
+			std::vector<T>{}.swap(buffer_);
+			merge_pass();
+		}
+	}
+
+	// Merges the runs fan_in_ at a time, closing each group's runs once
+	// merged, so that at most one merged run is open beyond them.
+	void merge_pass()
+	{
+		std::vector<RunFile> merged;
+
+		for (std::size_t first = 0; first < runs_.size(); first += fan_in_)
+		{
+			const std::size_t last = std::min(first + fan_in_, runs_.size());
+
+			if (last - first == 1)
+			{
+				merged.push_back(std::move(runs_[first]));
+				continue;
+			}
+
+			merged.emplace_back(options_.directory);
+			merge_to_run(first, last, merged.back());
+
+			for (std::size_t i = first; i != last; ++i)
+			{
+				const RunFile closed{std::move(runs_[i])};
+			}
+		}
+
+		runs_ = std::move(merged);
+	}
+
+	// Read buffer per run when k runs (and possibly one writer) share the budget.
+	std::size_t block_elements(const std::size_t k) const noexcept
+	{
+		const std::size_t bytes = std::min(options_.read_block, options_.memory_budget / (k + 1));
+		return std::max<std::size_t>(1, bytes / sizeof(T));
+	}
+
+	void merge_to_run(const std::size_t first, const std::size_t last, RunFile& run)
+	{
+		const std::size_t block = block_elements(last - first);
+		std::vector<T> output;
+
+		merge(first, last, false, block, appender(run, output, block));
+
+		run.append(output.data(), output.size() * sizeof(T));
+		stats_.bytes_spilled += run.size();
+		note_memory((last - first + 1) * block * sizeof(T));
+	}
+
+	template <typename Sink>
+	void merge(const std::size_t first, const std::size_t last, const bool reverse,
+	           const std::size_t block, Sink sink)
+	{
+		std::vector<std::unique_ptr<RunReader<T>>> readers;
+		std::vector<std::size_t>                   heap;
+
+		for (std::size_t i = first; i != last; ++i)
+		{
+			readers.emplace_back(new RunReader<T>(runs_[i], block, reverse, options_.use_mmap));
+
+			if (!readers.back()->done())
+			{
+				heap.push_back(i - first);
+			}
+		}
+
+		if (!options_.use_mmap)
+		{
+			note_memory((last - first) * block * sizeof(T));
+		}
+
+		// True if run a's next element goes out after run b's. Equal
+		// elements go out in push order: lower runs were pushed earlier.
+		const auto after = [&](const std::size_t a, const std::size_t b)
+		{
+			const T& x = readers[a]->front();
+			const T& y = readers[b]->front();
+
+			if (compare_(reverse ? y : x, reverse ? x : y)) return false;
+			if (compare_(reverse ? x : y, reverse ? y : x)) return true;
+
+			return reverse ? a < b : a > b;
+		};
+
+		std::make_heap(heap.begin(), heap.end(), after);
+
+		while (!heap.empty())
+		{
+			std::pop_heap(heap.begin(), heap.end(), after);
+			RunReader<T>& reader = *readers[heap.back()];
+
+			sink(reader.front());
+			reader.advance();
+
+			if (reader.done())
+			{
+				heap.pop_back();
+			}
+			else
+			{
+				std::push_heap(heap.begin(), heap.end(), after);
+			}
+		}
+
+		++stats_.passes;
+	}
+
+	ExternalSortOptions  options_;
+	Compare              compare_;
+	std::size_t          capacity_;
+	std::size_t          open_runs_;
+	std::size_t          fan_in_;
+	std::vector<T>       buffer_;
+	std::vector<RunFile> runs_;
+	ExternalSortStats    stats_;
+};
@@ -0,0 +1,200 @@
+#include "generator.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+
+// Known-answer vectors from the Random123 distribution.
+TEST(philox4x32, known_answers)
+{
+  generator::philox4x32::block output;
+
+  generator::philox4x32::encrypt({0, 0, 0, 0}, {0, 0}, output);
+  EXPECT_THAT(output, ElementsAre(0x6627e8d5U, 0xe169c58dU, 0xbc57ac4cU, 0x9b00dbd8U));
+
+  generator::philox4x32::encrypt({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                                 {0xffffffff, 0xffffffff}, output);
+  EXPECT_THAT(output, ElementsAre(0x408f276dU, 0x41c83b0eU, 0xa20bc7c6U, 0x6d5451fdU));
+
+  generator::philox4x32::encrypt({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                                 {0xa4093822, 0x299f31d0}, output);
+  EXPECT_THAT(output, ElementsAre(0xd16cfe09U, 0x94fdccebU, 0x5001e420U, 0x24126ea1U));
+}
+
+template <typename Engine>
+void test_discard()
+{
+  Engine serial{42};
+  std::vector<typename Engine::result_type> values(100);
+  std::generate(values.begin(), values.end(), std::ref(serial));
+
+  for (std::uint64_t skip = 0; skip != values.size(); ++skip)
+  {
+    Engine engine{42};
+    engine.discard(skip);
+    ASSERT_THAT(engine(), Eq(values[skip]));
+
+    ASSERT_THAT(Engine(42, skip)(), Eq(values[skip]));
+  }
+}
+
+TEST(generator, discard)
+{
+  test_discard<generator::splitmix64>();
+  test_discard<generator::philox4x32>();
+}
+
+TEST(generator, fill_uniform_independent_of_threads)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  std::vector<std::int16_t> reference(100000);
+  generator::fill_uniform(reference.begin(), reference.end(), seed,
+                          std::int16_t{-10}, std::int16_t{10}, 1);
+
+  EXPECT_THAT(*std::min_element(reference.begin(), reference.end()), Eq(-10));
+  EXPECT_THAT(*std::max_element(reference.begin(), reference.end()), Eq(10));
+
+  for (const unsigned int num_threads : {2U, 3U, 16U})
+  {
+    std::vector<std::int16_t> values(reference.size());
+    generator::fill_uniform(values.begin(), values.end(), seed,
+                            std::int16_t{-10}, std::int16_t{10}, num_threads);
+    ASSERT_THAT(values, Eq(reference));
+  }
+}
+
+TEST(generator, uniform_full_range)
+{
+  std::int64_t seen_or = 0;
+
+  for (std::uint64_t i = 0; i != 64; ++i)
+  {
+    seen_or |= generator::uniform_at(1, i, std::numeric_limits<std::int64_t>::min(),
+                                           std::numeric_limits<std::int64_t>::max());
+  }
+
+  EXPECT_THAT(seen_or, Eq(-1));
+}
+
+TEST(permutation, is_bijection)
+{
+  const std::uint64_t seed = generator::default_seed();
+  SCOPED_TRACE("GENERATOR_SEED=" + std::to_string(seed));
+
+  for (const std::uint64_t n : {0, 1, 2, 3, 5, 64, 1000, 65537})
+  {
+    std::vector<std::uint32_t> values(n);
+    generator::fill_permutation(values.begin(), values.end(), n, seed);
+
+    std::vector<std::uint32_t> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+
+    for (std::uint64_t i = 0; i != n; ++i)
+    {
+      ASSERT_THAT(sorted[i], Eq(i));
+    }
+
+    if (n >= 64)
+    {
+      EXPECT_FALSE(std::is_sorted(values.begin(), values.end()));
+    }
+  }
+}
+
+// An empty domain has nothing for the cycle walk to land on.
+TEST(permutation, rejects_an_empty_domain)
+{
+  EXPECT_THROW((generator::permutation{0, 1}), std::invalid_argument);
+
+  const generator::permutation one{1, 1};
+  EXPECT_THAT(one[0], Eq(0u));
+}
+
+TEST(permutation, depends_on_seed)
+{
+  const generator::permutation a{1000, 1};
+  const generator::permutation b{1000, 2};
+
+  int same = 0;
+
+  for (std::uint64_t i = 0; i != 1000; ++i)
+  {
+    same += a[i] == b[i];
+  }
+
+  EXPECT_THAT(same, Lt(20));
+}
+
+void fill_uniform_benchmark(benchmark::State& state)
+{
+  std::vector<std::uint32_t> values(state.range(0));
+
+  for (auto _ : state)
+  {
+    generator::fill_uniform(values.begin(), values.end(), 1, 0U, 1000000U, state.range(1));
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+void fill_default_random_engine(benchmark::State& state)
+{
+  std::vector<std::uint32_t> values(state.range(0));
+  std::default_random_engine engine;
+  std::uniform_int_distribution<std::uint32_t> dist{0, 1000000};
+
+  for (auto _ : state)
+  {
+    std::generate(values.begin(), values.end(), [&] { return dist(engine); });
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+void fill_permutation_benchmark(benchmark::State& state)
+{
+  std::vector<std::uint32_t> values(state.range(0));
+
+  for (auto _ : state)
+  {
+    generator::fill_permutation(values.begin(), values.end(), values.size(), 1, state.range(1));
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+void fill_iota_shuffle(benchmark::State& state)
+{
+  std::vector<std::uint32_t> values(state.range(0));
+  std::default_random_engine engine;
+
+  for (auto _ : state)
+  {
+    std::iota(values.begin(), values.end(), 0);
+    std::shuffle(values.begin(), values.end(), engine);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK(fill_uniform_benchmark)->ArgNames({"n", "threads"})->ArgsProduct({{1 << 16, 1 << 24}, {1, 4, 16}})->UseRealTime();
+BENCHMARK(fill_default_random_engine)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(fill_permutation_benchmark)->ArgNames({"n", "threads"})->ArgsProduct({{1 << 16, 1 << 24}, {1, 4, 16}})->UseRealTime();
+BENCHMARK(fill_iota_shuffle)->Arg(1 << 16)->Arg(1 << 24);
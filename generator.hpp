@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Reproducible test data. Every generator here is counter-based: the
+// i-th value is a pure function of (seed, i), so jumping ahead is free,
+// any number of threads can fill disjoint slices of a buffer and get the
+// same bytes as one thread would, and a failure can be replayed from the
+// seed alone.
+namespace generator
+{
+  // SplitMix64 finalizer: a bijective mix of 64 bits.
+  inline constexpr
+  std::uint64_t mix(std::uint64_t z) noexcept
+  {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // Independent seed for the index-th stream derived from seed.
+  inline constexpr
+  std::uint64_t derive_seed(const std::uint64_t seed, const std::uint64_t index) noexcept
+  {
+    return mix(seed + (index + 1) * 0x9e3779b97f4a7c15ULL);
+  }
+
+  // Seed for tests: the GENERATOR_SEED environment variable when set,
+  // otherwise drawn once per process from std::random_device. Tests log
+  // it so that a failing run can be repeated exactly.
+  inline std::uint64_t default_seed()
+  {
+    static const std::uint64_t seed = []
+    {
+      if (const char* value = std::getenv("GENERATOR_SEED"))
+      {
+        return static_cast<std::uint64_t>(std::strtoull(value, nullptr, 0));
+      }
+
+      std::random_device device;
+      return (std::uint64_t{device()} << 32) | device();
+    }();
+
+    return seed;
+  }
+
+  // SplitMix64 as a counter-based generator: value i is mix(seed + (i + 1) * gamma).
+  class splitmix64
+  {
+  public:
+    using result_type = std::uint64_t;
+
+    explicit constexpr splitmix64(const std::uint64_t seed = 0, const std::uint64_t counter = 0) noexcept
+      : seed_(seed), counter_(counter) {}
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+    static constexpr result_type at(const std::uint64_t seed, const std::uint64_t index) noexcept
+    {
+      return derive_seed(seed, index);
+    }
+
+    result_type operator()() noexcept
+    {
+      return at(seed_, counter_++);
+    }
+
+    void discard(const std::uint64_t n) noexcept
+    {
+      counter_ += n;
+    }
+
+    std::uint64_t counter() const noexcept
+    {
+      return counter_;
+    }
+
+  private:
+    std::uint64_t seed_;
+    std::uint64_t counter_;
+  };
+
+  // Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as
+  // 1, 2, 3", 2011). Each 128-bit counter is encrypted under a 64-bit
+  // key into four 32-bit outputs. Passes BigCrush, unlike SplitMix64
+  // whose outputs are a single mixing step apart.
+  class philox4x32
+  {
+  public:
+    using result_type = std::uint32_t;
+    using block       = std::uint32_t[4];
+
+    explicit philox4x32(const std::uint64_t seed = 0, const std::uint64_t counter = 0) noexcept
+      : key_{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)}
+    {
+      discard(counter);
+    }
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+    static void encrypt(const std::uint32_t (&counter)[4], const std::uint32_t (&key)[2], block& output) noexcept
+    {
+      std::uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+      std::uint32_t k0 = key[0], k1 = key[1];
+
+      for (int round = 0; round != 10; ++round)
+      {
+        const std::uint64_t p0 = std::uint64_t{0xD2511F53} * c0;
+        const std::uint64_t p1 = std::uint64_t{0xCD9E8D57} * c2;
+
+        const std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        const std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+
+        c0 = n0;
+        c1 = static_cast<std::uint32_t>(p1);
+        c2 = n2;
+        c3 = static_cast<std::uint32_t>(p0);
+
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+      }
+
+      output[0] = c0;
+      output[1] = c1;
+      output[2] = c2;
+      output[3] = c3;
+    }
+
+    result_type operator()() noexcept
+    {
+      if (index_ == 4)
+      {
+        refill();
+      }
+
+      return output_[index_++];
+    }
+
+    // Skips n outputs in constant time.
+    void discard(const std::uint64_t n) noexcept
+    {
+      const std::uint64_t position = this->position() + n;
+      block_  = position / 4;
+      refill();
+      index_ = position % 4;
+    }
+
+    // Number of outputs produced so far.
+    std::uint64_t position() const noexcept
+    {
+      return block_ * 4 - 4 + index_;
+    }
+
+  private:
+    void refill() noexcept
+    {
+      const std::uint32_t counter[4] =
+      {
+        static_cast<std::uint32_t>(block_), static_cast<std::uint32_t>(block_ >> 32), 0, 0
+      };
+
+      encrypt(counter, key_, output_);
+      ++block_;
+      index_ = 0;
+    }
+
+    std::uint32_t key_[2];
+    std::uint64_t block_  = 0;
+    block         output_ = {};
+    unsigned int  index_  = 4;
+  };
+
+  // Maps 64 random bits onto [0, range) with one multiplication (Lemire).
+  // The bias is below range / 2^64, far under anything a test can see.
+  inline
+  std::uint64_t bounded(const std::uint64_t bits, const std::uint64_t range) noexcept
+  {
+    return static_cast<std::uint64_t>((static_cast<unsigned __int128>(bits) * range) >> 64);
+  }
+
+  // The index-th value of a uniform stream over [low, high].
+  template <typename T>
+  inline
+  typename std::enable_if<std::is_integral<T>::value, T>::type
+  uniform_at(const std::uint64_t seed, const std::uint64_t index, const T low, const T high) noexcept
+  {
+    using U = typename std::make_unsigned<T>::type;
+
+    const std::uint64_t bits  = splitmix64::at(seed, index);
+    const std::uint64_t range = std::uint64_t{static_cast<U>(static_cast<U>(high) - static_cast<U>(low))} + 1;
+
+    // A range of zero means all 2^64 values.
+    const std::uint64_t value = range == 0 ? bits : bounded(bits, range);
+    return static_cast<T>(static_cast<U>(low) + static_cast<U>(value));
+  }
+
+  // Calls generate(i) for every i in [0, n) on up to num_threads threads,
+  // each taking one contiguous slice.
+  template <typename Function>
+  void parallel_for(const std::size_t n, Function generate,
+                    unsigned int num_threads = std::thread::hardware_concurrency())
+  {
+    const std::size_t min_slice = 1 << 14;
+    num_threads = static_cast<unsigned int>(std::max<std::size_t>(1,
+      std::min<std::size_t>(num_threads, n / min_slice)));
+
+    const auto slice = [&](const std::size_t t)
+    {
+      for (std::size_t i = n * t / num_threads, end = n * (t + 1) / num_threads; i != end; ++i)
+      {
+        generate(i);
+      }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (unsigned int t = 1; t < num_threads; ++t)
+    {
+      threads.emplace_back(slice, t);
+    }
+
+    slice(0);
+
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+  }
+
+  // Fills [first, last) with uniform values in [low, high]. Element i is
+  // uniform_at(seed, i, low, high) whatever the number of threads.
+  template <typename RandomIt, typename T>
+  void fill_uniform(const RandomIt first, const RandomIt last, const std::uint64_t seed,
+                    const T low, const T high,
+                    const unsigned int num_threads = std::thread::hardware_concurrency())
+  {
+    parallel_for(last - first, [&](const std::size_t i)
+    {
+      first[i] = uniform_at(seed, i, low, high);
+    }, num_threads);
+  }
+
+  // Pseudo-random permutation of [0, n) with O(1) random access and no
+  // storage: a balanced four-round Feistel network over the smallest
+  // power-of-four domain covering n, with cycle walking to map results
+  // outside [0, n) back in. Good enough to scramble test data; it does
+  // not reach all n! orderings the way a Fisher-Yates shuffle can.
+  class permutation
+  {
+  public:
+    // n must be positive: there is no value to walk back to in an empty
+    // domain.
+    permutation(const std::uint64_t n, const std::uint64_t seed)
+      : n_(n)
+    {
+      if (n == 0)
+      {
+        throw std::invalid_argument("generator::permutation: n must be positive");
+      }
+
+      while (half_bits_ < 32 && (std::uint64_t{1} << (2 * half_bits_)) < n)
+      {
+        ++half_bits_;
+      }
+
+      mask_ = half_bits_ == 32 ? 0xffffffffULL : (std::uint64_t{1} << half_bits_) - 1;
+
+      for (std::uint64_t round = 0; round != rounds; ++round)
+      {
+        keys_[round] = derive_seed(seed, round);
+      }
+    }
+
+    std::uint64_t size() const noexcept
+    {
+      return n_;
+    }
+
+    std::uint64_t operator[](const std::uint64_t index) const noexcept
+    {
+      std::uint64_t value = index;
+
+      do
+      {
+        value = encrypt(value);
+      } while (value >= n_);
+
+      return value;
+    }
+
+  private:
+    static constexpr std::uint64_t rounds = 4;
+
+    std::uint64_t encrypt(const std::uint64_t value) const noexcept
+    {
+      std::uint64_t left  = value >> half_bits_;
+      std::uint64_t right = value & mask_;
+
+      for (std::uint64_t round = 0; round != rounds; ++round)
+      {
+        const std::uint64_t next = left ^ (mix(right ^ keys_[round]) & mask_);
+        left  = right;
+        right = next;
+      }
+
+      return (left << half_bits_) | right;
+    }
+
+    std::uint64_t n_;
+    unsigned int  half_bits_ = 1;
+    std::uint64_t mask_;
+    std::uint64_t keys_[rounds];
+  };
+
+  // Fills [first, last) with the first last - first values of
+  // permutation(n, seed); with n == last - first, a shuffled iota.
+  template <typename RandomIt>
+  void fill_permutation(const RandomIt first, const RandomIt last, const std::uint64_t n,
+                        const std::uint64_t seed,
+                        const unsigned int num_threads = std::thread::hardware_concurrency())
+  {
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+
+    if (first == last)
+    {
+      return;
+    }
+
+    const permutation order{n, seed};
+
+    parallel_for(last - first, [&](const std::size_t i)
+    {
+      first[i] = static_cast<value_type>(order[i]);
+    }, num_threads);
+  }
+}
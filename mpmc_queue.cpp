@@ -0,0 +1,226 @@
+#include "mpmc_queue.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+
+TEST(MpmcQueue, capacity)
+{
+	EXPECT_THROW(MpmcQueue<int>{0}, std::invalid_argument);
+	EXPECT_THROW(MpmcQueue<int>{1}, std::invalid_argument);
+	EXPECT_THROW(MpmcQueue<int>{12}, std::invalid_argument);
+	EXPECT_THROW(MpmcQueue<int>{SIZE_MAX}, std::invalid_argument);
+	EXPECT_THAT(MpmcQueue<int>{16}.capacity(), Eq(16U));
+}
+
+TEST(MpmcQueue, fifo)
+{
+	MpmcQueue<int> queue{4, Backpressure::Fail};
+
+	for (int i = 0; i != 4; ++i)
+	{
+		ASSERT_TRUE(queue.push(i));
+	}
+
+	EXPECT_FALSE(queue.push(4));
+	EXPECT_THAT(queue.size(), Eq(4U));
+
+	for (int i = 0; i != 4; ++i)
+	{
+		int element = -1;
+		ASSERT_TRUE(queue.pop(element));
+		EXPECT_THAT(element, Eq(i));
+	}
+
+	int element = -1;
+	EXPECT_FALSE(queue.pop(element));
+	EXPECT_TRUE(queue.empty());
+
+	const MpmcQueueStats stats = queue.stats();
+	EXPECT_THAT(stats.full_waits, Eq(1U));
+	EXPECT_THAT(stats.empty_waits, Eq(1U));
+}
+
+TEST(MpmcQueue, move_only)
+{
+	MpmcQueue<std::unique_ptr<int>> queue{2};
+
+	queue.push(std::unique_ptr<int>(new int(7)));
+	queue.try_emplace(new int(8));
+
+	std::unique_ptr<int> element;
+	ASSERT_TRUE(queue.pop(element));
+	EXPECT_THAT(*element, Eq(7));
+
+	// The remaining element is released by the queue destructor.
+}
+
+namespace
+{
+	struct ThrowsOnNegative
+	{
+		ThrowsOnNegative() = default;
+
+		explicit ThrowsOnNegative(const int value)
+			: value(value)
+		{
+			if (value < 0)
+			{
+				throw std::invalid_argument("negative");
+			}
+		}
+
+		int value = 0;
+	};
+}
+
+TEST(MpmcQueue, throwing_constructor_claims_no_cell)
+{
+	MpmcQueue<ThrowsOnNegative> queue{2, Backpressure::Fail};
+
+	EXPECT_THROW(queue.try_emplace(-1), std::invalid_argument);
+	EXPECT_TRUE(queue.empty());
+
+	ASSERT_TRUE(queue.try_emplace(1));
+	ASSERT_TRUE(queue.try_emplace(2));
+
+	ThrowsOnNegative element;
+	ASSERT_TRUE(queue.pop(element));
+	EXPECT_THAT(element.value, Eq(1));
+	ASSERT_TRUE(queue.pop(element));
+	EXPECT_THAT(element.value, Eq(2));
+}
+
+TEST(MpmcQueue, counts_a_wait_once_per_call)
+{
+	MpmcQueue<int> queue{2, Backpressure::Yield};
+	queue.push(0);
+	queue.push(1);
+
+	std::thread producer([&] { queue.push(2); });
+
+	// Once the producer has found the queue full, let it retry many times
+	// before there is room.
+	while (queue.stats().full_waits == 0)
+	{
+		std::this_thread::yield();
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+	int element = -1;
+	ASSERT_TRUE(queue.pop(element));
+	producer.join();
+
+	EXPECT_THAT(queue.stats().full_waits, Eq(1U));
+}
+
+void transfer(const int producers, const int consumers, const int per_producer,
+              MpmcQueue<std::uint64_t>& queue, std::atomic<std::uint64_t>& sum)
+{
+	std::vector<std::thread> threads;
+	const int total = producers * per_producer;
+	std::atomic<int> remaining{total};
+
+	for (int p = 0; p != producers; ++p)
+	{
+		threads.emplace_back([&, p]
+		{
+			for (int i = 0; i != per_producer; ++i)
+			{
+				queue.push(static_cast<std::uint64_t>(p) * per_producer + i);
+			}
+		});
+	}
+
+	for (int c = 0; c != consumers; ++c)
+	{
+		threads.emplace_back([&]
+		{
+			std::uint64_t local = 0;
+			std::uint64_t element;
+
+			while (remaining.load(std::memory_order_relaxed) > 0)
+			{
+				if (queue.try_pop(element))
+				{
+					local += element;
+					remaining.fetch_sub(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			sum.fetch_add(local);
+		});
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+TEST(MpmcQueue, concurrent)
+{
+	const int producers    = 4;
+	const int consumers    = 4;
+	const int per_producer = 20000;
+	const std::uint64_t n  = producers * per_producer;
+
+	MpmcQueue<std::uint64_t>   queue{64};
+	std::atomic<std::uint64_t> sum{0};
+
+	transfer(producers, consumers, per_producer, queue, sum);
+
+	EXPECT_THAT(sum.load(), Eq(n * (n - 1) / 2));
+	EXPECT_TRUE(queue.empty());
+}
+
+void MpmcQueue_transfer(benchmark::State& state)
+{
+	const int producers    = state.range(0);
+	const int consumers    = state.range(1);
+	const int per_producer = 1 << 14;
+
+	MpmcQueueStats totals{};
+
+	for (auto _ : state)
+	{
+		MpmcQueue<std::uint64_t>   queue{1024};
+		std::atomic<std::uint64_t> sum{0};
+
+		transfer(producers, consumers, per_producer, queue, sum);
+		benchmark::DoNotOptimize(sum.load());
+
+		const MpmcQueueStats stats = queue.stats();
+		totals.push_retries += stats.push_retries;
+		totals.pop_retries  += stats.pop_retries;
+		totals.full_waits   += stats.full_waits;
+	}
+
+	state.SetItemsProcessed(state.iterations() * producers * per_producer);
+	state.counters["push_retries"] = benchmark::Counter(totals.push_retries, benchmark::Counter::kAvgIterations);
+	state.counters["pop_retries"]  = benchmark::Counter(totals.pop_retries,  benchmark::Counter::kAvgIterations);
+	state.counters["full_waits"]   = benchmark::Counter(totals.full_waits,   benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(MpmcQueue_transfer)
+	->ArgNames({"producers", "consumers"})
+	->ArgsProduct({{1, 2, 4, 8, 16, 32}, {1, 2, 4, 8, 16, 32}})
+	->UseRealTime()
+	->Unit(benchmark::kMillisecond);
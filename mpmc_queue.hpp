@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// What push() and pop() do when the queue is full or empty.
+//
+// Fail  returns immediately, leaving the caller to decide.
+// Spin  busy-waits, for dedicated cores with tight latency targets.
+// Yield gives the time slice away between attempts.
+// Sleep backs off exponentially up to a millisecond, for oversubscribed hosts.
+enum class Backpressure
+{
+	Fail,
+	Spin,
+	Yield,
+	Sleep
+};
+
+struct MpmcQueueStats
+{
+	std::uint64_t push_retries; // lost CAS races on the enqueue position
+	std::uint64_t pop_retries;  // lost CAS races on the dequeue position
+	std::uint64_t full_waits;   // push calls that found the queue full
+	std::uint64_t empty_waits;  // pop calls that found the queue empty
+};
+
+// Bounded multi-producer/multi-consumer queue after Dmitry Vyukov's
+// array queue. Every cell carries a sequence number telling producers
+// and consumers whose turn it is, so the only shared writes are one CAS
+// on the enqueue or dequeue position per operation and no lock is taken.
+//
+// A claimed cell must be published or other threads wait on it forever,
+// so nothing may throw between claiming a cell and publishing it: T must
+// move without throwing, and an element whose construction may throw is
+// built before a cell is claimed and moved in.
+template <typename T>
+class MpmcQueue
+{
+	static_assert(std::is_nothrow_move_constructible<T>::value &&
+	              std::is_nothrow_move_assignable<T>::value,
+	              "MpmcQueue needs a T that moves without throwing");
+
+public:
+	explicit MpmcQueue(const std::size_t capacity,
+	                   const Backpressure backpressure = Backpressure::Yield)
+		: cells_(new Cell[checked_capacity(capacity)]),
+		  mask_(capacity - 1),
+		  backpressure_(backpressure)
+	{
+		for (std::size_t i = 0; i != capacity; ++i)
+		{
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	MpmcQueue(const MpmcQueue&) = delete;
+	MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+	~MpmcQueue()
+	{
+		const std::size_t head = enqueue_pos_.load(std::memory_order_relaxed);
+
+		for (std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed); pos != head; ++pos)
+		{
+			reinterpret_cast<T*>(&cells_[pos & mask_].storage)->~T();
+		}
+	}
+
+	std::size_t capacity() const
+	{
+		return mask_ + 1;
+	}
+
+	// Approximate while other threads are operating on the queue.
+	std::size_t size() const
+	{
+		const std::size_t tail = dequeue_pos_.load(std::memory_order_relaxed);
+		const std::size_t head = enqueue_pos_.load(std::memory_order_relaxed);
+
+		return head - tail;
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	template <typename... Args>
+	bool try_emplace(Args&&... args)
+	{
+		return emplace(Backpressure::Fail, std::is_nothrow_constructible<T, Args&&...>{},
+		               std::forward<Args>(args)...);
+	}
+
+	bool try_push(const T& element)
+	{
+		return try_emplace(element);
+	}
+
+	bool try_push(T&& element)
+	{
+		return try_emplace(std::move(element));
+	}
+
+	bool try_pop(T& element)
+	{
+		return wait(Backpressure::Fail, [&] { return dequeue(element); }, empty_waits_);
+	}
+
+	// Applies the queue's back-pressure policy while the queue is full.
+	// Returns false only under Backpressure::Fail.
+	bool push(const T& element)
+	{
+		return emplace(backpressure_, std::is_nothrow_copy_constructible<T>{}, element);
+	}
+
+	bool push(T&& element)
+	{
+		return emplace(backpressure_, std::true_type{}, std::move(element));
+	}
+
+	// Applies the queue's back-pressure policy while the queue is empty.
+	// Returns false only under Backpressure::Fail.
+	bool pop(T& element)
+	{
+		return wait(backpressure_, [&] { return dequeue(element); }, empty_waits_);
+	}
+
+	MpmcQueueStats stats() const
+	{
+		return {
+			push_retries_.load(std::memory_order_relaxed),
+			pop_retries_.load(std::memory_order_relaxed),
+			full_waits_.load(std::memory_order_relaxed),
+			empty_waits_.load(std::memory_order_relaxed)
+		};
+	}
+
+private:
+	static constexpr std::size_t cache_line = 64;
+
+	struct Cell
+	{
+		std::atomic<std::size_t> sequence;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+	};
+
+	static std::size_t checked_capacity(const std::size_t capacity)
+	{
+		if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+		{
+			throw std::invalid_argument("capacity must be a power of two greater than one");
+		}
+
+		return capacity;
+	}
+
+	template <typename... Args>
+	bool emplace(const Backpressure backpressure, std::true_type, Args&&... args)
+	{
+		return wait(backpressure, [&] { return enqueue(std::forward<Args>(args)...); }, full_waits_);
+	}
+
+	template <typename... Args>
+	bool emplace(const Backpressure backpressure, std::false_type, Args&&... args)
+	{
+		T element(std::forward<Args>(args)...);
+		return emplace(backpressure, std::true_type{}, std::move(element));
+	}
+
+	// Claims the next cell and constructs the element in it; false if the
+	// queue is full.
+	template <typename... Args>
+	bool enqueue(Args&&... args) noexcept
+	{
+		static_assert(std::is_nothrow_constructible<T, Args&&...>::value,
+		              "a claimed cell is constructed without throwing");
+
+		std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			Cell& cell = cells_[pos & mask_];
+			const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			const std::intptr_t diff = static_cast<std::intptr_t>(sequence) -
+			                           static_cast<std::intptr_t>(pos);
+
+			if (diff == 0)
+			{
+				if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					::new (static_cast<void*>(&cell.storage)) T(std::forward<Args>(args)...);
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+
+				push_retries_.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Claims the oldest cell and moves its element out; false if the
+	// queue is empty.
+	bool dequeue(T& element) noexcept
+	{
+		std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			Cell& cell = cells_[pos & mask_];
+			const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			const std::intptr_t diff = static_cast<std::intptr_t>(sequence) -
+			                           static_cast<std::intptr_t>(pos + 1);
+
+			if (diff == 0)
+			{
+				if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					T* data = reinterpret_cast<T*>(&cell.storage);
+					element = std::move(*data);
+					data->~T();
+					cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+					return true;
+				}
+
+				pop_retries_.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = dequeue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// A wait is counted once per call rather than per attempt, so that
+	// waiting threads do not contend on the counter.
+	template <typename Attempt>
+	bool wait(const Backpressure backpressure, Attempt attempt, std::atomic<std::uint64_t>& waits)
+	{
+		if (attempt())
+		{
+			return true;
+		}
+
+		waits.fetch_add(1, std::memory_order_relaxed);
+
+		auto delay = std::chrono::microseconds{1};
+
+		do
+		{
+			switch (backpressure)
+			{
+			case Backpressure::Fail:
+				return false;
+			case Backpressure::Spin:
+				break;
+			case Backpressure::Yield:
+				std::this_thread::yield();
+				break;
+			case Backpressure::Sleep:
+				std::this_thread::sleep_for(delay);
+				delay = std::min(delay * 2, decltype(delay){1000});
+				break;
+			}
+		}
+		while (!attempt());
+
+		return true;
+	}
+
+	// Producers and consumers each own a cache line so that enqueueing
+	// does not invalidate the line dequeuers are spinning on.
+	alignas(cache_line) std::unique_ptr<Cell[]> cells_;
+	std::size_t                                 mask_;
+	Backpressure                                backpressure_;
+
+	alignas(cache_line) std::atomic<std::size_t>   enqueue_pos_{0};
+	alignas(cache_line) std::atomic<std::size_t>   dequeue_pos_{0};
+	alignas(cache_line) std::atomic<std::uint64_t> push_retries_{0};
+	std::atomic<std::uint64_t>                     full_waits_{0};
+	alignas(cache_line) std::atomic<std::uint64_t> pop_retries_{0};
+	std::atomic<std::uint64_t>                     empty_waits_{0};
+};
@@ -0,0 +1,304 @@
+#!/usr/bin/env python3
+"""Benchmark regression gate.
+
+Runs the benchmarks selected by the gate configuration, pinned to one CPU,
+and compares the median of each one's repetitions against a checked-in
+baseline produced by the same script. Throughput (items or bytes per second,
+or else real time) may drop by at most the benchmark's tolerance.
+
+Allocation counters come from a second, single run of the benchmarks that
+allocation_filter selects, in a build linked with the counting operator new
+(counting_benchmarks), so that the timings stay free of it. They may not
+grow by more than the allocation tolerance, and a counter the baseline does
+not have fails until the baseline is re-recorded.
+
+A tolerance only means something if the baseline is steadier than it: a
+benchmark whose noise floor, noise_factor standard errors of the baseline's
+median, exceeds its tolerance fails as NOISY until the baseline is
+re-recorded with more repetitions.
+
+Prints a table of every comparison and exits non-zero if anything
+regressed, went missing, has too noisy a baseline or has none.
+
+    gate.py --benchmarks build/benchmarks --counting-benchmarks build/counting_benchmarks
+    gate.py --benchmarks build/benchmarks --counting-benchmarks build/counting_benchmarks --update
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+TIME_UNITS = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1.0}
+
+
+def load_json(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def pick_cpu(requested):
+    """Returns the CPU to pin to: the requested one, or the last CPU this
+    process may run on, which is the one least likely to take interrupts."""
+    if requested is not None:
+        return requested
+    return max(os.sched_getaffinity(0))
+
+
+def run_benchmarks(binary, config, cpu, filter_key="filter", repetitions=None, min_time=None):
+    with tempfile.NamedTemporaryFile(suffix=".json", delete=False) as out:
+        path = out.name
+
+    command = [
+        binary,
+        "--benchmark_filter=" + config[filter_key],
+        "--benchmark_repetitions=%d" % (repetitions or config.get("repetitions", 1)),
+        "--benchmark_min_time=%g" % (min_time or config.get("min_time", 0.5)),
+        "--benchmark_display_aggregates_only=true",
+        # Repetitions of every benchmark are shuffled across the whole run, so
+        # that a slow spell of the machine spreads over many benchmarks as
+        # noise instead of shifting the median of the few it falls on.
+        "--benchmark_enable_random_interleaving=%s" % ("true" if config.get("interleave", True) else "false"),
+        "--benchmark_out=" + path,
+        "--benchmark_out_format=json",
+    ]
+
+    # The child inherits the affinity mask, so the whole run stays on one CPU.
+    os.sched_setaffinity(0, {cpu})
+
+    try:
+        subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+        return load_json(path)
+    finally:
+        os.unlink(path)
+
+
+def throughput(entry):
+    """Returns (label, value, higher_is_better) for the entry's speed."""
+    for counter, label in (("items_per_second", "items/s"), ("bytes_per_second", "bytes/s")):
+        if counter in entry:
+            return label, entry[counter], True
+
+    return "time", entry["real_time"] * TIME_UNITS[entry.get("time_unit", "ns")], False
+
+
+def medians(results):
+    """Maps each benchmark name to the median of its repetitions, with "cv"
+    set to the coefficient of variation of its throughput. A single run of a
+    benchmark is easily slowed by a third on a shared machine; the median of
+    several is not, and the spread says how far apart two medians of the same
+    code can land."""
+    runs = {}
+    spread = {}
+
+    for entry in results["benchmarks"]:
+        if entry.get("run_type") != "aggregate":
+            continue
+
+        name = entry.get("run_name", entry["name"])
+
+        if entry["aggregate_name"] == "median":
+            runs[name] = dict(entry)
+        elif entry["aggregate_name"] == "cv":
+            label, value, _ = throughput(entry)
+            # The cv of a time is reported in the time's field, unscaled.
+            spread[name] = entry["real_time"] if label == "time" else value
+
+    for name, entry in runs.items():
+        entry["cv"] = spread.get(name, 0.0)
+
+    return runs
+
+
+def allocations(results, config):
+    """Maps each benchmark that reports allocation counters to them. The
+    counts come from a single run: they do not vary with the machine."""
+    counts = {}
+
+    for entry in results["benchmarks"]:
+        found = {counter: entry[counter] for counter in config.get("allocation_counters", []) if counter in entry}
+
+        if found:
+            counts[entry.get("run_name", entry["name"])] = found
+
+    return counts
+
+
+def tolerance_for(name, config):
+    for rule in config.get("tolerances", []):
+        if re.search(rule["pattern"], name):
+            return rule["tolerance"]
+    return config.get("default_tolerance", 0.1)
+
+
+def noise_floor(base, config):
+    """The uncertainty of the baseline's median: noise_factor standard errors
+    of the median of its repetitions, sqrt(pi / 2) * cv / sqrt(repetitions).
+    A shared machine drifts over seconds, so longer repetitions barely lower
+    the cv, but more of them narrow the median. Only the baseline counts, so
+    that a change which makes a benchmark noisier does not excuse itself."""
+    repetitions = max(base.get("repetitions", 1), 1)
+    return config.get("noise_factor", 0.0) * math.sqrt(math.pi / 2 / repetitions) * base.get("cv", 0.0)
+
+
+def format_value(label, value):
+    if label == "time":
+        for unit in ("s", "ms", "us", "ns"):
+            if value >= TIME_UNITS[unit] or unit == "ns":
+                return "%.3g %s" % (value / TIME_UNITS[unit], unit)
+
+    for scale, suffix in ((1e9, "G"), (1e6, "M"), (1e3, "k")):
+        if abs(value) >= scale:
+            return "%.3g%s" % (value / scale, suffix)
+
+    return "%.3g" % value
+
+
+def compare(baseline, current, config):
+    """Returns the rows of the report and whether every check passed."""
+    rows = []
+    passed = True
+
+    for name, base in sorted(baseline.items()):
+        run = current.get(name)
+
+        if run is None:
+            rows.append((name, "-", "-", "-", "-", "-", "MISSING"))
+            passed = False
+            continue
+
+        label, base_value, higher_is_better = throughput(base)
+        _, value, _ = throughput(run)
+        tolerance = tolerance_for(name, config)
+        steady = noise_floor(base, config) <= tolerance
+
+        change = (value - base_value) / base_value if base_value else 0.0
+        loss = -change if higher_is_better else change
+        ok = steady and loss <= tolerance
+
+        rows.append((name, label, format_value(label, base_value), format_value(label, value),
+                     "%+.1f%%" % (100 * change), "%.0f%%" % (100 * tolerance),
+                     "ok" if ok else "SLOWER" if steady else "NOISY"))
+        passed &= ok
+
+    return rows, passed
+
+
+def compare_allocations(baseline, current, config):
+    """Returns the rows of the allocation report and whether every check
+    passed. A counter with no baseline fails rather than counting as zero:
+    the baseline has to be re-recorded to say what it should be."""
+    rows = []
+    passed = True
+    tolerance = config.get("allocation_tolerance", 0.0)
+
+    for name in sorted(set(baseline) | set(current)):
+        base = baseline.get(name, {})
+        run = current.get(name, {})
+
+        for counter in config.get("allocation_counters", []):
+            if counter not in base and counter not in run:
+                continue
+
+            if counter not in base:
+                rows.append((name, counter, "-", format_value(counter, run[counter]), "-", "-", "NO BASELINE"))
+                passed = False
+                continue
+
+            if counter not in run:
+                rows.append((name, counter, format_value(counter, base[counter]), "-", "-", "-", "MISSING"))
+                passed = False
+                continue
+
+            ok = run[counter] <= base[counter] * (1 + tolerance) + 1e-9
+
+            rows.append((name, counter, format_value(counter, base[counter]), format_value(counter, run[counter]),
+                         "%+.3g" % (run[counter] - base[counter]), "%.0f%%" % (100 * tolerance),
+                         "ok" if ok else "MORE ALLOCS"))
+            passed &= ok
+
+    return rows, passed
+
+
+def print_table(rows):
+    header = ("benchmark", "metric", "baseline", "current", "change", "tolerance", "status")
+    widths = [max(len(row[i]) for row in rows + [header]) for i in range(len(header))]
+
+    def line(row):
+        cells = [row[0].ljust(widths[0]), row[1].ljust(widths[1])]
+        cells += [cell.rjust(width) for cell, width in zip(row[2:6], widths[2:6])]
+        cells.append(row[6])
+        return "  ".join(cells)
+
+    print(line(header))
+    print("  ".join("-" * width for width in widths))
+
+    for row in rows:
+        print(line(row))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--benchmarks", required=True, help="path to the benchmarks binary")
+    parser.add_argument("--counting-benchmarks", required=True,
+                        help="path to the benchmarks binary linked with the allocation-counting operator new")
+    parser.add_argument("--config", default=os.path.join(HERE, "gate.json"))
+    parser.add_argument("--baseline", default=os.path.join(HERE, "baseline.json"))
+    parser.add_argument("--cpu", type=int, help="CPU to pin the run to")
+    parser.add_argument("--update", action="store_true", help="write this run as the new baseline")
+    args = parser.parse_args()
+
+    config = load_json(args.config)
+    cpu = pick_cpu(args.cpu)
+
+    print("running %s on CPU %d" % (os.path.basename(args.benchmarks), cpu), flush=True)
+    results = run_benchmarks(args.benchmarks, config, cpu)
+
+    # Timings come from the binary without the counting operator new, which
+    # would slow every allocation down; counts from the one with it.
+    print("running %s on CPU %d" % (os.path.basename(args.counting_benchmarks), cpu), flush=True)
+    counted = allocations(run_benchmarks(args.counting_benchmarks, config, cpu, "allocation_filter",
+                                         repetitions=1, min_time=config.get("allocation_min_time", 0.01)),
+                          config)
+
+    if args.update:
+        baseline = {"context": results["context"], "benchmarks": list(medians(results).values()),
+                    "allocations": counted}
+
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2)
+            f.write("\n")
+        print("wrote %d benchmarks and the allocations of %d to %s"
+              % (len(baseline["benchmarks"]), len(counted), args.baseline))
+
+        noisy = [entry["run_name"] for entry in baseline["benchmarks"]
+                 if noise_floor(entry, config) > tolerance_for(entry["run_name"], config)]
+
+        for name in noisy:
+            print("too noisy to gate: %s" % name)
+
+        return 1 if noisy else 0
+
+    recorded = load_json(args.baseline)
+    baseline = {entry["run_name"]: entry for entry in recorded["benchmarks"]}
+    rows, passed = compare(baseline, medians(results), config)
+    allocation_rows, allocations_passed = compare_allocations(recorded.get("allocations", {}), counted, config)
+    print_table(rows + allocation_rows)
+
+    if not (passed and allocations_passed):
+        print("\nperformance regressed against %s" % args.baseline)
+        print("if the change is intended, rerun with --update and commit the new baseline;")
+        print("for NOISY rows, raise repetitions in %s first" % args.config)
+        return 1
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "generator.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace permute
+{
+  // Exchanges n bytes between two non-overlapping buffers, a vector
+  // register at a time.
+  inline void swap_bytes(void* a, void* b, std::size_t n) noexcept
+  {
+    auto* p = static_cast<unsigned char*>(a);
+    auto* q = static_cast<unsigned char*>(b);
+
+#if defined(__AVX2__)
+    for (; n >= 32; n -= 32, p += 32, q += 32)
+    {
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), y);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(q), x);
+    }
+#elif defined(__SSE2__)
+    for (; n >= 16; n -= 16, p += 16, q += 16)
+    {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p), y);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(q), x);
+    }
+#endif
+
+    for (; n >= 8; n -= 8, p += 8, q += 8)
+    {
+      std::uint64_t x, y;
+      std::memcpy(&x, p, 8);
+      std::memcpy(&y, q, 8);
+      std::memcpy(p, &y, 8);
+      std::memcpy(q, &x, 8);
+    }
+
+    for (; n; --n, ++p, ++q)
+    {
+      std::swap(*p, *q);
+    }
+  }
+
+  template <typename ForwardIt1, typename ForwardIt2>
+  inline
+  ForwardIt2 swap_ranges(ForwardIt1 first1, const ForwardIt1 last1, ForwardIt2 first2)
+  {
+    return std::swap_ranges(first1, last1, first2);
+  }
+
+  // Contiguous ranges of trivially copyable elements are swapped as bytes.
+  template <typename T>
+  inline
+  typename std::enable_if<std::is_trivially_copyable<T>::value, T*>::type
+  swap_ranges(T* first1, T* const last1, T* first2) noexcept
+  {
+    const std::size_t n = last1 - first1;
+    swap_bytes(first1, first2, n * sizeof(T));
+    return first2 + n;
+  }
+
+  // Rearranges [first, last) so that element i ends up holding what was
+  // element indices[i], moving each element once. Every cycle of the
+  // permutation is followed from its lowest position, with a bitmap
+  // recording the positions already filled. Throws std::invalid_argument,
+  // leaving the range untouched, if indices is not a permutation.
+  template <typename RandomIt, typename IndexIt>
+  void apply_permutation(const RandomIt first, const RandomIt last, const IndexIt indices)
+  {
+    const std::size_t n = last - first;
+    std::vector<std::uint64_t> visited((n + 63) / 64);
+
+    const auto test_and_set = [&](const std::size_t i)
+    {
+      const std::uint64_t bit = std::uint64_t{1} << (i % 64);
+      const bool          set = visited[i / 64] & bit;
+      visited[i / 64] |= bit;
+      return set;
+    };
+
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      const std::size_t index = indices[i];
+
+      if (index >= n || test_and_set(index))
+      {
+        throw std::invalid_argument("indices is not a permutation of the range");
+      }
+    }
+
+    std::fill(visited.begin(), visited.end(), 0);
+
+    for (std::size_t start = 0; start != n; ++start)
+    {
+      if (test_and_set(start) || static_cast<std::size_t>(indices[start]) == start)
+      {
+        continue;
+      }
+
+      auto temp = std::move(first[start]);
+      std::size_t j = start;
+
+      for (std::size_t k = indices[j]; k != start; k = indices[j])
+      {
+        first[j] = std::move(first[k]);
+        test_and_set(k);
+        j = k;
+      }
+
+      first[j] = std::move(temp);
+    }
+  }
+
+  // Merges two adjacent, independently shuffled ranges into one uniformly
+  // shuffled range in place (MergeShuffle, Bacher et al. 2015).
+  template <typename RandomIt, typename Engine>
+  void merge_shuffled(const RandomIt first, const RandomIt middle, const RandomIt last, Engine& engine)
+  {
+    using std::iter_swap;
+
+    RandomIt i = first;
+    RandomIt j = middle;
+
+    std::uint64_t bits   = 0;
+    int           bits_n = 0;
+
+    for (;; ++i)
+    {
+      if (bits_n == 0)
+      {
+        bits   = engine();
+        bits_n = 64;
+      }
+
+      const bool take_right = bits & 1;
+      bits >>= 1;
+      --bits_n;
+
+      if (take_right)
+      {
+        if (j == last) break;
+        iter_swap(i, j);
+        ++j;
+      }
+      else if (i == j)
+      {
+        break;
+      }
+    }
+
+    for (; i != last; ++i)
+    {
+      std::uniform_int_distribution<std::ptrdiff_t> dist{0, i - first};
+      iter_swap(i, first + dist(engine));
+    }
+  }
+
+  constexpr std::size_t shuffle_block = std::size_t{1} << 16;
+
+  // Uniform in-place shuffle on num_threads threads. Blocks of
+  // shuffle_block elements are shuffled independently and then merged
+  // pairwise, so the result depends only on seed and never on the number
+  // of threads.
+  template <typename RandomIt>
+  void parallel_shuffle(const RandomIt first, const RandomIt last, const std::uint64_t seed,
+                        unsigned int num_threads = std::thread::hardware_concurrency())
+  {
+    const std::size_t n          = last - first;
+    const std::size_t num_blocks = (n + shuffle_block - 1) / shuffle_block;
+
+    num_threads = std::max(1U, num_threads);
+
+    // Runs task(0) .. task(count - 1) spread over the threads.
+    const auto for_each_task = [&](const std::size_t count, const auto& task)
+    {
+      std::vector<std::thread> threads;
+      const std::size_t num_workers = std::min<std::size_t>(num_threads, count);
+
+      for (std::size_t worker = 1; worker < num_workers; ++worker)
+      {
+        threads.emplace_back([&, worker]
+        {
+          for (std::size_t t = worker; t < count; t += num_workers) task(t);
+        });
+      }
+
+      for (std::size_t t = 0; t < count; t += std::max<std::size_t>(1, num_workers)) task(t);
+
+      for (auto& thread : threads) thread.join();
+    };
+
+    const auto bound = [&](const std::size_t block)
+    {
+      return first + std::min(n, block * shuffle_block);
+    };
+
+    for_each_task(num_blocks, [&](const std::size_t block)
+    {
+      std::mt19937_64 engine{generator::derive_seed(seed, block)};
+      std::shuffle(bound(block), bound(block + 1), engine);
+    });
+
+    for (std::size_t width = 1, level = 1; width < num_blocks; width *= 2, ++level)
+    {
+      const std::size_t num_merges = (num_blocks + 2 * width - 1) / (2 * width);
+
+      for_each_task(num_merges, [&](const std::size_t merge)
+      {
+        const std::size_t block = merge * 2 * width;
+
+        if (block + width < num_blocks)
+        {
+          std::mt19937_64 engine{generator::derive_seed(seed, level * num_blocks + block)};
+          merge_shuffled(bound(block), bound(block + width), bound(block + 2 * width), engine);
+        }
+      });
+    }
+  }
+}
@@ -0,0 +1,121 @@
+#include "profiling.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+using namespace ::testing;
+
+namespace
+{
+	// PROFILE_TESTS=1 ./runTests prints the counters of every test.
+	const bool listener_installed = []
+	{
+		const char* value = std::getenv("PROFILE_TESTS");
+
+		if (!value || !*value || *value == '0')
+		{
+			return false;
+		}
+
+		UnitTest::GetInstance()->listeners().Append(new profiling::TestListener);
+		return true;
+	}();
+
+	std::uint64_t busy_work(const std::uint64_t n)
+	{
+		std::uint64_t x = 1;
+
+		for (std::uint64_t i = 0; i != n; ++i)
+		{
+			x = x * 6364136223846793005ULL + i;
+			benchmark::DoNotOptimize(x);
+		}
+
+		return x;
+	}
+}
+
+TEST(profiling, counts_or_reports_nothing)
+{
+	profiling::Counters counters;
+
+	{
+		const profiling::Scope scope{counters};
+		busy_work(100000);
+	}
+
+	const profiling::Sample sample = counters.read();
+	std::ostringstream os;
+	os << sample;
+
+	if (!counters.available())
+	{
+		EXPECT_TRUE(sample.empty());
+		EXPECT_THAT(os.str(), Eq("no hardware counters available"));
+		return;
+	}
+
+	if (sample.has(profiling::Event::Instructions))
+	{
+		EXPECT_THAT(sample[profiling::Event::Instructions], Gt(100000.0));
+		EXPECT_THAT(os.str(), HasSubstr("instructions="));
+	}
+}
+
+TEST(profiling, stopped_counters_do_not_count)
+{
+	profiling::Counters counters;
+
+	if (!counters.available())
+	{
+		GTEST_SKIP() << "hardware counters are not available";
+	}
+
+	{
+		const profiling::Scope scope{counters};
+		busy_work(1000);
+	}
+
+	const profiling::Sample first = counters.read();
+	busy_work(100000);
+	const profiling::Sample second = counters.read();
+
+	for (std::size_t e = 0; e != profiling::num_events; ++e)
+	{
+		EXPECT_THAT(second.counts[e], Eq(first.counts[e]));
+	}
+
+	counters.reset();
+	EXPECT_THAT(counters.read().counts[0], Eq(0.0));
+}
+
+TEST(profiling, counts_threads_started_while_counting)
+{
+	profiling::Counters counters;
+
+	if (!counters.available())
+	{
+		GTEST_SKIP() << "hardware counters are not available";
+	}
+
+	{
+		const profiling::Scope scope{counters};
+		std::thread worker([] { busy_work(1000000); });
+		worker.join();
+	}
+
+	const profiling::Sample sample = counters.read();
+
+	if (sample.has(profiling::Event::Instructions))
+	{
+		EXPECT_THAT(sample[profiling::Event::Instructions], Gt(2000000.0));
+	}
+
+	// The worker's counts were added when it exited; reset clears them too.
+	counters.reset();
+	EXPECT_THAT(counters.read().counts[0], Eq(0.0));
+}
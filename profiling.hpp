@@ -0,0 +1,309 @@
+#pragma once
+
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware performance counters for the calling thread and every thread
+// it starts after the counters are created, read through Linux
+// perf_event_open. A started thread's counts are added when it exits, so
+// a parallel section is read after its workers have been joined.
+//
+// Events the kernel refuses (perf_event_paranoid, containers, virtual
+// machines without a PMU, other systems) are left out of the sample
+// rather than reported as errors, so code using these always runs; it
+// just measures less.
+namespace profiling
+{
+	enum class Event
+	{
+		Cycles,
+		Instructions,
+		BranchMisses,
+		CacheMisses
+	};
+
+	constexpr std::size_t num_events = 4;
+
+	inline const char* name(const Event event) noexcept
+	{
+		static const char* const names[num_events] =
+		{
+			"cycles", "instructions", "branch-misses", "cache-misses"
+		};
+
+		return names[static_cast<std::size_t>(event)];
+	}
+
+	// Counts for the events that could be measured, scaled up to the full
+	// measured time if the kernel had to multiplex the counters.
+	struct Sample
+	{
+		std::array<double, num_events> counts{};
+		std::array<bool, num_events>   measured{};
+
+		bool has(const Event event) const noexcept
+		{
+			return measured[static_cast<std::size_t>(event)];
+		}
+
+		double operator[](const Event event) const noexcept
+		{
+			return counts[static_cast<std::size_t>(event)];
+		}
+
+		bool empty() const noexcept
+		{
+			for (const bool m : measured)
+			{
+				if (m) return false;
+			}
+
+			return true;
+		}
+	};
+
+	inline std::ostream& operator<<(std::ostream& os, const Sample& sample)
+	{
+		if (sample.empty())
+		{
+			return os << "no hardware counters available";
+		}
+
+		const char* separator = "";
+
+		for (std::size_t e = 0; e != num_events; ++e)
+		{
+			if (sample.measured[e])
+			{
+				os << separator << name(static_cast<Event>(e)) << '=' << static_cast<std::uint64_t>(sample.counts[e]);
+				separator = " ";
+			}
+		}
+
+		if (sample.has(Event::Cycles) && sample.has(Event::Instructions) && sample[Event::Cycles] > 0)
+		{
+			os << " IPC=" << sample[Event::Instructions] / sample[Event::Cycles];
+		}
+
+		return os;
+	}
+
+	// One counter per event, all disabled until start(). Counts accumulate
+	// over every start()/stop() interval until reset(). Counters are
+	// inherited one at a time rather than read as a group, which the
+	// kernel does not allow for inherited counters.
+	class Counters
+	{
+	public:
+		Counters() noexcept
+		{
+			fds_.fill(-1);
+
+#if defined(__linux__)
+			static const std::uint64_t configs[num_events] =
+			{
+				PERF_COUNT_HW_CPU_CYCLES,
+				PERF_COUNT_HW_INSTRUCTIONS,
+				PERF_COUNT_HW_BRANCH_MISSES,
+				PERF_COUNT_HW_CACHE_MISSES
+			};
+
+			for (std::size_t e = 0; e != num_events; ++e)
+			{
+				perf_event_attr attr{};
+				attr.size           = sizeof(attr);
+				attr.type           = PERF_TYPE_HARDWARE;
+				attr.config         = configs[e];
+				attr.disabled       = 1;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv     = 1;
+				attr.inherit        = 1;
+				attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+				fds_[e] = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+			}
+#endif
+		}
+
+		Counters(const Counters&) = delete;
+		Counters& operator=(const Counters&) = delete;
+
+		~Counters()
+		{
+#if defined(__linux__)
+			for (const int fd : fds_)
+			{
+				if (fd >= 0) ::close(fd);
+			}
+#endif
+		}
+
+		// True if at least one event can be counted.
+		bool available() const noexcept
+		{
+			for (const int fd : fds_)
+			{
+				if (fd >= 0) return true;
+			}
+
+			return false;
+		}
+
+		void start() noexcept
+		{
+#if defined(__linux__)
+			control(PERF_EVENT_IOC_ENABLE);
+#endif
+		}
+
+		void stop() noexcept
+		{
+#if defined(__linux__)
+			control(PERF_EVENT_IOC_DISABLE);
+#endif
+		}
+
+		// The kernel's reset leaves out the counts of threads that have
+		// already exited, so the values at reset are kept and subtracted
+		// instead.
+		void reset() noexcept
+		{
+#if defined(__linux__)
+			for (std::size_t e = 0; e != num_events; ++e)
+			{
+				if (!read_values(e, base_[e]))
+				{
+					base_[e].fill(0);
+				}
+			}
+#endif
+		}
+
+		Sample read() const noexcept
+		{
+			Sample sample;
+
+#if defined(__linux__)
+			for (std::size_t e = 0; e != num_events; ++e)
+			{
+				Values values;
+
+				if (!read_values(e, values))
+				{
+					continue;
+				}
+
+				const std::uint64_t count   = values[0] - base_[e][0];
+				const std::uint64_t enabled = values[1] - base_[e][1];
+				const std::uint64_t running = values[2] - base_[e][2];
+
+				sample.measured[e] = true;
+				sample.counts[e]   = running == 0 ? 0.0 :
+					static_cast<double>(count) * enabled / running;
+			}
+#endif
+
+			return sample;
+		}
+
+	private:
+		using Values = std::array<std::uint64_t, 3>; // count, time enabled, time running
+
+#if defined(__linux__)
+		void control(const unsigned long request) noexcept
+		{
+			for (const int fd : fds_)
+			{
+				if (fd >= 0) ::ioctl(fd, request, 0);
+			}
+		}
+
+		bool read_values(const std::size_t e, Values& values) const noexcept
+		{
+			return fds_[e] >= 0 &&
+			       ::read(fds_[e], values.data(), sizeof(values)) == static_cast<ssize_t>(sizeof(values));
+		}
+#endif
+
+		std::array<int, num_events>    fds_;
+		std::array<Values, num_events> base_{};
+	};
+
+	// Counts for as long as it lives.
+	class Scope
+	{
+	public:
+		explicit Scope(Counters& counters) noexcept
+			: counters_(counters)
+		{
+			counters_.start();
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		~Scope()
+		{
+			counters_.stop();
+		}
+
+	private:
+		Counters& counters_;
+	};
+
+	// Adds <event>/op counters, and IPC when both cycles and instructions
+	// were measured, to a benchmark whose timing loop ran inside a Scope.
+	inline void report(benchmark::State& state, const Sample& sample)
+	{
+		for (std::size_t e = 0; e != num_events; ++e)
+		{
+			if (sample.measured[e])
+			{
+				state.counters[std::string(name(static_cast<Event>(e))) + "/op"] =
+					benchmark::Counter(sample.counts[e], benchmark::Counter::kAvgIterations);
+			}
+		}
+
+		if (sample.has(Event::Cycles) && sample.has(Event::Instructions) && sample[Event::Cycles] > 0)
+		{
+			state.counters["IPC"] = sample[Event::Instructions] / sample[Event::Cycles];
+		}
+	}
+
+	// Prints the counters of every test. Installed by profiling.cpp when
+	// the PROFILE_TESTS environment variable is set.
+	class TestListener : public ::testing::EmptyTestEventListener
+	{
+	public:
+		void OnTestStart(const ::testing::TestInfo&) override
+		{
+			counters_.reset();
+			counters_.start();
+		}
+
+		void OnTestEnd(const ::testing::TestInfo& info) override
+		{
+			counters_.stop();
+			std::cout << "[ PERF     ] " << info.test_suite_name() << '.' << info.name()
+			          << ": " << counters_.read() << std::endl;
+		}
+
+	private:
+		Counters counters_;
+	};
+}
@@ -0,0 +1,448 @@
+#include "allocation.hpp"
+#include "stack.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+
+namespace
+{
+	struct Tracked
+	{
+		static int live;
+
+		Tracked(int value) : value(value) { ++live; }
+		Tracked(const Tracked& other) : value(other.value) { ++live; }
+		~Tracked() { --live; }
+
+		friend std::ostream& operator<<(std::ostream& os, const Tracked& tracked)
+		{
+			return os << tracked.value;
+		}
+
+		int value;
+	};
+
+	int Tracked::live = 0;
+
+	template <typename T>
+	std::string to_string(const T& value)
+	{
+		std::ostringstream os;
+		os << value;
+		return os.str();
+	}
+}
+
+template <typename StackType>
+class StackStorage : public Test
+{
+};
+
+using StackTypes = Types<Stack<int>,
+                         Stack<int, std::allocator<int>>,
+                         ArrayStack<int>,
+                         ChunkedStack<int>,
+                         Stack<int, std::allocator<int>, ChunkedStorage<int, 3>>>;
+TYPED_TEST_CASE(StackStorage, StackTypes);
+
+TYPED_TEST(StackStorage, push_pop)
+{
+	TypeParam stack;
+	EXPECT_TRUE(stack.empty());
+
+	for (int i = 0; i != 100; ++i)
+	{
+		stack.push(i);
+		ASSERT_THAT(stack.top(), Eq(i));
+	}
+
+	EXPECT_THAT(stack.size(), Eq(100U));
+
+	for (int i = 99; i >= 0; --i)
+	{
+		ASSERT_THAT(stack.top(), Eq(i));
+		stack.pop();
+	}
+
+	EXPECT_TRUE(stack.empty());
+	stack.pop();
+	EXPECT_TRUE(stack.empty());
+}
+
+TYPED_TEST(StackStorage, top_is_reference)
+{
+	TypeParam stack;
+	stack.reserve(10);
+	stack.push(1);
+	stack.emplace(2) += 40;
+	EXPECT_THAT(stack.top(), Eq(42));
+
+	stack.top() = 7;
+	EXPECT_THAT(to_string(stack), Eq("Stack(size=2,elements=7 1)"));
+}
+
+TYPED_TEST(StackStorage, iteration)
+{
+	TypeParam stack;
+
+	for (int i = 0; i != 10; ++i)
+	{
+		stack.push(i);
+	}
+
+	const std::vector<int> elements(stack.begin(), stack.end());
+	EXPECT_THAT(elements, ElementsAre(9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+TYPED_TEST(StackStorage, copy)
+{
+	TypeParam stack;
+	stack.push(1);
+	stack.push(2);
+	stack.push(3);
+
+	TypeParam copy{stack};
+	EXPECT_THAT(to_string(copy), Eq("Stack(size=3,elements=3 2 1)"));
+
+	copy.pop();
+	copy = stack;
+	EXPECT_THAT(to_string(copy), Eq(to_string(stack)));
+}
+
+TYPED_TEST(StackStorage, move)
+{
+	TypeParam stack;
+	stack.push(1);
+	stack.push(2);
+
+	TypeParam moved{std::move(stack)};
+	EXPECT_TRUE(stack.empty());
+	EXPECT_THAT(to_string(moved), Eq("Stack(size=2,elements=2 1)"));
+
+	TypeParam assigned;
+	assigned.push(3);
+	assigned = std::move(moved);
+	EXPECT_TRUE(moved.empty());
+	EXPECT_THAT(to_string(assigned), Eq("Stack(size=2,elements=2 1)"));
+
+	moved.push(4);
+	EXPECT_THAT(moved.top(), Eq(4));
+}
+
+template <typename Storage>
+void test_releases_elements()
+{
+	{
+		Stack<Tracked, typename Storage::allocator_type, Storage> stack;
+
+		for (int i = 0; i != 1000; ++i)
+		{
+			stack.push(i);
+		}
+
+		for (int i = 0; i != 500; ++i)
+		{
+			stack.pop();
+		}
+
+		EXPECT_THAT(Tracked::live, Eq(500));
+	}
+
+	EXPECT_THAT(Tracked::live, Eq(0));
+}
+
+TEST(Stack, destructor_releases_elements)
+{
+	test_releases_elements<LinkedStorage<Tracked>>();
+	test_releases_elements<ChunkedStorage<Tracked>>();
+	test_releases_elements<ChunkedStorage<Tracked, 7>>();
+}
+
+template <typename Storage>
+void test_move_only()
+{
+	Stack<std::unique_ptr<int>, typename Storage::allocator_type, Storage> stack;
+	stack.push(std::unique_ptr<int>(new int(1)));
+	stack.emplace(new int(2));
+	EXPECT_THAT(*stack.top(), Eq(2));
+
+	std::unique_ptr<int> element = std::move(stack.top());
+	stack.pop();
+	EXPECT_THAT(*element, Eq(2));
+	EXPECT_THAT(*stack.top(), Eq(1));
+}
+
+TEST(Stack, move_only)
+{
+	test_move_only<LinkedStorage<std::unique_ptr<int>>>();
+	test_move_only<ChunkedStorage<std::unique_ptr<int>>>();
+	test_move_only<std::vector<std::unique_ptr<int>>>();
+}
+
+TEST(ChunkedStorage, keeps_one_spare_chunk)
+{
+	ChunkedStorage<int, 4> storage;
+
+	for (int i = 0; i != 16; ++i)
+	{
+		storage.push_back(i);
+	}
+
+	EXPECT_THAT(storage.capacity(), Eq(16U));
+
+	while (storage.size() != 5)
+	{
+		storage.pop_back();
+	}
+
+	EXPECT_THAT(storage.capacity(), Eq(12U));
+
+	storage.reserve(30);
+	EXPECT_THAT(storage.capacity(), Eq(32U));
+}
+
+TEST(ChunkedStorage, keeps_reserved_chunks)
+{
+	ChunkedStorage<int, 4> storage;
+	storage.reserve(30);
+
+	for (int i = 0; i != 40; ++i)
+	{
+		storage.push_back(i);
+	}
+
+	while (!storage.empty())
+	{
+		storage.pop_back();
+	}
+
+	EXPECT_THAT(storage.capacity(), Eq(32U));
+}
+
+namespace
+{
+	// Propagates on copy assignment and counts the chunks each instance
+	// has outstanding, so that a chunk freed through the wrong one shows.
+	template <typename T>
+	struct CountingAllocator
+	{
+		using value_type = T;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+
+		CountingAllocator()
+			: live(std::make_shared<int>(0)) { }
+
+		T* allocate(const std::size_t n)
+		{
+			++*live;
+			return std::allocator<T>{}.allocate(n);
+		}
+
+		void deallocate(T* p, const std::size_t n) noexcept
+		{
+			--*live;
+			std::allocator<T>{}.deallocate(p, n);
+		}
+
+		friend bool operator==(const CountingAllocator& a, const CountingAllocator& b) noexcept
+		{
+			return a.live == b.live;
+		}
+
+		friend bool operator!=(const CountingAllocator& a, const CountingAllocator& b) noexcept
+		{
+			return a.live != b.live;
+		}
+
+		std::shared_ptr<int> live;
+	};
+}
+
+TEST(ChunkedStorage, copy_assignment_propagates_the_allocator)
+{
+	using Storage = ChunkedStorage<int, 4, CountingAllocator<int>>;
+
+	CountingAllocator<int> from_allocator, to_allocator;
+	Storage from{from_allocator}, to{to_allocator};
+
+	for (int i = 0; i != 10; ++i)
+	{
+		from.push_back(i);
+		to.push_back(-i);
+	}
+
+	to = from;
+
+	EXPECT_TRUE(to.get_allocator() == from_allocator);
+	EXPECT_THAT(*to_allocator.live, Eq(0));
+	EXPECT_THAT(*from_allocator.live, Eq(6));
+	EXPECT_THAT(to.back(), Eq(9));
+}
+
+template <typename StackType>
+void push_n(StackType& stack, const int n)
+{
+	for (int i = 0; i != n; ++i)
+	{
+		stack.push(i);
+	}
+}
+
+TEST(Stack, push_within_capacity_does_not_allocate)
+{
+	ArrayStack<int> array;
+	array.reserve(100);
+	EXPECT_NO_ALLOCATIONS(push_n(array, 100));
+
+	ChunkedStack<int> chunked;
+	chunked.reserve(5000);
+	EXPECT_NO_ALLOCATIONS(push_n(chunked, 5000));
+
+	// The pool keeps its blocks, so a stack that has been this deep before
+	// gets its nodes back from the free list.
+	Stack<int> linked;
+	push_n(linked, 100);
+	linked.clear();
+	EXPECT_NO_ALLOCATIONS(push_n(linked, 100));
+}
+
+TEST(Stack, linked_storage_allocates_per_push_without_pool)
+{
+	SKIP_WITHOUT_ALLOCATION_HOOKS();
+
+	Stack<int, std::allocator<int>> stack;
+	const auto stats = allocation::measure([&] { push_n(stack, 100); });
+
+	EXPECT_THAT(stats.allocations, Eq(100U));
+
+	Stack<int> pooled;
+	const auto pooled_stats = allocation::measure([&] { push_n(pooled, 100); });
+
+	EXPECT_THAT(pooled_stats.allocations, Eq(2U));
+}
+
+TEST(Stack, std_allocator)
+{
+	Stack<int, std::allocator<int>> stack;
+	stack.push(1);
+	stack.push(2);
+	stack.pop();
+	EXPECT_THAT(stack.top(), Eq(1));
+}
+
+TEST(PoolAllocator, reuses_slots)
+{
+	PoolAllocator<int> allocator;
+
+	int* a = allocator.allocate(1);
+	int* b = allocator.allocate(1);
+	EXPECT_THAT(b, Ne(a));
+
+	allocator.deallocate(a, 1);
+	EXPECT_THAT(allocator.allocate(1), Eq(a));
+
+	allocator.deallocate(a, 1);
+	allocator.deallocate(b, 1);
+}
+
+TEST(PoolAllocator, rebound_copies_share_the_pool)
+{
+	PoolAllocator<int>    a;
+	PoolAllocator<double> b{a};
+
+	EXPECT_TRUE(b == a);
+	EXPECT_TRUE(PoolAllocator<int>{b} == a);
+	EXPECT_TRUE(PoolAllocator<int>{} != a);
+
+	// A slot freed through an equal allocator goes back to the pool it
+	// came from.
+	double* p = b.allocate(1);
+	PoolAllocator<double>{PoolAllocator<int>{b}}.deallocate(p, 1);
+	EXPECT_THAT(b.allocate(1), Eq(p));
+	b.deallocate(p, 1);
+}
+
+template <typename StackType>
+void Stack_push_pop(benchmark::State& state)
+{
+	const auto n = state.range(0);
+	StackType stack;
+
+	// One round up front, so allocs/op shows the steady state rather than
+	// the growth of the first iteration spread over all of them.
+	for (auto i = 0; i != n; ++i)
+	{
+		stack.push(i);
+	}
+
+	while (!stack.empty())
+	{
+		stack.pop();
+	}
+
+	const allocation::Scope scope;
+
+	for (auto _ : state)
+	{
+		for (auto i = 0; i != n; ++i)
+		{
+			stack.push(i);
+		}
+
+		while (!stack.empty())
+		{
+			benchmark::DoNotOptimize(stack.top());
+			stack.pop();
+		}
+	}
+
+	allocation::report(state, scope.stats());
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename StackType>
+void Stack_iterate(benchmark::State& state)
+{
+	const auto n = state.range(0);
+	StackType stack;
+
+	for (auto i = 0; i != n; ++i)
+	{
+		stack.push(i);
+	}
+
+	for (auto _ : state)
+	{
+		long sum = 0;
+
+		for (const auto element : stack)
+		{
+			sum += element;
+		}
+
+		benchmark::DoNotOptimize(sum);
+	}
+
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(Stack_push_pop, Stack<int>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(Stack_push_pop, Stack<int, std::allocator<int>>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(Stack_push_pop, ArrayStack<int>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(Stack_push_pop, ChunkedStack<int>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(Stack_push_pop, std::stack<int, std::vector<int>>)->Range(8, 1 << 16);
+
+BENCHMARK_TEMPLATE(Stack_iterate, Stack<int>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(Stack_iterate, ArrayStack<int>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(Stack_iterate, ChunkedStack<int>)->Range(8, 1 << 16);
@@ -0,0 +1,920 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <forward_list>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace detail
+{
+	// Free lists of fixed-size slots, one per slot size, each carved out of
+	// blocks of BlockSize slots. Every PoolAllocator copied or rebound from
+	// the same original shares one Pools, so whichever of them frees a slot
+	// returns it to the list it came from.
+	template <std::size_t BlockSize>
+	class Pools
+	{
+	public:
+		class Pool
+		{
+		public:
+			explicit Pool(const std::size_t slot_size) noexcept
+				: slot_size_(slot_size) { }
+
+			Pool(const Pool&) = delete;
+			Pool& operator=(const Pool&) = delete;
+
+			~Pool()
+			{
+				while (blocks_)
+				{
+					char* block = blocks_;
+					blocks_ = *reinterpret_cast<char**>(block);
+					::operator delete(block);
+				}
+			}
+
+			std::size_t slot_size() const noexcept
+			{
+				return slot_size_;
+			}
+
+			void* allocate()
+			{
+				if (free_)
+				{
+					Link* slot = free_;
+					free_ = slot->next;
+					return slot;
+				}
+
+				if (used_ == BlockSize)
+				{
+					char* block = static_cast<char*>(::operator new(header + BlockSize * slot_size_));
+					*reinterpret_cast<char**>(block) = blocks_;
+					blocks_ = block;
+					used_ = 0;
+				}
+
+				return blocks_ + header + slot_size_ * used_++;
+			}
+
+			void deallocate(void* slot) noexcept
+			{
+				free_ = ::new (slot) Link{free_};
+			}
+
+		private:
+			struct Link
+			{
+				Link* next;
+			};
+
+			// Each block starts with the link to the previous one, padded so
+			// that the slots after it are aligned.
+			static constexpr std::size_t header = alignof(std::max_align_t);
+
+			std::size_t slot_size_;
+			char*       blocks_ = nullptr;
+			Link*       free_   = nullptr;
+			std::size_t used_   = BlockSize;
+		};
+
+		Pools() = default;
+		Pools(const Pools&) = delete;
+		Pools& operator=(const Pools&) = delete;
+
+		// The pool of slots holding objects of this size and alignment,
+		// created on first use.
+		Pool& get(const std::size_t size, const std::size_t alignment)
+		{
+			const std::size_t align = std::max(alignment, alignof(void*));
+			const std::size_t slot  = (std::max(size, sizeof(void*)) + align - 1) / align * align;
+
+			for (Pool& pool : pools_)
+			{
+				if (pool.slot_size() == slot)
+				{
+					return pool;
+				}
+			}
+
+			pools_.emplace_front(slot);
+			return pools_.front();
+		}
+
+	private:
+		std::forward_list<Pool> pools_;
+	};
+}
+
+
+// Allocator handing out single objects from fixed-size blocks of
+// BlockSize slots. Deallocated slots go onto a free list and are reused
+// by the next allocation, so a container that keeps growing and shrinking
+// stops calling operator new once it has reached its peak size. Blocks
+// are released when the last allocator sharing the pool is destroyed.
+// Array allocations bypass the pool.
+//
+// Copies and rebound copies share their pools and compare equal: a
+// container's node allocator, rebound from the one it was given, frees
+// into the same pools as that one.
+//
+// A pool is not thread-safe: allocators sharing one must be used from
+// one thread at a time.
+template <typename T, std::size_t BlockSize = 64>
+class PoolAllocator
+{
+	static_assert(alignof(T) <= alignof(std::max_align_t),
+	              "PoolAllocator does not support over-aligned types");
+
+public:
+	using value_type = T;
+
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap            = std::true_type;
+	using is_always_equal                        = std::false_type;
+
+	template <typename U>
+	struct rebind
+	{
+		using other = PoolAllocator<U, BlockSize>;
+	};
+
+	PoolAllocator()
+		: pools_(std::make_shared<Pools>()),
+		  pool_(&pools_->get(sizeof(T), alignof(T))) { }
+
+	PoolAllocator(const PoolAllocator&) = default;
+	PoolAllocator& operator=(const PoolAllocator&) = default;
+
+	template <typename U>
+	PoolAllocator(const PoolAllocator<U, BlockSize>& other)
+		: pools_(other.pools_),
+		  pool_(&pools_->get(sizeof(T), alignof(T))) { }
+
+	// Copied containers get pools of their own.
+	PoolAllocator select_on_container_copy_construction() const
+	{
+		return PoolAllocator{};
+	}
+
+	T* allocate(const std::size_t n)
+	{
+		if (n != 1)
+		{
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		}
+
+		return static_cast<T*>(pool_->allocate());
+	}
+
+	void deallocate(T* p, const std::size_t n) noexcept
+	{
+		if (n != 1)
+		{
+			::operator delete(p);
+		}
+		else
+		{
+			pool_->deallocate(p);
+		}
+	}
+
+	template <typename U>
+	bool operator==(const PoolAllocator<U, BlockSize>& other) const noexcept
+	{
+		return pools_ == other.pools_;
+	}
+
+	template <typename U>
+	bool operator!=(const PoolAllocator<U, BlockSize>& other) const noexcept
+	{
+		return pools_ != other.pools_;
+	}
+
+private:
+	template <typename, std::size_t>
+	friend class PoolAllocator;
+
+	using Pools = detail::Pools<BlockSize>;
+
+	std::shared_ptr<Pools> pools_;
+	typename Pools::Pool*  pool_;
+};
+
+
+// Singly linked storage: one node per element, the last element at the
+// head of the list. References stay valid until the element is popped.
+template <typename T, typename Allocator = PoolAllocator<T>>
+class LinkedStorage
+{
+	struct Node;
+
+public:
+	using value_type     = T;
+	using allocator_type = Allocator;
+
+	// Walks from the last element pushed to the first.
+	class const_reverse_iterator
+	{
+	public:
+		using difference_type   = std::ptrdiff_t;
+		using value_type        = T;
+		using pointer           = const T*;
+		using reference         = const T&;
+		using iterator_category = std::forward_iterator_tag;
+
+		explicit const_reverse_iterator(const Node *node = nullptr) noexcept
+			: node_(node) { }
+
+		reference operator*() const noexcept
+		{
+			return node_->data;
+		}
+
+		pointer operator->() const noexcept
+		{
+			return &node_->data;
+		}
+
+		const_reverse_iterator& operator++() noexcept
+		{
+			node_ = node_->next;
+			return *this;
+		}
+
+		const_reverse_iterator operator++(int) noexcept
+		{
+			const_reverse_iterator i{*this};
+			node_ = node_->next;
+			return i;
+		}
+
+		bool operator==(const const_reverse_iterator& other) const noexcept
+		{
+			return node_ == other.node_;
+		}
+
+		bool operator!=(const const_reverse_iterator& other) const noexcept
+		{
+			return node_ != other.node_;
+		}
+
+	private:
+		const Node *node_;
+	};
+
+	LinkedStorage() = default;
+
+	explicit LinkedStorage(const Allocator& allocator)
+		: allocator_(allocator) { }
+
+	LinkedStorage(const LinkedStorage& other)
+		: allocator_(NodeTraits::select_on_container_copy_construction(other.allocator_))
+	{
+		append(other);
+	}
+
+	LinkedStorage(LinkedStorage&& other) noexcept
+		: allocator_(std::move(other.allocator_))
+	{
+		steal(other);
+	}
+
+	LinkedStorage& operator=(const LinkedStorage& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			assign_allocator(other.allocator_,
+				typename NodeTraits::propagate_on_container_copy_assignment{});
+			append(other);
+		}
+
+		return *this;
+	}
+
+	LinkedStorage& operator=(LinkedStorage&& other) noexcept(
+		NodeTraits::propagate_on_container_move_assignment::value)
+	{
+		if (this != &other)
+		{
+			clear();
+			move_assign(other,
+				typename NodeTraits::propagate_on_container_move_assignment{});
+		}
+
+		return *this;
+	}
+
+	~LinkedStorage()
+	{
+		clear();
+	}
+
+	bool empty() const noexcept
+	{
+		return top_ == nullptr;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	// Nodes are allocated one at a time; there is nothing to reserve.
+	void reserve(std::size_t) noexcept
+	{
+	}
+
+	T& back() noexcept
+	{
+		return top_->data;
+	}
+
+	const T& back() const noexcept
+	{
+		return top_->data;
+	}
+
+	template <typename... Args>
+	void emplace_back(Args&&... args)
+	{
+		top_ = create_node(top_, std::forward<Args>(args)...);
+		++size_;
+	}
+
+	void push_back(const T& element)
+	{
+		emplace_back(element);
+	}
+
+	void push_back(T&& element)
+	{
+		emplace_back(std::move(element));
+	}
+
+	void pop_back() noexcept
+	{
+		Node *node = top_;
+		top_ = node->next;
+		destroy_node(node);
+		--size_;
+	}
+
+	void clear() noexcept
+	{
+		while (top_)
+		{
+			Node *node = top_;
+			top_ = node->next;
+			destroy_node(node);
+		}
+
+		size_ = 0;
+	}
+
+	const_reverse_iterator crbegin() const noexcept
+	{
+		return const_reverse_iterator{top_};
+	}
+
+	const_reverse_iterator crend() const noexcept
+	{
+		return const_reverse_iterator{};
+	}
+
+private:
+	struct Node
+	{
+		template <typename... Args>
+		Node(Node *next, Args&&... args) : data(std::forward<Args>(args)...), next(next) { }
+		T     data;
+		Node *next = nullptr;
+	};
+
+	using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+	using NodeTraits    = std::allocator_traits<NodeAllocator>;
+
+	template <typename... Args>
+	Node* create_node(Node *next, Args&&... args)
+	{
+		Node *node = NodeTraits::allocate(allocator_, 1);
+
+		try
+		{
+			NodeTraits::construct(allocator_, node, next, std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			NodeTraits::deallocate(allocator_, node, 1);
+			throw;
+		}
+
+		return node;
+	}
+
+	void destroy_node(Node *node) noexcept
+	{
+		NodeTraits::destroy(allocator_, node);
+		NodeTraits::deallocate(allocator_, node, 1);
+	}
+
+	// Copies the elements of other below the current ones, keeping their order.
+	void append(const LinkedStorage& other)
+	{
+		Node **link = &top_;
+
+		while (*link)
+		{
+			link = &(*link)->next;
+		}
+
+		for (Node *node = other.top_; node; node = node->next)
+		{
+			*link = create_node(nullptr, node->data);
+			link = &(*link)->next;
+			++size_;
+		}
+	}
+
+	void assign_allocator(const NodeAllocator& allocator, std::true_type)
+	{
+		allocator_ = allocator;
+	}
+
+	void assign_allocator(const NodeAllocator&, std::false_type)
+	{
+	}
+
+	void move_assign(LinkedStorage& other, std::true_type) noexcept
+	{
+		allocator_ = std::move(other.allocator_);
+		steal(other);
+	}
+
+	void move_assign(LinkedStorage& other, std::false_type)
+	{
+		if (allocator_ == other.allocator_)
+		{
+			steal(other);
+		}
+		else
+		{
+			append(other);
+			other.clear();
+		}
+	}
+
+	void steal(LinkedStorage& other) noexcept
+	{
+		top_  = other.top_;
+		size_ = other.size_;
+		other.top_  = nullptr;
+		other.size_ = 0;
+	}
+
+	NodeAllocator allocator_;
+	Node*         top_  = nullptr;
+	std::size_t   size_ = 0;
+};
+
+
+// Contiguous chunks of ChunkSize elements, by default about a page each.
+// Unlike a growable array, growing never moves existing elements, and
+// unlike a linked list, walking the elements is a sequential scan. One
+// spare chunk is kept when shrinking so that a stack oscillating around
+// a chunk boundary does not allocate on every push, and shrinking never
+// frees the chunks reserve() asked for.
+template <typename T,
+          std::size_t ChunkSize = (sizeof(T) < 4096 ? 4096 / sizeof(T) : 1),
+          typename Allocator = std::allocator<T>>
+class ChunkedStorage
+{
+public:
+	using value_type     = T;
+	using allocator_type = Allocator;
+
+	class const_reverse_iterator
+	{
+	public:
+		using difference_type   = std::ptrdiff_t;
+		using value_type        = T;
+		using pointer           = const T*;
+		using reference         = const T&;
+		using iterator_category = std::bidirectional_iterator_tag;
+
+		const_reverse_iterator(T* const *chunks, std::size_t index) noexcept
+			: chunks_(chunks), index_(index) { }
+
+		reference operator*() const noexcept
+		{
+			return chunks_[(index_ - 1) / ChunkSize][(index_ - 1) % ChunkSize];
+		}
+
+		pointer operator->() const noexcept
+		{
+			return &operator*();
+		}
+
+		const_reverse_iterator& operator++() noexcept
+		{
+			--index_;
+			return *this;
+		}
+
+		const_reverse_iterator operator++(int) noexcept
+		{
+			const_reverse_iterator i{*this};
+			--index_;
+			return i;
+		}
+
+		const_reverse_iterator& operator--() noexcept
+		{
+			++index_;
+			return *this;
+		}
+
+		const_reverse_iterator operator--(int) noexcept
+		{
+			const_reverse_iterator i{*this};
+			++index_;
+			return i;
+		}
+
+		bool operator==(const const_reverse_iterator& other) const noexcept
+		{
+			return index_ == other.index_;
+		}
+
+		bool operator!=(const const_reverse_iterator& other) const noexcept
+		{
+			return index_ != other.index_;
+		}
+
+	private:
+		T* const    *chunks_;
+		std::size_t  index_;
+	};
+
+	ChunkedStorage() = default;
+
+	explicit ChunkedStorage(const Allocator& allocator)
+		: allocator_(allocator) { }
+
+	ChunkedStorage(const ChunkedStorage& other)
+		: allocator_(Traits::select_on_container_copy_construction(other.allocator_))
+	{
+		append(other);
+	}
+
+	ChunkedStorage(ChunkedStorage&& other) noexcept
+		: allocator_(std::move(other.allocator_)),
+		  chunks_(std::move(other.chunks_)),
+		  size_(other.size_),
+		  reserved_(other.reserved_)
+	{
+		other.chunks_.clear();
+		other.size_     = 0;
+		other.reserved_ = 0;
+	}
+
+	ChunkedStorage& operator=(const ChunkedStorage& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			assign_allocator(other.allocator_,
+				typename Traits::propagate_on_container_copy_assignment{});
+			append(other);
+		}
+
+		return *this;
+	}
+
+	ChunkedStorage& operator=(ChunkedStorage&& other) noexcept
+	{
+		static_assert(Traits::propagate_on_container_move_assignment::value,
+		              "ChunkedStorage requires an allocator propagating on move assignment");
+
+		if (this != &other)
+		{
+			clear();
+			release(0);
+			allocator_ = std::move(other.allocator_);
+			chunks_    = std::move(other.chunks_);
+			size_      = other.size_;
+			reserved_  = other.reserved_;
+			other.chunks_.clear();
+			other.size_     = 0;
+			other.reserved_ = 0;
+		}
+
+		return *this;
+	}
+
+	~ChunkedStorage()
+	{
+		clear();
+		release(0);
+	}
+
+	bool empty() const noexcept
+	{
+		return size_ == 0;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	std::size_t capacity() const noexcept
+	{
+		return chunks_.size() * ChunkSize;
+	}
+
+	Allocator get_allocator() const
+	{
+		return allocator_;
+	}
+
+	void reserve(const std::size_t n)
+	{
+		const std::size_t chunks = (n + ChunkSize - 1) / ChunkSize;
+		chunks_.reserve(chunks);
+
+		while (chunks_.size() < chunks)
+		{
+			grow();
+		}
+
+		reserved_ = std::max(reserved_, chunks);
+	}
+
+	T& back() noexcept
+	{
+		return at(size_ - 1);
+	}
+
+	const T& back() const noexcept
+	{
+		return at(size_ - 1);
+	}
+
+	template <typename... Args>
+	void emplace_back(Args&&... args)
+	{
+		if (size_ == capacity())
+		{
+			grow();
+		}
+
+		Traits::construct(allocator_, &at(size_), std::forward<Args>(args)...);
+		++size_;
+	}
+
+	void push_back(const T& element)
+	{
+		emplace_back(element);
+	}
+
+	void push_back(T&& element)
+	{
+		emplace_back(std::move(element));
+	}
+
+	void pop_back() noexcept
+	{
+		--size_;
+		Traits::destroy(allocator_, &at(size_));
+
+		if (size_ + 2 * ChunkSize <= capacity() && chunks_.size() > reserved_)
+		{
+			release(chunks_.size() - 1);
+		}
+	}
+
+	void clear() noexcept
+	{
+		for (; size_; --size_)
+		{
+			Traits::destroy(allocator_, &at(size_ - 1));
+		}
+	}
+
+	const_reverse_iterator crbegin() const noexcept
+	{
+		return const_reverse_iterator{chunks_.data(), size_};
+	}
+
+	const_reverse_iterator crend() const noexcept
+	{
+		return const_reverse_iterator{chunks_.data(), 0};
+	}
+
+private:
+	using Traits = std::allocator_traits<Allocator>;
+
+	T& at(const std::size_t index) noexcept
+	{
+		return chunks_[index / ChunkSize][index % ChunkSize];
+	}
+
+	const T& at(const std::size_t index) const noexcept
+	{
+		return chunks_[index / ChunkSize][index % ChunkSize];
+	}
+
+	void grow()
+	{
+		T* chunk = Traits::allocate(allocator_, ChunkSize);
+
+		try
+		{
+			chunks_.push_back(chunk);
+		}
+		catch (...)
+		{
+			Traits::deallocate(allocator_, chunk, ChunkSize);
+			throw;
+		}
+	}
+
+	// Frees the chunks from index first onwards, which must be empty.
+	void release(const std::size_t first) noexcept
+	{
+		while (chunks_.size() > first)
+		{
+			Traits::deallocate(allocator_, chunks_.back(), ChunkSize);
+			chunks_.pop_back();
+		}
+	}
+
+	// With unequal allocators the chunks go back to the old one before
+	// the new one is taken.
+	void assign_allocator(const Allocator& allocator, std::true_type)
+	{
+		if (allocator_ != allocator)
+		{
+			release(0);
+		}
+
+		allocator_ = allocator;
+	}
+
+	void assign_allocator(const Allocator&, std::false_type) noexcept
+	{
+	}
+
+	void append(const ChunkedStorage& other)
+	{
+		chunks_.reserve((size_ + other.size_ + ChunkSize - 1) / ChunkSize);
+
+		while (capacity() < size_ + other.size_)
+		{
+			grow();
+		}
+
+
+		for (std::size_t i = 0; i != other.size_; ++i)
+		{
+			emplace_back(other.at(i));
+		}
+	}
+
+	Allocator       allocator_;
+	std::vector<T*> chunks_;
+	std::size_t     size_     = 0;
+	std::size_t     reserved_ = 0;
+};
+
+
+// LIFO adapter over a storage policy. Storage is anything with the
+// back-insertion interface of std::vector (emplace_back, pop_back, back,
+// size, empty, clear, reserve and crbegin/crend) allocating through
+// Allocator, which includes std::vector itself. The back of the storage
+// is the top of the stack.
+template <typename T,
+          typename Allocator = PoolAllocator<T>,
+          typename Storage   = LinkedStorage<T, Allocator>>
+class Stack
+{
+	static_assert(std::is_same<typename Storage::allocator_type, Allocator>::value,
+	              "Stack's storage must use its allocator");
+
+public:
+	using allocator_type = Allocator;
+	using storage_type   = Storage;
+	using const_iterator = typename Storage::const_reverse_iterator;
+
+	Stack() = default;
+
+	explicit Stack(const Allocator& allocator)
+		: storage_(allocator) { }
+
+	bool empty() const
+	{
+		return storage_.empty();
+	}
+
+	void pop()
+	{
+		if (!storage_.empty())
+		{
+			storage_.pop_back();
+		}
+	}
+
+	void push(const T& element)
+	{
+		storage_.push_back(element);
+	}
+
+	void push(T&& element)
+	{
+		storage_.push_back(std::move(element));
+	}
+
+	template <typename... Args>
+	T& emplace(Args&&... args)
+	{
+		storage_.emplace_back(std::forward<Args>(args)...);
+		return storage_.back();
+	}
+
+	void reserve(const std::size_t n)
+	{
+		storage_.reserve(n);
+	}
+
+	void clear()
+	{
+		storage_.clear();
+	}
+
+	std::size_t size() const
+	{
+		return storage_.size();
+	}
+
+	T& top()
+	{
+		return storage_.back();
+	}
+
+	const T& top() const
+	{
+		return storage_.back();
+	}
+
+	// Iterates from the top of the stack to the bottom.
+	const_iterator begin() const
+	{
+		return storage_.crbegin();
+	}
+
+	const_iterator end() const
+	{
+		return storage_.crend();
+	}
+
+	friend std::ostream& operator<<(std::ostream& os, const Stack& stack)
+	{
+		os << "Stack(size=" << stack.size();
+
+		if (!stack.empty())
+		{
+			auto element = stack.begin();
+			os << ",elements=" << *element;
+
+			for (++element; element != stack.end(); ++element)
+			{
+				os << " " << *element;
+			}
+		}
+
+		os << ")";
+
+		return os;
+	}
+
+private:
+	Storage storage_;
+};
+
+template <typename T>
+using ArrayStack = Stack<T, std::allocator<T>, std::vector<T>>;
+
+template <typename T>
+using ChunkedStack = Stack<T, std::allocator<T>, ChunkedStorage<T>>;